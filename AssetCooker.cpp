@@ -0,0 +1,410 @@
+#include <Windows.h>
+#include "AssetCooker.h"
+#include "ModelLoader.h"
+#include "MeshFile.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace
+{
+	// part of every settings hash: bumped when a cooker changes its output, so that everything is cooked again
+	const uint64_t COOK_VERSION = 1;
+
+	const uint64_t MODEL_ASSET = 0;
+	const uint64_t TEXTURE_ASSET = 1;
+
+	const char *const MODEL_EXTENSIONS[] = { ".obj", ".fbx", ".dae", ".3ds", ".blend", };
+
+	const unsigned int MAX_MANIFEST_LINE = 2048;
+
+	bool IsModel(const std::string &fileName)
+	{
+		size_t dot = fileName.find_last_of('.');
+		if (dot == std::string::npos)
+			return false;
+
+		std::string extension = fileName.substr(dot);
+		for (char &c : extension)
+			c = (char)tolower((unsigned char)c);
+
+		for (const char *modelExtension : MODEL_EXTENSIONS)
+			if (extension == modelExtension)
+				return true;
+
+		return false;
+	}
+
+	// tab separated fields of a manifest line
+	std::vector<std::string> SplitLine(const char *line)
+	{
+		std::vector<std::string> fields(1);
+
+		for (; *line && *line != '\n' && *line != '\r'; line++)
+		{
+			if (*line == '\t')
+				fields.emplace_back();
+			else
+				fields.back() += *line;
+		}
+
+		return fields;
+	}
+}
+
+uint64_t AssetCooker::HashData(const uint8_t *data, size_t size)
+{
+	// fnv-1a over 8 byte words (the high half folded in after each one), the tail a byte at a time
+	uint64_t hash = 14695981039346656037ull;
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+
+		hash = (hash ^ word) * 1099511628211ull;
+		hash ^= hash >> 32;
+	}
+
+	for (; i < size; i++)
+		hash = (hash ^ data[i]) * 1099511628211ull;
+
+	return hash ^ size;
+}
+
+uint64_t AssetCooker::HashSettings(uint64_t assetType, uint64_t settings)
+{
+	uint64_t values[] = { COOK_VERSION, assetType, settings };
+
+	return HashData(reinterpret_cast<const uint8_t*>(values), sizeof(values));
+}
+
+void AssetCooker::FindModels(const std::string &directory, std::vector<std::string> &models)
+{
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA((directory + "/*").c_str(), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		std::string name = findData.cFileName;
+
+		if (name == "." || name == "..")
+			continue;
+
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			FindModels(directory + "/" + name, models);
+		else if (IsModel(name))
+			models.push_back(directory + "/" + name);
+	} while (FindNextFileA(find, &findData));
+
+	FindClose(find);
+}
+
+bool AssetCooker::Cook(const std::vector<std::string> &directories, const std::string &manifestPath)
+{
+	mStatistics = {};
+	mModelStatistics.clear();
+	mErrors.clear();
+	mModels.clear();
+	mTextures.clear();
+
+	// a missing or unreadable manifest cooks everything
+	LoadManifest(manifestPath);
+
+	std::vector<std::string> modelPaths;
+	for (const std::string &directory : directories)
+		FindModels(directory, modelPaths);
+
+	std::sort(modelPaths.begin(), modelPaths.end());
+
+	for (const std::string &modelPath : modelPaths)
+		mModels.push_back({ modelPath, TextureCooker::Usage::COLOR, {}, State::FAILED, {} });
+
+	ThreadPool::GetInstance().ParallelFor((unsigned int)mModels.size(), [this](unsigned int model) { CookModel(mModels[model]); });
+
+	// textures shared by several models are cooked once, with the usage of the first slot they were found in
+	std::map<std::string, size_t> textureIndices;
+
+	for (const Asset &model : mModels)
+		for (const std::pair<std::string, TextureCooker::Usage> &texture : model.textures)
+			if (textureIndices.insert(std::pair<std::string, size_t>(texture.first, mTextures.size())).second)
+				mTextures.push_back({ texture.first, texture.second, {}, State::FAILED, {} });
+
+	ThreadPool::GetInstance().ParallelFor((unsigned int)mTextures.size(), [this](unsigned int texture) { CookTexture(mTextures[texture]); });
+
+	for (const std::vector<Asset> *assets : { &mModels, &mTextures })
+		for (const Asset &asset : *assets)
+		{
+			if (asset.state == State::COOKED)
+				mStatistics.numCooked++;
+			else if (asset.state == State::UP_TO_DATE)
+				mStatistics.numUpToDate++;
+			else
+				mStatistics.numFailed++;
+		}
+
+	for (const Asset &model : mModels)
+	{
+		if (model.state != State::COOKED)
+			continue;
+
+		mModelStatistics.push_back({ model.filePath, model.vertexCache });
+
+		MeshOptimizer::Statistics &vertexCache = mStatistics.vertexCache;
+		unsigned int numTriangles = vertexCache.numTriangles + model.vertexCache.numTriangles;
+
+		if (numTriangles)
+		{
+			vertexCache.acmrBefore = (vertexCache.acmrBefore * vertexCache.numTriangles + model.vertexCache.acmrBefore * model.vertexCache.numTriangles) / numTriangles;
+			vertexCache.acmrAfter = (vertexCache.acmrAfter * vertexCache.numTriangles + model.vertexCache.acmrAfter * model.vertexCache.numTriangles) / numTriangles;
+			vertexCache.numTriangles = numTriangles;
+		}
+	}
+
+	if (!SaveManifest(manifestPath))
+		AddError("couldn't write manifest " + manifestPath);
+
+	return mErrors.empty();
+}
+
+bool AssetCooker::LoadManifest(const std::string &manifestPath)
+{
+	mManifest.clear();
+	mLastFiles.clear();
+
+	FILE *fileStream;
+	if (fopen_s(&fileStream, manifestPath.c_str(), "r"))
+		return false;
+
+	// asset <source> <settings hash> <cooked>, followed by file <path> <time> <hash> for each of its dependencies
+	char line[MAX_MANIFEST_LINE];
+	Record *record = nullptr;
+
+	while (fgets(line, sizeof(line), fileStream))
+	{
+		std::vector<std::string> fields = SplitLine(line);
+
+		if (fields.size() == 4 && fields[0] == "asset")
+		{
+			record = &mManifest[fields[1]];
+			record->settingsHash = strtoull(fields[2].c_str(), nullptr, 16);
+			record->cooked = fields[3] == "1";
+		}
+		else if (fields.size() == 4 && fields[0] == "file" && record)
+		{
+			Dependency dependency = { fields[1], strtoull(fields[2].c_str(), nullptr, 16), strtoull(fields[3].c_str(), nullptr, 16) };
+
+			record->dependencies.push_back(dependency);
+			mLastFiles[dependency.filePath] = dependency;
+		}
+	}
+
+	fclose(fileStream);
+
+	return true;
+}
+
+bool AssetCooker::SaveManifest(const std::string &manifestPath) const
+{
+	FILE *fileStream;
+	if (fopen_s(&fileStream, manifestPath.c_str(), "w"))
+		return false;
+
+	bool written = true;
+
+	// failed assets aren't recorded, the next cook tries them again
+	for (const std::vector<Asset> *assets : { &mModels, &mTextures })
+		for (const Asset &asset : *assets)
+		{
+			if (asset.state == State::FAILED)
+				continue;
+
+			written = written && fprintf(fileStream, "asset\t%s\t%016llx\t%d\n", asset.filePath.c_str(), (unsigned long long)asset.record.settingsHash, asset.record.cooked ? 1 : 0) > 0;
+
+			for (const Dependency &dependency : asset.record.dependencies)
+				written = written && fprintf(fileStream, "file\t%s\t%016llx\t%016llx\n", dependency.filePath.c_str(), (unsigned long long)dependency.modificationTime, (unsigned long long)dependency.hash) > 0;
+		}
+
+	written = fclose(fileStream) == 0 && written;
+
+	if (!written)
+		remove(manifestPath.c_str());
+
+	return written;
+}
+
+bool AssetCooker::HashDependency(const std::string &filePath, Dependency &dependency) const
+{
+	dependency.filePath = filePath;
+	dependency.modificationTime = MappedFile::GetModificationTime(filePath);
+
+	if (dependency.modificationTime == 0)
+		return false;
+
+	// a file with the time it had at the last cook isn't read again
+	std::map<std::string, Dependency>::const_iterator it = mLastFiles.find(filePath);
+
+	if (it != mLastFiles.end() && it->second.modificationTime == dependency.modificationTime)
+	{
+		dependency.hash = it->second.hash;
+		return true;
+	}
+
+	// empty files can't be mapped
+	MappedFile file;
+	dependency.hash = file.Open(filePath) ? HashData(file.GetData(), file.GetSize()) : HashData(nullptr, 0);
+
+	return true;
+}
+
+bool AssetCooker::IsUpToDate(const std::string &filePath, uint64_t settingsHash, Record &record) const
+{
+	std::map<std::string, Record>::const_iterator it = mManifest.find(filePath);
+
+	if (it == mManifest.end() || it->second.settingsHash != settingsHash)
+		return false;
+
+	record.cooked = it->second.cooked;
+	record.dependencies.clear();
+
+	for (const Dependency &lastDependency : it->second.dependencies)
+	{
+		Dependency dependency;
+
+		if (!HashDependency(lastDependency.filePath, dependency) || dependency.hash != lastDependency.hash)
+			return false;
+
+		record.dependencies.push_back(dependency);
+	}
+
+	return true;
+}
+
+void AssetCooker::CookModel(Asset &model)
+{
+	const VertexLayout &layout = VertexLayout::GetStaticMeshLayout();
+
+	std::string cookedPath = MeshFile::GetCookedPath(model.filePath);
+	uint64_t sourceTime = MappedFile::GetModificationTime(model.filePath);
+
+	model.record.settingsHash = HashSettings(MODEL_ASSET, MeshFile::HashLayout(layout));
+
+	MeshFile cookedFile;
+	bool upToDate = IsUpToDate(model.filePath, model.record.settingsHash, model.record);
+
+	// a source touched without changing (a checkout) gets its new time written into the cooked file instead of a new import
+	if (upToDate)
+		upToDate = cookedFile.Open(cookedPath, layout, sourceTime) || (MeshFile::Restamp(cookedPath, sourceTime) && cookedFile.Open(cookedPath, layout, sourceTime));
+
+	if (!upToDate)
+	{
+		ModelLoader::StaticModelData modelData;
+		std::string error;
+
+		if (!ModelLoader::GetInstance().ReadStaticModel(model.filePath, modelData, error, true))
+		{
+			AddError(model.filePath + ": " + error);
+			return;
+		}
+
+		model.record.cooked = true;
+		model.record.dependencies.clear();
+		model.vertexCache = modelData.statistics;
+
+		for (const std::string &importedFile : modelData.importedFiles)
+		{
+			Dependency dependency;
+
+			if (!HashDependency(importedFile, dependency))
+			{
+				AddError(model.filePath + ": can't read " + importedFile);
+				return;
+			}
+
+			model.record.dependencies.push_back(dependency);
+		}
+
+		if (!cookedFile.Open(cookedPath, layout, sourceTime))
+		{
+			AddError(model.filePath + ": couldn't write " + cookedPath);
+			return;
+		}
+	}
+
+	// the material slots decide how the textures are cooked
+	static const TextureCooker::Usage usages[MeshFile::NUM_TEXTURE_TYPES] = { TextureCooker::Usage::COLOR, TextureCooker::Usage::DATA, TextureCooker::Usage::NORMAL, };
+
+	std::string directory = model.filePath.substr(0, model.filePath.find_last_of('/'));
+
+	for (unsigned int mesh = 0; mesh < cookedFile.GetNumMeshes(); mesh++)
+		for (unsigned int type = 0; type < MeshFile::NUM_TEXTURE_TYPES; type++)
+			for (unsigned int texture = 0; texture < cookedFile.GetNumTextures(mesh, (MeshFile::TextureType)type); texture++)
+				model.textures.push_back(std::pair<std::string, TextureCooker::Usage>(directory + "/" + cookedFile.GetTexture(mesh, (MeshFile::TextureType)type, texture), usages[type]));
+
+	model.state = upToDate ? State::UP_TO_DATE : State::COOKED;
+}
+
+void AssetCooker::CookTexture(Asset &texture)
+{
+	std::string cookedPath = TextureCooker::GetCookedPath(texture.filePath);
+	uint64_t sourceTime = MappedFile::GetModificationTime(texture.filePath);
+
+	texture.record.settingsHash = HashSettings(TEXTURE_ASSET, (uint64_t)texture.usage);
+
+	bool upToDate = IsUpToDate(texture.filePath, texture.record.settingsHash, texture.record);
+
+	// loads take the cooked file if it's at least as recent as the source: a touched source gets the cooked file restamped
+	if (upToDate && texture.record.cooked)
+	{
+		uint64_t cookedTime = MappedFile::GetModificationTime(cookedPath);
+
+		upToDate = cookedTime != 0 && (cookedTime >= sourceTime || MappedFile::SetModificationTime(cookedPath, sourceTime));
+	}
+
+	if (upToDate)
+	{
+		texture.state = State::UP_TO_DATE;
+		return;
+	}
+
+	Dependency source;
+	RenderDevice::TextureData textureData;
+
+	if (!HashDependency(texture.filePath, source) || !mDecodeTexture(texture.filePath, textureData))
+	{
+		AddError(texture.filePath + ": can't read texture");
+		return;
+	}
+
+	texture.record.cooked = false;
+	texture.record.dependencies.assign(1, source);
+
+	// dds sources are loaded as they are, textures that can't be block compressed are loaded decoded
+	std::vector<uint8_t> ddsFile;
+
+	if (!textureData.isFile && textureData.format == RenderDevice::Format::R8G8B8A8_UNORM && TextureCooker::Cook(&textureData.data[0], textureData.width, textureData.height, texture.usage, ddsFile))
+	{
+		if (!TextureCooker::Save(cookedPath, ddsFile))
+		{
+			AddError(texture.filePath + ": couldn't write " + cookedPath);
+			return;
+		}
+
+		texture.record.cooked = true;
+	}
+
+	texture.state = State::COOKED;
+}
+
+void AssetCooker::AddError(const std::string &error)
+{
+	std::lock_guard<std::mutex> lock(mErrorMutex);
+
+	mErrors.push_back(error);
+}
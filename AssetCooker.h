@@ -0,0 +1,102 @@
+#ifndef ASSET_COOKER_H
+#define ASSET_COOKER_H
+
+#include "RenderDevice.h"
+#include "TextureCooker.h"
+#include "MeshOptimizer.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+/**** asset build: every model under the asset directories is imported into its .mesh file, then the textures its materials ****/
+/**** use are cooked to dds with the usage of their slot. a manifest records, for each asset, the hash of the cook settings and ****/
+/**** the content hash of every file it was cooked from (a model and its material libraries, a texture) - an asset is cooked ****/
+/**** again only when one of them changed. files with the time they had at the last cook aren't read again, touched files ****/
+/**** with the same content get their outputs restamped. models, then textures, are cooked in parallel on the thread pool ****/
+
+class AssetCooker
+{
+public:
+	typedef std::function<bool(const std::string&, RenderDevice::TextureData&)> TextureDecoder;     // thread safe, no device needed
+
+	struct Statistics
+	{
+		unsigned int numCooked;
+		unsigned int numUpToDate;
+		unsigned int numFailed;
+		MeshOptimizer::Statistics vertexCache;     // of the models imported by the cook, weighted by triangles
+	};
+	struct ModelStatistics
+	{
+		std::string filePath;
+		MeshOptimizer::Statistics vertexCache;     // before and after the mesh optimisation
+	};
+public:
+	explicit AssetCooker(const TextureDecoder &decodeTexture) : mDecodeTexture(decodeTexture) {}
+
+	// fails if any asset fails to cook, the manifest keeps the ones that didn't
+	bool Cook(const std::vector<std::string> &directories, const std::string &manifestPath);
+
+	const Statistics &GetStatistics() const { return mStatistics; }
+	const std::vector<std::string> &GetErrors() const { return mErrors; }
+	const std::vector<ModelStatistics> &GetModelStatistics() const { return mModelStatistics; }     // models imported by the cook
+
+	static uint64_t HashData(const uint8_t *data, size_t size);
+private:
+	enum class State { FAILED, COOKED, UP_TO_DATE, };
+
+	struct Dependency
+	{
+		std::string filePath;
+		uint64_t modificationTime;
+		uint64_t hash;
+	};
+
+	struct Record        // an asset as it was cooked
+	{
+		uint64_t settingsHash;
+		bool cooked;                               // false for textures that can't be block compressed (loaded decoded)
+		std::vector<Dependency> dependencies;
+	};
+
+	struct Asset
+	{
+		std::string filePath;
+		TextureCooker::Usage usage;                // textures
+		Record record;
+		State state;
+		std::vector<std::pair<std::string, TextureCooker::Usage>> textures;      // models: used by the materials
+		MeshOptimizer::Statistics vertexCache;     // models: set if imported
+	};
+
+	static void FindModels(const std::string &directory, std::vector<std::string> &models);
+	static uint64_t HashSettings(uint64_t assetType, uint64_t settings);
+
+	bool LoadManifest(const std::string &manifestPath);
+	bool SaveManifest(const std::string &manifestPath) const;
+
+	bool HashDependency(const std::string &filePath, Dependency &dependency) const;
+	bool IsUpToDate(const std::string &filePath, uint64_t settingsHash, Record &record) const;
+
+	void CookModel(Asset &model);
+	void CookTexture(Asset &texture);
+	void AddError(const std::string &error);
+
+	TextureDecoder mDecodeTexture;
+
+	std::map<std::string, Record> mManifest;            // the last cook, by source
+	std::map<std::string, Dependency> mLastFiles;       // files of the last cook, by path
+
+	std::vector<Asset> mModels;
+	std::vector<Asset> mTextures;
+
+	Statistics mStatistics = {};
+	std::vector<ModelStatistics> mModelStatistics;
+	std::vector<std::string> mErrors;
+	std::mutex mErrorMutex;
+};
+
+#endif  // ASSET_COOKER_H
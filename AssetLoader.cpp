@@ -0,0 +1,260 @@
+#include "AssetLoader.h"
+#include "GraphicsSystem.h"
+#include "ModelLoader.h"
+#include "Error.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+// file reading is mostly waiting: a couple of threads keep the disk busy without competing with the thread pool for cores
+static const unsigned int NUM_LOADING_THREADS = 2;
+
+const AssetLoader::RequestID AssetLoader::INVALID_REQUEST;
+const unsigned int AssetLoader::NUM_PRIORITIES;
+
+/**** requests ****/
+
+class AssetLoader::Request
+{
+public:
+	Request(const std::string &filePath, Priority priority) : mFilePath(filePath), mPriority(priority) {}
+	virtual ~Request() = default;
+
+	virtual void Read() = 0;         // loading thread
+	virtual void Create() = 0;       // render thread
+
+	RequestID GetID() const { return mID; }
+	void SetID(RequestID id) { mID = id; }
+	Priority GetPriority() const { return mPriority; }
+	bool IsCancelled() const { return mCancelled; }
+	void Cancel() { mCancelled = true; }
+protected:
+	std::string mFilePath;
+private:
+	Priority mPriority;
+	RequestID mID = INVALID_REQUEST;
+	bool mCancelled = false;        // set while the request is being read, read when it lands
+};
+
+class AssetLoader::TextureRequest : public Request
+{
+public:
+	TextureRequest(const std::string &filePath, TextureCooker::Usage usage, Priority priority, const std::function<void(TextureHandle, const RenderDevice::TextureData&)> &onLoaded, unsigned int firstMip) : Request(filePath, priority), mUsage(usage), mOnLoaded(onLoaded), mFirstMip(firstMip) {}
+
+	void Read() override
+	{
+		mDecoded = TextureCooker::Read(GraphicsSystem::GetInstance().GetRenderDevice(), mFilePath, mUsage, mTextureData);
+	}
+
+	void Create() override
+	{
+		RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+		// files the device can't decode off the render thread are loaded the synchronous way (which reports errors)
+		if (mDecoded)
+			mOnLoaded(renderDevice.CreateTexture(mTextureData, mFirstMip), mTextureData);
+		else
+			mOnLoaded(renderDevice.LoadTexture(mFilePath), RenderDevice::TextureData{});
+	}
+private:
+	TextureCooker::Usage mUsage;
+	std::function<void(TextureHandle, const RenderDevice::TextureData&)> mOnLoaded;
+	unsigned int mFirstMip;
+	RenderDevice::TextureData mTextureData;
+	bool mDecoded = false;
+};
+
+class AssetLoader::StaticModelRequest : public Request
+{
+public:
+	StaticModelRequest(const std::string &filePath, Priority priority, const std::function<void(StaticMeshComponent*)> &onLoaded) : Request(filePath, priority), mOnLoaded(onLoaded) {}
+
+	void Read() override
+	{
+		mRead = ModelLoader::GetInstance().ReadStaticModel(mFilePath, mModel, mError);
+	}
+
+	void Create() override
+	{
+		if (!mRead)
+			ErrorBox(mError);
+
+		mOnLoaded(ModelLoader::GetInstance().CreateStaticModel(mModel));
+	}
+private:
+	std::function<void(StaticMeshComponent*)> mOnLoaded;
+	ModelLoader::StaticModelData mModel;
+	std::string mError;
+	bool mRead = false;
+};
+
+/**** asset loader ****/
+
+AssetLoader::AssetLoader()
+{
+	for (unsigned int i = 0; i < NUM_LOADING_THREADS; i++)
+		mLoaders.emplace_back(&AssetLoader::LoaderLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+
+	mRequestAvailable.notify_all();
+
+	for (std::thread &loader : mLoaders)
+		loader.join();
+
+	for (std::deque<Request*> &queue : mQueues)
+		for (Request *request : queue)
+			delete request;
+
+	for (Request *request : mLanded)
+		delete request;
+}
+
+AssetLoader::RequestID AssetLoader::LoadTexture(const std::string &filePath, TextureCooker::Usage usage, Priority priority, const std::function<void(TextureHandle, const RenderDevice::TextureData&)> &onLoaded, unsigned int firstMip)
+{
+	return Submit(new TextureRequest(filePath, usage, priority, onLoaded, firstMip));
+}
+
+AssetLoader::RequestID AssetLoader::LoadStaticModel(const std::string &filePath, Priority priority, const std::function<void(StaticMeshComponent*)> &onLoaded)
+{
+	return Submit(new StaticModelRequest(filePath, priority, onLoaded));
+}
+
+AssetLoader::RequestID AssetLoader::Submit(Request *request)
+{
+	RequestID id;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		id = mNextRequest++;
+		request->SetID(id);
+		mQueues[(unsigned int)request->GetPriority()].push_back(request);
+	}
+
+	mRequestAvailable.notify_one();
+
+	return id;
+}
+
+void AssetLoader::Cancel(RequestID id)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// a request that isn't being read is dropped, one being read is dropped when it lands
+	for (std::deque<Request*> &queue : mQueues)
+		for (std::deque<Request*>::iterator it = queue.begin(); it != queue.end(); ++it)
+			if ((*it)->GetID() == id)
+			{
+				delete *it;
+				queue.erase(it);
+				return;
+			}
+
+	for (std::deque<Request*>::iterator it = mLanded.begin(); it != mLanded.end(); ++it)
+		if ((*it)->GetID() == id)
+		{
+			delete *it;
+			mLanded.erase(it);
+			return;
+		}
+
+	for (Request *request : mReading)
+		if (request->GetID() == id)
+			request->Cancel();
+}
+
+void AssetLoader::Update(double budgetMilliseconds)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	while (true)
+	{
+		Request *request;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (mLanded.empty())
+				return;
+
+			request = mLanded.front();
+			mLanded.pop_front();
+		}
+
+		if (!request->IsCancelled())
+			request->Create();
+
+		delete request;
+
+		if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMilliseconds)
+			return;
+	}
+}
+
+void AssetLoader::Flush()
+{
+	// creating an asset can request more (the textures of a model)
+	while (GetNumPending() > 0)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mRequestLanded.wait(lock, [this]() { return mReading.empty() && mQueues[0].empty() && mQueues[1].empty() && mQueues[2].empty(); });
+		}
+
+		Update(std::numeric_limits<double>::max());
+	}
+}
+
+unsigned int AssetLoader::GetNumPending() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	unsigned int numPending = (unsigned int)(mReading.size() + mLanded.size());
+	for (const std::deque<Request*> &queue : mQueues)
+		numPending += (unsigned int)queue.size();
+
+	return numPending;
+}
+
+void AssetLoader::LoaderLoop()
+{
+	while (true)
+	{
+		Request *request = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mRequestAvailable.wait(lock, [this]() { return mShutdown || !mQueues[0].empty() || !mQueues[1].empty() || !mQueues[2].empty(); });
+
+			if (mShutdown)
+				return;
+
+			// highest priority first, in submission order within a priority
+			for (int priority = NUM_PRIORITIES - 1; priority >= 0 && !request; priority--)
+				if (!mQueues[priority].empty())
+				{
+					request = mQueues[priority].front();
+					mQueues[priority].pop_front();
+				}
+
+			mReading.push_back(request);
+		}
+
+		request->Read();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mReading.erase(std::find(mReading.begin(), mReading.end(), request));
+			mLanded.push_back(request);
+		}
+
+		mRequestLanded.notify_all();
+	}
+}
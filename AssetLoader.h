@@ -0,0 +1,70 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include "RenderDevice.h"
+#include "TextureCooker.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+class StaticMeshComponent;
+
+/**** background asset loading: requests return at once, files are read and decoded on the loading threads (highest priority first) ****/
+/**** and the gpu resources are created on the render thread by Update(), within a time budget per frame. the callback of a ****/
+/**** request runs on the render thread when its asset lands ****/
+
+class AssetLoader
+{
+private:
+	class Request;
+	class TextureRequest;
+	class StaticModelRequest;
+public:
+	enum class Priority { LOW, NORMAL, HIGH, };
+
+	typedef uint32_t RequestID;
+
+	static const RequestID INVALID_REQUEST = 0;
+	static const unsigned int NUM_PRIORITIES = 3;
+public:
+	static AssetLoader &GetInstance() { static AssetLoader instance; return instance; }
+	~AssetLoader();
+
+	// textures are cooked on their first load (block compressed for the usage), the callback gets the decoded dimensions too
+	// (zero if the device couldn't decode the file off the render thread)
+	RequestID LoadTexture(const std::string &filePath, TextureCooker::Usage usage, Priority priority, const std::function<void(TextureHandle, const RenderDevice::TextureData&)> &onLoaded, unsigned int firstMip = 0);
+	RequestID LoadStaticModel(const std::string &filePath, Priority priority, const std::function<void(StaticMeshComponent*)> &onLoaded);
+
+	// the callback of a cancelled request is never invoked (its owner may be gone)
+	void Cancel(RequestID request);
+
+	// render thread, once per frame: creates landed assets until the budget is spent, at least one per call
+	void Update(double budgetMilliseconds = 2.0);
+	void Flush();          // waits for every request and creates its asset
+
+	unsigned int GetNumPending() const;
+private:
+	AssetLoader();
+
+	RequestID Submit(Request *request);
+	void LoaderLoop();
+
+	std::vector<std::thread> mLoaders;
+	std::deque<Request*> mQueues[NUM_PRIORITIES];     // requests waiting for a loading thread
+	std::vector<Request*> mReading;
+	std::deque<Request*> mLanded;                      // read and decoded, waiting for the render thread
+	RequestID mNextRequest = 1;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mRequestAvailable;
+	std::condition_variable mRequestLanded;
+
+	bool mShutdown = false;
+};
+
+#endif  // ASSET_LOADER_H
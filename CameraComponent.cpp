@@ -1,5 +1,6 @@
 #include "CameraComponent.h"
 #include "PositionComponent.h"
+#include "RenderScene.h"
 
 CameraComponent::CameraComponent(float verticalFOV, float aspectRatio, float nearDistance, float farDistance, PositionComponent *positionComponent, const XMFLOAT3 &relativePosition, const XMFLOAT3 &relativeOrientationEulerAngles)
 	: mPositionComponent(positionComponent), mRelativePosition(relativePosition), mRelativeOrientationEulerAngles(relativeOrientationEulerAngles)
@@ -16,6 +17,17 @@ CameraComponent::CameraComponent(float verticalFOV, float aspectRatio, float nea
 	XMStoreFloat4x4(&mOffsetMatrix, offsetMatrix);
 }
 
+CameraComponent::~CameraComponent()
+{
+	RenderScene::GetInstance().RemoveEntity(GetOwner());
+}
+
+void CameraComponent::Init()
+{
+	EntitySystem::GetInstance().SetCamera(GetOwner());
+	RenderScene::GetInstance().UpdateEntity(GetOwner());
+}
+
 void CameraComponent::SetLens(float verticalFOV, float aspectRatio, float nearDistance, float farDistance)
 {
 	// set camera frustum parameters
@@ -26,7 +26,9 @@ public:
 public:
 	CameraComponent(float verticalFOV, float aspectRatio, float nearDistance, float farDistance, PositionComponent *positionComponent, const XMFLOAT3 &relativePosition, const XMFLOAT3 &relativeOrientationEulerAngles); 
 
-	void Init() override { EntitySystem::GetInstance().SetCamera(GetOwner()); }
+	~CameraComponent();
+
+	void Init() override;
 
 	void SetLens(float verticalFOV, float aspectRatio, float nearDistance, float farDistance);
 
@@ -42,6 +44,8 @@ public:
 
 	const XMFLOAT4X4 &GetProjectionMatrix() const { return mProjectionMatrix; }
 
+	float GetVerticalFOV() const { return mVerticalFOV; }
+	float GetAspectRatio() const { return mAspectRatio; }
 	float GetNearDistance() const { return mNearDistance; }
 	float GetFarDistance() const { return mFarDistance; }
 private:
@@ -1,8 +1,14 @@
 #include "CollisionComponent.h"
 #include "Entity.h"
 #include "PositionComponent.h"
+#include <atomic>
 
-CollisionComponent::CollisionComponent(Type type, const XMFLOAT3 &relativePosition) : mType(type), mRelativePosition(relativePosition)
+namespace
+{
+	std::atomic<uint64_t> nextColliderID(0);
+}
+
+CollisionComponent::CollisionComponent(Type type, const XMFLOAT3 &relativePosition) : mType(type), mID(nextColliderID++), mRelativePosition(relativePosition)
 {
 	XMStoreFloat4x4(&mOffsetMatrix, XMMatrixIdentity());
 
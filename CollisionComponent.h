@@ -3,18 +3,32 @@
 
 #include "Component.h"
 #include <DirectXMath.h>
+#include <cstdint>
+
+#ifdef FAST_DELEGATES
+	#include "fast delegates/delegate.hpp"
+#else
+	#include "delegates/delegate.hpp"
+#endif  // FAST_DELEGATES
 
 using namespace DirectX;
 
 class CollisionComponent : public Component
 {
+private:
+	MULTICAST_DELEGATE_ONE_PARAM(TriggerDelegate, Entity*);
+friend class CollisionSystem;
+
 public:
-	enum class Type { BOX, SPHERE, PLANE, };
+	enum class Type { BOX, SPHERE, PLANE, MESH, HEIGHTFIELD, };
 public:
 	CollisionComponent(Type type, const XMFLOAT3 &relativePosition);
 
 	Type GetType() const { return mType; }
 
+	// assigned at creation in increasing order and never reused, unlike addresses
+	uint64_t GetID() const { return mID; }
+
 	XMFLOAT3 const GetPosition() const;
 
 	const XMFLOAT3 GetAxis(int axis) const;
@@ -24,13 +38,50 @@ public:
 
 	void SetMovable(bool movable) { mIsMovable = movable; }
 	bool IsMovable() const { return mIsMovable; }
+
+	// collision filtering - a pair is tested only if the layer of each collider is in the mask of the other
+	void SetLayer(uint32_t layer) { mLayer = layer; }
+	uint32_t GetLayer() const { return mLayer; }
+	void SetMask(uint32_t mask) { mMask = mask; }
+	uint32_t GetMask() const { return mMask; }
+
+	bool CanCollide(const CollisionComponent *other) const { return (mLayer & other->mMask) && (other->mLayer & mMask); }
+
+	// trigger colliders generate no contacts, they report overlaps with the other colliders' owners
+	void SetTrigger(bool trigger) { mIsTrigger = trigger; }
+	bool IsTrigger() const { return mIsTrigger; }
+
+#ifdef FAST_DELEGATES
+	template <typename T, void (T::*MemFunPtr)(Entity*)>
+	void RegisterTriggerEnterEvent(T *instance) { mTriggerEnterEvent.Bind<T, MemFunPtr>(*instance); }
+	template <typename T, void (T::*MemFunPtr)(Entity*)>
+	void RegisterTriggerStayEvent(T *instance) { mTriggerStayEvent.Bind<T, MemFunPtr>(*instance); }
+	template <typename T, void (T::*MemFunPtr)(Entity*)>
+	void RegisterTriggerExitEvent(T *instance) { mTriggerExitEvent.Bind<T, MemFunPtr>(*instance); }
+#else
+	template <typename T>
+	void RegisterTriggerEnterEvent(T *instance, void (T::*ptr)(Entity*)) { mTriggerEnterEvent.Bind(*instance, ptr); }
+	template <typename T>
+	void RegisterTriggerStayEvent(T *instance, void (T::*ptr)(Entity*)) { mTriggerStayEvent.Bind(*instance, ptr); }
+	template <typename T>
+	void RegisterTriggerExitEvent(T *instance, void (T::*ptr)(Entity*)) { mTriggerExitEvent.Bind(*instance, ptr); }
+#endif  // FAST_DELEGATES
 private:
 	Type mType;
+	uint64_t mID;
 	
 	XMFLOAT3 mRelativePosition;
 	XMFLOAT4X4 mOffsetMatrix;
 
 	bool mIsMovable = false;
+
+	uint32_t mLayer = 1u;
+	uint32_t mMask = 0xFFFFFFFFu;
+
+	bool mIsTrigger = false;
+	TriggerDelegate mTriggerEnterEvent;
+	TriggerDelegate mTriggerStayEvent;
+	TriggerDelegate mTriggerExitEvent;
 };
 
 #endif  // COLLISION_COMPONENT_H
@@ -3,64 +3,331 @@
 #include "SphereCollisionComponent.h"
 #include "BoxCollisionComponent.h"
 #include "PlaneCollisionComponent.h"
+#include "MeshCollisionComponent.h"
+#include "HeightfieldCollisionComponent.h"
 
-#include "Picker.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 void CollisionSystem::DoCollisions()
 {
 	// check for collisions
+	UpdateBroadphase();
+	FindCollisionPairs();
+	GenerateContacts();
+
+	DispatchTriggerEvents();
+
+	// resolve collisions
+	if (mContacts.size())
+		ResolveContacts();
+}
+
+/**** broadphase ****/
+
+void CollisionSystem::UpdateBroadphase()
+{
+	// gather colliders
 	const Vector<Entity*> &entities = EntitySystem::GetInstance().GetEntities();
 
+	mColliders.clear();
+
 	for (int i = 0; i < entities.Size(); i++)
+		if (entities[i]->HasComponent<CollisionComponent>())
+			mColliders.push_back(entities[i]->GetComponent<CollisionComponent>());
+
+	// world bounds, padding entries are empty (min > max) so they never overlap anything
+	size_t paddedSize = (mColliders.size() + 3) & ~(size_t)3;
+
+	mBoundsMinX.assign(paddedSize, FLT_MAX); mBoundsMinY.assign(paddedSize, FLT_MAX); mBoundsMinZ.assign(paddedSize, FLT_MAX);
+	mBoundsMaxX.assign(paddedSize, -FLT_MAX); mBoundsMaxY.assign(paddedSize, -FLT_MAX); mBoundsMaxZ.assign(paddedSize, -FLT_MAX);
+
+	for (size_t i = 0; i < mColliders.size(); i++)
 	{
-		// picking
-		if (mPicker && entities[i]->HasComponent<CollisionComponent>())
+		XMFLOAT3 min(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		XMFLOAT3 max(FLT_MAX, FLT_MAX, FLT_MAX);
+
+		GetWorldBounds(mColliders[i], min, max);
+
+		mBoundsMinX[i] = min.x; mBoundsMinY[i] = min.y; mBoundsMinZ[i] = min.z;
+		mBoundsMaxX[i] = max.x; mBoundsMaxY[i] = max.y; mBoundsMaxZ[i] = max.z;
+	}
+}
+
+// returns false for unbounded colliders
+bool CollisionSystem::GetWorldBounds(const CollisionComponent *collider, XMFLOAT3 &min, XMFLOAT3 &max) const
+{
+	switch (collider->GetType())
+	{
+		case CollisionComponent::Type::SPHERE:
+		{
+			XMFLOAT3 center = collider->GetPosition();
+			float radius = static_cast<const SphereCollisionComponent*>(collider)->GetRadius();
+
+			min = XMFLOAT3(center.x - radius, center.y - radius, center.z - radius);
+			max = XMFLOAT3(center.x + radius, center.y + radius, center.z + radius);
+
+			return true;
+		}
+		case CollisionComponent::Type::BOX:
+		{
+			XMFLOAT3 center = collider->GetPosition();
+			XMFLOAT3 halfSize = static_cast<const BoxCollisionComponent*>(collider)->GetHalfSize();
+			XMFLOAT3 axes[3] = { collider->GetAxis(0), collider->GetAxis(1), collider->GetAxis(2) };
+
+			XMFLOAT3 extent;
+			extent.x = fabs(axes[0].x) * halfSize.x + fabs(axes[1].x) * halfSize.y + fabs(axes[2].x) * halfSize.z;
+			extent.y = fabs(axes[0].y) * halfSize.x + fabs(axes[1].y) * halfSize.y + fabs(axes[2].y) * halfSize.z;
+			extent.z = fabs(axes[0].z) * halfSize.x + fabs(axes[1].z) * halfSize.y + fabs(axes[2].z) * halfSize.z;
+
+			min = XMFLOAT3(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+			max = XMFLOAT3(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+
+			return true;
+		}
+		case CollisionComponent::Type::MESH:
 		{
-			CollisionComponent *collisionComponent = entities[i]->GetComponent<CollisionComponent>();
+			// transform the local bounds (center and extent) to world coordinates
+			const MeshBVH &bvh = static_cast<const MeshCollisionComponent*>(collider)->GetBVH();
+			XMFLOAT3 localMin = bvh.GetBoundsMin();
+			XMFLOAT3 localMax = bvh.GetBoundsMax();
+
+			XMFLOAT4X4 worldMatrix = collider->GetWorldMatrix();
+
+			XMFLOAT3 center;
+			XMStoreFloat3(&center, XMVector3Transform((XMLoadFloat3(&localMin) + XMLoadFloat3(&localMax)) * 0.5f, XMLoadFloat4x4(&worldMatrix)));
+
+			XMFLOAT3 halfSize((localMax.x - localMin.x) * 0.5f, (localMax.y - localMin.y) * 0.5f, (localMax.z - localMin.z) * 0.5f);
+
+			XMFLOAT3 extent;
+			extent.x = fabs(worldMatrix._11) * halfSize.x + fabs(worldMatrix._21) * halfSize.y + fabs(worldMatrix._31) * halfSize.z;
+			extent.y = fabs(worldMatrix._12) * halfSize.x + fabs(worldMatrix._22) * halfSize.y + fabs(worldMatrix._32) * halfSize.z;
+			extent.z = fabs(worldMatrix._13) * halfSize.x + fabs(worldMatrix._23) * halfSize.y + fabs(worldMatrix._33) * halfSize.z;
+
+			min = XMFLOAT3(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+			max = XMFLOAT3(center.x + extent.x, center.y + extent.y, center.z + extent.z);
 
-			if (collisionComponent->GetType() == CollisionComponent::Type::SPHERE)
-				RayAndSphereCollision(mPicker->GetRay(), mPicker->GetOrigin(), static_cast<SphereCollisionComponent*>(collisionComponent));
+			return true;
 		}
+		case CollisionComponent::Type::HEIGHTFIELD:
+			static_cast<const HeightfieldCollisionComponent*>(collider)->GetBounds(min, max);
+			return true;
+		default:   // PLANE
+			return false;
+	}
+}
+
+// pairs of colliders with overlapping bounds, ordered by collider index - each collider is tested against 4 others at a time
+void CollisionSystem::FindCollisionPairs()
+{
+	mCollisionPairs.clear();
+
+	unsigned int numColliders = (unsigned int)mColliders.size();
 
-		for (int j = i + 1; j < entities.Size(); j++)
+	for (unsigned int i = 0; i < numColliders; i++)
+	{
+		XMVECTOR minX = XMVectorReplicate(mBoundsMinX[i]), minY = XMVectorReplicate(mBoundsMinY[i]), minZ = XMVectorReplicate(mBoundsMinZ[i]);
+		XMVECTOR maxX = XMVectorReplicate(mBoundsMaxX[i]), maxY = XMVectorReplicate(mBoundsMaxY[i]), maxZ = XMVectorReplicate(mBoundsMaxZ[i]);
+
+		for (unsigned int j = (i + 1) & ~3u; j < numColliders; j += 4)
 		{
-			if (!entities[i]->HasComponent<CollisionComponent>() || !entities[j]->HasComponent<CollisionComponent>())
+			XMVECTOR overlap = XMVectorAndInt(XMVectorLessOrEqual(minX, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mBoundsMaxX[j]))), XMVectorGreaterOrEqual(maxX, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mBoundsMinX[j]))));
+			overlap = XMVectorAndInt(overlap, XMVectorAndInt(XMVectorLessOrEqual(minY, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mBoundsMaxY[j]))), XMVectorGreaterOrEqual(maxY, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mBoundsMinY[j])))));
+			overlap = XMVectorAndInt(overlap, XMVectorAndInt(XMVectorLessOrEqual(minZ, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mBoundsMaxZ[j]))), XMVectorGreaterOrEqual(maxZ, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mBoundsMinZ[j])))));
+
+			if (XMVector4EqualInt(overlap, XMVectorZero()))
 				continue;
 
-			CollisionComponent *collisionComponent1 = entities[i]->GetComponent<CollisionComponent>();
-			CollisionComponent *collisionComponent2 = entities[j]->GetComponent<CollisionComponent>();
+			uint32_t lanes[4];
+			XMStoreInt4(lanes, overlap);
 
-			// get collision geometry and calculate contacts
-			if (collisionComponent1->GetType() == CollisionComponent::Type::BOX && collisionComponent2->GetType() == CollisionComponent::Type::BOX)
-				BoxAndBoxCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<BoxCollisionComponent*>(collisionComponent2));
-			else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE && collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
-				SphereAndSphereCollision(static_cast<SphereCollisionComponent*>(collisionComponent1), static_cast<SphereCollisionComponent*>(collisionComponent2));
-			else if (collisionComponent1->GetType() == CollisionComponent::Type::PLANE)
-			{
-				if (collisionComponent2->GetType() == CollisionComponent::Type::BOX)
-					BoxAndHalfSpaceCollision(static_cast<BoxCollisionComponent*>(collisionComponent2), static_cast<PlaneCollisionComponent*>(collisionComponent1));
-				else if (collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
-					SphereAndHalfSpaceCollision(static_cast<SphereCollisionComponent*>(collisionComponent2), static_cast<PlaneCollisionComponent*>(collisionComponent1));
-			}
-			else if (collisionComponent2->GetType() == CollisionComponent::Type::PLANE)
+			for (unsigned int k = 0; k < 4; k++)
+				if (lanes[k] && j + k > i && j + k < numColliders && mColliders[i]->CanCollide(mColliders[j + k]))
+					mCollisionPairs.push_back(CollisionPair{ i, j + k });
+		}
+	}
+}
+
+/**** narrowphase - pairs are split in fixed size chunks, each chunk writes its own contact buffer ****/
+/**** buffers are concatenated in chunk order so the contact list is ordered by pair index whatever the number of threads ****/
+
+void CollisionSystem::GenerateContacts()
+{
+	unsigned int numChunks = ((unsigned int)mCollisionPairs.size() + PAIRS_PER_CHUNK - 1) / PAIRS_PER_CHUNK;
+
+	if (mChunkContacts.size() < numChunks)
+	{
+		mChunkContacts.resize(numChunks);
+		mChunkOverlaps.resize(numChunks);
+	}
+
+	ThreadPool::GetInstance().ParallelFor(numChunks, [this](unsigned int chunk)
+	{
+		std::vector<Contact> &contacts = mChunkContacts[chunk];
+		contacts.clear();
+
+		std::vector<CollisionPair> &overlaps = mChunkOverlaps[chunk];
+		overlaps.clear();
+
+		unsigned int firstPair = chunk * PAIRS_PER_CHUNK;
+		unsigned int lastPair = std::min(firstPair + PAIRS_PER_CHUNK, (unsigned int)mCollisionPairs.size());
+
+		for (unsigned int i = firstPair; i < lastPair; i++)
+		{
+			CollisionComponent *collisionComponent1 = mColliders[mCollisionPairs[i].collider1];
+			CollisionComponent *collisionComponent2 = mColliders[mCollisionPairs[i].collider2];
+
+			if (collisionComponent1->IsTrigger() || collisionComponent2->IsTrigger())
 			{
-				if (collisionComponent1->GetType() == CollisionComponent::Type::BOX)
-					BoxAndHalfSpaceCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<PlaneCollisionComponent*>(collisionComponent2));
-				else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE)
-					SphereAndHalfSpaceCollision(static_cast<SphereCollisionComponent*>(collisionComponent1), static_cast<PlaneCollisionComponent*>(collisionComponent2));
+				if (TestOverlap(collisionComponent1, collisionComponent2, contacts))
+					overlaps.push_back(mCollisionPairs[i]);
 			}
-			else if (collisionComponent1->GetType() == CollisionComponent::Type::BOX && collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
-				BoxAndSphereCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<SphereCollisionComponent*>(collisionComponent2));
-			else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE && collisionComponent2->GetType() == CollisionComponent::Type::BOX)
-				BoxAndSphereCollision(static_cast<BoxCollisionComponent*>(collisionComponent2), static_cast<SphereCollisionComponent*>(collisionComponent1));
+			else
+				GenerateContacts(collisionComponent1, collisionComponent2, contacts);
+		}
+	});
+
+	// merge contact and overlap buffers
+	mContacts.clear();
+	mTriggerOverlaps.clear();
+
+	for (unsigned int chunk = 0; chunk < numChunks; chunk++)
+	{
+		mContacts.insert(mContacts.end(), mChunkContacts[chunk].begin(), mChunkContacts[chunk].end());
+
+		for (const CollisionPair &overlap : mChunkOverlaps[chunk])
+		{
+			CollisionComponent *collisionComponent1 = mColliders[overlap.collider1];
+			CollisionComponent *collisionComponent2 = mColliders[overlap.collider2];
+
+			if (collisionComponent1->GetID() < collisionComponent2->GetID())
+				mTriggerOverlaps.push_back(TriggerOverlap{ collisionComponent1->GetID(), collisionComponent2->GetID(), collisionComponent1, collisionComponent2 });
+			else
+				mTriggerOverlaps.push_back(TriggerOverlap{ collisionComponent2->GetID(), collisionComponent1->GetID(), collisionComponent2, collisionComponent1 });
 		}
 	}
+}
+
+// sphere triggers use the exact overlap tests of the scene queries, the other shapes run the contact routines on a scratch area of the chunk buffer
+bool CollisionSystem::TestOverlap(CollisionComponent *collisionComponent1, CollisionComponent *collisionComponent2, std::vector<Contact> &scratchContacts)
+{
+	if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE)
+		return OverlapCollider(collisionComponent2, SphereQuery{ collisionComponent1->GetPosition(), static_cast<SphereCollisionComponent*>(collisionComponent1)->GetRadius() });
+	
+	if (collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
+		return OverlapCollider(collisionComponent1, SphereQuery{ collisionComponent2->GetPosition(), static_cast<SphereCollisionComponent*>(collisionComponent2)->GetRadius() });
 
-	mPicker = nullptr;
+	size_t numContacts = scratchContacts.size();
+	GenerateContacts(collisionComponent1, collisionComponent2, scratchContacts);
 
-	// resolve collisions
-	if (mContacts.Size())
-		ResolveContacts();
+	bool overlap = scratchContacts.size() > numContacts;
+	scratchContacts.erase(scratchContacts.begin() + numContacts, scratchContacts.end());
+
+	return overlap;
+}
+
+// overlaps are ordered by collider id so that events are dispatched in the same order on every run. a collider is alive if its
+// id is, ids aren't reused so a collider created at the address of a removed one is never taken for it
+void CollisionSystem::DispatchTriggerEvents()
+{
+	std::sort(mTriggerOverlaps.begin(), mTriggerOverlaps.end());
+
+	mColliderIDs.clear();
+	for (CollisionComponent *collider : mColliders)
+		mColliderIDs.push_back(collider->GetID());
+
+	std::sort(mColliderIDs.begin(), mColliderIDs.end());
+
+	auto exists = [this](uint64_t id) { return std::binary_search(mColliderIDs.begin(), mColliderIDs.end(), id); };
+
+	auto dispatch = [](const TriggerOverlap &overlap, CollisionComponent::TriggerDelegate CollisionComponent::*event)
+	{
+		if (overlap.collider1->IsTrigger())
+			(overlap.collider1->*event).Invoke(overlap.collider2->GetOwner());
+		if (overlap.collider2->IsTrigger())
+			(overlap.collider2->*event).Invoke(overlap.collider1->GetOwner());
+	};
+
+	// both lists are sorted: walk them together
+	size_t current = 0, previous = 0;
+
+	while (current < mTriggerOverlaps.size() || previous < mPreviousTriggerOverlaps.size())
+	{
+		if (previous == mPreviousTriggerOverlaps.size() || (current < mTriggerOverlaps.size() && mTriggerOverlaps[current] < mPreviousTriggerOverlaps[previous]))
+			dispatch(mTriggerOverlaps[current++], &CollisionComponent::mTriggerEnterEvent);
+		else if (current == mTriggerOverlaps.size() || mPreviousTriggerOverlaps[previous] < mTriggerOverlaps[current])
+		{
+			// colliders removed since the previous frame get no exit event
+			const TriggerOverlap &overlap = mPreviousTriggerOverlaps[previous++];
+
+			if (exists(overlap.id1) && exists(overlap.id2))
+				dispatch(overlap, &CollisionComponent::mTriggerExitEvent);
+		}
+		else
+		{
+			dispatch(mTriggerOverlaps[current++], &CollisionComponent::mTriggerStayEvent);
+			previous++;
+		}
+	}
+
+	mPreviousTriggerOverlaps.swap(mTriggerOverlaps);
+}
+
+// dispatch on collision geometry and calculate contacts
+void CollisionSystem::GenerateContacts(CollisionComponent *collisionComponent1, CollisionComponent *collisionComponent2, std::vector<Contact> &contacts)
+{
+	if (collisionComponent1->GetType() == CollisionComponent::Type::BOX && collisionComponent2->GetType() == CollisionComponent::Type::BOX)
+		BoxAndBoxCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<BoxCollisionComponent*>(collisionComponent2), contacts);
+	else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE && collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
+		SphereAndSphereCollision(static_cast<SphereCollisionComponent*>(collisionComponent1), static_cast<SphereCollisionComponent*>(collisionComponent2), contacts);
+	else if (collisionComponent1->GetType() == CollisionComponent::Type::PLANE)
+	{
+		if (collisionComponent2->GetType() == CollisionComponent::Type::BOX)
+			BoxAndHalfSpaceCollision(static_cast<BoxCollisionComponent*>(collisionComponent2), static_cast<PlaneCollisionComponent*>(collisionComponent1), contacts);
+		else if (collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
+			SphereAndHalfSpaceCollision(static_cast<SphereCollisionComponent*>(collisionComponent2), static_cast<PlaneCollisionComponent*>(collisionComponent1), contacts);
+	}
+	else if (collisionComponent2->GetType() == CollisionComponent::Type::PLANE)
+	{
+		if (collisionComponent1->GetType() == CollisionComponent::Type::BOX)
+			BoxAndHalfSpaceCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<PlaneCollisionComponent*>(collisionComponent2), contacts);
+		else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE)
+			SphereAndHalfSpaceCollision(static_cast<SphereCollisionComponent*>(collisionComponent1), static_cast<PlaneCollisionComponent*>(collisionComponent2), contacts);
+	}
+	else if (collisionComponent1->GetType() == CollisionComponent::Type::MESH)
+	{
+		if (collisionComponent2->GetType() == CollisionComponent::Type::BOX)
+			BoxAndMeshCollision(static_cast<BoxCollisionComponent*>(collisionComponent2), static_cast<MeshCollisionComponent*>(collisionComponent1), contacts);
+		else if (collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
+			SphereAndMeshCollision(static_cast<SphereCollisionComponent*>(collisionComponent2), static_cast<MeshCollisionComponent*>(collisionComponent1), contacts);
+	}
+	else if (collisionComponent2->GetType() == CollisionComponent::Type::MESH)
+	{
+		if (collisionComponent1->GetType() == CollisionComponent::Type::BOX)
+			BoxAndMeshCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<MeshCollisionComponent*>(collisionComponent2), contacts);
+		else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE)
+			SphereAndMeshCollision(static_cast<SphereCollisionComponent*>(collisionComponent1), static_cast<MeshCollisionComponent*>(collisionComponent2), contacts);
+	}
+	else if (collisionComponent1->GetType() == CollisionComponent::Type::HEIGHTFIELD)
+	{
+		if (collisionComponent2->GetType() == CollisionComponent::Type::BOX)
+			BoxAndHeightfieldCollision(static_cast<BoxCollisionComponent*>(collisionComponent2), static_cast<HeightfieldCollisionComponent*>(collisionComponent1), contacts);
+		else if (collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
+			SphereAndHeightfieldCollision(static_cast<SphereCollisionComponent*>(collisionComponent2), static_cast<HeightfieldCollisionComponent*>(collisionComponent1), contacts);
+	}
+	else if (collisionComponent2->GetType() == CollisionComponent::Type::HEIGHTFIELD)
+	{
+		if (collisionComponent1->GetType() == CollisionComponent::Type::BOX)
+			BoxAndHeightfieldCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<HeightfieldCollisionComponent*>(collisionComponent2), contacts);
+		else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE)
+			SphereAndHeightfieldCollision(static_cast<SphereCollisionComponent*>(collisionComponent1), static_cast<HeightfieldCollisionComponent*>(collisionComponent2), contacts);
+	}
+	else if (collisionComponent1->GetType() == CollisionComponent::Type::BOX && collisionComponent2->GetType() == CollisionComponent::Type::SPHERE)
+		BoxAndSphereCollision(static_cast<BoxCollisionComponent*>(collisionComponent1), static_cast<SphereCollisionComponent*>(collisionComponent2), contacts);
+	else if (collisionComponent1->GetType() == CollisionComponent::Type::SPHERE && collisionComponent2->GetType() == CollisionComponent::Type::BOX)
+		BoxAndSphereCollision(static_cast<BoxCollisionComponent*>(collisionComponent2), static_cast<SphereCollisionComponent*>(collisionComponent1), contacts);
 }
 
 /**** contact resolver routine ****/
@@ -69,8 +336,8 @@ void CollisionSystem::ResolveContacts()
 	static int numIterationPosition = 5;
 	static int numIterationVelocity = 5; 
 
-	for (Contact *contact : mContacts)
-		contact->CalculateContactData();
+	for (Contact &contact : mContacts)
+		contact.CalculateContactData();
 
 	// resolve interpenetrations 
 	while (numIterationPosition--)
@@ -79,11 +346,11 @@ void CollisionSystem::ResolveContacts()
 		float currentPenetration = 0.01f;  // threshold for interpenetration
 		int index = -1;
 
-		for (int i = 0; i < mContacts.Size(); i++)
+		for (int i = 0; i < mContacts.size(); i++)
 		{
-			if (mContacts[i]->mPenetration > currentPenetration)
+			if (mContacts[i].mPenetration > currentPenetration)
 			{
-				currentPenetration = mContacts[i]->mPenetration;
+				currentPenetration = mContacts[i].mPenetration;
 				index = i;
 			}
 		}
@@ -97,26 +364,26 @@ void CollisionSystem::ResolveContacts()
 		XMFLOAT3 deltaOrientation[2];
 
 		// resolve interpenetration - apply displacement
-		//mContacts[index]->MatchAwakeState();
-		mContacts[index]->ResolveInterpenetration(deltaPosition, deltaOrientation);
+		//mContacts[index].MatchAwakeState();
+		mContacts[index].ResolveInterpenetration(deltaPosition, deltaOrientation);
 
 		// update other penetrations in contact set (entities in contact with resolved entities)
-		for (int i = 0; i < mContacts.Size(); i++)
+		for (int i = 0; i < mContacts.size(); i++)
 			for (int j = 0; j < 2; j++)
-				if (mContacts[i]->mEntities[j])
+				if (mContacts[i].mEntities[j])
 					for (int k = 0; k < 2; k++)
-						if (mContacts[i]->mEntities[j] == mContacts[index]->mEntities[k])
+						if (mContacts[i].mEntities[j] == mContacts[index].mEntities[k])
 						{
 							XMVECTOR deltaContactPointPositionLinear = XMLoadFloat3(&deltaPosition[k]);
-							XMVECTOR deltaContactPointPositionAngular = XMVector3Cross(XMLoadFloat3(&deltaOrientation[k]), XMLoadFloat3(&mContacts[i]->mContactPointOffset[j]));
+							XMVECTOR deltaContactPointPositionAngular = XMVector3Cross(XMLoadFloat3(&deltaOrientation[k]), XMLoadFloat3(&mContacts[i].mContactPointOffset[j]));
 							XMVECTOR deltaContactPointPosition = deltaContactPointPositionLinear + deltaContactPointPositionAngular;
 
-							float delta = XMVectorGetX(XMVector3Dot(deltaContactPointPosition, XMLoadFloat3(&mContacts[i]->mContactNormal)));
+							float delta = XMVectorGetX(XMVector3Dot(deltaContactPointPosition, XMLoadFloat3(&mContacts[i].mContactNormal)));
 
 							if (j == 0)
-								mContacts[i]->mPenetration -= delta;
+								mContacts[i].mPenetration -= delta;
 							else  // j == 1
-								mContacts[i]->mPenetration += delta;
+								mContacts[i].mPenetration += delta;
 						}
 	}
 
@@ -126,11 +393,11 @@ void CollisionSystem::ResolveContacts()
 		float currentDeltaClosingVelocity = -0.01f;   // threshold for delta closing velocity
 		int index = -1;
 
-		for (int i = 0; i < mContacts.Size(); i++)
+		for (int i = 0; i < mContacts.size(); i++)
 		{
-			if (mContacts[i]->mDeltaClosingVelocity < currentDeltaClosingVelocity)
+			if (mContacts[i].mDeltaClosingVelocity < currentDeltaClosingVelocity)
 			{
-				currentDeltaClosingVelocity = mContacts[i]->mDeltaClosingVelocity;
+				currentDeltaClosingVelocity = mContacts[i].mDeltaClosingVelocity;
 				index = i;
 			}
 		}
@@ -143,25 +410,25 @@ void CollisionSystem::ResolveContacts()
 		XMFLOAT3 deltaAngularVelocity[2];
 
 		// resolve velocity - apply impulse
-		//mContacts[index]->MatchAwakeState();
-		mContacts[index]->ResolveVelocity(deltaLinearVelocity, deltaAngularVelocity);
+		//mContacts[index].MatchAwakeState();
+		mContacts[index].ResolveVelocity(deltaLinearVelocity, deltaAngularVelocity);
 
 		// update other closing velocities in contact set (entities in contact with resolved entities)
-		for (int i = 0; i < mContacts.Size(); i++)
+		for (int i = 0; i < mContacts.size(); i++)
 			for (int j = 0; j < 2; j++)
-				if (mContacts[i]->mEntities[j])
+				if (mContacts[i].mEntities[j])
 					for (int k = 0; k < 2; k++)
-						if (mContacts[i]->mEntities[j] == mContacts[index]->mEntities[k])
+						if (mContacts[i].mEntities[j] == mContacts[index].mEntities[k])
 						{
-							XMVECTOR deltaContactPointVelocity = XMLoadFloat3(&deltaLinearVelocity[k]) + XMVector3Cross(XMLoadFloat3(&deltaAngularVelocity[k]), XMLoadFloat3(&mContacts[i]->mContactPointOffset[j]));
+							XMVECTOR deltaContactPointVelocity = XMLoadFloat3(&deltaLinearVelocity[k]) + XMVector3Cross(XMLoadFloat3(&deltaAngularVelocity[k]), XMLoadFloat3(&mContacts[i].mContactPointOffset[j]));
 
 							if (j == 0)
-								XMStoreFloat3(&mContacts[i]->mContactPointRelativeVelocityLocal, XMLoadFloat3(&mContacts[i]->mContactPointRelativeVelocityLocal) + deltaContactPointVelocity);
+								XMStoreFloat3(&mContacts[i].mContactPointRelativeVelocityLocal, XMLoadFloat3(&mContacts[i].mContactPointRelativeVelocityLocal) + deltaContactPointVelocity);
 							else  // j == 1
-								XMStoreFloat3(&mContacts[i]->mContactPointRelativeVelocityLocal, XMLoadFloat3(&mContacts[i]->mContactPointRelativeVelocityLocal) - deltaContactPointVelocity);
+								XMStoreFloat3(&mContacts[i].mContactPointRelativeVelocityLocal, XMLoadFloat3(&mContacts[i].mContactPointRelativeVelocityLocal) - deltaContactPointVelocity);
 
 							// update contact point delta relative velocity
-							mContacts[i]->mDeltaClosingVelocity = -XMVectorGetX(XMVector3Dot(-XMLoadFloat3(&mContacts[i]->mContactNormal), XMLoadFloat3(&mContacts[i]->mContactPointRelativeVelocityLocal))) * (1 + mContacts[i]->mCoefficientOfRestitution);
+							mContacts[i].mDeltaClosingVelocity = -XMVectorGetX(XMVector3Dot(-XMLoadFloat3(&mContacts[i].mContactNormal), XMLoadFloat3(&mContacts[i].mContactPointRelativeVelocityLocal))) * (1 + mContacts[i].mCoefficientOfRestitution);
 						}
 	}
 
@@ -181,7 +448,7 @@ void CollisionSystem::ResolveContacts()
 	//}
 
 	// clear contacts buffer
-	mContacts.Clear();
+	mContacts.clear();
 }
 
 /**** separating axis theorem ****/
@@ -270,7 +537,7 @@ float CollisionSystem::PerformSAT(const XMFLOAT3 &axis, BoxCollisionComponent *b
 /**** collision detection / contact data generation algorithms ****/
 
 #include <limits>
-void CollisionSystem::BoxAndBoxCollision(BoxCollisionComponent *box1, BoxCollisionComponent *box2)
+void CollisionSystem::BoxAndBoxCollision(BoxCollisionComponent *box1, BoxCollisionComponent *box2, std::vector<Contact> &contacts)
 {
 	XMFLOAT3 contactPoint;
 	XMFLOAT3 contactNormal;
@@ -473,10 +740,10 @@ void CollisionSystem::BoxAndBoxCollision(BoxCollisionComponent *box1, BoxCollisi
 	}
 
 	// store contact
-	mContacts.InsertLast(new Contact(contactPoint, contactNormal, penetration, box1->GetOwner(), box2->GetOwner()));
+	contacts.push_back(Contact(contactPoint, contactNormal, penetration, box1->GetOwner(), box2->GetOwner()));
 }
 
-void CollisionSystem::SphereAndSphereCollision(SphereCollisionComponent *sphere1, SphereCollisionComponent *sphere2)
+void CollisionSystem::SphereAndSphereCollision(SphereCollisionComponent *sphere1, SphereCollisionComponent *sphere2, std::vector<Contact> &contacts)
 {
 	// get primitives' data
 	XMFLOAT3 sphereCenter1 = sphere1->GetPosition();
@@ -503,10 +770,10 @@ void CollisionSystem::SphereAndSphereCollision(SphereCollisionComponent *sphere1
 	float penetration = (sphereRadius1 + sphereRadius2) - distance;
 
 	// add contact to list
-	mContacts.InsertLast(new Contact(contactPoint, contactNormal, penetration, sphere1->GetOwner(), sphere2->GetOwner()));
+	contacts.push_back(Contact(contactPoint, contactNormal, penetration, sphere1->GetOwner(), sphere2->GetOwner()));
 }
 
-void CollisionSystem::SphereAndHalfSpaceCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane)
+void CollisionSystem::SphereAndHalfSpaceCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane, std::vector<Contact> &contacts)
 {
 	// get primitives' data
 	XMFLOAT3 sphereCenter = sphere->GetPosition();
@@ -533,10 +800,10 @@ void CollisionSystem::SphereAndHalfSpaceCollision(SphereCollisionComponent *sphe
 	float penetration = sphereRadius - distance;
 
 	// add contact to list
-	mContacts.InsertLast(new Contact(contactPoint, contactNormal, penetration, sphere->GetOwner(), nullptr));
+	contacts.push_back(Contact(contactPoint, contactNormal, penetration, sphere->GetOwner(), nullptr));
 }
 
-void CollisionSystem::SphereAndPlaneCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane)
+void CollisionSystem::SphereAndPlaneCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane, std::vector<Contact> &contacts)
 {
 	// get primitives' data
 	XMFLOAT3 sphereCenter = sphere->GetPosition();
@@ -569,10 +836,10 @@ void CollisionSystem::SphereAndPlaneCollision(SphereCollisionComponent *sphere,
 	float penetration = sphereRadius - distance;
 
 	// add contact to list
-	mContacts.InsertLast(new Contact(contactPoint, contactNormal, penetration, sphere->GetOwner(), nullptr));
+	contacts.push_back(Contact(contactPoint, contactNormal, penetration, sphere->GetOwner(), nullptr));
 }
 
-void CollisionSystem::BoxAndHalfSpaceCollision(BoxCollisionComponent *box, PlaneCollisionComponent *plane)
+void CollisionSystem::BoxAndHalfSpaceCollision(BoxCollisionComponent *box, PlaneCollisionComponent *plane, std::vector<Contact> &contacts)
 {
 	// get primitives' data
 	XMFLOAT3 boxHalfSize = box->GetHalfSize();
@@ -625,11 +892,11 @@ void CollisionSystem::BoxAndHalfSpaceCollision(BoxCollisionComponent *box, Plane
 		float penetration = -distance;
 
 		// add contact to list
-		mContacts.InsertLast(new Contact(contactPoint, contactNormal, penetration, box->GetOwner(), nullptr));
+		contacts.push_back(Contact(contactPoint, contactNormal, penetration, box->GetOwner(), nullptr));
 	}
 }
 
-void CollisionSystem::BoxAndSphereCollision(BoxCollisionComponent *box, SphereCollisionComponent *sphere)
+void CollisionSystem::BoxAndSphereCollision(BoxCollisionComponent *box, SphereCollisionComponent *sphere, std::vector<Contact> &contacts)
 {
 	// get primitives' data
 	XMFLOAT3 boxPosition = box->GetPosition();
@@ -700,56 +967,750 @@ void CollisionSystem::BoxAndSphereCollision(BoxCollisionComponent *box, SphereCo
 	float penetration = sphereRadius - closestDistance;
 
 	// add contact to list
-	mContacts.InsertLast(new Contact(contactPoint, contactNormal, penetration, box->GetOwner(), sphere->GetOwner()));
+	contacts.push_back(Contact(contactPoint, contactNormal, penetration, box->GetOwner(), sphere->GetOwner()));
 }
 
-#include "MotionComponent.h"
-
-void CollisionSystem::RayAndSphereCollision(const XMFLOAT3 &ray, const XMFLOAT3 &origin, const SphereCollisionComponent *sphere)
+void CollisionSystem::SphereAndMeshCollision(SphereCollisionComponent *sphere, MeshCollisionComponent *mesh, std::vector<Contact> &contacts)
 {
+	// get primitives' data
 	XMFLOAT3 sphereCenter = sphere->GetPosition();
-	XMVECTOR sphereCenterV = XMLoadFloat3(&sphereCenter);
 	float sphereRadius = sphere->GetRadius();
 
-	XMVECTOR rayOriginV = XMLoadFloat3(&origin);
-	XMVECTOR rayDirectionV = XMLoadFloat3(&ray);
+	// transform sphere center into mesh local coordinates (mesh scale is baked into the BVH)
+	XMFLOAT4X4 meshInverseWorldMatrix = mesh->GetInverseWorldMatrix();
 
-	float a = 1.0f;
-	float b = 2.0f * XMVectorGetX(XMVector3Dot((rayOriginV - sphereCenterV), rayDirectionV));
-	float c = XMVectorGetX(XMVector3LengthSq(rayOriginV - sphereCenterV)) - sphereRadius * sphereRadius;
-	float delta = b * b - 4.0f * a * c;
+	XMFLOAT3 sphereCenterMesh;
+	XMStoreFloat3(&sphereCenterMesh, XMVector3Transform(XMLoadFloat3(&sphereCenter), XMLoadFloat4x4(&meshInverseWorldMatrix)));
 
-	if (delta < 0)  // no collision - early out
-		return;
+	Vector<MeshBVH::Contact> meshContacts;
+	mesh->GetBVH().SphereContacts(sphereCenterMesh, sphereRadius, meshContacts);
+
+	// transform contacts back to world coordinates
+	XMFLOAT4X4 meshWorldMatrix = mesh->GetWorldMatrix();
+	XMMATRIX meshWorldMatrixM = XMLoadFloat4x4(&meshWorldMatrix);
 
-	if (delta == 0.0f)  // tangent point collision
+	for (const MeshBVH::Contact &meshContact : meshContacts)
 	{
+		XMFLOAT3 contactPoint;
+		XMStoreFloat3(&contactPoint, XMVector3Transform(XMLoadFloat3(&meshContact.point), meshWorldMatrixM));
+
+		XMFLOAT3 contactNormal;
+		XMStoreFloat3(&contactNormal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&meshContact.normal), meshWorldMatrixM)));  // directed from mesh to sphere
 
+		// add contact to list - the mesh is static
+		contacts.push_back(Contact(contactPoint, contactNormal, meshContact.penetration, sphere->GetOwner(), nullptr));
 	}
-	else  // delta > 0
+}
+
+void CollisionSystem::BoxAndMeshCollision(BoxCollisionComponent *box, MeshCollisionComponent *mesh, std::vector<Contact> &contacts)
+{
+	// get primitives' data
+	XMFLOAT3 boxPosition = box->GetPosition();
+	XMFLOAT3 boxHalfSize = box->GetHalfSize();
+
+	// transform box center and axes into mesh local coordinates
+	XMFLOAT4X4 meshInverseWorldMatrix = mesh->GetInverseWorldMatrix();
+	XMMATRIX meshInverseWorldMatrixM = XMLoadFloat4x4(&meshInverseWorldMatrix);
+
+	XMFLOAT3 boxPositionMesh;
+	XMStoreFloat3(&boxPositionMesh, XMVector3Transform(XMLoadFloat3(&boxPosition), meshInverseWorldMatrixM));
+
+	XMFLOAT3 boxAxesMesh[3];
+	for (int i = 0; i < 3; i++)
 	{
-		float t1 = (-b - sqrt(delta)) / 2.0f;
-		float t2 = (-b + sqrt(delta)) / 2.0f;
+		XMFLOAT3 axis = box->GetAxis(i);
+		XMStoreFloat3(&boxAxesMesh[i], XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&axis), meshInverseWorldMatrixM)));
+	}
 
-		// min t
-		float t = t1 < t2 ? t1 : t2;
+	Vector<MeshBVH::Contact> meshContacts;
+	mesh->GetBVH().BoxContacts(boxPositionMesh, boxAxesMesh, boxHalfSize, meshContacts);
 
-		if (t < 0.0f)   // intersection point is behind ray origin
-			return;
+	// transform contacts back to world coordinates
+	XMFLOAT4X4 meshWorldMatrix = mesh->GetWorldMatrix();
+	XMMATRIX meshWorldMatrixM = XMLoadFloat4x4(&meshWorldMatrix);
 
+	for (const MeshBVH::Contact &meshContact : meshContacts)
+	{
 		XMFLOAT3 contactPoint;
-		XMStoreFloat3(&contactPoint, rayOriginV + t * rayDirectionV);
+		XMStoreFloat3(&contactPoint, XMVector3Transform(XMLoadFloat3(&meshContact.point), meshWorldMatrixM));
 
 		XMFLOAT3 contactNormal;
-		XMStoreFloat3(&contactNormal, rayDirectionV);
+		XMStoreFloat3(&contactNormal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&meshContact.normal), meshWorldMatrixM)));  // directed from mesh to box
+
+		// add contact to list - the mesh is static
+		contacts.push_back(Contact(contactPoint, contactNormal, meshContact.penetration, box->GetOwner(), nullptr));
+	}
+}
+
+void CollisionSystem::SphereAndHeightfieldCollision(SphereCollisionComponent *sphere, HeightfieldCollisionComponent *heightfield, std::vector<Contact> &contacts)
+{
+	// heightfield contacts are generated in world coordinates
+	Vector<HeightfieldCollisionComponent::Contact> heightfieldContacts;
+	heightfield->SphereContacts(sphere->GetPosition(), sphere->GetRadius(), heightfieldContacts);
+
+	// add contacts to list - the terrain is static
+	for (const HeightfieldCollisionComponent::Contact &heightfieldContact : heightfieldContacts)
+		contacts.push_back(Contact(heightfieldContact.point, heightfieldContact.normal, heightfieldContact.penetration, sphere->GetOwner(), nullptr));
+}
+
+void CollisionSystem::BoxAndHeightfieldCollision(BoxCollisionComponent *box, HeightfieldCollisionComponent *heightfield, std::vector<Contact> &contacts)
+{
+	XMFLOAT3 boxAxes[3] = { box->GetAxis(0), box->GetAxis(1), box->GetAxis(2) };
+
+	Vector<HeightfieldCollisionComponent::Contact> heightfieldContacts;
+	heightfield->BoxContacts(box->GetPosition(), boxAxes, box->GetHalfSize(), heightfieldContacts);
+
+	// add contacts to list - the terrain is static
+	for (const HeightfieldCollisionComponent::Contact &heightfieldContact : heightfieldContacts)
+		contacts.push_back(Contact(heightfieldContact.point, heightfieldContact.normal, heightfieldContact.penetration, box->GetOwner(), nullptr));
+}
+
+
+/**** scene queries - queries are processed in parallel tasks. a bounding volume hierarchy over the collider bounds is built ****/
+/**** at the start of each batch, each task traverses it with packets of 4 rays/sweeps tested against the node bounds at once ****/
+
+namespace
+{
+	struct QueryPacket
+	{
+		XMVECTOR originX, originY, originZ;
+		XMVECTOR inverseDirectionX, inverseDirectionY, inverseDirectionZ;
+		XMVECTOR radius;
+	};
+
+	// slab test of the 4 queries against bounds inflated by the sweep radius, returns the mask of the lanes that hit them
+	XMVECTOR IntersectBounds(const QueryPacket &packet, const XMFLOAT4 &maxDistance, float minX, float minY, float minZ, float maxX, float maxY, float maxZ)
+	{
+		XMVECTOR t1 = (XMVectorReplicate(minX) - packet.radius - packet.originX) * packet.inverseDirectionX;
+		XMVECTOR t2 = (XMVectorReplicate(maxX) + packet.radius - packet.originX) * packet.inverseDirectionX;
+		XMVECTOR tNear = XMVectorMin(t1, t2), tFar = XMVectorMax(t1, t2);
+
+		t1 = (XMVectorReplicate(minY) - packet.radius - packet.originY) * packet.inverseDirectionY;
+		t2 = (XMVectorReplicate(maxY) + packet.radius - packet.originY) * packet.inverseDirectionY;
+		tNear = XMVectorMax(tNear, XMVectorMin(t1, t2)); tFar = XMVectorMin(tFar, XMVectorMax(t1, t2));
+
+		t1 = (XMVectorReplicate(minZ) - packet.radius - packet.originZ) * packet.inverseDirectionZ;
+		t2 = (XMVectorReplicate(maxZ) + packet.radius - packet.originZ) * packet.inverseDirectionZ;
+		tNear = XMVectorMax(tNear, XMVectorMin(t1, t2)); tFar = XMVectorMin(tFar, XMVectorMax(t1, t2));
+
+		tNear = XMVectorMax(tNear, XMVectorZero());
+		tFar = XMVectorMin(tFar, XMLoadFloat4(&maxDistance));
+
+		return XMVectorLessOrEqual(tNear, tFar);
+	}
+}
+
+void CollisionSystem::RayCast(const std::vector<RayQuery> &queries, QueryMode mode, QueryResults &results)
+{
+	mRayQueries.resize(queries.size());
+
+	for (size_t i = 0; i < queries.size(); i++)
+		mRayQueries[i] = SweepQuery{ queries[i].origin, queries[i].direction, queries[i].maxDistance, 0.0f, queries[i].mask, queries[i].includeTriggers };
+
+	CastSpheres(mRayQueries, mode, results);
+}
+
+void CollisionSystem::SweepSphere(const std::vector<SweepQuery> &queries, QueryMode mode, QueryResults &results)
+{
+	CastSpheres(queries, mode, results);
+}
+
+// gathers the colliders and their bounds as they are now and builds the hierarchy over them
+void CollisionSystem::BuildQueryTree()
+{
+	UpdateBroadphase();
+
+	mQueryNodes.clear();
+	mQueryColliders.clear();
+	mUnboundedColliders.clear();
+
+	for (unsigned int i = 0; i < (unsigned int)mColliders.size(); i++)
+	{
+		if (mBoundsMinX[i] == -FLT_MAX)
+			mUnboundedColliders.push_back(i);
+		else
+			mQueryColliders.push_back(i);
+	}
+
+	if (mQueryColliders.size())
+		BuildQueryNode(0, (unsigned int)mQueryColliders.size());
+}
+
+// filtering happens before the exact tests
+bool CollisionSystem::AcceptCollider(const CollisionComponent *collider, uint32_t mask, bool includeTriggers)
+{
+	return (collider->GetLayer() & mask) && (includeTriggers || !collider->IsTrigger());
+}
+
+// median split along the longest axis of the collider centers - the depth is at most log2 of the number of leaves
+unsigned int CollisionSystem::BuildQueryNode(unsigned int first, unsigned int count)
+{
+	unsigned int nodeIndex = (unsigned int)mQueryNodes.size();
+	mQueryNodes.push_back(QueryNode());
 
-		XMFLOAT3 velocity;
-		XMStoreFloat3(&velocity, rayDirectionV * 3.0f);
+	XMFLOAT3 min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	XMFLOAT3 centerMin(FLT_MAX, FLT_MAX, FLT_MAX), centerMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 
-		sphere->GetOwner()->GetComponent<MotionComponent>()->AddVelocity(velocity);
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		unsigned int collider = mQueryColliders[i];
+
+		min.x = std::min(min.x, mBoundsMinX[collider]); max.x = std::max(max.x, mBoundsMaxX[collider]);
+		min.y = std::min(min.y, mBoundsMinY[collider]); max.y = std::max(max.y, mBoundsMaxY[collider]);
+		min.z = std::min(min.z, mBoundsMinZ[collider]); max.z = std::max(max.z, mBoundsMaxZ[collider]);
+
+		XMFLOAT3 center((mBoundsMinX[collider] + mBoundsMaxX[collider]) * 0.5f, (mBoundsMinY[collider] + mBoundsMaxY[collider]) * 0.5f, (mBoundsMinZ[collider] + mBoundsMaxZ[collider]) * 0.5f);
+
+		centerMin.x = std::min(centerMin.x, center.x); centerMax.x = std::max(centerMax.x, center.x);
+		centerMin.y = std::min(centerMin.y, center.y); centerMax.y = std::max(centerMax.y, center.y);
+		centerMin.z = std::min(centerMin.z, center.z); centerMax.z = std::max(centerMax.z, center.z);
+	}
+
+	mQueryNodes[nodeIndex].min = min;
+	mQueryNodes[nodeIndex].max = max;
+
+	if (count <= COLLIDERS_PER_LEAF)
+	{
+		mQueryNodes[nodeIndex].first = first;
+		mQueryNodes[nodeIndex].count = count;
+		mQueryNodes[nodeIndex].axis = 0;
+
+		return nodeIndex;
+	}
+
+	XMFLOAT3 extent(centerMax.x - centerMin.x, centerMax.y - centerMin.y, centerMax.z - centerMin.z);
+	unsigned int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+	const std::vector<float> &boundsMin = axis == 0 ? mBoundsMinX : (axis == 1 ? mBoundsMinY : mBoundsMinZ);
+	const std::vector<float> &boundsMax = axis == 0 ? mBoundsMaxX : (axis == 1 ? mBoundsMaxY : mBoundsMaxZ);
+
+	// ties are broken by collider index so that the tree doesn't depend on the sort implementation
+	unsigned int half = count / 2;
+	std::nth_element(mQueryColliders.begin() + first, mQueryColliders.begin() + first + half, mQueryColliders.begin() + first + count, [&](unsigned int collider1, unsigned int collider2)
+	{
+		float center1 = boundsMin[collider1] + boundsMax[collider1];
+		float center2 = boundsMin[collider2] + boundsMax[collider2];
+
+		return center1 < center2 || (center1 == center2 && collider1 < collider2);
+	});
+
+	BuildQueryNode(first, half);
+	unsigned int secondChild = BuildQueryNode(first + half, count - half);
+
+	mQueryNodes[nodeIndex].first = secondChild;
+	mQueryNodes[nodeIndex].count = 0;
+	mQueryNodes[nodeIndex].axis = axis;
+
+	return nodeIndex;
+}
+
+void CollisionSystem::CastSpheres(const std::vector<SweepQuery> &queries, QueryMode mode, QueryResults &results)
+{
+	BuildQueryTree();
+
+	unsigned int numQueries = (unsigned int)queries.size();
+	unsigned int numTasks = (numQueries + QUERIES_PER_TASK - 1) / QUERIES_PER_TASK;
+
+	if (mTaskHits.size() < numTasks)
+		mTaskHits.resize(numTasks);
+
+	ThreadPool::GetInstance().ParallelFor(numTasks, [&](unsigned int task)
+	{
+		std::vector<QueryHit> &taskHits = mTaskHits[task];
+		taskHits.clear();
+
+		unsigned int firstQuery = task * QUERIES_PER_TASK;
+		unsigned int lastQuery = std::min(firstQuery + QUERIES_PER_TASK, numQueries);
+
+		std::vector<QueryHit> laneHits[4];
+
+		for (unsigned int packet = firstQuery; packet < lastQuery; packet += 4)
+		{
+			// packet data in SoA layout, inactive lanes get a negative max distance so that they never hit
+			XMFLOAT4 originX, originY, originZ, inverseDirectionX, inverseDirectionY, inverseDirectionZ, maxDistance, radius;
+			float *lanes[8] = { &originX.x, &originY.x, &originZ.x, &inverseDirectionX.x, &inverseDirectionY.x, &inverseDirectionZ.x, &maxDistance.x, &radius.x };
+
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				laneHits[k].clear();
+
+				if (packet + k < lastQuery)
+				{
+					const SweepQuery &query = queries[packet + k];
+
+					lanes[0][k] = query.origin.x; lanes[1][k] = query.origin.y; lanes[2][k] = query.origin.z;
+					lanes[3][k] = query.direction.x != 0.0f ? 1.0f / query.direction.x : FLT_MAX;
+					lanes[4][k] = query.direction.y != 0.0f ? 1.0f / query.direction.y : FLT_MAX;
+					lanes[5][k] = query.direction.z != 0.0f ? 1.0f / query.direction.z : FLT_MAX;
+					lanes[6][k] = query.maxDistance;
+					lanes[7][k] = query.radius;
+				}
+				else
+				{
+					lanes[0][k] = lanes[1][k] = lanes[2][k] = 0.0f;
+					lanes[3][k] = lanes[4][k] = lanes[5][k] = FLT_MAX;
+					lanes[6][k] = -1.0f;
+					lanes[7][k] = 0.0f;
+				}
+			}
+
+			QueryPacket queryPacket;
+			queryPacket.originX = XMLoadFloat4(&originX); queryPacket.originY = XMLoadFloat4(&originY); queryPacket.originZ = XMLoadFloat4(&originZ);
+			queryPacket.inverseDirectionX = XMLoadFloat4(&inverseDirectionX); queryPacket.inverseDirectionY = XMLoadFloat4(&inverseDirectionY); queryPacket.inverseDirectionZ = XMLoadFloat4(&inverseDirectionZ);
+			queryPacket.radius = XMLoadFloat4(&radius);
+
+			// exact test for the lanes whose bounds test passed
+			auto castCollider = [&](unsigned int collider, uint32_t hitLanes[4])
+			{
+				for (unsigned int k = 0; k < 4; k++)
+				{
+					if (!hitLanes[k] || !AcceptCollider(mColliders[collider], queries[packet + k].mask, queries[packet + k].includeTriggers))
+						continue;
+
+					QueryHit hit;
+					if (!CastCollider(mColliders[collider], queries[packet + k], lanes[6][k], hit))
+						continue;
+
+					hit.query = packet + k;
+					hit.collider = mColliders[collider];
+
+					if (mode == QueryMode::CLOSEST)
+					{
+						laneHits[k].assign(1, hit);
+						lanes[6][k] = hit.distance;   // only closer hits are of interest now, farther nodes are culled
+					}
+					else
+						laneHits[k].push_back(hit);
+				}
+			};
+
+			// children are visited front to back along the direction of the first query of the packet
+			bool negativeDirection[3] = { lanes[3][0] < 0.0f, lanes[4][0] < 0.0f, lanes[5][0] < 0.0f };
+
+			unsigned int stack[64];
+			unsigned int stackSize = 0;
+
+			if (mQueryNodes.size())
+				stack[stackSize++] = 0;
+
+			while (stackSize)
+			{
+				unsigned int nodeIndex = stack[--stackSize];
+				const QueryNode &node = mQueryNodes[nodeIndex];
+
+				if (XMVector4EqualInt(IntersectBounds(queryPacket, maxDistance, node.min.x, node.min.y, node.min.z, node.max.x, node.max.y, node.max.z), XMVectorZero()))
+					continue;
+
+				if (node.count == 0)
+				{
+					if (negativeDirection[node.axis])
+					{
+						stack[stackSize++] = nodeIndex + 1;
+						stack[stackSize++] = node.first;
+					}
+					else
+					{
+						stack[stackSize++] = node.first;
+						stack[stackSize++] = nodeIndex + 1;
+					}
+
+					continue;
+				}
+
+				for (unsigned int i = node.first; i < node.first + node.count; i++)
+				{
+					unsigned int collider = mQueryColliders[i];
+
+					XMVECTOR hitMask = IntersectBounds(queryPacket, maxDistance, mBoundsMinX[collider], mBoundsMinY[collider], mBoundsMinZ[collider], mBoundsMaxX[collider], mBoundsMaxY[collider], mBoundsMaxZ[collider]);
+					if (XMVector4EqualInt(hitMask, XMVectorZero()))
+						continue;
+
+					uint32_t hitLanes[4];
+					XMStoreInt4(hitLanes, hitMask);
+
+					castCollider(collider, hitLanes);
+				}
+			}
+
+			// unbounded colliders are tested by every active lane
+			for (unsigned int collider : mUnboundedColliders)
+			{
+				uint32_t hitLanes[4];
+				for (unsigned int k = 0; k < 4; k++)
+					hitLanes[k] = lanes[6][k] >= 0.0f;
+
+				castCollider(collider, hitLanes);
+			}
+
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				std::sort(laneHits[k].begin(), laneHits[k].end(), [](const QueryHit &hit1, const QueryHit &hit2) { return hit1.distance < hit2.distance; });
+				taskHits.insert(taskHits.end(), laneHits[k].begin(), laneHits[k].end());
+			}
+		}
+	});
+
+	MergeQueryHits(numQueries, numTasks, results);
+}
+
+void CollisionSystem::OverlapSphere(const std::vector<SphereQuery> &queries, QueryResults &results)
+{
+	BuildQueryTree();
+
+	unsigned int numQueries = (unsigned int)queries.size();
+	unsigned int numTasks = (numQueries + QUERIES_PER_TASK - 1) / QUERIES_PER_TASK;
+
+	if (mTaskHits.size() < numTasks)
+		mTaskHits.resize(numTasks);
+
+	ThreadPool::GetInstance().ParallelFor(numTasks, [&](unsigned int task)
+	{
+		std::vector<QueryHit> &taskHits = mTaskHits[task];
+		taskHits.clear();
+
+		unsigned int firstQuery = task * QUERIES_PER_TASK;
+		unsigned int lastQuery = std::min(firstQuery + QUERIES_PER_TASK, numQueries);
+
+		for (unsigned int q = firstQuery; q < lastQuery; q++)
+		{
+			const SphereQuery &query = queries[q];
+
+			XMFLOAT3 min(query.center.x - query.radius, query.center.y - query.radius, query.center.z - query.radius);
+			XMFLOAT3 max(query.center.x + query.radius, query.center.y + query.radius, query.center.z + query.radius);
+
+			// overlaps don't compute contact data
+			auto overlapCollider = [&](unsigned int collider)
+			{
+				if (!AcceptCollider(mColliders[collider], query.mask, query.includeTriggers) || !OverlapCollider(mColliders[collider], query))
+					return;
+
+				QueryHit hit;
+				hit.query = q;
+				hit.collider = mColliders[collider];
+				hit.distance = 0.0f;
+				hit.point = query.center;
+				hit.normal = XMFLOAT3();
+
+				taskHits.push_back(hit);
+			};
+
+			unsigned int stack[64];
+			unsigned int stackSize = 0;
+
+			if (mQueryNodes.size())
+				stack[stackSize++] = 0;
+
+			while (stackSize)
+			{
+				unsigned int nodeIndex = stack[--stackSize];
+				const QueryNode &node = mQueryNodes[nodeIndex];
+
+				if (min.x > node.max.x || max.x < node.min.x || min.y > node.max.y || max.y < node.min.y || min.z > node.max.z || max.z < node.min.z)
+					continue;
 
-		//float penetration = 0.1f;
+				if (node.count == 0)
+				{
+					stack[stackSize++] = node.first;
+					stack[stackSize++] = nodeIndex + 1;
 
-		//mContacts.InsertLast(new Contact{ contactPoint, contactNormal, penetration, sphere->GetOwner(), nullptr });
+					continue;
+				}
+
+				for (unsigned int i = node.first; i < node.first + node.count; i++)
+				{
+					unsigned int collider = mQueryColliders[i];
+
+					if (min.x > mBoundsMaxX[collider] || max.x < mBoundsMinX[collider] || min.y > mBoundsMaxY[collider] || max.y < mBoundsMinY[collider] || min.z > mBoundsMaxZ[collider] || max.z < mBoundsMinZ[collider])
+						continue;
+
+					overlapCollider(collider);
+				}
+			}
+
+			for (unsigned int collider : mUnboundedColliders)
+				overlapCollider(collider);
+		}
+	});
+
+	MergeQueryHits(numQueries, numTasks, results);
+}
+
+// task hit buffers cover consecutive query ranges, so concatenating them keeps the hits grouped by query
+void CollisionSystem::MergeQueryHits(unsigned int numQueries, unsigned int numTasks, QueryResults &results)
+{
+	results.hits.clear();
+	results.firstHit.assign(numQueries + 1, 0);
+
+	for (unsigned int task = 0; task < numTasks; task++)
+		results.hits.insert(results.hits.end(), mTaskHits[task].begin(), mTaskHits[task].end());
+
+	for (const QueryHit &hit : results.hits)
+		results.firstHit[hit.query + 1]++;
+
+	for (unsigned int i = 0; i < numQueries; i++)
+		results.firstHit[i + 1] += results.firstHit[i];
+}
+
+bool CollisionSystem::CastCollider(const CollisionComponent *collider, const SweepQuery &query, float maxDistance, QueryHit &hit) const
+{
+	switch (collider->GetType())
+	{
+		case CollisionComponent::Type::SPHERE:
+			return RayAndSphereCollision(query, maxDistance, static_cast<const SphereCollisionComponent*>(collider), hit);
+		case CollisionComponent::Type::BOX:
+			return RayAndBoxCollision(query, maxDistance, static_cast<const BoxCollisionComponent*>(collider), hit);
+		case CollisionComponent::Type::PLANE:
+			return RayAndPlaneCollision(query, maxDistance, static_cast<const PlaneCollisionComponent*>(collider), hit);
+		case CollisionComponent::Type::MESH:
+			return RayAndMeshCollision(query, maxDistance, static_cast<const MeshCollisionComponent*>(collider), hit);
+		case CollisionComponent::Type::HEIGHTFIELD:
+			return RayAndHeightfieldCollision(query, maxDistance, static_cast<const HeightfieldCollisionComponent*>(collider), hit);
+		default:
+			return false;
 	}
-}
\ No newline at end of file
+}
+
+bool CollisionSystem::OverlapCollider(const CollisionComponent *collider, const SphereQuery &query) const
+{
+	XMVECTOR centerV = XMLoadFloat3(&query.center);
+
+	switch (collider->GetType())
+	{
+		case CollisionComponent::Type::SPHERE:
+		{
+			XMFLOAT3 sphereCenter = collider->GetPosition();
+			float radius = static_cast<const SphereCollisionComponent*>(collider)->GetRadius() + query.radius;
+
+			return XMVectorGetX(XMVector3LengthSq(centerV - XMLoadFloat3(&sphereCenter))) <= radius * radius;
+		}
+		case CollisionComponent::Type::BOX:
+		{
+			// closest point on the box in box coordinates
+			XMFLOAT3 boxCenter = collider->GetPosition();
+			XMFLOAT3 halfSize = static_cast<const BoxCollisionComponent*>(collider)->GetHalfSize();
+			float halfSizes[3] = { halfSize.x, halfSize.y, halfSize.z };
+
+			XMVECTOR offset = centerV - XMLoadFloat3(&boxCenter);
+			float distanceSq = 0.0f;
+
+			for (int i = 0; i < 3; i++)
+			{
+				XMFLOAT3 axis = collider->GetAxis(i);
+				float distance = fabs(XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&axis))));
+
+				if (distance > halfSizes[i])
+					distanceSq += (distance - halfSizes[i]) * (distance - halfSizes[i]);
+			}
+
+			return distanceSq <= query.radius * query.radius;
+		}
+		case CollisionComponent::Type::PLANE:
+		{
+			// half-space
+			const PlaneCollisionComponent *plane = static_cast<const PlaneCollisionComponent*>(collider);
+			XMFLOAT3 normal = plane->GetNormal();
+
+			return XMVectorGetX(XMVector3Dot(centerV, XMLoadFloat3(&normal))) - plane->GetOffset() < query.radius;
+		}
+		case CollisionComponent::Type::MESH:
+		{
+			XMFLOAT4X4 inverseWorldMatrix = collider->GetInverseWorldMatrix();
+
+			XMFLOAT3 centerMesh;
+			XMStoreFloat3(&centerMesh, XMVector3Transform(centerV, XMLoadFloat4x4(&inverseWorldMatrix)));
+
+			return static_cast<const MeshCollisionComponent*>(collider)->GetBVH().OverlapSphere(centerMesh, query.radius);
+		}
+		case CollisionComponent::Type::HEIGHTFIELD:
+			return static_cast<const HeightfieldCollisionComponent*>(collider)->OverlapSphere(query.center, query.radius);
+		default:
+			return false;
+	}
+}
+
+/**** ray/sweep tests ****/
+
+bool CollisionSystem::RayAndSphereCollision(const SweepQuery &query, float maxDistance, const SphereCollisionComponent *sphere, QueryHit &hit) const
+{
+	XMFLOAT3 sphereCenter = sphere->GetPosition();
+	float radius = sphere->GetRadius() + query.radius;
+
+	XMVECTOR originV = XMLoadFloat3(&query.origin);
+	XMVECTOR directionV = XMLoadFloat3(&query.direction);
+	XMVECTOR m = originV - XMLoadFloat3(&sphereCenter);
+
+	float b = XMVectorGetX(XMVector3Dot(m, directionV));
+	float c = XMVectorGetX(XMVector3Dot(m, m)) - radius * radius;
+
+	// origin outside and pointing away
+	if (c > 0.0f && b > 0.0f)
+		return false;
+
+	float discriminant = b * b - c;
+	if (discriminant < 0.0f)
+		return false;
+
+	// starting inside the sphere gives a hit at distance 0
+	float t = std::max(-b - sqrtf(discriminant), 0.0f);
+	if (t > maxDistance)
+		return false;
+
+	XMVECTOR centerV = originV + directionV * t;
+	XMVECTOR normalV = XMVector3Normalize(centerV - XMLoadFloat3(&sphereCenter));
+
+	hit.distance = t;
+	XMStoreFloat3(&hit.point, centerV - normalV * query.radius);
+	XMStoreFloat3(&hit.normal, normalV);
+
+	return true;
+}
+
+bool CollisionSystem::RayAndBoxCollision(const SweepQuery &query, float maxDistance, const BoxCollisionComponent *box, QueryHit &hit) const
+{
+	// slab test in box coordinates against the box inflated by the sweep radius (corners and edges are treated as square)
+	XMFLOAT3 boxCenter = box->GetPosition();
+	XMFLOAT3 halfSize = box->GetHalfSize();
+	float halfSizes[3] = { halfSize.x + query.radius, halfSize.y + query.radius, halfSize.z + query.radius };
+
+	XMVECTOR originV = XMLoadFloat3(&query.origin);
+	XMVECTOR directionV = XMLoadFloat3(&query.direction);
+	XMVECTOR offset = originV - XMLoadFloat3(&boxCenter);
+
+	float tNear = 0.0f, tFar = maxDistance;
+	int nearAxis = -1;
+	float nearSign = 0.0f;
+
+	for (int i = 0; i < 3; i++)
+	{
+		XMFLOAT3 axis = box->GetAxis(i);
+		float o = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&axis)));
+		float d = XMVectorGetX(XMVector3Dot(directionV, XMLoadFloat3(&axis)));
+
+		if (fabs(d) < 1e-9f)
+		{
+			if (fabs(o) > halfSizes[i])
+				return false;
+
+			continue;
+		}
+
+		float t1 = (-halfSizes[i] - o) / d;
+		float t2 = (halfSizes[i] - o) / d;
+		float sign = -1.0f;
+
+		if (t1 > t2)
+		{
+			std::swap(t1, t2);
+			sign = 1.0f;
+		}
+
+		if (t1 > tNear)
+		{
+			tNear = t1;
+			nearAxis = i;
+			nearSign = sign;
+		}
+
+		tFar = std::min(tFar, t2);
+
+		if (tNear > tFar)
+			return false;
+	}
+
+	XMVECTOR normalV;
+	if (nearAxis >= 0)
+	{
+		XMFLOAT3 axis = box->GetAxis(nearAxis);
+		normalV = XMLoadFloat3(&axis) * nearSign;
+	}
+	else
+		normalV = -directionV;   // starting inside the box
+
+	hit.distance = tNear;
+	XMStoreFloat3(&hit.point, originV + directionV * tNear - normalV * query.radius);
+	XMStoreFloat3(&hit.normal, normalV);
+
+	return true;
+}
+
+bool CollisionSystem::RayAndPlaneCollision(const SweepQuery &query, float maxDistance, const PlaneCollisionComponent *plane, QueryHit &hit) const
+{
+	// the plane bounds a solid half-space
+	XMFLOAT3 normal = plane->GetNormal();
+	XMVECTOR normalV = XMLoadFloat3(&normal);
+	XMVECTOR originV = XMLoadFloat3(&query.origin);
+	XMVECTOR directionV = XMLoadFloat3(&query.direction);
+
+	float distance = XMVectorGetX(XMVector3Dot(originV, normalV)) - plane->GetOffset();
+	float t;
+
+	if (distance < query.radius)
+		t = 0.0f;
+	else
+	{
+		float approach = XMVectorGetX(XMVector3Dot(normalV, directionV));
+		if (approach >= 0.0f)
+			return false;
+
+		t = (query.radius - distance) / approach;
+		if (t > maxDistance)
+			return false;
+	}
+
+	hit.distance = t;
+	XMStoreFloat3(&hit.point, originV + directionV * t - normalV * query.radius);
+	hit.normal = normal;
+
+	return true;
+}
+
+bool CollisionSystem::RayAndMeshCollision(const SweepQuery &query, float maxDistance, const MeshCollisionComponent *mesh, QueryHit &hit) const
+{
+	// query in mesh local coordinates - the collider transform is rigid so distances are preserved
+	XMFLOAT4X4 meshInverseWorldMatrix = mesh->GetInverseWorldMatrix();
+	XMMATRIX meshInverseWorldMatrixM = XMLoadFloat4x4(&meshInverseWorldMatrix);
+
+	XMFLOAT3 originMesh, directionMesh;
+	XMStoreFloat3(&originMesh, XMVector3Transform(XMLoadFloat3(&query.origin), meshInverseWorldMatrixM));
+	XMStoreFloat3(&directionMesh, XMVector3TransformNormal(XMLoadFloat3(&query.direction), meshInverseWorldMatrixM));
+
+	MeshBVH::RayHit meshHit;
+
+	if (query.radius > 0.0f)
+	{
+		if (!mesh->GetBVH().SweepSphere(originMesh, directionMesh, query.radius, maxDistance, meshHit))
+			return false;
+	}
+	else if (!mesh->GetBVH().RayCast(originMesh, directionMesh, maxDistance, meshHit))
+		return false;
+
+	// back to world coordinates
+	XMFLOAT4X4 meshWorldMatrix = mesh->GetWorldMatrix();
+	XMMATRIX meshWorldMatrixM = XMLoadFloat4x4(&meshWorldMatrix);
+
+	hit.distance = meshHit.distance;
+	XMStoreFloat3(&hit.point, XMVector3Transform(XMLoadFloat3(&meshHit.point), meshWorldMatrixM));
+	XMStoreFloat3(&hit.normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&meshHit.normal), meshWorldMatrixM)));
+
+	return true;
+}
+
+bool CollisionSystem::RayAndHeightfieldCollision(const SweepQuery &query, float maxDistance, const HeightfieldCollisionComponent *heightfield, QueryHit &hit) const
+{
+	float distance;
+	XMFLOAT3 normal;
+
+	if (query.radius > 0.0f)
+	{
+		if (!heightfield->SweepSphere(query.origin, query.direction, query.radius, maxDistance, distance, normal))
+			return false;
+	}
+	else if (!heightfield->RayCast(query.origin, query.direction, maxDistance, distance, normal))
+		return false;
+
+	hit.distance = distance;
+	hit.point = XMFLOAT3(query.origin.x + query.direction.x * distance - normal.x * query.radius, query.origin.y + query.direction.y * distance - normal.y * query.radius, query.origin.z + query.direction.z * distance - normal.z * query.radius);
+	hit.normal = normal;
+
+	return true;
+}
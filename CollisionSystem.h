@@ -3,44 +3,176 @@
 
 #include "data structures/Vector.h"
 #include "Contact.h"
+#include <vector>
+#include <utility>
+#include <cstdint>
 
 class BoxCollisionComponent;
 class SphereCollisionComponent;
 class PlaneCollisionComponent;
+class MeshCollisionComponent;
+class HeightfieldCollisionComponent;
+class CollisionComponent;
 
 class CollisionSystem
 {
 public:
-	static CollisionSystem &GetInstance() { static CollisionSystem instance; return instance; }
+	/**** scene queries - a query only tests the colliders whose layer is in its mask, and triggers only if it includes them ****/
+	struct RayQuery
+	{
+		XMFLOAT3 origin;
+		XMFLOAT3 direction;        // unit length
+		float maxDistance;
+		uint32_t mask = 0xFFFFFFFFu;
+		bool includeTriggers = true;
+	};
+	struct SphereQuery
+	{
+		XMFLOAT3 center;
+		float radius;
+		uint32_t mask = 0xFFFFFFFFu;
+		bool includeTriggers = true;
+	};
+	struct SweepQuery
+	{
+		XMFLOAT3 origin;           // sphere center at the start of the sweep
+		XMFLOAT3 direction;        // unit length
+		float maxDistance;
+		float radius;
+		uint32_t mask = 0xFFFFFFFFu;
+		bool includeTriggers = true;
+	};
+	struct QueryHit
+	{
+		unsigned int query;        // index of the query in the batch
+		CollisionComponent *collider;
+		float distance;            // along the ray/sweep - 0 for overlaps and for queries starting inside a collider
+		XMFLOAT3 point;
+		XMFLOAT3 normal;
+	};
+	struct QueryResults
+	{
+		std::vector<QueryHit> hits;              // grouped by query, each group sorted by distance
+		std::vector<unsigned int> firstHit;      // hits of query i are [firstHit[i], firstHit[i + 1])
 
-	void AddRay(class Picker *picker) { mPicker = picker; }
+		unsigned int GetNumHits(unsigned int query) const { return firstHit[query + 1] - firstHit[query]; }
+		const QueryHit *GetHits(unsigned int query) const { return GetNumHits(query) ? &hits[firstHit[query]] : nullptr; }
+	};
+	enum class QueryMode { CLOSEST, ALL, };
+public:
+	static CollisionSystem &GetInstance() { static CollisionSystem instance; return instance; }
 
 	void DoCollisions();
+
+	// batched queries, processed in parallel - call from the main thread. the collider bounds are gathered again at the start
+	// of each batch, so a batch sees the colliders as they are when it is issued (after contact resolution, without removed ones)
+	void RayCast(const std::vector<RayQuery> &queries, QueryMode mode, QueryResults &results);
+	void SweepSphere(const std::vector<SweepQuery> &queries, QueryMode mode, QueryResults &results);
+	void OverlapSphere(const std::vector<SphereQuery> &queries, QueryResults &results);
+private:
+	struct CollisionPair
+	{
+		unsigned int collider1;    // indices into mColliders, collider1 < collider2
+		unsigned int collider2;
+	};
+
+	struct TriggerOverlap
+	{
+		uint64_t id1;              // collider ids, id1 < id2
+		uint64_t id2;
+		CollisionComponent *collider1;
+		CollisionComponent *collider2;
+
+		bool operator<(const TriggerOverlap &other) const { return id1 < other.id1 || (id1 == other.id1 && id2 < other.id2); }
+	};
+
+	struct QueryNode
+	{
+		XMFLOAT3 min;
+		unsigned int first;        // leaves: first entry in mQueryColliders, inner nodes: second child (the first one follows the node)
+		XMFLOAT3 max;
+		unsigned int count;        // colliders in the leaf, 0 for inner nodes
+		unsigned int axis;         // split axis of inner nodes, the first child holds the lower centers
+	};
+
+	static const unsigned int PAIRS_PER_CHUNK = 32;
+	static const unsigned int QUERIES_PER_TASK = 64;
+	static const unsigned int COLLIDERS_PER_LEAF = 4;
 private:
 	CollisionSystem() = default;
 
+	// broadphase - world bounds of the colliders in SoA layout, padded to a multiple of 4
+	void UpdateBroadphase();
+	bool GetWorldBounds(const CollisionComponent *collider, XMFLOAT3 &min, XMFLOAT3 &max) const;
+
+	// candidate pairs - filtered by collider layers and masks
+	void FindCollisionPairs();
+
+	// scene queries - rays are sweeps with zero radius. a bounding volume hierarchy over the collider bounds is built for each batch
+	void BuildQueryTree();
+	static bool AcceptCollider(const CollisionComponent *collider, uint32_t mask, bool includeTriggers);
+	unsigned int BuildQueryNode(unsigned int first, unsigned int count);
+	void CastSpheres(const std::vector<SweepQuery> &queries, QueryMode mode, QueryResults &results);
+	bool CastCollider(const CollisionComponent *collider, const SweepQuery &query, float maxDistance, QueryHit &hit) const;
+	bool OverlapCollider(const CollisionComponent *collider, const SphereQuery &query) const;
+	void MergeQueryHits(unsigned int numQueries, unsigned int numTasks, QueryResults &results);
+
+	// narrowphase - pairs involving a trigger are only tested for overlap
+	void GenerateContacts();
+	void GenerateContacts(CollisionComponent *collisionComponent1, CollisionComponent *collisionComponent2, std::vector<Contact> &contacts);
+	bool TestOverlap(CollisionComponent *collisionComponent1, CollisionComponent *collisionComponent2, std::vector<Contact> &scratchContacts);
+
+	// trigger enter/stay/exit events from the overlaps of this frame and of the previous one
+	void DispatchTriggerEvents();
+
 	// separating axis theorem
 	Vector<XMFLOAT3> GetSATAxes(BoxCollisionComponent *box1, BoxCollisionComponent *box2);
 	float PerformSAT(const XMFLOAT3 &axis, BoxCollisionComponent *box1, BoxCollisionComponent *box2);
 
 	// collision detection - contact data generation algoritms	
-	void BoxAndBoxCollision(BoxCollisionComponent *box1,BoxCollisionComponent *box2);
-	void BoxAndHalfSpaceCollision(BoxCollisionComponent *box, PlaneCollisionComponent *plane);
-	void BoxAndSphereCollision(BoxCollisionComponent *box, SphereCollisionComponent *sphere);
+	void BoxAndBoxCollision(BoxCollisionComponent *box1, BoxCollisionComponent *box2, std::vector<Contact> &contacts);
+	void BoxAndHalfSpaceCollision(BoxCollisionComponent *box, PlaneCollisionComponent *plane, std::vector<Contact> &contacts);
+	void BoxAndSphereCollision(BoxCollisionComponent *box, SphereCollisionComponent *sphere, std::vector<Contact> &contacts);
 	
-	void SphereAndSphereCollision(SphereCollisionComponent *s1, SphereCollisionComponent *s2);
-	void SphereAndHalfSpaceCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane);
-	void SphereAndPlaneCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane);
+	void SphereAndSphereCollision(SphereCollisionComponent *s1, SphereCollisionComponent *s2, std::vector<Contact> &contacts);
+	void SphereAndHalfSpaceCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane, std::vector<Contact> &contacts);
+	void SphereAndPlaneCollision(SphereCollisionComponent *sphere, PlaneCollisionComponent *plane, std::vector<Contact> &contacts);
+
+	void SphereAndMeshCollision(SphereCollisionComponent *sphere, MeshCollisionComponent *mesh, std::vector<Contact> &contacts);
+	void BoxAndMeshCollision(BoxCollisionComponent *box, MeshCollisionComponent *mesh, std::vector<Contact> &contacts);
 
-	void RayAndSphereCollision(const XMFLOAT3 &ray, const XMFLOAT3 &origin, const SphereCollisionComponent *sphere);
-	void RayAndBoxCollision(const XMFLOAT3 &ray, const XMFLOAT3 &origin, const BoxCollisionComponent *box);
-	void RayAndPlaneCollision(const XMFLOAT3 &ray, const XMFLOAT3 &origin, const PlaneCollisionComponent *sphere);
+	void SphereAndHeightfieldCollision(SphereCollisionComponent *sphere, HeightfieldCollisionComponent *heightfield, std::vector<Contact> &contacts);
+	void BoxAndHeightfieldCollision(BoxCollisionComponent *box, HeightfieldCollisionComponent *heightfield, std::vector<Contact> &contacts);
+
+	// ray/sweep tests - sweeps are rays against the collider inflated by the sweep radius
+	bool RayAndSphereCollision(const SweepQuery &query, float maxDistance, const SphereCollisionComponent *sphere, QueryHit &hit) const;
+	bool RayAndBoxCollision(const SweepQuery &query, float maxDistance, const BoxCollisionComponent *box, QueryHit &hit) const;
+	bool RayAndPlaneCollision(const SweepQuery &query, float maxDistance, const PlaneCollisionComponent *plane, QueryHit &hit) const;
+	bool RayAndMeshCollision(const SweepQuery &query, float maxDistance, const MeshCollisionComponent *mesh, QueryHit &hit) const;
+	bool RayAndHeightfieldCollision(const SweepQuery &query, float maxDistance, const HeightfieldCollisionComponent *heightfield, QueryHit &hit) const;
 
 	void ResolveContacts();
 
-	Vector<Contact*> mContacts;
+	std::vector<CollisionComponent*> mColliders;
+	std::vector<float> mBoundsMinX, mBoundsMinY, mBoundsMinZ;     // unbounded colliders (planes) span the whole float range
+	std::vector<float> mBoundsMaxX, mBoundsMaxY, mBoundsMaxZ;
+
+	std::vector<CollisionPair> mCollisionPairs;
+
+	std::vector<std::vector<Contact>> mChunkContacts;    // narrowphase contact buffers, kept between frames to avoid reallocations
+	std::vector<Contact> mContacts;
+
+	std::vector<std::vector<CollisionPair>> mChunkOverlaps;   // trigger overlaps found by each chunk
+	std::vector<TriggerOverlap> mTriggerOverlaps;            // sorted by collider ids
+	std::vector<TriggerOverlap> mPreviousTriggerOverlaps;
+	std::vector<uint64_t> mColliderIDs;                      // sorted, to check that colliders of previous overlaps still exist
+
+	std::vector<QueryNode> mQueryNodes;
+	std::vector<unsigned int> mQueryColliders;           // indices into mColliders, in leaf order
+	std::vector<unsigned int> mUnboundedColliders;       // planes, tested by every query
 
-	Picker *mPicker;
+	std::vector<SweepQuery> mRayQueries;
+	std::vector<std::vector<QueryHit>> mTaskHits;          // query hit buffers, one per task
 };
 
 #endif  // COLLISION_SYSTEM_H
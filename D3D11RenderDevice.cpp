@@ -0,0 +1,1036 @@
+#include "D3D11RenderDevice.h"
+#include "DDSTextureLoader.h"
+#include "WICTextureLoader.h"
+#include "Error.h"
+#include "VirtualFileSystem.h"
+#include <d3dcompiler.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+#include <cstring>
+
+#define DEBUG
+
+D3D11RenderDevice::D3D11RenderDevice(HWND window, bool msaaEnabled) : mMSAAEnabled(msaaEnabled)
+{
+	HRESULT hr;
+
+	/* check DirectX11 support and create device and device context */
+	D3D_FEATURE_LEVEL featureLevel;
+#ifdef DEBUG
+	hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, 0, D3D11_CREATE_DEVICE_DEBUG, nullptr, 0, D3D11_SDK_VERSION, &mDevice, &featureLevel, &mDeviceContext);
+#else
+	hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, 0, 0, nullptr, 0, D3D11_SDK_VERSION, &mDevice, &featureLevel, &mDeviceContext);
+#endif
+	if (FAILED(hr))
+		ErrorBox("cannot create device");
+	if (featureLevel != D3D_FEATURE_LEVEL_11_0)
+		ErrorBox("DirectX 11 not supported");
+
+	/* check Multi Sampling support */
+	DXGI_SAMPLE_DESC sampleDesc = {};
+	sampleDesc.Count = 4;
+	mDevice->CheckMultisampleQualityLevels(DXGI_FORMAT_R8G8B8A8_UNORM, sampleDesc.Count, &sampleDesc.Quality);
+	if (sampleDesc.Quality <= 0)
+		ErrorBox("MSAA not supported");
+
+	mSampleCount = sampleDesc.Count;
+	mSampleQuality = sampleDesc.Quality - 1;
+
+	/* get window area */
+	RECT rect;
+	GetClientRect(window, &rect);
+
+	mBackBufferWidth = rect.right;
+	mBackBufferHeight = rect.bottom;
+
+	/* describe the swap chain */
+	DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
+	DXGI_MODE_DESC modeDesc = {};
+	modeDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	modeDesc.Width = mBackBufferWidth;
+	modeDesc.Height = mBackBufferHeight;
+	modeDesc.RefreshRate.Numerator = 60;
+	modeDesc.RefreshRate.Denominator = 1;
+	modeDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+	modeDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+	swapChainDesc.BufferDesc = modeDesc;
+	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+	swapChainDesc.BufferCount = 1;  // one back buffer for double buffering
+	swapChainDesc.OutputWindow = window;
+	swapChainDesc.Windowed = true;
+	swapChainDesc.Flags = 0;
+	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+	if (mMSAAEnabled)
+	{
+		swapChainDesc.SampleDesc.Count = sampleDesc.Count;
+		swapChainDesc.SampleDesc.Quality = sampleDesc.Quality - 1;
+	}
+	else
+	{
+		swapChainDesc.SampleDesc.Count = 1;
+		swapChainDesc.SampleDesc.Quality = 0;
+	}
+
+	/* create the swap chain */
+	IDXGIDevice *dxgiDevice;
+	mDevice->QueryInterface(__uuidof(IDXGIDevice), (void**)&dxgiDevice);
+	IDXGIAdapter *dxgiAdapter;
+	dxgiDevice->GetParent(__uuidof(IDXGIAdapter), (void**)&dxgiAdapter);
+	IDXGIFactory *dxgiFactory;
+	dxgiAdapter->GetParent(__uuidof(IDXGIFactory), (void**)&dxgiFactory);
+
+	hr = dxgiFactory->CreateSwapChain(mDevice, &swapChainDesc, &mSwapChain);
+	if (FAILED(hr))
+		ErrorBox("could not create swap chain");
+
+	dxgiDevice->Release();    // release resources used to create swap chain
+	dxgiAdapter->Release();
+	dxgiFactory->Release();
+
+	/* create the render target view */
+	ID3D11Texture2D *backBuffer;
+	mSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer);       // Texture2D resource is the swap chain back buffer
+
+	hr = mDevice->CreateRenderTargetView(backBuffer, nullptr, &mRenderTargetView);  // render target view from Texture2D resource
+	if (FAILED(hr))
+		ErrorBox("couldn't create render target view");
+	backBuffer->Release();     // release backbuffer resource
+
+	/* describe and create depth/stencil buffer 2D texture resource (same size as back buffer) */
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = mBackBufferWidth;
+	textureDesc.Height = mBackBufferHeight;
+	textureDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	if (mMSAAEnabled)
+	{
+		textureDesc.SampleDesc.Count = sampleDesc.Count;
+		textureDesc.SampleDesc.Quality = sampleDesc.Quality - 1;
+	}
+	else
+	{
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.SampleDesc.Quality = 0;
+	}
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	ID3D11Texture2D *depthStencilBuffer;
+	mDevice->CreateTexture2D(&textureDesc, nullptr, &depthStencilBuffer);
+
+	/* create depth/stencil view */
+	hr = mDevice->CreateDepthStencilView(depthStencilBuffer, nullptr, &mDepthStencilView);
+	if (FAILED(hr))
+		ErrorBox("couldn't create depth/stencil view");
+
+	depthStencilBuffer->Release();   // release depth and stencil buffer resource
+
+	/* bind render target view and depth stencil view to the Output Merger stage of the rendering pipeline */
+	SetRenderTargets(GetBackBufferTarget(), GetBackBufferDepthTarget());
+
+	/* set the viewport */
+	Viewport viewport = { 0.0f, 0.0f, (float)mBackBufferWidth, (float)mBackBufferHeight };
+	SetViewport(viewport);
+
+	/*** describe and create all render states at initialization ***/
+	CreateRenderStates();
+}
+
+D3D11RenderDevice::~D3D11RenderDevice()
+{
+	for (ID3D11RasterizerState *state : mRasterizerStateGroup)
+		state->Release();
+	for (ID3D11BlendState *state : mBlendStateGroup)
+		state->Release();
+	for (ID3D11DepthStencilState *state : mDepthStencilStateGroup)
+		state->Release();
+
+	mDepthStencilView->Release();
+	mRenderTargetView->Release();
+	mSwapChain->Release();
+	mDeviceContext->Release();
+	mDevice->Release();
+}
+
+void D3D11RenderDevice::CreateRenderStates()
+{
+	HRESULT hr;
+
+	/*** rasterizer states ***/
+
+	ID3D11RasterizerState *rasterizerState;
+
+	/* solid raterizer state */
+	D3D11_RASTERIZER_DESC fillRasterizerDesc = {};
+	fillRasterizerDesc.FillMode = D3D11_FILL_SOLID;
+	fillRasterizerDesc.CullMode = D3D11_CULL_BACK;
+	fillRasterizerDesc.FrontCounterClockwise = false;
+	fillRasterizerDesc.DepthClipEnable = true;
+
+	hr = mDevice->CreateRasterizerState(&fillRasterizerDesc, &rasterizerState);
+	if (FAILED(hr))
+		ErrorBox("rasterizer state creation failed");
+
+	mRasterizerStateGroup.push_back(rasterizerState);
+
+	/* wireframe rasterizer state */
+	D3D11_RASTERIZER_DESC wireframeRasterizerDesc = {};
+	wireframeRasterizerDesc.FillMode = D3D11_FILL_WIREFRAME;
+	wireframeRasterizerDesc.CullMode = D3D11_CULL_BACK;
+	fillRasterizerDesc.FrontCounterClockwise = false;
+	wireframeRasterizerDesc.DepthClipEnable = true;
+
+	hr = mDevice->CreateRasterizerState(&wireframeRasterizerDesc, &rasterizerState);
+	if (FAILED(hr))
+		ErrorBox("rasterizer state creation failed");
+
+	mRasterizerStateGroup.push_back(rasterizerState);
+
+	/* set default rasterizer state */
+	mDeviceContext->RSSetState(mRasterizerStateGroup[0]);
+
+	/*** blend states ***/
+
+	ID3D11BlendState *blendState;
+
+	/* blending disabled (default blend state) */
+	D3D11_BLEND_DESC blendDisabledDesc = {};
+	D3D11_RENDER_TARGET_BLEND_DESC renderTargetBlendDisabledDesc;
+	renderTargetBlendDisabledDesc.BlendEnable = false;
+	renderTargetBlendDisabledDesc.SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	renderTargetBlendDisabledDesc.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	renderTargetBlendDisabledDesc.BlendOp = D3D11_BLEND_OP_ADD;
+	renderTargetBlendDisabledDesc.SrcBlendAlpha = D3D11_BLEND_ONE;
+	renderTargetBlendDisabledDesc.DestBlendAlpha = D3D11_BLEND_ZERO;
+	renderTargetBlendDisabledDesc.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	renderTargetBlendDisabledDesc.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	blendDisabledDesc.RenderTarget[0] = renderTargetBlendDisabledDesc;
+
+	hr = mDevice->CreateBlendState(&blendDisabledDesc, &blendState);
+	if (FAILED(hr))
+		ErrorBox("blend state creation failed");
+
+	mBlendStateGroup.push_back(blendState);
+
+	/* blending enabled */
+	D3D11_BLEND_DESC blendEnabledDesc = {};
+	blendEnabledDesc.AlphaToCoverageEnable = false;
+	blendEnabledDesc.IndependentBlendEnable = false;
+	D3D11_RENDER_TARGET_BLEND_DESC renderTargetBlendEnabledDesc;
+	renderTargetBlendEnabledDesc.BlendEnable = true;
+	renderTargetBlendEnabledDesc.SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	renderTargetBlendEnabledDesc.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	renderTargetBlendEnabledDesc.BlendOp = D3D11_BLEND_OP_ADD;
+	renderTargetBlendEnabledDesc.SrcBlendAlpha = D3D11_BLEND_ONE;
+	renderTargetBlendEnabledDesc.DestBlendAlpha = D3D11_BLEND_ONE;
+	renderTargetBlendEnabledDesc.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	renderTargetBlendEnabledDesc.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	blendEnabledDesc.RenderTarget[0] = renderTargetBlendEnabledDesc;
+
+	hr = mDevice->CreateBlendState(&blendEnabledDesc, &blendState);
+	if (FAILED(hr))
+		ErrorBox("blend state creation failed");
+
+	mBlendStateGroup.push_back(blendState);
+
+	/*** depth and stencil states ***/
+
+	ID3D11DepthStencilState *depthStencilState;
+
+	/* depth test enabled */
+	D3D11_DEPTH_STENCIL_DESC depthStencilDepthDesc;
+	depthStencilDepthDesc.DepthEnable = TRUE;
+	depthStencilDepthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	depthStencilDepthDesc.DepthFunc = D3D11_COMPARISON_LESS;
+	depthStencilDepthDesc.StencilEnable = FALSE;
+	depthStencilDepthDesc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+	depthStencilDepthDesc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+	depthStencilDepthDesc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+	depthStencilDepthDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilDepthDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilDepthDesc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilDepthDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+	depthStencilDepthDesc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilDepthDesc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilDepthDesc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+
+	hr = mDevice->CreateDepthStencilState(&depthStencilDepthDesc, &depthStencilState);
+	if (FAILED(hr))
+		ErrorBox("depth stencil state creation failed");
+
+	mDepthStencilStateGroup.push_back(depthStencilState);
+
+	/* depth test disabled */
+	D3D11_DEPTH_STENCIL_DESC depthStencilNoDepthDesc;
+	depthStencilNoDepthDesc.DepthEnable = FALSE;
+	depthStencilNoDepthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	depthStencilNoDepthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+	depthStencilNoDepthDesc.StencilEnable = FALSE;
+	depthStencilNoDepthDesc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+	depthStencilNoDepthDesc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+	depthStencilNoDepthDesc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+	depthStencilNoDepthDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilNoDepthDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilNoDepthDesc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilNoDepthDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+	depthStencilNoDepthDesc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilNoDepthDesc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	depthStencilNoDepthDesc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+
+	hr = mDevice->CreateDepthStencilState(&depthStencilNoDepthDesc, &depthStencilState);
+	if (FAILED(hr))
+		ErrorBox("depth stencil state creation failed");
+
+	mDepthStencilStateGroup.push_back(depthStencilState);
+
+	/* set default depth and stencil state */
+	mDeviceContext->OMSetDepthStencilState(mDepthStencilStateGroup[0], 0);
+}
+
+DXGI_FORMAT D3D11RenderDevice::GetFormat(Format format)
+{
+	switch (format)
+	{
+		case Format::R8_UNORM:
+			return DXGI_FORMAT_R8_UNORM;
+		case Format::R8G8B8A8_UNORM:
+			return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case Format::R32_FLOAT:
+			return DXGI_FORMAT_R32_FLOAT;
+		case Format::R32G32_FLOAT:
+			return DXGI_FORMAT_R32G32_FLOAT;
+		case Format::R32G32B32_FLOAT:
+			return DXGI_FORMAT_R32G32B32_FLOAT;
+		case Format::R32G32B32A32_FLOAT:
+			return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		case Format::R16G16_FLOAT:
+			return DXGI_FORMAT_R16G16_FLOAT;
+		case Format::R16G16_SNORM:
+			return DXGI_FORMAT_R16G16_SNORM;
+		case Format::R16G16B16A16_UNORM:
+			return DXGI_FORMAT_R16G16B16A16_UNORM;
+		default:
+			return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+/**** resources ****/
+
+BufferHandle D3D11RenderDevice::CreateBuffer(BufferType type, Usage usage, unsigned int size, const void *data)
+{
+	static const UINT bindFlags[] = { D3D11_BIND_VERTEX_BUFFER, D3D11_BIND_INDEX_BUFFER, D3D11_BIND_CONSTANT_BUFFER };
+	static const D3D11_USAGE usages[] = { D3D11_USAGE_IMMUTABLE, D3D11_USAGE_DEFAULT, D3D11_USAGE_DYNAMIC };
+
+	// buffer description
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.Usage = usages[static_cast<int>(usage)];
+	bufferDesc.BindFlags = bindFlags[static_cast<int>(type)];
+	bufferDesc.ByteWidth = size;
+	bufferDesc.CPUAccessFlags = usage == Usage::DYNAMIC ? D3D11_CPU_ACCESS_WRITE : 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	// buffer data - bufferData.SysMemPitch and bufferData.SysMemSlicePitch not needed (1D buffer)
+	D3D11_SUBRESOURCE_DATA bufferData = {};
+	bufferData.pSysMem = data;
+
+	ID3D11Buffer *buffer;
+	HRESULT hr = mDevice->CreateBuffer(&bufferDesc, data ? &bufferData : nullptr, &buffer);
+	if (FAILED(hr))
+		ErrorBox(type == BufferType::VERTEX ? "vertex buffer creation failed" : type == BufferType::INDEX ? "index buffer creation failed" : "constant buffer creation failed");
+
+	return reinterpret_cast<BufferHandle>(buffer);
+}
+
+void D3D11RenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	if (buffer)
+		reinterpret_cast<ID3D11Buffer*>(buffer)->Release();
+}
+
+void *D3D11RenderDevice::Map(BufferHandle buffer, MapMode mode)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	mDeviceContext->Map(reinterpret_cast<ID3D11Buffer*>(buffer), 0, mode == MapMode::WRITE_DISCARD ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedResource);
+
+	return mappedResource.pData;
+}
+
+void D3D11RenderDevice::Unmap(BufferHandle buffer)
+{
+	mDeviceContext->Unmap(reinterpret_cast<ID3D11Buffer*>(buffer), 0);
+}
+
+TextureHandle D3D11RenderDevice::CreateTexture(unsigned int width, unsigned int height, Format format, const void *data)
+{
+	D3D11_TEXTURE2D_DESC textureDesc;
+
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.Format = GetFormat(format);
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA textureData = {};
+	textureData.pSysMem = data;
+	textureData.SysMemPitch = width * (format == Format::R8_UNORM ? 1 : 4);
+
+	ID3D11Texture2D *texture;
+	HRESULT hr = mDevice->CreateTexture2D(&textureDesc, data ? &textureData : nullptr, &texture);  // empty texture resource if no data
+	if (FAILED(hr))
+		ErrorBox("couldn't create texture resource");
+
+	ID3D11ShaderResourceView *shaderResourceView;
+	hr = mDevice->CreateShaderResourceView(texture, nullptr, &shaderResourceView);
+	if (FAILED(hr))
+		ErrorBox("couldn't create shader resource view from texture");
+
+	texture->Release();   // the view holds a reference to the texture
+
+	return reinterpret_cast<TextureHandle>(shaderResourceView);
+}
+
+TextureHandle D3D11RenderDevice::LoadTexture(const std::string &textureFilePath)
+{
+	size_t dot = textureFilePath.find_last_of('.');
+	std::string extension = dot == std::string::npos ? std::string() : textureFilePath.substr(dot);
+
+	// the file is read through the virtual file system (it can be in a pack), the texture created from memory
+	VirtualFileSystem::File file;
+	if (!VirtualFileSystem::GetInstance().Open(textureFilePath, file))
+		ErrorBox("couldn't open texture file " + textureFilePath);
+
+	ID3D11Resource *resource = nullptr;
+	ID3D11ShaderResourceView *shaderResourceView = nullptr;
+	HRESULT hr = E_FAIL;
+
+	if (extension == ".png" || extension == ".jpg" || extension == ".tga")
+		hr = DirectX::CreateWICTextureFromMemory(mDevice, mDeviceContext, file.GetData(), file.GetSize(), &resource, &shaderResourceView);
+	else if (extension == ".dds")
+		hr = DirectX::CreateDDSTextureFromMemory(mDevice, mDeviceContext, file.GetData(), file.GetSize(), &resource, &shaderResourceView);
+	else
+		ErrorBox("unsupported texture file format");
+
+	if (FAILED(hr))
+		ErrorBox("couldn't create shader resource view");
+
+	resource->Release();  // resource view creation increases resource's ref-counting by 1
+
+	return reinterpret_cast<TextureHandle>(shaderResourceView);
+}
+
+// box filtered rgba8 mip chain appended after level 0
+static void GenerateMips(RenderDevice::TextureData &textureData)
+{
+	unsigned int width = textureData.width, height = textureData.height;
+	size_t source = 0;
+
+	textureData.mipLevels = 1;
+
+	while (width > 1 || height > 1)
+	{
+		unsigned int mipWidth = width > 1 ? width / 2 : 1, mipHeight = height > 1 ? height / 2 : 1;
+		size_t destination = textureData.data.size();
+
+		textureData.data.resize(destination + mipWidth * mipHeight * 4);
+
+		for (unsigned int y = 0; y < mipHeight; y++)
+			for (unsigned int x = 0; x < mipWidth; x++)
+				for (unsigned int c = 0; c < 4; c++)
+				{
+					// odd sizes clamp the second texel to the edge
+					unsigned int x0 = x * 2, x1 = x * 2 + 1 < width ? x * 2 + 1 : x * 2;
+					unsigned int y0 = y * 2, y1 = y * 2 + 1 < height ? y * 2 + 1 : y * 2;
+
+					unsigned int sum = textureData.data[source + (y0 * width + x0) * 4 + c] + textureData.data[source + (y0 * width + x1) * 4 + c] + textureData.data[source + (y1 * width + x0) * 4 + c] + textureData.data[source + (y1 * width + x1) * 4 + c];
+					textureData.data[destination + (y * mipWidth + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+				}
+
+		source = destination;
+		width = mipWidth;
+		height = mipHeight;
+		textureData.mipLevels++;
+	}
+}
+
+bool D3D11RenderDevice::DecodeTexture(const std::string &textureFilePath, TextureData &textureData) const
+{
+	return DecodeTextureFile(textureFilePath, textureData);
+}
+
+bool D3D11RenderDevice::DecodeTextureFile(const std::string &textureFilePath, TextureData &textureData)
+{
+	size_t dot = textureFilePath.find_last_of('.');
+	std::string extension = dot == std::string::npos ? std::string() : textureFilePath.substr(dot);
+
+	if (extension != ".png" && extension != ".jpg" && extension != ".tga" && extension != ".dds")
+		return false;
+
+	// read the file (mapped, or decompressed from a pack)
+	VirtualFileSystem::File file;
+	if (!VirtualFileSystem::GetInstance().Open(textureFilePath, file))
+		return false;
+
+	// dds files hold gpu formats and their mip levels already, only the dimensions are read from the header
+	if (extension == ".dds")
+	{
+		if (file.GetSize() < 128 || memcmp(file.GetData(), "DDS ", 4))
+			return false;
+
+		uint32_t header[3];     // height, width (offsets 12 and 16) and mip count (offset 28)
+		memcpy(&header[0], file.GetData() + 12, sizeof(uint32_t) * 2);
+		memcpy(&header[2], file.GetData() + 28, sizeof(uint32_t));
+
+		textureData.height = header[0];
+		textureData.width = header[1];
+		textureData.mipLevels = header[2] ? header[2] : 1;
+		textureData.format = Format::UNKNOWN;
+		textureData.isFile = true;
+		textureData.data.assign(file.GetData(), file.GetData() + file.GetSize());
+
+		return true;
+	}
+
+	// wic decoding to rgba8, com is initialised once on each loading thread
+	static thread_local HRESULT comInitialized = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	if (FAILED(comInitialized) && comInitialized != RPC_E_CHANGED_MODE)
+		return false;
+
+	Microsoft::WRL::ComPtr<IWICImagingFactory> factory;
+	Microsoft::WRL::ComPtr<IWICStream> stream;
+	Microsoft::WRL::ComPtr<IWICBitmapDecoder> decoder;
+	Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> frame;
+	Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
+
+	HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+	if (SUCCEEDED(hr))
+		hr = factory->CreateStream(&stream);
+	if (SUCCEEDED(hr))
+		hr = stream->InitializeFromMemory(const_cast<BYTE*>(file.GetData()), (DWORD)file.GetSize());
+	if (SUCCEEDED(hr))
+		hr = factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, &decoder);
+	if (SUCCEEDED(hr))
+		hr = decoder->GetFrame(0, &frame);
+	if (SUCCEEDED(hr))
+		hr = factory->CreateFormatConverter(&converter);
+	if (SUCCEEDED(hr))
+		hr = converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+
+	UINT width = 0, height = 0;
+	if (SUCCEEDED(hr))
+		hr = converter->GetSize(&width, &height);
+	if (FAILED(hr) || width == 0 || height == 0)
+		return false;
+
+	textureData.width = width;
+	textureData.height = height;
+	textureData.format = Format::R8G8B8A8_UNORM;
+	textureData.isFile = false;
+	textureData.data.resize(width * height * 4);
+
+	if (FAILED(converter->CopyPixels(nullptr, width * 4, (UINT)textureData.data.size(), &textureData.data[0])))
+		return false;
+
+	GenerateMips(textureData);
+
+	return true;
+}
+
+TextureHandle D3D11RenderDevice::CreateTexture(const TextureData &textureData, unsigned int firstMip)
+{
+	ID3D11Resource *resource = nullptr;
+	ID3D11ShaderResourceView *shaderResourceView = nullptr;
+
+	if (firstMip >= textureData.mipLevels)
+		firstMip = textureData.mipLevels ? textureData.mipLevels - 1 : 0;
+
+	if (textureData.isFile)
+	{
+		// no device context: dds files come with their mip levels, the loader skips the ones larger than the maximum size
+		size_t maxSize = (textureData.width > textureData.height ? textureData.width : textureData.height) >> firstMip;
+		if (firstMip == 0)
+			maxSize = 0;
+		else if (maxSize == 0)
+			maxSize = 1;
+
+		if (FAILED(DirectX::CreateDDSTextureFromMemory(mDevice, &textureData.data[0], textureData.data.size(), &resource, &shaderResourceView, maxSize)))
+			ErrorBox("couldn't create shader resource view");
+
+		resource->Release();
+
+		return reinterpret_cast<TextureHandle>(shaderResourceView);
+	}
+
+	unsigned int width = textureData.width, height = textureData.height;
+	size_t offset = 0;
+
+	// skip the finer mips
+	for (unsigned int mip = 0; mip < firstMip; mip++)
+	{
+		offset += width * height * 4;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	D3D11_TEXTURE2D_DESC textureDesc;
+
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.Format = GetFormat(textureData.format);
+	textureDesc.MipLevels = textureData.mipLevels - firstMip;
+	textureDesc.ArraySize = 1;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	// one subresource per mip level
+	std::vector<D3D11_SUBRESOURCE_DATA> levels(textureDesc.MipLevels);
+
+	for (D3D11_SUBRESOURCE_DATA &level : levels)
+	{
+		level.pSysMem = &textureData.data[offset];
+		level.SysMemPitch = width * 4;
+		level.SysMemSlicePitch = 0;
+
+		offset += width * height * 4;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	ID3D11Texture2D *texture;
+	HRESULT hr = mDevice->CreateTexture2D(&textureDesc, &levels[0], &texture);
+	if (FAILED(hr))
+		ErrorBox("couldn't create texture resource");
+
+	hr = mDevice->CreateShaderResourceView(texture, nullptr, &shaderResourceView);
+	if (FAILED(hr))
+		ErrorBox("couldn't create shader resource view from texture");
+
+	texture->Release();   // the view holds a reference to the texture
+
+	return reinterpret_cast<TextureHandle>(shaderResourceView);
+}
+
+void D3D11RenderDevice::UpdateTexture(TextureHandle texture, const void *data, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int rowPitch)
+{
+	ID3D11Resource *resource;
+	reinterpret_cast<ID3D11ShaderResourceView*>(texture)->GetResource(&resource);
+
+	D3D11_BOX box{};
+	box.left = x;
+	box.right = x + width;
+	box.top = y;
+	box.bottom = y + height;
+	box.front = 0;
+	box.back = 1;
+
+	mDeviceContext->UpdateSubresource(resource, 0, &box, data, rowPitch, 0);
+
+	resource->Release();
+}
+
+void D3D11RenderDevice::ReleaseTexture(TextureHandle texture)
+{
+	if (texture)
+		reinterpret_cast<ID3D11ShaderResourceView*>(texture)->Release();
+}
+
+RenderTargetHandle D3D11RenderDevice::CreateRenderTarget(unsigned int width, unsigned int height, TextureHandle &colorTexture)
+{
+	HRESULT hr;
+
+	// texture 2D resource description
+	D3D11_TEXTURE2D_DESC colorBufferTexture2DDesc;
+	colorBufferTexture2DDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	colorBufferTexture2DDesc.Width = width;
+	colorBufferTexture2DDesc.Height = height;
+	colorBufferTexture2DDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	colorBufferTexture2DDesc.Usage = D3D11_USAGE_DEFAULT;
+	colorBufferTexture2DDesc.CPUAccessFlags = 0;
+	colorBufferTexture2DDesc.ArraySize = 1;
+	colorBufferTexture2DDesc.MipLevels = 1;
+	colorBufferTexture2DDesc.SampleDesc.Count = 1;
+	colorBufferTexture2DDesc.SampleDesc.Quality = 0;
+	colorBufferTexture2DDesc.MiscFlags = 0;
+
+	// create Texture2D resource
+	ID3D11Texture2D *colorBuffer;
+	hr = mDevice->CreateTexture2D(&colorBufferTexture2DDesc, nullptr, &colorBuffer);
+	if (FAILED(hr))
+		ErrorBox("unable to create texture for framebuffer's color buffer");
+
+	// render target view description
+	D3D11_RENDER_TARGET_VIEW_DESC colorBufferRenderTargetViewDesc;
+	colorBufferRenderTargetViewDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	colorBufferRenderTargetViewDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+	colorBufferRenderTargetViewDesc.Texture2D.MipSlice = 0;
+
+	// create render target view
+	ID3D11RenderTargetView *renderTargetView;
+	hr = mDevice->CreateRenderTargetView(colorBuffer, &colorBufferRenderTargetViewDesc, &renderTargetView);
+	if (FAILED(hr))
+		ErrorBox("unable to create render target view for color buffer");
+
+	// shader resource view description
+	D3D11_SHADER_RESOURCE_VIEW_DESC colorBufferShaderResourceViewDesc;
+	colorBufferShaderResourceViewDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	colorBufferShaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	colorBufferShaderResourceViewDesc.Texture2D.MipLevels = 1;
+	colorBufferShaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
+
+	// create shader resource view
+	ID3D11ShaderResourceView *shaderResourceView;
+	hr = mDevice->CreateShaderResourceView(colorBuffer, &colorBufferShaderResourceViewDesc, &shaderResourceView);
+	if (FAILED(hr))
+		ErrorBox("unable to create shader resource view for color buffer");
+
+	colorBuffer->Release();    // the views hold a reference to the texture
+
+	colorTexture = reinterpret_cast<TextureHandle>(shaderResourceView);
+
+	return reinterpret_cast<RenderTargetHandle>(renderTargetView);
+}
+
+DepthTargetHandle D3D11RenderDevice::CreateDepthTarget(unsigned int width, unsigned int height, TextureHandle &depthTexture)
+{
+	HRESULT hr;
+
+	// Texture2D resource description
+	D3D11_TEXTURE2D_DESC depthStencilBufferTexture2DDesc;
+	depthStencilBufferTexture2DDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
+	depthStencilBufferTexture2DDesc.Width = width;
+	depthStencilBufferTexture2DDesc.Height = height;
+	depthStencilBufferTexture2DDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+	depthStencilBufferTexture2DDesc.Usage = D3D11_USAGE_DEFAULT;
+	depthStencilBufferTexture2DDesc.CPUAccessFlags = 0;
+	depthStencilBufferTexture2DDesc.ArraySize = 1;
+	depthStencilBufferTexture2DDesc.MipLevels = 1;
+	depthStencilBufferTexture2DDesc.SampleDesc.Count = 1;
+	depthStencilBufferTexture2DDesc.SampleDesc.Quality = 0;
+	depthStencilBufferTexture2DDesc.MiscFlags = 0;
+
+	// create Texture2D resource
+	ID3D11Texture2D *depthStencilBuffer;
+	hr = mDevice->CreateTexture2D(&depthStencilBufferTexture2DDesc, nullptr, &depthStencilBuffer);
+	if (FAILED(hr))
+		ErrorBox("unable to create texture for framebuffer's depth stencil buffer");
+
+	// create depth stencil view
+	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilBufferDepthStencilViewDesc;
+	depthStencilBufferDepthStencilViewDesc.Texture2D.MipSlice = 0;
+	depthStencilBufferDepthStencilViewDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthStencilBufferDepthStencilViewDesc.Flags = 0;
+	depthStencilBufferDepthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+
+	ID3D11DepthStencilView *depthStencilView;
+	hr = mDevice->CreateDepthStencilView(depthStencilBuffer, &depthStencilBufferDepthStencilViewDesc, &depthStencilView);
+	if (FAILED(hr))
+		ErrorBox("unable to create depth stencil view for depth stencil buffer");
+
+	// create shader resource view
+	D3D11_SHADER_RESOURCE_VIEW_DESC depthStencilBufferShaderResourceViewDesc;
+	depthStencilBufferShaderResourceViewDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+	depthStencilBufferShaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	depthStencilBufferShaderResourceViewDesc.Texture2D.MipLevels = 1;
+	depthStencilBufferShaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
+
+	ID3D11ShaderResourceView *shaderResourceView;
+	hr = mDevice->CreateShaderResourceView(depthStencilBuffer, &depthStencilBufferShaderResourceViewDesc, &shaderResourceView);
+	if (FAILED(hr))
+		ErrorBox("unable to create shader resource view for depth stencil buffer");
+
+	depthStencilBuffer->Release();    // the views hold a reference to the texture
+
+	depthTexture = reinterpret_cast<TextureHandle>(shaderResourceView);
+
+	return reinterpret_cast<DepthTargetHandle>(depthStencilView);
+}
+
+void D3D11RenderDevice::ReleaseRenderTarget(RenderTargetHandle renderTarget)
+{
+	if (renderTarget)
+		reinterpret_cast<ID3D11RenderTargetView*>(renderTarget)->Release();
+}
+
+void D3D11RenderDevice::ReleaseDepthTarget(DepthTargetHandle depthTarget)
+{
+	if (depthTarget)
+		reinterpret_cast<ID3D11DepthStencilView*>(depthTarget)->Release();
+}
+
+SamplerHandle D3D11RenderDevice::CreateSampler(Filter filter, AddressMode addressMode)
+{
+	D3D11_TEXTURE_ADDRESS_MODE textureAddressMode = addressMode == AddressMode::WRAP ? D3D11_TEXTURE_ADDRESS_WRAP : D3D11_TEXTURE_ADDRESS_CLAMP;
+
+	// describe sampler state
+	D3D11_SAMPLER_DESC samplerDesc = {};
+	samplerDesc.Filter = filter == Filter::POINT ? D3D11_FILTER_MIN_MAG_MIP_POINT : D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDesc.AddressU = textureAddressMode;
+	samplerDesc.AddressV = textureAddressMode;
+	samplerDesc.AddressW = textureAddressMode;
+	samplerDesc.MipLODBias = 0.0f;
+	samplerDesc.MaxAnisotropy = 1;
+	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+	samplerDesc.BorderColor[0] = 0;
+	samplerDesc.BorderColor[1] = 0;
+	samplerDesc.BorderColor[2] = 0;
+	samplerDesc.BorderColor[3] = 0;
+	samplerDesc.MinLOD = 0.0f;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+	// create sampler state
+	ID3D11SamplerState *samplerState;
+	HRESULT hr = mDevice->CreateSamplerState(&samplerDesc, &samplerState);
+	if (FAILED(hr))
+		ErrorBox("sampler state creation failed");
+
+	return reinterpret_cast<SamplerHandle>(samplerState);
+}
+
+ShaderHandle D3D11RenderDevice::CreateShader(const wchar_t *vertexShaderFilePath, const wchar_t *geometryShaderFilePath, const wchar_t *pixelShaderFilePath)
+{
+	HRESULT hr;
+	ID3DBlob *geometryShaderCode;
+	ID3DBlob *pixelShaderCode;
+
+	ShaderProgram *program = new ShaderProgram{ nullptr, nullptr, nullptr, nullptr };
+
+	// compile shaders
+	ID3DBlob *error;
+
+	if (vertexShaderFilePath)
+	{
+		hr = D3DCompileFromFile(vertexShaderFilePath, nullptr, nullptr, "main", "vs_5_0", 0, 0, &program->vertexShaderCode, &error);
+		if (FAILED(hr))
+		{
+			OutputDebugStringA((LPCSTR)error->GetBufferPointer());
+			ErrorBox("vertex shader compilation failed");
+		}
+
+		hr = mDevice->CreateVertexShader(program->vertexShaderCode->GetBufferPointer(), program->vertexShaderCode->GetBufferSize(), nullptr, &program->vertexShader);
+		if (FAILED(hr))
+			ErrorBox("vertex shader creation failed");
+	}
+
+	if (geometryShaderFilePath)
+	{
+		hr = D3DCompileFromFile(geometryShaderFilePath, nullptr, nullptr, "main", "gs_5_0", 0, 0, &geometryShaderCode, &error);
+		if (FAILED(hr))
+		{
+			OutputDebugStringA((LPCSTR)error->GetBufferPointer());
+			ErrorBox("geometry shader compilation failed");
+		}
+
+		hr = mDevice->CreateGeometryShader(geometryShaderCode->GetBufferPointer(), geometryShaderCode->GetBufferSize(), nullptr, &program->geometryShader);
+		if (FAILED(hr))
+			ErrorBox("geometry shader creation failed");
+
+		geometryShaderCode->Release();
+	}
+
+	if (pixelShaderFilePath)
+	{
+		hr = D3DCompileFromFile(pixelShaderFilePath, nullptr, nullptr, "main", "ps_5_0", 0, 0, &pixelShaderCode, &error);
+		if (FAILED(hr))
+		{
+			OutputDebugStringA((LPCSTR)error->GetBufferPointer());
+			ErrorBox("pixel shader compilation failed");
+		}
+
+		hr = mDevice->CreatePixelShader(pixelShaderCode->GetBufferPointer(), pixelShaderCode->GetBufferSize(), nullptr, &program->pixelShader);
+		if (FAILED(hr))
+			ErrorBox("pixel shader creation failed");
+
+		pixelShaderCode->Release();
+	}
+
+	return reinterpret_cast<ShaderHandle>(program);
+}
+
+InputLayoutHandle D3D11RenderDevice::CreateInputLayout(ShaderHandle shader, const InputElement *elements, unsigned int numElements)
+{
+	ShaderProgram *program = reinterpret_cast<ShaderProgram*>(shader);
+
+	// describe input layout
+	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayout(numElements);
+	for (unsigned int i = 0; i < numElements; i++)
+	{
+		inputLayout[i].SemanticName = elements[i].semantic;
+		inputLayout[i].SemanticIndex = elements[i].semanticIndex;
+		inputLayout[i].Format = GetFormat(elements[i].format);
+		inputLayout[i].InputSlot = elements[i].slot;
+		inputLayout[i].AlignedByteOffset = elements[i].offset == APPEND_ALIGNED ? D3D11_APPEND_ALIGNED_ELEMENT : elements[i].offset;
+		inputLayout[i].InputSlotClass = elements[i].perInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+		inputLayout[i].InstanceDataStepRate = elements[i].perInstance ? 1 : 0;
+	}
+
+	// create input layout
+	ID3D11InputLayout *d3dInputLayout;
+	HRESULT hr = mDevice->CreateInputLayout(&inputLayout[0], numElements, program->vertexShaderCode->GetBufferPointer(), program->vertexShaderCode->GetBufferSize(), &d3dInputLayout);
+	if (FAILED(hr))
+		ErrorBox("input layout creation failed");
+
+	return reinterpret_cast<InputLayoutHandle>(d3dInputLayout);
+}
+
+/**** pipeline state ****/
+
+void D3D11RenderDevice::SetShader(ShaderHandle shader, InputLayoutHandle inputLayout)
+{
+	ShaderProgram *program = reinterpret_cast<ShaderProgram*>(shader);
+
+	// set shaders
+	mDeviceContext->VSSetShader(program->vertexShader, nullptr, 0);
+	mDeviceContext->GSSetShader(program->geometryShader, nullptr, 0);
+	mDeviceContext->PSSetShader(program->pixelShader, nullptr, 0);
+
+	// set input layout
+	mDeviceContext->IASetInputLayout(reinterpret_cast<ID3D11InputLayout*>(inputLayout));
+}
+
+void D3D11RenderDevice::SetPrimitiveTopology(Topology topology)
+{
+	mDeviceContext->IASetPrimitiveTopology(topology == Topology::TRIANGLE_LIST ? D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST : D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+}
+
+void D3D11RenderDevice::SetVertexBuffers(unsigned int firstSlot, unsigned int numBuffers, const BufferHandle *buffers, const unsigned int *strides)
+{
+	static const unsigned int offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};   // all elements are 0
+
+	mDeviceContext->IASetVertexBuffers(firstSlot, numBuffers, reinterpret_cast<ID3D11Buffer* const*>(buffers), strides, offsets);
+}
+
+void D3D11RenderDevice::SetIndexBuffer(BufferHandle buffer)
+{
+	mDeviceContext->IASetIndexBuffer(reinterpret_cast<ID3D11Buffer*>(buffer), DXGI_FORMAT_R32_UINT, 0);
+}
+
+void D3D11RenderDevice::SetConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer)
+{
+	ID3D11Buffer *constantBuffer = reinterpret_cast<ID3D11Buffer*>(buffer);
+
+	if (stage == ShaderStage::VERTEX)
+		mDeviceContext->VSSetConstantBuffers(slot, 1, &constantBuffer);
+	else if (stage == ShaderStage::GEOMETRY)
+		mDeviceContext->GSSetConstantBuffers(slot, 1, &constantBuffer);
+	else
+		mDeviceContext->PSSetConstantBuffers(slot, 1, &constantBuffer);
+}
+
+void D3D11RenderDevice::SetTexture(ShaderStage stage, unsigned int slot, TextureHandle texture)
+{
+	ID3D11ShaderResourceView *shaderResourceView = reinterpret_cast<ID3D11ShaderResourceView*>(texture);
+
+	if (stage == ShaderStage::VERTEX)
+		mDeviceContext->VSSetShaderResources(slot, 1, &shaderResourceView);
+	else if (stage == ShaderStage::GEOMETRY)
+		mDeviceContext->GSSetShaderResources(slot, 1, &shaderResourceView);
+	else
+		mDeviceContext->PSSetShaderResources(slot, 1, &shaderResourceView);
+}
+
+void D3D11RenderDevice::SetSampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler)
+{
+	ID3D11SamplerState *samplerState = reinterpret_cast<ID3D11SamplerState*>(sampler);
+
+	if (stage == ShaderStage::VERTEX)
+		mDeviceContext->VSSetSamplers(slot, 1, &samplerState);
+	else if (stage == ShaderStage::GEOMETRY)
+		mDeviceContext->GSSetSamplers(slot, 1, &samplerState);
+	else
+		mDeviceContext->PSSetSamplers(slot, 1, &samplerState);
+}
+
+void D3D11RenderDevice::SetRasterizerState(RasterizerState state)
+{
+	mDeviceContext->RSSetState(mRasterizerStateGroup[static_cast<int>(state)]);
+}
+
+void D3D11RenderDevice::SetBlendState(BlendState state)
+{
+	float blendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	mDeviceContext->OMSetBlendState(mBlendStateGroup[static_cast<int>(state)], blendFactor, 0xFFFFFFFF);
+}
+
+void D3D11RenderDevice::SetDepthStencilState(DepthStencilState state)
+{
+	mDeviceContext->OMSetDepthStencilState(mDepthStencilStateGroup[static_cast<int>(state)], 0);
+}
+
+void D3D11RenderDevice::SetRenderTargets(RenderTargetHandle renderTarget, DepthTargetHandle depthTarget)
+{
+	mCurrentRenderTarget = reinterpret_cast<ID3D11RenderTargetView*>(renderTarget);
+	mCurrentDepthTarget = reinterpret_cast<ID3D11DepthStencilView*>(depthTarget);
+
+	mDeviceContext->OMSetRenderTargets(1, &mCurrentRenderTarget, mCurrentDepthTarget);
+}
+
+void D3D11RenderDevice::GetRenderTargets(RenderTargetHandle &renderTarget, DepthTargetHandle &depthTarget) const
+{
+	renderTarget = reinterpret_cast<RenderTargetHandle>(mCurrentRenderTarget);
+	depthTarget = reinterpret_cast<DepthTargetHandle>(mCurrentDepthTarget);
+}
+
+void D3D11RenderDevice::SetViewport(const Viewport &viewport)
+{
+	mViewport = viewport;
+
+	D3D11_VIEWPORT d3dViewport = {};
+	d3dViewport.TopLeftX = viewport.x;
+	d3dViewport.TopLeftY = viewport.y;
+	d3dViewport.Width = viewport.width;
+	d3dViewport.Height = viewport.height;
+	d3dViewport.MinDepth = 0.0f;
+	d3dViewport.MaxDepth = 1.0f;
+
+	mDeviceContext->RSSetViewports(1, &d3dViewport);
+}
+
+/**** commands ****/
+
+void D3D11RenderDevice::ClearRenderTarget(RenderTargetHandle renderTarget, const float color[4])
+{
+	mDeviceContext->ClearRenderTargetView(reinterpret_cast<ID3D11RenderTargetView*>(renderTarget), color);
+}
+
+void D3D11RenderDevice::ClearDepthTarget(DepthTargetHandle depthTarget)
+{
+	mDeviceContext->ClearDepthStencilView(reinterpret_cast<ID3D11DepthStencilView*>(depthTarget), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+}
+
+void D3D11RenderDevice::Draw(unsigned int vertexCount, unsigned int firstVertex)
+{
+	mDeviceContext->Draw(vertexCount, firstVertex);
+}
+
+void D3D11RenderDevice::DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex)
+{
+	mDeviceContext->DrawIndexed(indexCount, firstIndex, baseVertex);
+}
+
+void D3D11RenderDevice::DrawInstanced(unsigned int vertexCount, unsigned int instanceCount, unsigned int firstVertex, unsigned int firstInstance)
+{
+	mDeviceContext->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+void D3D11RenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int firstIndex, int baseVertex, unsigned int firstInstance)
+{
+	mDeviceContext->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+}
+
+void D3D11RenderDevice::Present()
+{
+	mSwapChain->Present(0, 0);
+}
@@ -0,0 +1,107 @@
+#ifndef D3D11_RENDER_DEVICE_H
+#define D3D11_RENDER_DEVICE_H
+
+#include "RenderDevice.h"
+#include <d3d11.h>
+#include <vector>
+
+/**** direct3d 11 render device: handles are the d3d11 interfaces (views for textures and targets) ****/
+
+class D3D11RenderDevice : public RenderDevice
+{
+public:
+	D3D11RenderDevice(HWND window, bool msaaEnabled = true);
+	~D3D11RenderDevice();
+
+	RenderTargetHandle GetBackBufferTarget() const override { return reinterpret_cast<RenderTargetHandle>(mRenderTargetView); }
+	DepthTargetHandle GetBackBufferDepthTarget() const override { return reinterpret_cast<DepthTargetHandle>(mDepthStencilView); }
+
+	BufferHandle CreateBuffer(BufferType type, Usage usage, unsigned int size, const void *data) override;
+	void ReleaseBuffer(BufferHandle buffer) override;
+
+	void *Map(BufferHandle buffer, MapMode mode) override;
+	void Unmap(BufferHandle buffer) override;
+
+	TextureHandle CreateTexture(unsigned int width, unsigned int height, Format format, const void *data) override;
+	TextureHandle LoadTexture(const std::string &filePath) override;
+	bool DecodeTexture(const std::string &filePath, TextureData &textureData) const override;
+	static bool DecodeTextureFile(const std::string &filePath, TextureData &textureData);     // wic and dds decoding needs no device (asset cook)
+	TextureHandle CreateTexture(const TextureData &textureData, unsigned int firstMip) override;
+	void UpdateTexture(TextureHandle texture, const void *data, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int rowPitch) override;
+	void ReleaseTexture(TextureHandle texture) override;
+
+	RenderTargetHandle CreateRenderTarget(unsigned int width, unsigned int height, TextureHandle &colorTexture) override;
+	DepthTargetHandle CreateDepthTarget(unsigned int width, unsigned int height, TextureHandle &depthTexture) override;
+	void ReleaseRenderTarget(RenderTargetHandle renderTarget) override;
+	void ReleaseDepthTarget(DepthTargetHandle depthTarget) override;
+
+	SamplerHandle CreateSampler(Filter filter, AddressMode addressMode) override;
+
+	ShaderHandle CreateShader(const wchar_t *vertexShaderFilePath, const wchar_t *geometryShaderFilePath, const wchar_t *pixelShaderFilePath) override;
+	InputLayoutHandle CreateInputLayout(ShaderHandle shader, const InputElement *elements, unsigned int numElements) override;
+
+	void SetShader(ShaderHandle shader, InputLayoutHandle inputLayout) override;
+	void SetPrimitiveTopology(Topology topology) override;
+
+	void SetVertexBuffers(unsigned int firstSlot, unsigned int numBuffers, const BufferHandle *buffers, const unsigned int *strides) override;
+	void SetIndexBuffer(BufferHandle buffer) override;
+	void SetConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) override;
+	void SetTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) override;
+	void SetSampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) override;
+
+	void SetRasterizerState(RasterizerState state) override;
+	void SetBlendState(BlendState state) override;
+	void SetDepthStencilState(DepthStencilState state) override;
+
+	void SetRenderTargets(RenderTargetHandle renderTarget, DepthTargetHandle depthTarget) override;
+	void GetRenderTargets(RenderTargetHandle &renderTarget, DepthTargetHandle &depthTarget) const override;
+
+	void SetViewport(const Viewport &viewport) override;
+	Viewport GetViewport() const override { return mViewport; }
+
+	void ClearRenderTarget(RenderTargetHandle renderTarget, const float color[4]) override;
+	void ClearDepthTarget(DepthTargetHandle depthTarget) override;
+
+	void Draw(unsigned int vertexCount, unsigned int firstVertex) override;
+	void DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex) override;
+	void DrawInstanced(unsigned int vertexCount, unsigned int instanceCount, unsigned int firstVertex, unsigned int firstInstance) override;
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int firstIndex, int baseVertex, unsigned int firstInstance) override;
+
+	void Present() override;
+
+	ID3D11Device *GetDevice() { return mDevice; }
+	ID3D11DeviceContext *GetDeviceContext() { return mDeviceContext; }
+private:
+	struct ShaderProgram
+	{
+		ID3D11VertexShader *vertexShader;
+		ID3D11GeometryShader *geometryShader;
+		ID3D11PixelShader *pixelShader;
+		ID3DBlob *vertexShaderCode;     // input layouts are validated against the vertex shader signature
+	};
+
+	static DXGI_FORMAT GetFormat(Format format);
+
+	void CreateRenderStates();
+
+	ID3D11Device *mDevice;
+	ID3D11DeviceContext *mDeviceContext;
+	IDXGISwapChain *mSwapChain;
+	ID3D11RenderTargetView *mRenderTargetView;
+	ID3D11DepthStencilView *mDepthStencilView;
+
+	bool mMSAAEnabled;
+	int mSampleCount;
+	int mSampleQuality;
+
+	// currently bound targets and viewport, so that they can be restored without querying the context
+	ID3D11RenderTargetView *mCurrentRenderTarget;
+	ID3D11DepthStencilView *mCurrentDepthTarget;
+	Viewport mViewport;
+
+	std::vector<ID3D11RasterizerState*> mRasterizerStateGroup;    // same order as the enumerators
+	std::vector<ID3D11BlendState*> mBlendStateGroup;
+	std::vector<ID3D11DepthStencilState*> mDepthStencilStateGroup;
+};
+
+#endif  // D3D11_RENDER_DEVICE_H
@@ -54,6 +54,8 @@ T &Entity::AddComponent(T *component)
 {
 	static_assert(std::is_base_of<U,T>::value, "T is not a component derived from U");
 
+	component->SetOwner(this);
+
 	mComponents[GetComponentID<U>()] = component;  // TODO: multiple components
 	
 	if (!mComponentMask.Test(GetComponentID<U>()))
@@ -22,7 +22,10 @@ void FontManager::LoadFontFace(const std::string &fontName)
 
 	std::string path = "fonts/" + fontName;
 
-	if (FT_New_Face(mFreetypeLib, path.c_str(), 0, &face)) 
+	// the face reads from the file data (mapped or from a pack), which is kept until the face is done
+	VirtualFileSystem::File &file = mFontFiles[fontName];
+
+	if (!VirtualFileSystem::GetInstance().Open(path, file) || FT_New_Memory_Face(mFreetypeLib, file.GetData(), (FT_Long)file.GetSize(), 0, &face)) 
 		ErrorBox("Could not open font");
 
 	mFontFaces.insert(std::pair<std::string, FT_Face>(fontName, face));
@@ -37,10 +40,9 @@ void FontManager::UnloadFontFace(const std::string &fontName)
 
 	FT_Done_Face(it->second);
 	mFontFaces.erase(it);
+	mFontFiles.erase(fontName);
 }
 
-#include <d3d11.h>
-
 void FontManager::LoadFont(std::string const &fontName, unsigned size)
 {
 	FT_Face face = mFontFaces[fontName];
@@ -68,7 +70,7 @@ void FontManager::LoadFont(std::string const &fontName, unsigned size)
 			lineSpacing = face->glyph->metrics.vertAdvance;
 	}
 
-	Texture fontAtlas(Texture(fontAtlasWidth, fontAtlasHeight, DXGI_FORMAT_R8_UNORM));
+	Texture fontAtlas(Texture(fontAtlasWidth, fontAtlasHeight, RenderDevice::Format::R8_UNORM));
 	
 	int offset = 0;
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <map>
 #include "Font.h"
+#include "VirtualFileSystem.h"
 
 #include "ft2build.h"
 #include FT_FREETYPE_H
@@ -23,6 +24,7 @@ private:
 	FT_Library mFreetypeLib;
 
 	std::map<std::string,FT_Face> mFontFaces;
+	std::map<std::string,VirtualFileSystem::File> mFontFiles;
 	std::map<std::string,std::map<unsigned,Font>> mFonts;
 };
 
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <d3d11.h>
 #include "GraphicsSystem.h"
 
 class FrameBuffer
@@ -12,8 +11,8 @@ public:
 	void Set(bool depthOnly = false);
 	void Unset();
 
-	ID3D11ShaderResourceView *GetColorBuffer() { return mColorBufferShaderResourceView; }
-	ID3D11ShaderResourceView *GetDepthStencilBuffer() { return mDepthStencilBufferShaderResourceView; }
+	TextureHandle GetColorBuffer() { return mColorBufferShaderResourceView; }
+	TextureHandle GetDepthStencilBuffer() { return mDepthStencilBufferShaderResourceView; }
 	
 	int GetWidth() const { return mWidth; }
 	int GetHeight() const { return mHeight; }
@@ -21,18 +20,16 @@ private:
 	int mWidth;
 	int mHeight;
 
-	ID3D11Texture2D * mColorBuffer;
-	ID3D11RenderTargetView *mColorBufferRenderTargetView;
-	ID3D11ShaderResourceView *mColorBufferShaderResourceView;
+	RenderTargetHandle mColorBufferRenderTargetView;
+	TextureHandle mColorBufferShaderResourceView;
 	
-	ID3D11Texture2D * mDepthStencilBuffer;
-	ID3D11DepthStencilView *mDepthStencilView;
-	ID3D11ShaderResourceView *mDepthStencilBufferShaderResourceView;
+	DepthTargetHandle mDepthStencilView;
+	TextureHandle mDepthStencilBufferShaderResourceView;
 	
-	ID3D11RenderTargetView *mOldRenderTargetView;
-	ID3D11DepthStencilView *mOldDepthStencilView;
+	RenderTargetHandle mOldRenderTargetView;
+	DepthTargetHandle mOldDepthStencilView;
 	
-	D3D11_VIEWPORT mViewport;
-	D3D11_VIEWPORT mOldViewport;
+	RenderDevice::Viewport mViewport;
+	RenderDevice::Viewport mOldViewport;
 };
 
@@ -0,0 +1,123 @@
+#include "FrustumCuller.h"
+#include <cmath>
+#include <cfloat>
+
+#ifdef __AVX__
+	#include <immintrin.h>
+#endif  // __AVX__
+
+void FrustumCuller::Clear()
+{
+	mCenterX.clear(); mCenterY.clear(); mCenterZ.clear();
+	mExtentX.clear(); mExtentY.clear(); mExtentZ.clear();
+
+	mNumBounds = 0;
+}
+
+unsigned int FrustumCuller::AddBounds(const XMFLOAT3 &center, const XMFLOAT3 &extent)
+{
+	// grow by a whole batch, padding bounds sit far outside any frustum (and are never reported anyway)
+	if (mNumBounds == mCenterX.size())
+	{
+		size_t size = mCenterX.size() + LANES;
+
+		mCenterX.resize(size, FLT_MAX); mCenterY.resize(size, FLT_MAX); mCenterZ.resize(size, FLT_MAX);
+		mExtentX.resize(size, 0.0f); mExtentY.resize(size, 0.0f); mExtentZ.resize(size, 0.0f);
+	}
+
+	mCenterX[mNumBounds] = center.x; mCenterY[mNumBounds] = center.y; mCenterZ[mNumBounds] = center.z;
+	mExtentX[mNumBounds] = extent.x; mExtentY[mNumBounds] = extent.y; mExtentZ[mNumBounds] = extent.z;
+
+	return mNumBounds++;
+}
+
+void FrustumCuller::SetBounds(unsigned int index, const XMFLOAT3 &center, const XMFLOAT3 &extent)
+{
+	mCenterX[index] = center.x; mCenterY[index] = center.y; mCenterZ[index] = center.z;
+	mExtentX[index] = extent.x; mExtentY[index] = extent.y; mExtentZ[index] = extent.z;
+}
+
+void FrustumCuller::RemoveBounds(unsigned int index)
+{
+	unsigned int last = --mNumBounds;
+
+	mCenterX[index] = mCenterX[last]; mCenterY[index] = mCenterY[last]; mCenterZ[index] = mCenterZ[last];
+	mExtentX[index] = mExtentX[last]; mExtentY[index] = mExtentY[last]; mExtentZ[index] = mExtentZ[last];
+
+	// the freed slot becomes padding again
+	mCenterX[last] = mCenterY[last] = mCenterZ[last] = FLT_MAX;
+	mExtentX[last] = mExtentY[last] = mExtentZ[last] = 0.0f;
+}
+
+void FrustumCuller::GetBounds(unsigned int index, XMFLOAT3 &center, XMFLOAT3 &extent) const
+{
+	center = XMFLOAT3(mCenterX[index], mCenterY[index], mCenterZ[index]);
+	extent = XMFLOAT3(mExtentX[index], mExtentY[index], mExtentZ[index]);
+}
+
+// Gribb-Hartmann: with row vectors clip = v * M, the planes are combinations of the columns of M (D3D clip space, 0 <= z <= w)
+void FrustumCuller::ExtractPlanes(const XMFLOAT4X4 &m, XMFLOAT4 (&planes)[6])
+{
+	planes[0] = XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);   // left
+	planes[1] = XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);   // right
+	planes[2] = XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);   // bottom
+	planes[3] = XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);   // top
+	planes[4] = XMFLOAT4(m._13, m._23, m._33, m._43);                                   // near
+	planes[5] = XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);   // far
+}
+
+// a box is outside if it is entirely behind one of the planes: n.c + d + |n|.e < 0
+void FrustumCuller::Cull(const XMFLOAT4X4 &viewProjectionMatrix, std::vector<unsigned int> &visible) const
+{
+	visible.clear();
+
+	XMFLOAT4 planes[6];
+	ExtractPlanes(viewProjectionMatrix, planes);
+
+#ifdef __AVX__
+	for (unsigned int i = 0; i < mNumBounds; i += 8)
+	{
+		__m256 centerX = _mm256_loadu_ps(&mCenterX[i]), centerY = _mm256_loadu_ps(&mCenterY[i]), centerZ = _mm256_loadu_ps(&mCenterZ[i]);
+		__m256 extentX = _mm256_loadu_ps(&mExtentX[i]), extentY = _mm256_loadu_ps(&mExtentY[i]), extentZ = _mm256_loadu_ps(&mExtentZ[i]);
+
+		__m256 outside = _mm256_setzero_ps();
+
+		for (const XMFLOAT4 &plane : planes)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane.x)), _mm256_mul_ps(centerY, _mm256_set1_ps(plane.y))), _mm256_add_ps(_mm256_mul_ps(centerZ, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(fabs(plane.x))), _mm256_mul_ps(extentY, _mm256_set1_ps(fabs(plane.y)))), _mm256_mul_ps(extentZ, _mm256_set1_ps(fabs(plane.z))));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		int insideMask = ~_mm256_movemask_ps(outside) & 0xFF;
+
+		for (unsigned int k = 0; insideMask && k < 8 && i + k < mNumBounds; k++, insideMask >>= 1)
+			if (insideMask & 1)
+				visible.push_back(i + k);
+	}
+#else
+	for (unsigned int i = 0; i < mNumBounds; i += 4)
+	{
+		XMVECTOR centerX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterX[i])), centerY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterY[i])), centerZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterZ[i]));
+		XMVECTOR extentX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentX[i])), extentY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentY[i])), extentZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentZ[i]));
+
+		XMVECTOR outside = XMVectorFalseInt();
+
+		for (const XMFLOAT4 &plane : planes)
+		{
+			XMVECTOR distance = centerX * plane.x + centerY * plane.y + centerZ * plane.z + XMVectorReplicate(plane.w);
+			XMVECTOR radius = extentX * fabs(plane.x) + extentY * fabs(plane.y) + extentZ * fabs(plane.z);
+
+			outside = XMVectorOrInt(outside, XMVectorLess(distance + radius, XMVectorZero()));
+		}
+
+		uint32_t lanes[4];
+		XMStoreInt4(lanes, outside);
+
+		for (unsigned int k = 0; k < 4 && i + k < mNumBounds; k++)
+			if (!lanes[k])
+				visible.push_back(i + k);
+	}
+#endif  // __AVX__
+}
@@ -0,0 +1,36 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+using namespace DirectX;
+
+/**** world space axis aligned bounds in SoA layout, culled against the 6 planes of a view-projection frustum ****/
+/**** 8 bounds per iteration with AVX (build with /arch:AVX), 4 per iteration with DirectXMath otherwise ****/
+
+class FrustumCuller
+{
+public:
+	void Clear();
+	unsigned int AddBounds(const XMFLOAT3 &center, const XMFLOAT3 &extent);    // returns the index of the bounds
+	void SetBounds(unsigned int index, const XMFLOAT3 &center, const XMFLOAT3 &extent);
+	void RemoveBounds(unsigned int index);    // the last bounds take the index of the removed ones
+	unsigned int GetNumBounds() const { return mNumBounds; }
+	void GetBounds(unsigned int index, XMFLOAT3 &center, XMFLOAT3 &extent) const;
+
+	// indices of the bounds intersecting the frustum, in ascending order
+	void Cull(const XMFLOAT4X4 &viewProjectionMatrix, std::vector<unsigned int> &visible) const;
+
+	// frustum planes (a, b, c, d) pointing inward, ax + by + cz + d >= 0 inside - not normalised
+	static void ExtractPlanes(const XMFLOAT4X4 &viewProjectionMatrix, XMFLOAT4 (&planes)[6]);
+private:
+	static const unsigned int LANES = 8;    // arrays are padded to a multiple of the widest batch
+
+	std::vector<float> mCenterX, mCenterY, mCenterZ;
+	std::vector<float> mExtentX, mExtentY, mExtentZ;
+	unsigned int mNumBounds = 0;
+};
+
+#endif  // FRUSTUM_CULLER_H
@@ -9,6 +9,9 @@
 #include "CollisionSystem.h"
 #include "EntitySystem.h"
 #include "GUISystem.h"
+#include "AssetLoader.h"
+#include "TextureManager.h"
+#include "VirtualFileSystem.h"
 
 Game &Game::GetInstance()
 {
@@ -21,6 +24,7 @@ void Game::Initialize(HINSTANCE hInstance)
 	int windowWidth = 1024;
 	int windowHeight = 768;
 
+	VirtualFileSystem::GetInstance().Mount("assets.pak");     // packed assets, if any (loose files otherwise)
 	InitializeWindow(hInstance, windowWidth, windowHeight);   // create window
 	GraphicsSystem::GetInstance().Initialize(mWindow);        // initialize graphics system
 	InputSystem::GetInstance().Initialize(mWindow);           // initialize input system
@@ -104,6 +108,8 @@ void Game::UpdateState()
 
 	//GameFSM::GetInstance().OnEvent(EventSystem::GetInstance().GetEvent());
 
+	AssetLoader::GetInstance().Update();             // create the assets loaded in the background, within the frame budget
+	TextureManager::GetInstance().Update();          // stream texture mips in and out under the memory budget
 	PhysicsSystem::GetInstance().Update(dt);         // update physics
 	CollisionSystem::GetInstance().DoCollisions();   // perform collision  detection and resolution
 	InputSystem::GetInstance().ProcessInput();       // invoke delegates
@@ -164,7 +164,7 @@ void PlayGameState::OnEntry()
 	// skybox
 	Entity &skyBox = EntitySystem::GetInstance().AddEntity();
 	skyBox.AddComponent<PositionComponent>(XMFLOAT3(), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
-	skyBox.AddComponent<StaticMeshComponent>(*GeometryGenerator::GenerateSkybox("res/sky.dds"));
+	skyBox.AddComponent<StaticMeshComponent>(GeometryGenerator::GenerateSkybox("res/sky.dds"));
 	skyBox.AddComponent<SkyboxComponent>();
 
 	// player + camera
@@ -175,7 +175,7 @@ void PlayGameState::OnEntry()
 	playerMaterial.AddSpecularMap("materials/futuristic panel/futuristic_metallic.png");
 	playerMaterial.AddNormalMap("materials/futuristic panel/futuristic_normal.png");
 
-	player.AddComponent<StaticMeshComponent>(*GeometryGenerator::GenerateSphere(1.0f, playerMaterial));
+	player.AddComponent<StaticMeshComponent>(GeometryGenerator::GenerateSphere(1.0f, playerMaterial));
 	PositionComponent &positionComponentP = player.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 6.0f, -20.0f), XMFLOAT3(XMConvertToRadians(30.0f), XMConvertToRadians(0.0f), XMConvertToRadians(0.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	CameraComponent &cameraComponent = player.AddComponent<CameraComponent>(XMConvertToRadians(45.0f), 3.0f / 2.0f, 0.1f, 500.0f, &positionComponentP, XMFLOAT3(0.0f, 3.0f, -15.0f), XMFLOAT3(XMConvertToRadians(0.0f), XMConvertToRadians(0.0f), XMConvertToRadians(0.0f)));
 	cameraComponent.SetActive(true);
@@ -204,7 +204,7 @@ void PlayGameState::OnEntry()
 	sphere1Material.AddSpecularMap("materials/rusted iron/rust_metallic.png");
 	sphere1Material.AddNormalMap("materials/rusted iron/rust_normal.png");
 
-	sphere1.AddComponent<StaticMeshComponent>(*GeometryGenerator::GenerateSphere(1.0f, sphere1Material));
+	sphere1.AddComponent<StaticMeshComponent>(GeometryGenerator::GenerateSphere(1.0f, sphere1Material));
 	PositionComponent &positionComponent0 = sphere1.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(XMConvertToRadians(90.0f), XMConvertToRadians(0.0f), XMConvertToRadians(0.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	sphere1.AddComponent<MotionComponent>();
 	sphere1.AddComponent<ShadowComponent>();
@@ -233,7 +233,7 @@ void PlayGameState::OnEntry()
 	sphere2Material.AddDiffuseMap("res/checkers.jpg");
 	sphere2Material.SetSpecularColor(XMFLOAT3(1.0f, 1.0f, 1.0f));
 
-	sphere2.AddComponent<StaticMeshComponent>(*GeometryGenerator::GenerateSphere(1.0f, sphere2Material));
+	sphere2.AddComponent<StaticMeshComponent>(GeometryGenerator::GenerateSphere(1.0f, sphere2Material));
 	PositionComponent &positionComponent2 = sphere2.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 5.0f, 1.0f), XMFLOAT3(XMConvertToRadians(90.0f), XMConvertToRadians(0.0f), XMConvertToRadians(0.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	sphere2.AddComponent<MotionComponent>(XMFLOAT3(2.0f, 0.0f, 0.0f));
 	sphere2.AddComponent<ShadowComponent>();
@@ -265,7 +265,7 @@ void PlayGameState::OnEntry()
 	box1Material.AddNormalMap("materials/concrete/concrete_normal.png");
 	box1Material.AddSpecularMap("materials/concrete/concrete_metallic.png");
 	
-	box1.AddComponent<StaticMeshComponent>(*GeometryGenerator::GenerateBox(XMFLOAT3(2.0f, 4.0f, 3.0f), box1Material));
+	box1.AddComponent<StaticMeshComponent>(GeometryGenerator::GenerateBox(XMFLOAT3(2.0f, 4.0f, 3.0f), box1Material));
 	box1.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 10.0f, 10.0f), XMFLOAT3(XMConvertToRadians(90.0f), XMConvertToRadians(0.0f), XMConvertToRadians(0.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	box1.AddComponent<MotionComponent>();
 	box1.AddComponent<ShadowComponent>();
@@ -295,7 +295,7 @@ void PlayGameState::OnEntry()
 	box2Material.AddSpecularMap("materials/snow/snow_metallic.png");
 	box2Material.AddNormalMap("materials/snow/snow_normal.png");
 	
-	box2.AddComponent<StaticMeshComponent>(*GeometryGenerator::GenerateBox(XMFLOAT3(1.0f, 1.0f, 1.0f), box2Material));
+	box2.AddComponent<StaticMeshComponent>(GeometryGenerator::GenerateBox(XMFLOAT3(1.0f, 1.0f, 1.0f), box2Material));
 	
 	PositionComponent &positionComponent3 = box2.AddComponent<PositionComponent>(XMFLOAT3(4.0f, 12.0f, 10.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	box2.AddComponent<ShadowComponent>();
@@ -309,7 +309,7 @@ void PlayGameState::OnEntry()
 	box3Material.AddSpecularMap("materials/plastic/plastic_metallic.png");
 	box3Material.AddNormalMap("materials/plastic/plastic_normal.png");
 	
-	box3.AddComponent<StaticMeshComponent>(*GeometryGenerator::GenerateBox(XMFLOAT3(2.0f, 0.2f, 3.0f), box3Material));
+	box3.AddComponent<StaticMeshComponent>(GeometryGenerator::GenerateBox(XMFLOAT3(2.0f, 0.2f, 3.0f), box3Material));
 	box3.AddComponent<PositionComponent>(XMFLOAT3(4.0f, 6.0f, 10.0f), XMFLOAT3(0.0f, 0.0f, XMConvertToRadians(90.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	box3.AddComponent<ShadowComponent>();
 	box3.AddComponent<MotionComponent>(XMFLOAT3(0.0f, 0.0f, 0.0f));
@@ -338,7 +338,7 @@ void PlayGameState::OnEntry()
 	planeMaterial.AddNormalMap("materials/oakfloor/oakfloor_normal.png");
 	planeMaterial.SetSpecularColor(XMFLOAT3(0.25f, 0.2f, 0.2f));
 
-	plane.AddComponent<StaticMeshComponent>(*GeometryGenerator::GeneratePlane(100.0f, 100.0f, planeMaterial));
+	plane.AddComponent<StaticMeshComponent>(GeometryGenerator::GeneratePlane(100.0f, 100.0f, planeMaterial));
 
 	plane.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	CollisionComponent &c = plane.AddComponent<PlaneCollisionComponent, CollisionComponent>(XMFLOAT3(0.0f, 1.0f, 0.0f));
@@ -353,7 +353,7 @@ void PlayGameState::OnEntry()
 	sideMaterial.SetSpecularColor(XMFLOAT3(0.8f, 0.7f, 1.0f));
 	sideMaterial.SetTiling(2.0f, 4.0f);
 
-	side.AddComponent<StaticMeshComponent>(*GeometryGenerator::GeneratePlane(20.0f, 100.0f, sideMaterial));
+	side.AddComponent<StaticMeshComponent>(GeometryGenerator::GeneratePlane(20.0f, 100.0f, sideMaterial));
 
 	side.AddComponent<PositionComponent>(XMFLOAT3(-50.0f, 10.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, XMConvertToRadians(-90.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	CollisionComponent &collisionComponent1 = side.AddComponent<PlaneCollisionComponent, CollisionComponent>(XMFLOAT3(1.0f, 0.0f, 0.0f));
@@ -362,7 +362,7 @@ void PlayGameState::OnEntry()
 	// right side wall 
 	Entity &sideR = EntitySystem::GetInstance().AddEntity();
 
-	sideR.AddComponent<StaticMeshComponent>(*GeometryGenerator::GeneratePlane(20.0f, 100.0f, sideMaterial));
+	sideR.AddComponent<StaticMeshComponent>(GeometryGenerator::GeneratePlane(20.0f, 100.0f, sideMaterial));
 
 	sideR.AddComponent<PositionComponent>(XMFLOAT3(50.0f, 10.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, XMConvertToRadians(90.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	CollisionComponent &collisionComponent3 = sideR.AddComponent<PlaneCollisionComponent, CollisionComponent>(XMFLOAT3(-1.0f, 0.0f, 0.0f));
@@ -377,7 +377,7 @@ void PlayGameState::OnEntry()
 	frontMaterial.SetSpecularColor(XMFLOAT3(0.8f, 0.8f, 1.0f));
 	frontMaterial.SetTiling(4.0f, 2.0f);
 
-	front.AddComponent<StaticMeshComponent>(*GeometryGenerator::GeneratePlane(100.0f, 20.0f, frontMaterial));
+	front.AddComponent<StaticMeshComponent>(GeometryGenerator::GeneratePlane(100.0f, 20.0f, frontMaterial));
 
 	front.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 10.0f, -50.0f), XMFLOAT3(XMConvertToRadians(90.0f), 0.0f, XMConvertToRadians(0.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	CollisionComponent &collisionComponent4 = front.AddComponent<PlaneCollisionComponent, CollisionComponent>(XMFLOAT3(0.0f, 0.0f, 1.0f));
@@ -386,7 +386,7 @@ void PlayGameState::OnEntry()
 	// end wall 
 	Entity &end = EntitySystem::GetInstance().AddEntity();
 
-	end.AddComponent<StaticMeshComponent>(*GeometryGenerator::GeneratePlane(100.0f, 20.0f, frontMaterial));
+	end.AddComponent<StaticMeshComponent>(GeometryGenerator::GeneratePlane(100.0f, 20.0f, frontMaterial));
 
 	end.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 10.0f, 50.0f), XMFLOAT3(XMConvertToRadians(-90.0f), 0.0f, XMConvertToRadians(0.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f));
 	CollisionComponent &collisionComponent2 = end.AddComponent<PlaneCollisionComponent, CollisionComponent>(XMFLOAT3(0.0f, 0.0f, -1.0f));
@@ -395,9 +395,15 @@ void PlayGameState::OnEntry()
 	// 3D model
 	Entity &crate = EntitySystem::GetInstance().AddEntity();
 	crate.AddComponent<PositionComponent>(XMFLOAT3(-10.0f, 2.0f, 0.0f), XMFLOAT3(0.0f, XMConvertToRadians(180.0f), 0.0f), XMFLOAT3(0.02f, 0.02f, 0.02f));
-	crate.AddComponent<StaticMeshComponent>(*ModelLoader::GetInstance().LoadStaticModel("models/crate/crate.obj"));
 	crate.AddComponent<ShadowComponent>();
 
+	// the model is read in the background, the crate is drawn from the frame it lands
+	mCrateRequest = AssetLoader::GetInstance().LoadStaticModel("models/crate/crate.obj", AssetLoader::Priority::NORMAL, [this, &crate](StaticMeshComponent *model)
+	{
+		crate.AddComponent<StaticMeshComponent>(model);
+		mCrateRequest = AssetLoader::INVALID_REQUEST;
+	});
+
 	mEntities.InsertLast(&light);
 	mEntities.InsertLast(&player);
 	mEntities.InsertLast(&sphere1);
@@ -436,6 +442,9 @@ void PlayGameState::OnExit()
 	mGameGUI->Destroy();
 	mGameGUI = nullptr;
 
+	AssetLoader::GetInstance().Cancel(mCrateRequest);
+	mCrateRequest = AssetLoader::INVALID_REQUEST;
+
 	for (Entity *entity : mEntities)
 		entity->Destroy();
 
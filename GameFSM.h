@@ -10,6 +10,7 @@
 #endif  // FAST_DELEGATES
 
 #include "data structures/Vector.h"
+#include "AssetLoader.h"
 
 class GameFSM;
 
@@ -53,6 +54,7 @@ private:
 	class GUI *mGameGUI;
 	Vector<class Entity*> mEntities;
 	class Picker *mPicker;
+	AssetLoader::RequestID mCrateRequest = AssetLoader::INVALID_REQUEST;
 };
 
 class PauseGameState : public GameState
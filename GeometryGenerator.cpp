@@ -2,6 +2,8 @@
 #include <vector>
 #include "StaticMeshComponent.h"
 #include "Mesh.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
 #include "Material.h"
 
 StaticMeshComponent *GeometryGenerator::GenerateSkybox(const std::string &cubeMap)
@@ -20,13 +22,13 @@ StaticMeshComponent *GeometryGenerator::GenerateSkybox(const std::string &cubeMa
 	std::vector<unsigned int> indices{ 0, 3, 2, 2, 1, 0, 4, 5, 6, 6, 7, 4, 1, 2, 6, 6, 5, 1, 0, 4, 7, 7, 3, 0, 4, 0, 1, 1, 5, 4, 3, 7, 6, 6, 2, 3 };
 
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], positions.size());
+	mesh.LoadAttribute(VertexLayout::Attribute::POSITION, &positions[0], positions.size());
 	mesh.LoadIndexBuffer(indices);
 
 	Material material;
 	material.AddDiffuseMap(cubeMap);
 
-	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions);
+	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions, indices);
 }
 
 StaticMeshComponent *GeometryGenerator::GenerateSphere(float radius, Material material)
@@ -156,14 +158,27 @@ StaticMeshComponent *GeometryGenerator::GenerateSphere(float radius, Material ma
 		tangents.push_back(averagedTangent);
 	}
 
+	// reorder triangles and vertices for the gpu, before the vertex data is loaded
+	std::vector<unsigned int> remap;
+	MeshOptimizer::Optimize(indices, positions, remap);
+
+	MeshOptimizer::RemapVertices(positions, remap);
+	MeshOptimizer::RemapVertices(normals, remap);
+	MeshOptimizer::RemapVertices(tangents, remap);
+	MeshOptimizer::RemapVertices(textureCoordinates, remap);
+
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], positions.size());
-	mesh.LoadAttribute("NORMAL", &normals[0], normals.size());
-	mesh.LoadAttribute("TANGENT", &tangents[0], tangents.size());
-	mesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], textureCoordinates.size());
-	mesh.LoadIndexBuffer(indices);
+	VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], (unsigned int)positions.size() };
+	mesh.LoadVertices(VertexLayout::GetStaticMeshLayout(), sources);
+
+	// detail levels follow the full detail indices in the index buffer
+	std::vector<unsigned int> lodIndices;
+	std::vector<Mesh::LOD> lods = MeshSimplifier(positions, normals, textureCoordinates, indices).BuildLODChain(lodIndices);
 
-	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions);
+	mesh.LoadIndexBuffer(lodIndices);
+	mesh.SetLODs(lods);
+
+	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions, indices);
 }
 
 StaticMeshComponent *GeometryGenerator::GenerateBox(XMFLOAT3 halfsize, Material material)
@@ -276,13 +291,11 @@ StaticMeshComponent *GeometryGenerator::GenerateBox(XMFLOAT3 halfsize, Material
 	}
 
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], 36);
-	mesh.LoadAttribute("NORMAL", &normals[0], 36);
-	mesh.LoadAttribute("TANGENT", &tangents[0], 36);
-	mesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], 36);
+	VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], 36 };
+	mesh.LoadVertices(VertexLayout::GetStaticMeshLayout(), sources);
 	mesh.SetVertexCount(36);
 
-	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material> {material}, positions);
+	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material> {material}, positions, indices);
 }
 
 StaticMeshComponent *GeometryGenerator::GeneratePlane(float width, float depth, Material material)
@@ -308,13 +321,12 @@ StaticMeshComponent *GeometryGenerator::GeneratePlane(float width, float depth,
 	};
 
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], 4);
-	mesh.LoadAttribute("NORMAL", &normals[0], 4);
-	mesh.LoadAttribute("TANGENT", &tangents[0], 4);
-	mesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], 4);
-	mesh.LoadIndexBuffer({ 0, 3, 2, 2, 1, 0 });
+	VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], 4 };
+	mesh.LoadVertices(VertexLayout::GetStaticMeshLayout(), sources);
+	std::vector<unsigned int> indices{ 0, 3, 2, 2, 1, 0 };
+	mesh.LoadIndexBuffer(indices);
 
-	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions);
+	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions, indices);
 }
 
 StaticMeshComponent *GeometryGenerator::GenerateCylinder(float bottomRadius, float topRadius, float height, Material material)
@@ -432,14 +444,27 @@ StaticMeshComponent *GeometryGenerator::GenerateCylinder(float bottomRadius, flo
 	std::vector<XMFLOAT3> tangents(positions.size());
 	std::vector<XMFLOAT2> textureCoordinates(positions.size());
 
+	// reorder triangles and vertices for the gpu, before the vertex data is loaded
+	std::vector<unsigned int> remap;
+	MeshOptimizer::Optimize(indices, positions, remap);
+
+	MeshOptimizer::RemapVertices(positions, remap);
+	MeshOptimizer::RemapVertices(normals, remap);
+	MeshOptimizer::RemapVertices(tangents, remap);
+	MeshOptimizer::RemapVertices(textureCoordinates, remap);
+
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], positions.size());
-	mesh.LoadAttribute("NORMAL", &normals[0], normals.size());
-	mesh.LoadAttribute("TANGENT", &tangents[0], tangents.size());
-	mesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], textureCoordinates.size());
-	mesh.LoadIndexBuffer(indices);
+	VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], (unsigned int)positions.size() };
+	mesh.LoadVertices(VertexLayout::GetStaticMeshLayout(), sources);
+
+	// detail levels follow the full detail indices in the index buffer
+	std::vector<unsigned int> lodIndices;
+	std::vector<Mesh::LOD> lods = MeshSimplifier(positions, normals, textureCoordinates, indices).BuildLODChain(lodIndices);
 
-	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions);
+	mesh.LoadIndexBuffer(lodIndices);
+	mesh.SetLODs(lods);
+
+	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions, indices);
 }
 
 StaticMeshComponent *GeometryGenerator::GenerateCone(float radius, float height, Material material)
@@ -520,12 +545,25 @@ StaticMeshComponent *GeometryGenerator::GenerateCone(float radius, float height,
 	std::vector<XMFLOAT2> textureCoordinates(positions.size());
 	std::vector<XMFLOAT3> tangents(positions.size());
 
+	// reorder triangles and vertices for the gpu, before the vertex data is loaded
+	std::vector<unsigned int> remap;
+	MeshOptimizer::Optimize(indices, positions, remap);
+
+	MeshOptimizer::RemapVertices(positions, remap);
+	MeshOptimizer::RemapVertices(normals, remap);
+	MeshOptimizer::RemapVertices(tangents, remap);
+	MeshOptimizer::RemapVertices(textureCoordinates, remap);
+
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], positions.size());
-	mesh.LoadAttribute("NORMAL", &normals[0], normals.size());
-	mesh.LoadAttribute("TANGENT", &tangents[0], tangents.size());
-	mesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], textureCoordinates.size());
-	mesh.LoadIndexBuffer(indices);
+	VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], (unsigned int)positions.size() };
+	mesh.LoadVertices(VertexLayout::GetStaticMeshLayout(), sources);
+
+	// detail levels follow the full detail indices in the index buffer
+	std::vector<unsigned int> lodIndices;
+	std::vector<Mesh::LOD> lods = MeshSimplifier(positions, normals, textureCoordinates, indices).BuildLODChain(lodIndices);
+
+	mesh.LoadIndexBuffer(lodIndices);
+	mesh.SetLODs(lods);
 
-	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions);
+	return new StaticMeshComponent(std::vector<Mesh>{mesh}, std::vector<Material>{material}, positions, indices);
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
-#include <d3d11.h>
-#include <vector>
+#include "RenderDevice.h"
 
 class GraphicsSystem
 {
@@ -14,12 +13,16 @@ public:
 		unsigned height;
 	};
 public:
-	enum class RasterizerState { SOLID, WIREFRAME, };        // render states are created at initialization and stored into dynamic arrays in same order as enumerators
-	enum class BlendState { DISABLED, ADDITIVE, };
-	enum class DepthStencilState { ENABLED, DISABLED, };
+	using RasterizerState = RenderDevice::RasterizerState;      // render states are created by the render device at initialization
+	using BlendState = RenderDevice::BlendState;
+	using DepthStencilState = RenderDevice::DepthStencilState;
 	static GraphicsSystem &GetInstance();
-	~GraphicsSystem() = default;
-	void Initialize(HWND window);
+	~GraphicsSystem();
+#ifdef _WIN32
+	void Initialize(void *window);                               // direct3d 11 device rendering to the window
+#endif
+	void InitializeHeadless(unsigned width, unsigned height);    // null device: nothing is drawn, submission is counted and recorded
+	RenderDevice &GetRenderDevice() { return *mRenderDevice; }
 	unsigned GetDisplayWidth() const { return mDisplayWidth; }
 	unsigned GetDisplayHeight() const { return mDisplayHeight; }
 	Viewport GetViewport() const { return mViewport; }
@@ -28,27 +31,13 @@ public:
 	void SetDepthStencilState(DepthStencilState state);
 	void ClearScreen(const float color[]);
 	void Present();
-	ID3D11Device *GetDevice() { return mDevice; }
-	ID3D11DeviceContext *GetDeviceContext() { return mDeviceContext; }
-	bool IsMSAAEnabled() const { return mMSAAEnabled; }
-	int GetSampleCount() const { return mSampleCount; }
-	int GetSampleQuality() const { return mSampleQuality; }
 private:
 	GraphicsSystem() = default;
-	ID3D11Device *mDevice;
-	ID3D11DeviceContext *mDeviceContext;
-	IDXGISwapChain *mSwapChain;
-	int mSampleCount;
-	int mSampleQuality;
-	ID3D11RenderTargetView *mRenderTargetView;
-	ID3D11DepthStencilView *mDepthStencilView;
+	void SetDisplaySize(unsigned width, unsigned height);
+	RenderDevice *mRenderDevice = nullptr;
 	unsigned int mDisplayWidth;
 	unsigned int mDisplayHeight;
 	Viewport mViewport;
-	bool mMSAAEnabled = true;
-	std::vector<ID3D11RasterizerState*> mRasterizerStateGroup;
-	std::vector<ID3D11BlendState*> mBlendStateGroup;
-	std::vector<ID3D11DepthStencilState*> mDepthStencilStateGroup;
 };
 
 
@@ -1,8 +1,10 @@
 #include "TerrainGenerationStrategy.h"
 #include "Terrain.h"
 #include "StaticMeshComponent.h"
+#include "MeshOptimizer.h"
 #include "Error.h"
-#include <cstdio>
+#include "VirtualFileSystem.h"
+#include <cstring>
 
 StaticMeshComponent *HeightMapTerrainGenerationStrategy::GenerateTerrain(Terrain *terrain)
 {
@@ -88,10 +90,18 @@ StaticMeshComponent *HeightMapTerrainGenerationStrategy::GenerateTerrain(Terrain
 		normals.push_back(normal);
 	}
 
+	// grid rows run past the vertex cache, reorder triangles and vertices for the gpu (heights keep the grid layout)
+	std::vector<unsigned int> remap;
+	MeshOptimizer::Optimize(indices, positions, remap);
+
+	MeshOptimizer::RemapVertices(positions, remap);
+	MeshOptimizer::RemapVertices(normals, remap);
+	MeshOptimizer::RemapVertices(textureCoordinates, remap);
+
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], positions.size());
-	mesh.LoadAttribute("NORMAL", &normals[0], normals.size());
-	mesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], textureCoordinates.size());
+	mesh.LoadAttribute(VertexLayout::Attribute::POSITION, &positions[0], positions.size());
+	mesh.LoadAttribute(VertexLayout::Attribute::NORMAL, &normals[0], normals.size());
+	mesh.LoadAttribute(VertexLayout::Attribute::TEX_COORD, &textureCoordinates[0], textureCoordinates.size());
 	mesh.LoadIndexBuffer(indices);
 
 	Material material;
@@ -102,31 +112,32 @@ StaticMeshComponent *HeightMapTerrainGenerationStrategy::GenerateTerrain(Terrain
 // load height map (bitmap format)
 void HeightMapTerrainGenerationStrategy::LoadHeightMap(std::string const &heightMapFilePath)
 {
-	FILE *fileStream = nullptr;
-	int e = fopen_s(&fileStream, heightMapFilePath.c_str(), "rb");
-	if (e)
+	VirtualFileSystem::File file;
+	if (!VirtualFileSystem::GetInstance().Open(heightMapFilePath, file))
 		ErrorBox("can't load height map");
 
 	BITMAPFILEHEADER fileHeader;
 	BITMAPINFOHEADER infoHeader;
 
-	int read = fread(&fileHeader, sizeof(BITMAPFILEHEADER), 1, fileStream);
-	if (read != 1)
+	if (file.GetSize() < sizeof(BITMAPFILEHEADER))
 		ErrorBox("can't load height map - file header");
 
-	read = fread(&infoHeader, sizeof(BITMAPINFOHEADER), 1, fileStream);
-	if (read != 1)
+	memcpy(&fileHeader, file.GetData(), sizeof(BITMAPFILEHEADER));
+
+	if (file.GetSize() < sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER))
 		ErrorBox("can't load height map - info header");
 
+	memcpy(&infoHeader, file.GetData() + sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER));
+
 	mHeightMapWidth = infoHeader.biWidth;
 	mHeightMapDepth = infoHeader.biHeight;
 
 	std::vector<char> imageData(mHeightMapWidth * mHeightMapDepth * 3);
 
-	fseek(fileStream, fileHeader.bfOffBits, SEEK_SET);
-	read = fread(&imageData[0], 1, mHeightMapWidth * mHeightMapDepth * 3, fileStream);
+	if (fileHeader.bfOffBits > file.GetSize() || imageData.size() > file.GetSize() - fileHeader.bfOffBits)
+		ErrorBox("can't load height map - image data");
 
-	fclose(fileStream);
+	memcpy(&imageData[0], file.GetData() + fileHeader.bfOffBits, imageData.size());
 
 	for (int i = 0; i < mHeightMapWidth * mHeightMapWidth * 3; i += 3)
 		mHeightMap.push_back(imageData[i]);
@@ -0,0 +1,585 @@
+#include "HeightfieldCollisionComponent.h"
+#include "Terrain.h"
+#include "MeshBVH.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace
+{
+	// keep only the deepest of contacts sharing (almost) the same normal - neighbouring cells are usually close to coplanar
+	void AddContact(Vector<HeightfieldCollisionComponent::Contact> &contacts, size_t firstContact, const HeightfieldCollisionComponent::Contact &contact)
+	{
+		for (size_t i = firstContact; i < contacts.Size(); i++)
+		{
+			float dot = contacts[i].normal.x * contact.normal.x + contacts[i].normal.y * contact.normal.y + contacts[i].normal.z * contact.normal.z;
+
+			if (dot > 0.99f)
+			{
+				if (contact.penetration > contacts[i].penetration)
+					contacts[i] = contact;
+
+				return;
+			}
+		}
+
+		contacts.InsertLast(contact);
+	}
+}
+
+HeightfieldCollisionComponent::HeightfieldCollisionComponent(const Terrain *terrain) : CollisionComponent(Type::HEIGHTFIELD, XMFLOAT3()), mTerrain(terrain)
+{
+	XMFLOAT3 position = terrain->GetPosition();
+
+	mNumNodesWidth = terrain->GetNumNodesWidth();
+	mNumNodesDepth = terrain->GetNumNodesDepth();
+
+	mXOrigin = position.x - terrain->GetWidth() / 2.0f;
+	mZOrigin = position.z + terrain->GetDepth() / 2.0f;
+	mDX = terrain->GetWidth() / (mNumNodesWidth - 1);
+	mDZ = terrain->GetDepth() / (mNumNodesDepth - 1);
+
+	UpdateHeightBounds();
+}
+
+void HeightfieldCollisionComponent::UpdateHeightBounds()
+{
+	mHeightBounds.clear();
+	mLevelWidth.clear();
+	mLevelDepth.clear();
+
+	const std::vector<float> &heights = mTerrain->GetHeights();
+
+	if (mNumNodesWidth < 2 || mNumNodesDepth < 2 || heights.size() < mNumNodesWidth * mNumNodesDepth)
+		return;
+
+	// level 0: height range of each cell
+	unsigned int width = mNumNodesWidth - 1;
+	unsigned int depth = mNumNodesDepth - 1;
+
+	mHeightBounds.emplace_back(width * depth);
+	mLevelWidth.push_back(width);
+	mLevelDepth.push_back(depth);
+
+	for (unsigned int i = 0; i < depth; i++)
+		for (unsigned int j = 0; j < width; j++)
+		{
+			float h00 = heights[i * mNumNodesWidth + j];
+			float h01 = heights[i * mNumNodesWidth + j + 1];
+			float h10 = heights[(i + 1) * mNumNodesWidth + j];
+			float h11 = heights[(i + 1) * mNumNodesWidth + j + 1];
+
+			HeightBounds &bounds = mHeightBounds[0][i * width + j];
+			bounds.min = std::min(std::min(h00, h01), std::min(h10, h11));
+			bounds.max = std::max(std::max(h00, h01), std::max(h10, h11));
+		}
+
+	// coarser levels merge 2x2 cells of the finer level
+	while (width > 1 || depth > 1)
+	{
+		unsigned int coarseWidth = (width + 1) / 2;
+		unsigned int coarseDepth = (depth + 1) / 2;
+
+		std::vector<HeightBounds> coarse(coarseWidth * coarseDepth, HeightBounds{ FLT_MAX, -FLT_MAX });
+		const std::vector<HeightBounds> &fine = mHeightBounds.back();
+
+		for (unsigned int i = 0; i < depth; i++)
+			for (unsigned int j = 0; j < width; j++)
+			{
+				HeightBounds &bounds = coarse[(i / 2) * coarseWidth + j / 2];
+				bounds.min = std::min(bounds.min, fine[i * width + j].min);
+				bounds.max = std::max(bounds.max, fine[i * width + j].max);
+			}
+
+		mHeightBounds.push_back(std::move(coarse));
+		mLevelWidth.push_back(coarseWidth);
+		mLevelDepth.push_back(coarseDepth);
+
+		width = coarseWidth;
+		depth = coarseDepth;
+	}
+}
+
+template <typename Visitor>
+void HeightfieldCollisionComponent::VisitCells(float xMin, float zMin, float xMax, float zMax, float minHeight, Visitor &&visitor) const
+{
+	if (mHeightBounds.empty())
+		return;
+
+	// covered cell range (row i grows towards -z, column j towards +x)
+	int jMin = (int)floorf((xMin - mXOrigin) / mDX);
+	int jMax = (int)floorf((xMax - mXOrigin) / mDX);
+	int iMin = (int)floorf((mZOrigin - zMax) / mDZ);
+	int iMax = (int)floorf((mZOrigin - zMin) / mDZ);
+
+	int numCellsWidth = (int)mLevelWidth[0];
+	int numCellsDepth = (int)mLevelDepth[0];
+
+	if (jMax < 0 || iMax < 0 || jMin >= numCellsWidth || iMin >= numCellsDepth)
+		return;
+
+	jMin = std::max(jMin, 0);
+	iMin = std::max(iMin, 0);
+	jMax = std::min(jMax, numCellsWidth - 1);
+	iMax = std::min(iMax, numCellsDepth - 1);
+
+	// descend from the single top level cell, skipping cells that are entirely below the query
+	struct StackEntry
+	{
+		unsigned int level;
+		int i;
+		int j;
+	};
+
+	StackEntry stack[128];     // at most 3 pending siblings per level
+	int stackSize = 0;
+	stack[stackSize++] = { (unsigned int)mHeightBounds.size() - 1, 0, 0 };
+
+	while (stackSize)
+	{
+		StackEntry entry = stack[--stackSize];
+
+		if (mHeightBounds[entry.level][entry.i * mLevelWidth[entry.level] + entry.j].max < minHeight)
+			continue;
+
+		// level 0 cells covered by this cell
+		int cellIMin = entry.i << entry.level, cellIMax = ((entry.i + 1) << entry.level) - 1;
+		int cellJMin = entry.j << entry.level, cellJMax = ((entry.j + 1) << entry.level) - 1;
+
+		if (cellIMax < iMin || cellIMin > iMax || cellJMax < jMin || cellJMin > jMax)
+			continue;
+
+		if (entry.level == 0)
+		{
+			if (!visitor((unsigned int)entry.i, (unsigned int)entry.j))
+				return;
+
+			continue;
+		}
+
+		unsigned int childLevel = entry.level - 1;
+
+		for (int di = 0; di < 2; di++)
+			for (int dj = 0; dj < 2; dj++)
+			{
+				int childI = entry.i * 2 + di;
+				int childJ = entry.j * 2 + dj;
+
+				if (childI < (int)mLevelDepth[childLevel] && childJ < (int)mLevelWidth[childLevel])
+					stack[stackSize++] = { childLevel, childI, childJ };
+			}
+	}
+}
+
+// cell (i, j) is split along the diagonal from node (i, j + 1) to node (i + 1, j) - same triangulation as the terrain mesh
+void HeightfieldCollisionComponent::GetCellTriangle(unsigned int i, unsigned int j, int triangle, XMFLOAT3 (&vertices)[3]) const
+{
+	const std::vector<float> &heights = mTerrain->GetHeights();
+
+	float x0 = mXOrigin + j * mDX;
+	float x1 = x0 + mDX;
+	float z0 = mZOrigin - i * mDZ;
+	float z1 = z0 - mDZ;
+
+	if (triangle == 0)
+	{
+		vertices[0] = XMFLOAT3(x0, heights[i * mNumNodesWidth + j], z0);
+		vertices[1] = XMFLOAT3(x1, heights[i * mNumNodesWidth + j + 1], z0);
+		vertices[2] = XMFLOAT3(x0, heights[(i + 1) * mNumNodesWidth + j], z1);
+	}
+	else  // triangle == 1
+	{
+		vertices[0] = XMFLOAT3(x0, heights[(i + 1) * mNumNodesWidth + j], z1);
+		vertices[1] = XMFLOAT3(x1, heights[i * mNumNodesWidth + j + 1], z0);
+		vertices[2] = XMFLOAT3(x1, heights[(i + 1) * mNumNodesWidth + j + 1], z1);
+	}
+}
+
+bool HeightfieldCollisionComponent::GetHeight(float x, float z, float &height, XMFLOAT3 &normal) const
+{
+	if (mHeightBounds.empty())
+		return false;
+
+	float xGrid = (x - mXOrigin) / mDX;
+	float zGrid = (mZOrigin - z) / mDZ;
+
+	if (xGrid < 0.0f || zGrid < 0.0f || xGrid > mLevelWidth[0] || zGrid > mLevelDepth[0])
+		return false;
+
+	unsigned int j = std::min((unsigned int)xGrid, mLevelWidth[0] - 1);
+	unsigned int i = std::min((unsigned int)zGrid, mLevelDepth[0] - 1);
+
+	// position relative to the upper left corner of the cell
+	float relX = xGrid - j;
+	float relZ = zGrid - i;
+
+	XMFLOAT3 vertices[3];
+	GetCellTriangle(i, j, relZ >= 1.0f - relX ? 1 : 0, vertices);
+
+	// triangles are wound so that the normal points up
+	XMVECTOR a = XMLoadFloat3(&vertices[0]);
+	XMVECTOR normalV = XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&vertices[1]) - a, XMLoadFloat3(&vertices[2]) - a));
+	XMStoreFloat3(&normal, normalV);
+
+	height = vertices[0].y - (normal.x * (x - vertices[0].x) + normal.z * (z - vertices[0].z)) / normal.y;
+
+	return true;
+}
+
+void HeightfieldCollisionComponent::GetBounds(XMFLOAT3 &min, XMFLOAT3 &max) const
+{
+	if (mHeightBounds.empty())
+	{
+		min = max = XMFLOAT3(mXOrigin, 0.0f, mZOrigin);
+		return;
+	}
+
+	const HeightBounds &bounds = mHeightBounds.back()[0];
+
+	min = XMFLOAT3(mXOrigin, bounds.min, mZOrigin - mLevelDepth[0] * mDZ);
+	max = XMFLOAT3(mXOrigin + mLevelWidth[0] * mDX, bounds.max, mZOrigin);
+}
+
+// walk the cells crossed by the ray in order, the first triangle hit is the closest
+bool HeightfieldCollisionComponent::RayCast(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float maxDistance, float &distance, XMFLOAT3 &normal) const
+{
+	if (mHeightBounds.empty())
+		return false;
+
+	int numCellsWidth = (int)mLevelWidth[0];
+	int numCellsDepth = (int)mLevelDepth[0];
+
+	// clip the ray to the grid rectangle
+	float tEnter = 0.0f;
+	float tExit = maxDistance;
+
+	const float slabOrigin[2] = { origin.x, origin.z };
+	const float slabDirection[2] = { direction.x, direction.z };
+	const float slabMin[2] = { mXOrigin, mZOrigin - numCellsDepth * mDZ };
+	const float slabMax[2] = { mXOrigin + numCellsWidth * mDX, mZOrigin };
+
+	for (int k = 0; k < 2; k++)
+	{
+		if (fabs(slabDirection[k]) < 1e-9f)
+		{
+			if (slabOrigin[k] < slabMin[k] || slabOrigin[k] > slabMax[k])
+				return false;
+
+			continue;
+		}
+
+		float t1 = (slabMin[k] - slabOrigin[k]) / slabDirection[k];
+		float t2 = (slabMax[k] - slabOrigin[k]) / slabDirection[k];
+
+		tEnter = std::max(tEnter, std::min(t1, t2));
+		tExit = std::min(tExit, std::max(t1, t2));
+	}
+
+	if (tEnter > tExit)
+		return false;
+
+	// starting cell
+	int j = std::min(std::max((int)floorf((origin.x + direction.x * tEnter - mXOrigin) / mDX), 0), numCellsWidth - 1);
+	int i = std::min(std::max((int)floorf((mZOrigin - origin.z - direction.z * tEnter) / mDZ), 0), numCellsDepth - 1);
+
+	int stepJ = direction.x > 0.0f ? 1 : -1;
+	int stepI = direction.z > 0.0f ? -1 : 1;     // rows grow towards -z
+
+	// distance along the ray to the next column/row boundary and between boundaries
+	float tNextX = fabs(direction.x) > 1e-9f ? (mXOrigin + (j + (stepJ > 0 ? 1 : 0)) * mDX - origin.x) / direction.x : FLT_MAX;
+	float tNextZ = fabs(direction.z) > 1e-9f ? (mZOrigin - (i + (stepI > 0 ? 1 : 0)) * mDZ - origin.z) / direction.z : FLT_MAX;
+	float tDeltaX = fabs(direction.x) > 1e-9f ? mDX / fabs(direction.x) : FLT_MAX;
+	float tDeltaZ = fabs(direction.z) > 1e-9f ? mDZ / fabs(direction.z) : FLT_MAX;
+
+	XMVECTOR originV = XMLoadFloat3(&origin);
+	XMVECTOR directionV = XMLoadFloat3(&direction);
+
+	float tCell = tEnter;
+
+	while (true)
+	{
+		float tCellExit = std::min(std::min(tNextX, tNextZ), tExit);
+
+		// skip the cell if the ray passes above it
+		float y0 = origin.y + direction.y * tCell;
+		float y1 = origin.y + direction.y * tCellExit;
+
+		if (std::min(y0, y1) <= mHeightBounds[0][i * numCellsWidth + j].max)
+		{
+			bool found = false;
+
+			for (int t = 0; t < 2; t++)
+			{
+				XMFLOAT3 vertices[3];
+				GetCellTriangle(i, j, t, vertices);
+
+				XMVECTOR a = XMLoadFloat3(&vertices[0]);
+				XMVECTOR b = XMLoadFloat3(&vertices[1]);
+				XMVECTOR c = XMLoadFloat3(&vertices[2]);
+
+				float triangleDistance;
+				if (!MeshBVH::IntersectRayTriangle(originV, directionV, a, b, c, triangleDistance) || triangleDistance > maxDistance || (found && triangleDistance >= distance))
+					continue;
+
+				distance = triangleDistance;
+				XMStoreFloat3(&normal, XMVector3Normalize(XMVector3Cross(b - a, c - a)));
+				found = true;
+			}
+
+			if (found)
+				return true;
+		}
+
+		if (tCellExit >= tExit)
+			return false;
+
+		// step to the next cell
+		if (tNextX < tNextZ)
+		{
+			j += stepJ;
+			tCell = tNextX;
+			tNextX += tDeltaX;
+		}
+		else
+		{
+			i += stepI;
+			tCell = tNextZ;
+			tNextZ += tDeltaZ;
+		}
+
+		if (j < 0 || j >= numCellsWidth || i < 0 || i >= numCellsDepth)
+			return false;
+	}
+}
+
+bool HeightfieldCollisionComponent::SweepSphere(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float radius, float maxDistance, float &distance, XMFLOAT3 &normal) const
+{
+	// center below the surface
+	float height;
+
+	if (GetHeight(origin.x, origin.z, height, normal) && origin.y < height)
+	{
+		distance = 0.0f;
+		return true;
+	}
+
+	XMFLOAT3 end(origin.x + direction.x * maxDistance, origin.y + direction.y * maxDistance, origin.z + direction.z * maxDistance);
+
+	XMVECTOR originV = XMLoadFloat3(&origin);
+	XMVECTOR directionV = XMLoadFloat3(&direction);
+
+	float closest = maxDistance;
+	bool found = false;
+
+	VisitCells(std::min(origin.x, end.x) - radius, std::min(origin.z, end.z) - radius, std::max(origin.x, end.x) + radius, std::max(origin.z, end.z) + radius, std::min(origin.y, end.y) - radius, [&](unsigned int i, unsigned int j)
+	{
+		for (int t = 0; t < 2; t++)
+		{
+			XMFLOAT3 vertices[3];
+			GetCellTriangle(i, j, t, vertices);
+
+			float triangleDistance;
+			XMVECTOR normalV;
+
+			if (!MeshBVH::IntersectSphereTriangle(originV, directionV, radius, XMLoadFloat3(&vertices[0]), XMLoadFloat3(&vertices[1]), XMLoadFloat3(&vertices[2]), triangleDistance, normalV) || triangleDistance > closest)
+				continue;
+
+			closest = triangleDistance;
+			found = true;
+
+			XMStoreFloat3(&normal, normalV);
+		}
+
+		return true;
+	});
+
+	if (found)
+		distance = closest;
+
+	return found;
+}
+
+bool HeightfieldCollisionComponent::OverlapSphere(const XMFLOAT3 &center, float radius) const
+{
+	// center below the surface
+	float height;
+	XMFLOAT3 normal;
+
+	if (GetHeight(center.x, center.z, height, normal) && center.y < height)
+		return true;
+
+	XMVECTOR centerV = XMLoadFloat3(&center);
+	bool overlap = false;
+
+	VisitCells(center.x - radius, center.z - radius, center.x + radius, center.z + radius, center.y - radius, [&](unsigned int i, unsigned int j)
+	{
+		for (int t = 0; t < 2 && !overlap; t++)
+		{
+			XMFLOAT3 vertices[3];
+			GetCellTriangle(i, j, t, vertices);
+
+			XMVECTOR closestPoint = MeshBVH::ClosestPointOnTriangle(centerV, XMLoadFloat3(&vertices[0]), XMLoadFloat3(&vertices[1]), XMLoadFloat3(&vertices[2]));
+
+			overlap = XMVectorGetX(XMVector3LengthSq(centerV - closestPoint)) < radius * radius;
+		}
+
+		return !overlap;
+	});
+
+	return overlap;
+}
+
+void HeightfieldCollisionComponent::SphereContacts(const XMFLOAT3 &center, float radius, Vector<Contact> &contacts) const
+{
+	XMVECTOR centerV = XMLoadFloat3(&center);
+	size_t firstContact = contacts.Size();
+
+	VisitCells(center.x - radius, center.z - radius, center.x + radius, center.z + radius, center.y - radius, [&](unsigned int i, unsigned int j)
+	{
+		for (int t = 0; t < 2; t++)
+		{
+			XMFLOAT3 vertices[3];
+			GetCellTriangle(i, j, t, vertices);
+
+			XMVECTOR a = XMLoadFloat3(&vertices[0]);
+			XMVECTOR b = XMLoadFloat3(&vertices[1]);
+			XMVECTOR c = XMLoadFloat3(&vertices[2]);
+
+			XMVECTOR normalV = XMVector3Normalize(XMVector3Cross(b - a, c - a));
+			float planeDistance = XMVectorGetX(XMVector3Dot(normalV, centerV - a));
+
+			if (planeDistance >= radius)
+				continue;
+
+			XMVECTOR closestPoint = MeshBVH::ClosestPointOnTriangle(centerV, a, b, c);
+
+			Contact contact;
+			XMStoreFloat3(&contact.point, closestPoint);
+
+			if (planeDistance > 0.0f)
+			{
+				// center above the triangle: push out along the closest point direction
+				XMVECTOR offset = centerV - closestPoint;
+				float distance = XMVectorGetX(XMVector3Length(offset));
+
+				if (distance >= radius || distance < 1e-6f)
+					continue;
+
+				XMStoreFloat3(&contact.normal, offset / distance);
+				contact.penetration = radius - distance;
+			}
+			else
+			{
+				// center below the surface: only the triangle right above the center pushes it out (along its normal)
+				if (XMVectorGetX(XMVector3LengthSq(closestPoint - (centerV - normalV * planeDistance))) > 1e-6f)
+					continue;
+
+				XMStoreFloat3(&contact.normal, normalV);
+				contact.penetration = radius - planeDistance;
+			}
+
+			AddContact(contacts, firstContact, contact);
+		}
+
+		return true;
+	});
+}
+
+void HeightfieldCollisionComponent::BoxContacts(const XMFLOAT3 &center, const XMFLOAT3 (&axes)[3], const XMFLOAT3 &halfSize, Vector<Contact> &contacts) const
+{
+	XMVECTOR centerV = XMLoadFloat3(&center);
+	XMVECTOR axesV[3] = { XMLoadFloat3(&axes[0]), XMLoadFloat3(&axes[1]), XMLoadFloat3(&axes[2]) };
+	const float extents[3] = { halfSize.x, halfSize.y, halfSize.z };
+
+	XMFLOAT3 boxExtent;
+	boxExtent.x = fabs(axes[0].x) * halfSize.x + fabs(axes[1].x) * halfSize.y + fabs(axes[2].x) * halfSize.z;
+	boxExtent.y = fabs(axes[0].y) * halfSize.x + fabs(axes[1].y) * halfSize.y + fabs(axes[2].y) * halfSize.z;
+	boxExtent.z = fabs(axes[0].z) * halfSize.x + fabs(axes[1].z) * halfSize.y + fabs(axes[2].z) * halfSize.z;
+
+	// early out: box above every covered cell
+	bool reachable = false;
+
+	VisitCells(center.x - boxExtent.x, center.z - boxExtent.z, center.x + boxExtent.x, center.z + boxExtent.z, center.y - boxExtent.y, [&reachable](unsigned int, unsigned int)
+	{
+		reachable = true;
+		return false;
+	});
+
+	if (!reachable)
+		return;
+
+	// box vertices below the surface
+	bool foundContact = false;
+
+	for (int i = 0; i < 8; i++)
+	{
+		XMFLOAT3 vertex;
+		XMStoreFloat3(&vertex, centerV + axesV[0] * ((i & 1) ? extents[0] : -extents[0]) + axesV[1] * ((i & 2) ? extents[1] : -extents[1]) + axesV[2] * ((i & 4) ? extents[2] : -extents[2]));
+
+		float height;
+		XMFLOAT3 normal;
+
+		if (!GetHeight(vertex.x, vertex.z, height, normal) || vertex.y >= height)
+			continue;
+
+		Contact contact;
+		contact.point = vertex;
+		contact.normal = normal;
+		contact.penetration = (height - vertex.y) * normal.y;    // distance from the triangle plane
+		contacts.InsertLast(contact);
+
+		foundContact = true;
+	}
+
+	if (foundContact)
+		return;
+
+	// terrain nodes inside the box (box resting on a terrain peak)
+	int jMin = std::max(0, (int)ceilf((center.x - boxExtent.x - mXOrigin) / mDX));
+	int jMax = std::min((int)mNumNodesWidth - 1, (int)floorf((center.x + boxExtent.x - mXOrigin) / mDX));
+	int iMin = std::max(0, (int)ceilf((mZOrigin - center.z - boxExtent.z) / mDZ));
+	int iMax = std::min((int)mNumNodesDepth - 1, (int)floorf((mZOrigin - center.z + boxExtent.z) / mDZ));
+
+	const std::vector<float> &heights = mTerrain->GetHeights();
+	size_t firstContact = contacts.Size();
+
+	for (int i = iMin; i <= iMax; i++)
+		for (int j = jMin; j <= jMax; j++)
+		{
+			XMVECTOR node = XMVectorSet(mXOrigin + j * mDX, heights[i * mNumNodesWidth + j], mZOrigin - i * mDZ, 0.0f);
+			XMVECTOR offset = node - centerV;
+
+			float minPenetration = FLT_MAX;
+			int minAxis = -1;
+			float side = 1.0f;
+
+			for (int k = 0; k < 3; k++)
+			{
+				float projection = XMVectorGetX(XMVector3Dot(offset, axesV[k]));
+				float penetration = extents[k] - fabs(projection);
+
+				if (penetration < 0.0f)
+				{
+					minAxis = -1;
+					break;
+				}
+
+				if (penetration < minPenetration)
+				{
+					minPenetration = penetration;
+					minAxis = k;
+					side = projection > 0.0f ? 1.0f : -1.0f;
+				}
+			}
+
+			if (minAxis == -1)
+				continue;
+
+			Contact contact;
+			XMStoreFloat3(&contact.point, node);
+			XMStoreFloat3(&contact.normal, -axesV[minAxis] * side);
+			contact.penetration = minPenetration;
+
+			AddContact(contacts, firstContact, contact);
+		}
+}
@@ -0,0 +1,63 @@
+#ifndef HEIGHTFIELD_COLLISION_COMPONENT_H
+#define HEIGHTFIELD_COLLISION_COMPONENT_H
+
+#include "CollisionComponent.h"
+#include "data structures/Vector.h"
+#include <vector>
+
+class Terrain;
+
+/**** static heightfield collider - samples the terrain heights in place, triangles are generated on the fly for the covered cells only ****/
+/**** terrain heights are in world coordinates (the generation strategy bakes in the terrain position), the owner's transform is ignored ****/
+
+class HeightfieldCollisionComponent : public CollisionComponent
+{
+public:
+	struct Contact
+	{
+		XMFLOAT3 point;
+		XMFLOAT3 normal;    // directed from the terrain to the query shape
+		float penetration;
+	};
+public:
+	HeightfieldCollisionComponent(const Terrain *terrain);
+
+	void UpdateHeightBounds();   // rebuild the min/max height levels after the terrain heights have been modified
+
+	bool GetHeight(float x, float z, float &height, XMFLOAT3 &normal) const;
+	void GetBounds(XMFLOAT3 &min, XMFLOAT3 &max) const;
+
+	bool RayCast(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float maxDistance, float &distance, XMFLOAT3 &normal) const;
+	bool SweepSphere(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float radius, float maxDistance, float &distance, XMFLOAT3 &normal) const;
+	bool OverlapSphere(const XMFLOAT3 &center, float radius) const;
+
+	void SphereContacts(const XMFLOAT3 &center, float radius, Vector<Contact> &contacts) const;
+	void BoxContacts(const XMFLOAT3 &center, const XMFLOAT3 (&axes)[3], const XMFLOAT3 &halfSize, Vector<Contact> &contacts) const;
+private:
+	struct HeightBounds
+	{
+		float min;
+		float max;
+	};
+
+	// visit cells overlapping the rectangle whose max height is not below minHeight: visitor(i, j) returns false to stop
+	template <typename Visitor>
+	void VisitCells(float xMin, float zMin, float xMax, float zMax, float minHeight, Visitor &&visitor) const;
+
+	void GetCellTriangle(unsigned int i, unsigned int j, int triangle, XMFLOAT3 (&vertices)[3]) const;
+
+	const Terrain *mTerrain;
+
+	float mXOrigin;            // grid upper left corner
+	float mZOrigin;
+	float mDX;
+	float mDZ;
+	unsigned int mNumNodesWidth;
+	unsigned int mNumNodesDepth;
+
+	std::vector<std::vector<HeightBounds>> mHeightBounds;      // level 0 has one entry per cell, each level halves the resolution down to a single cell
+	std::vector<unsigned int> mLevelWidth;
+	std::vector<unsigned int> mLevelDepth;
+};
+
+#endif  // HEIGHTFIELD_COLLISION_COMPONENT_H
@@ -0,0 +1,36 @@
+#include "InstanceBatcher.h"
+
+void InstanceBatcher::MakeInstance(const XMFLOAT4X4 &worldMatrix, const XMFLOAT4X4 &normalMatrix, Instance &instance)
+{
+	for (int i = 0; i < 4; i++)
+		instance.worldMatrix[i] = XMFLOAT4(worldMatrix.m[i]);
+
+	// normals have w = 0: the translation row is never used
+	for (int i = 0; i < 3; i++)
+		instance.worldInverseTransposeMatrix[i] = XMFLOAT4(normalMatrix.m[i]);
+}
+
+void InstanceBatcher::Clear()
+{
+	mBatches.clear();
+	mInstances.clear();
+}
+
+void InstanceBatcher::Add(uint64_t key, unsigned int item, const Instance &instance)
+{
+	bool newBatch = mBatches.empty() || key == UNIQUE_KEY || mBatches.back().key != key || mBatches.back().numInstances == mMaxInstances;
+
+	if (newBatch)
+	{
+		Batch batch;
+		batch.key = key;
+		batch.item = item;
+		batch.firstInstance = (unsigned int)mInstances.size();
+		batch.numInstances = 0;
+
+		mBatches.push_back(batch);
+	}
+
+	mBatches.back().numInstances++;
+	mInstances.push_back(instance);
+}
@@ -0,0 +1,48 @@
+#ifndef INSTANCE_BATCHER_H
+#define INSTANCE_BATCHER_H
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+using namespace DirectX;
+
+/**** groups consecutive draws with the same batch key (mesh and material) into instance batches ****/
+/**** draws must be added in sorted order, the instance data of all the batches is a single contiguous array uploaded once per frame ****/
+/**** no graphics api calls: the batches and instances are the recording the renderer submits ****/
+
+class InstanceBatcher
+{
+public:
+	struct Instance     // per instance vertex data, matrix rows as stored by XMStoreFloat4x4
+	{
+		XMFLOAT4 worldMatrix[4];
+		XMFLOAT4 worldInverseTransposeMatrix[3];
+	};
+	struct Batch
+	{
+		uint64_t key;
+		unsigned int item;            // first draw of the batch, identifies the mesh and material to bind
+		unsigned int firstInstance;
+		unsigned int numInstances;
+	};
+
+	static const uint64_t UNIQUE_KEY = ~0ull;    // draws with this key are never merged
+
+	static void MakeInstance(const XMFLOAT4X4 &worldMatrix, const XMFLOAT4X4 &normalMatrix, Instance &instance);
+
+	void Clear();
+	void SetMaxInstancesPerBatch(unsigned int maxInstances) { mMaxInstances = maxInstances ? maxInstances : 1; }
+
+	void Add(uint64_t key, unsigned int item, const Instance &instance);
+
+	const std::vector<Batch> &GetBatches() const { return mBatches; }
+	const std::vector<Instance> &GetInstances() const { return mInstances; }
+private:
+	std::vector<Batch> mBatches;
+	std::vector<Instance> mInstances;
+
+	unsigned int mMaxInstances = 1024;
+};
+
+#endif  // INSTANCE_BATCHER_H
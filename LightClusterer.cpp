@@ -0,0 +1,266 @@
+#include "LightClusterer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+LightClusterer::LightClusterer()
+	: mSliceLights(SLICES), mSliceIndices(SLICES), mClusters(NUM_CLUSTERS, Cluster{ 0, 0 })
+{
+}
+
+void LightClusterer::SetProjection(float verticalFOV, float aspectRatio, float nearDistance, float farDistance)
+{
+	if (verticalFOV == mVerticalFOV && aspectRatio == mAspectRatio && nearDistance == mNearDistance && farDistance == mFarDistance)
+		return;
+
+	mVerticalFOV = verticalFOV;
+	mAspectRatio = aspectRatio;
+	mNearDistance = nearDistance;
+	mFarDistance = farDistance;
+
+	// exponential slices: every slice covers the same depth ratio
+	float logDepthRange = log(farDistance / nearDistance);
+
+	mSliceScale = SLICES / logDepthRange;
+	mSliceBias = -(float)SLICES * log(nearDistance) / logDepthRange;
+
+	mSliceDepths.resize(SLICES + 1);
+	for (unsigned int s = 0; s <= SLICES; s++)
+		mSliceDepths[s] = nearDistance * pow(farDistance / nearDistance, (float)s / SLICES);
+
+	// view space bounds of the clusters, x and y of a frustum point are its depth times the tangents of the half fields of view
+	float tanY = tan(verticalFOV / 2.0f);
+	float tanX = aspectRatio * tanY;
+
+	mClusterGroups.resize(SLICES * GROUPS_PER_SLICE);
+
+	for (unsigned int s = 0; s < SLICES; s++)
+	{
+		float nearDepth = mSliceDepths[s];
+		float farDepth = mSliceDepths[s + 1];
+
+		for (unsigned int g = 0; g < GROUPS_PER_SLICE; g++)
+		{
+			unsigned int tileY = g / (TILES_X / 4);
+			unsigned int firstTileX = g % (TILES_X / 4) * 4;
+
+			float minX[4], minY[4], minZ[4], maxX[4], maxY[4], maxZ[4];
+			float centerX[4], centerY[4], centerZ[4], radius[4];
+
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				// tile rows start at the top of the screen
+				float left = -1.0f + 2.0f * (firstTileX + i) / TILES_X;
+				float right = left + 2.0f / TILES_X;
+				float top = 1.0f - 2.0f * tileY / TILES_Y;
+				float bottom = top - 2.0f / TILES_Y;
+
+				minX[i] = std::min(left * nearDepth, left * farDepth) * tanX;
+				maxX[i] = std::max(right * nearDepth, right * farDepth) * tanX;
+				minY[i] = std::min(bottom * nearDepth, bottom * farDepth) * tanY;
+				maxY[i] = std::max(top * nearDepth, top * farDepth) * tanY;
+				minZ[i] = nearDepth;
+				maxZ[i] = farDepth;
+
+				centerX[i] = (minX[i] + maxX[i]) * 0.5f;
+				centerY[i] = (minY[i] + maxY[i]) * 0.5f;
+				centerZ[i] = (minZ[i] + maxZ[i]) * 0.5f;
+
+				float halfX = (maxX[i] - minX[i]) * 0.5f, halfY = (maxY[i] - minY[i]) * 0.5f, halfZ = (maxZ[i] - minZ[i]) * 0.5f;
+				radius[i] = sqrt(halfX * halfX + halfY * halfY + halfZ * halfZ);
+			}
+
+			ClusterGroup &group = mClusterGroups[s * GROUPS_PER_SLICE + g];
+			group.min[0] = XMVectorSet(minX[0], minX[1], minX[2], minX[3]);
+			group.min[1] = XMVectorSet(minY[0], minY[1], minY[2], minY[3]);
+			group.min[2] = XMVectorSet(minZ[0], minZ[1], minZ[2], minZ[3]);
+			group.max[0] = XMVectorSet(maxX[0], maxX[1], maxX[2], maxX[3]);
+			group.max[1] = XMVectorSet(maxY[0], maxY[1], maxY[2], maxY[3]);
+			group.max[2] = XMVectorSet(maxZ[0], maxZ[1], maxZ[2], maxZ[3]);
+			group.center[0] = XMVectorSet(centerX[0], centerX[1], centerX[2], centerX[3]);
+			group.center[1] = XMVectorSet(centerY[0], centerY[1], centerY[2], centerY[3]);
+			group.center[2] = XMVectorSet(centerZ[0], centerZ[1], centerZ[2], centerZ[3]);
+			group.radius = XMVectorSet(radius[0], radius[1], radius[2], radius[3]);
+		}
+	}
+}
+
+unsigned int LightClusterer::GetSlice(float viewDepth) const
+{
+	if (viewDepth <= mNearDistance)
+		return 0;
+
+	float slice = floor(log(viewDepth) * mSliceScale + mSliceBias);
+
+	return (unsigned int)std::min(std::max(slice, 0.0f), (float)(SLICES - 1));
+}
+
+bool LightClusterer::ConeIntersectsSphere(const ViewLight &light, const XMFLOAT3 &center, float radius)
+{
+	// distance of the sphere center from the cone surface, along and across the cone axis
+	XMVECTOR toCenter = XMLoadFloat3(&center) - XMLoadFloat3(&light.position);
+
+	float lengthSquared = XMVectorGetX(XMVector3Dot(toCenter, toCenter));
+	float axial = XMVectorGetX(XMVector3Dot(toCenter, XMLoadFloat3(&light.direction)));
+	float radial = sqrt(std::max(lengthSquared - axial * axial, 0.0f));
+
+	float distanceFromCone = light.cosAngle * radial - axial * light.sinAngle;
+
+	bool angleCull = distanceFromCone > radius;
+	bool frontCull = axial > radius + light.range;
+	bool backCull = axial < -radius;
+
+	return !angleCull && !frontCull && !backCull;
+}
+
+void LightClusterer::BinLights(const XMFLOAT4X4 &viewMatrix, const std::vector<Light> &lights)
+{
+	XMMATRIX view = XMLoadFloat4x4(&viewMatrix);
+
+	unsigned int numLights = std::min((unsigned int)lights.size(), MAX_LIGHTS);
+	mViewLights.resize(numLights);
+
+	for (unsigned int i = 0; i < numLights; i++)
+	{
+		const Light &light = lights[i];
+		ViewLight &viewLight = mViewLights[i];
+
+		XMStoreFloat3(&viewLight.position, XMVector3Transform(XMLoadFloat3(&light.position), view));
+		XMStoreFloat3(&viewLight.direction, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&light.direction), view)));
+		viewLight.range = light.range;
+		viewLight.spot = light.spotAngle > 0.0f;
+
+		if (!viewLight.spot)
+		{
+			viewLight.center = viewLight.position;
+			viewLight.radius = light.range;
+			viewLight.cosAngle = -1.0f;
+			viewLight.sinAngle = 0.0f;
+
+			continue;
+		}
+
+		float halfAngle = XMConvertToRadians(std::min(light.spotAngle, 360.0f) / 2.0f);
+		viewLight.cosAngle = cos(halfAngle);
+		viewLight.sinAngle = sin(halfAngle);
+
+		// bounding sphere of the lit cone (a spherical sector of radius range)
+		float distance, radius;
+		if (halfAngle >= XM_PI / 2.0f)
+		{
+			distance = 0.0f;
+			radius = light.range;
+		}
+		else if (halfAngle > XM_PI / 4.0f)
+		{
+			distance = light.range * viewLight.cosAngle;
+			radius = light.range * viewLight.sinAngle;
+		}
+		else
+			distance = radius = light.range / (2.0f * viewLight.cosAngle);
+
+		XMStoreFloat3(&viewLight.center, XMLoadFloat3(&viewLight.position) + XMLoadFloat3(&viewLight.direction) * distance);
+		viewLight.radius = radius;
+	}
+
+	// each slice writes its own list and its own clusters
+	ThreadPool::GetInstance().ParallelFor(SLICES, [this](unsigned int slice) { BinSlice(slice); });
+
+	// concatenate the slice lists, cluster offsets become global
+	mLightIndices.clear();
+
+	for (unsigned int s = 0; s < SLICES; s++)
+	{
+		unsigned int base = (unsigned int)mLightIndices.size();
+
+		for (unsigned int c = GetClusterIndex(0, 0, s); c < GetClusterIndex(0, 0, s + 1); c++)
+		{
+			Cluster &cluster = mClusters[c];
+
+			// lists past the index budget are truncated, and point at its end so that the packed offsets stay in 16 bits
+			cluster.offset = std::min(cluster.offset + base, MAX_INDICES);
+			cluster.count = std::min(cluster.count, MAX_INDICES - cluster.offset);
+		}
+
+		unsigned int numIndices = std::min((unsigned int)mSliceIndices[s].size(), MAX_INDICES - base);
+		mLightIndices.insert(mLightIndices.end(), mSliceIndices[s].begin(), mSliceIndices[s].begin() + numIndices);
+	}
+}
+
+void LightClusterer::BinSlice(unsigned int slice)
+{
+	float nearDepth = mSliceDepths[slice];
+	float farDepth = mSliceDepths[slice + 1];
+
+	// lights whose bounding sphere overlaps the slice
+	std::vector<uint16_t> &sliceLights = mSliceLights[slice];
+	sliceLights.clear();
+
+	for (unsigned int i = 0; i < (unsigned int)mViewLights.size(); i++)
+		if (mViewLights[i].center.z + mViewLights[i].radius >= nearDepth && mViewLights[i].center.z - mViewLights[i].radius <= farDepth)
+			sliceLights.push_back((uint16_t)i);
+
+	std::vector<uint16_t> &sliceIndices = mSliceIndices[slice];
+	sliceIndices.clear();
+
+	uint16_t lists[4][MAX_LIGHTS];
+
+	for (unsigned int g = 0; g < GROUPS_PER_SLICE; g++)
+	{
+		const ClusterGroup &group = mClusterGroups[slice * GROUPS_PER_SLICE + g];
+
+		unsigned int counts[4] = { 0, 0, 0, 0 };
+
+		for (uint16_t index : sliceLights)
+		{
+			const ViewLight &light = mViewLights[index];
+
+			// squared distance from the sphere center to the four boxes
+			XMVECTOR distanceSquared = XMVectorZero();
+			const float *center = &light.center.x;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				XMVECTOR c = XMVectorReplicate(center[axis]);
+				XMVECTOR d = XMVectorMax(group.min[axis] - c, XMVectorZero()) + XMVectorMax(c - group.max[axis], XMVectorZero());
+				distanceSquared += d * d;
+			}
+
+			uint32_t overlaps[4];
+			XMStoreInt4(overlaps, XMVectorLessOrEqual(distanceSquared, XMVectorReplicate(light.radius * light.radius)));
+
+			if (!(overlaps[0] | overlaps[1] | overlaps[2] | overlaps[3]))
+				continue;
+
+			XMFLOAT4 centerX, centerY, centerZ, radius;
+			if (light.spot)
+			{
+				XMStoreFloat4(&centerX, group.center[0]);
+				XMStoreFloat4(&centerY, group.center[1]);
+				XMStoreFloat4(&centerZ, group.center[2]);
+				XMStoreFloat4(&radius, group.radius);
+			}
+
+			for (int i = 0; i < 4; i++)
+			{
+				if (!overlaps[i])
+					continue;
+
+				if (light.spot && !ConeIntersectsSphere(light, XMFLOAT3((&centerX.x)[i], (&centerY.x)[i], (&centerZ.x)[i]), (&radius.x)[i]))
+					continue;
+
+				lists[i][counts[i]++] = index;
+			}
+		}
+
+		unsigned int firstCluster = GetClusterIndex(g % (TILES_X / 4) * 4, g / (TILES_X / 4), slice);
+
+		for (int i = 0; i < 4; i++)
+		{
+			mClusters[firstCluster + i].offset = (uint32_t)sliceIndices.size();     // relative to the slice
+			mClusters[firstCluster + i].count = counts[i];
+
+			sliceIndices.insert(sliceIndices.end(), lists[i], lists[i] + counts[i]);
+		}
+	}
+}
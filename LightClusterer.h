@@ -0,0 +1,97 @@
+#ifndef LIGHT_CLUSTERER_H
+#define LIGHT_CLUSTERER_H
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+using namespace DirectX;
+
+/**** clustered forward lighting: the view frustum is split in TILES_X x TILES_Y screen tiles and SLICES exponential depth slices ****/
+/**** point and spot lights are binned into the clusters they touch, each cluster gets a compact list of light indices ****/
+/**** depth slices are binned in parallel, four clusters per light test; no graphics api calls, the clusters and indices are uploaded by the shader ****/
+
+class LightClusterer
+{
+public:
+	static const unsigned int TILES_X = 16;
+	static const unsigned int TILES_Y = 8;
+	static const unsigned int SLICES = 24;
+	static const unsigned int NUM_CLUSTERS = TILES_X * TILES_Y * SLICES;
+
+	static const unsigned int MAX_LIGHTS = 256;          // lights binned per frame, the rest are dropped
+	static const unsigned int MAX_INDICES = 32768;       // total entries of the cluster lists
+
+	struct Light     // world space
+	{
+		XMFLOAT3 position;
+		float range;
+		XMFLOAT3 direction;
+		float spotAngle;      // full cone angle in degrees, 0 for point lights
+	};
+	struct Cluster
+	{
+		uint32_t offset;      // into GetLightIndices()
+		uint32_t count;
+	};
+public:
+	LightClusterer();
+
+	// cluster bounds are rebuilt only when the projection changes
+	void SetProjection(float verticalFOV, float aspectRatio, float nearDistance, float farDistance);
+
+	void BinLights(const XMFLOAT4X4 &viewMatrix, const std::vector<Light> &lights);
+
+	const std::vector<Cluster> &GetClusters() const { return mClusters; }
+	const std::vector<uint16_t> &GetLightIndices() const { return mLightIndices; }      // indices into the lights passed to BinLights()
+
+	static unsigned int GetClusterIndex(unsigned int tileX, unsigned int tileY, unsigned int slice) { return (slice * TILES_Y + tileY) * TILES_X + tileX; }
+
+	// view depth to slice: slice = log(depth) * scale + bias
+	float GetSliceScale() const { return mSliceScale; }
+	float GetSliceBias() const { return mSliceBias; }
+	unsigned int GetSlice(float viewDepth) const;
+private:
+	struct ClusterGroup      // view space bounds of four consecutive clusters of a slice (structure of arrays)
+	{
+		XMVECTOR min[3];
+		XMVECTOR max[3];
+		XMVECTOR center[3];
+		XMVECTOR radius;     // bounding sphere for the spot light cone test
+	};
+	struct ViewLight
+	{
+		XMFLOAT3 center;     // bounding sphere (view space)
+		float radius;
+		XMFLOAT3 position;
+		float range;
+		XMFLOAT3 direction;
+		float cosAngle;
+		float sinAngle;
+		bool spot;
+	};
+
+	static const unsigned int GROUPS_PER_SLICE = TILES_X * TILES_Y / 4;
+
+	void BinSlice(unsigned int slice);
+	static bool ConeIntersectsSphere(const ViewLight &light, const XMFLOAT3 &center, float radius);
+
+	float mVerticalFOV = 0.0f;
+	float mAspectRatio = 0.0f;
+	float mNearDistance = 0.0f;
+	float mFarDistance = 0.0f;
+	float mSliceScale = 0.0f;
+	float mSliceBias = 0.0f;
+
+	std::vector<float> mSliceDepths;                   // SLICES + 1 slice boundaries
+	std::vector<ClusterGroup> mClusterGroups;          // GROUPS_PER_SLICE per slice
+
+	std::vector<ViewLight> mViewLights;
+
+	std::vector<std::vector<uint16_t>> mSliceLights;   // lights overlapping the depth range of each slice
+	std::vector<std::vector<uint16_t>> mSliceIndices;  // per slice lists, concatenated once all slices are binned
+	std::vector<Cluster> mClusters;
+	std::vector<uint16_t> mLightIndices;
+};
+
+#endif  // LIGHT_CLUSTERER_H
@@ -1,6 +1,17 @@
 #include "LightComponent.h"
+#include "RenderScene.h"
 
 LightComponent::LightComponent(Type type, const XMFLOAT3 &color, float range, float intensity, float spotLightAngle, PositionComponent *positionComponent)
 	: mType(type), mColor(color), mRange(range), mIntensity(intensity), mSpotlightAngle(spotLightAngle)
 {
-}
\ No newline at end of file
+}
+
+LightComponent::~LightComponent()
+{
+	RenderScene::GetInstance().RemoveEntity(GetOwner());
+}
+
+void LightComponent::Init()
+{
+	RenderScene::GetInstance().UpdateEntity(GetOwner());
+}
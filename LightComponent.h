@@ -14,6 +14,9 @@ public:
 	enum class Type { DIRECTIONAL, POINT, SPOT, };
 public:
 	LightComponent(Type type, const XMFLOAT3 &color, float range, float intensity, float spotLightAngle, PositionComponent *positionComponent);
+	~LightComponent();
+
+	void Init() override;
 
 	void SetEnabled(bool enabled) { mIsEnabled = enabled; }
 	bool IsEnabled() const { return mIsEnabled; }
@@ -0,0 +1,89 @@
+#include <Windows.h>
+#include "MappedFile.h"
+
+bool MappedFile::Open(const std::string &filePath)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mMapping = mapping;
+	mData = static_cast<const uint8_t*>(view);
+	mSize = (size_t)size.QuadPart;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+		UnmapViewOfFile(mData);
+
+	if (mMapping)
+		CloseHandle(mMapping);
+
+	if (mFile)
+		CloseHandle(mFile);
+
+	mFile = nullptr;
+	mMapping = nullptr;
+	mData = nullptr;
+	mSize = 0;
+}
+
+void MappedFile::Prefetch() const
+{
+	static const size_t PAGE_SIZE = 4096;
+
+	volatile uint8_t sum = 0;
+	for (size_t offset = 0; offset < mSize; offset += PAGE_SIZE)
+		sum += mData[offset];
+}
+
+uint64_t MappedFile::GetModificationTime(const std::string &filePath)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(filePath.c_str(), GetFileExInfoStandard, &attributes))
+		return 0;
+
+	return (uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+bool MappedFile::SetModificationTime(const std::string &filePath, uint64_t time)
+{
+	HANDLE file = CreateFileA(filePath.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	FILETIME lastWriteTime = { (DWORD)time, (DWORD)(time >> 32) };
+	BOOL set = SetFileTime(file, nullptr, nullptr, &lastWriteTime);
+
+	CloseHandle(file);
+
+	return set != 0;
+}
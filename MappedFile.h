@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**** read only memory mapped file: the contents are paged in by the os when they're first touched, nothing is copied ****/
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string &filePath);      // fails if the file is missing or empty
+	void Close();
+
+	void Prefetch() const;      // touches every page so that later reads don't fault
+
+	const uint8_t *GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+
+	static uint64_t GetModificationTime(const std::string &filePath);     // 0 if the file is missing
+	static bool SetModificationTime(const std::string &filePath, uint64_t time);
+private:
+	void *mFile = nullptr;
+	void *mMapping = nullptr;
+	const uint8_t *mData = nullptr;
+	size_t mSize = 0;
+};
+
+#endif  // MAPPED_FILE_H
@@ -12,11 +12,12 @@ using namespace DirectX;
 class Material
 {
 public:
-	void AddDiffuseMap(std::string const &diffuseMapName) { Texture diffuseMap = TextureManager::GetInstance().GetTexture(diffuseMapName); mDiffuseMaps.push_back(diffuseMap); }
+	// maps are loaded (and cooked the first time) in the background, they show placeholders until they land
+	void AddDiffuseMap(std::string const &diffuseMapName) { Texture diffuseMap = TextureManager::GetInstance().RequestTexture(diffuseMapName, TextureManager::Placeholder::WHITE, TextureCooker::Usage::COLOR); mDiffuseMaps.push_back(diffuseMap); mTextureNames.push_back(diffuseMapName); }
 	void AddDiffuseMaps(const std::vector<Texture> &diffuseMaps) { for (Texture texture : diffuseMaps) mDiffuseMaps.push_back(texture); }
-	void AddSpecularMap(const std::string &specularMapName) { Texture specularMap = TextureManager::GetInstance().GetTexture(specularMapName);  mSpecularMaps.push_back(specularMap); }
+	void AddSpecularMap(const std::string &specularMapName) { Texture specularMap = TextureManager::GetInstance().RequestTexture(specularMapName, TextureManager::Placeholder::BLACK, TextureCooker::Usage::DATA);  mSpecularMaps.push_back(specularMap); mTextureNames.push_back(specularMapName); }
 	void AddSpecularMaps(const std::vector<Texture> &diffuseMaps) { for (Texture texture : diffuseMaps) mSpecularMaps.push_back(texture); }
-	void AddNormalMap(const std::string &normalMapName) { Texture normalMap = TextureManager::GetInstance().GetTexture(normalMapName); mNormalMaps.push_back(normalMap); }
+	void AddNormalMap(const std::string &normalMapName) { Texture normalMap = TextureManager::GetInstance().RequestTexture(normalMapName, TextureManager::Placeholder::FLAT_NORMAL, TextureCooker::Usage::NORMAL); mNormalMaps.push_back(normalMap); mTextureNames.push_back(normalMapName); }
 	void AddNormalMaps(const std::vector<Texture> &diffuseMaps) { for (Texture texture : diffuseMaps) mNormalMaps.push_back(texture); }
 
 	void SetDiffuseColor(const XMFLOAT3 &diffuseColor) { mDiffuseColor = diffuseColor; }
@@ -25,9 +26,10 @@ public:
 
 	void SetTiling(float horizontal, float vertical) { mHorizontalTiling = horizontal; mVerticalTiling = vertical; }
 
-	const std::vector<Texture> GetDiffuseMaps() const { return mDiffuseMaps; }
-	const std::vector<Texture> GetSpecularMaps() const { return mSpecularMaps; }
-	const std::vector<Texture> GetNormalMaps() const { return mNormalMaps; }
+	const std::vector<Texture> &GetDiffuseMaps() const { return mDiffuseMaps; }
+	const std::vector<Texture> &GetSpecularMaps() const { return mSpecularMaps; }
+	const std::vector<Texture> &GetNormalMaps() const { return mNormalMaps; }
+	const std::vector<std::string> &GetTextureNames() const { return mTextureNames; }     // maps added by name (texture manager references)
 
 	XMFLOAT3 GetDiffuseColor() const { return mDiffuseColor; }
 	XMFLOAT3 GetSpecularColor() const { return mSpecularColor; }
@@ -43,6 +45,7 @@ private:
 	std::vector<Texture> mDiffuseMaps;
 	std::vector<Texture> mSpecularMaps;
 	std::vector<Texture> mNormalMaps;
+	std::vector<std::string> mTextureNames;
 
 	XMFLOAT3 mDiffuseColor = XMFLOAT3(1.0f, 1.0f, 1.0f);
 	XMFLOAT3 mSpecularColor = XMFLOAT3();
@@ -1,13 +1,14 @@
 #include "Mesh.h"
+#include <utility>
 
 Mesh::Mesh(const Mesh &other) 
-	: mVertexBuffers(other.mVertexBuffers), mIndexBuffer(other.mIndexBuffer), mVertexCount(other.mVertexCount), mStrides(other.mStrides), mAttributeMapping(other.mAttributeMapping), mMapIndex(other.mMapIndex), mReferenceCount(other.mReferenceCount)
+	: mVertexBuffers(other.mVertexBuffers), mIndexBuffer(other.mIndexBuffer), mVertexCount(other.mVertexCount), mLODs(other.mLODs), mStrides(other.mStrides), mAttributeStreams(other.mAttributeStreams), mQuantization(other.mQuantization), mReferenceCount(other.mReferenceCount)
 {
 	mReferenceCount->Increment();
 }
 
 Mesh::Mesh(Mesh &&other)
-	: mVertexBuffers(other.mVertexBuffers), mIndexBuffer(other.mIndexBuffer), mVertexCount(other.mVertexCount), mStrides(other.mStrides), mAttributeMapping(other.mAttributeMapping), mMapIndex(other.mMapIndex), mReferenceCount(other.mReferenceCount)
+	: mVertexBuffers(other.mVertexBuffers), mIndexBuffer(other.mIndexBuffer), mVertexCount(other.mVertexCount), mLODs(other.mLODs), mStrides(other.mStrides), mAttributeStreams(other.mAttributeStreams), mQuantization(other.mQuantization), mReferenceCount(other.mReferenceCount)
 {
 	other.mVertexBuffers.clear();
 	other.mIndexBuffer = nullptr;
@@ -22,11 +23,11 @@ Mesh::~Mesh()
 
 		if (mReferenceCount == 0)
 		{
-			for (ID3D11Buffer *buffer : mVertexBuffers)
-				buffer->Release();
+			for (BufferHandle buffer : mVertexBuffers)
+				GraphicsSystem::GetInstance().GetRenderDevice().ReleaseBuffer(buffer);
 
 			if (mIndexBuffer)
-				mIndexBuffer->Release();
+				GraphicsSystem::GetInstance().GetRenderDevice().ReleaseBuffer(mIndexBuffer);
 
 			delete mReferenceCount;
 		}
@@ -56,7 +57,7 @@ void Mesh::Swap(Mesh &other)
 	mReferenceCount = other.mReferenceCount;
 	other.mReferenceCount = tempRefCount;
 
-	std::vector<ID3D11Buffer*> tempBuffs = mVertexBuffers;
+	std::vector<BufferHandle> tempBuffs = mVertexBuffers;
 	mVertexBuffers = other.mVertexBuffers;
 	other.mVertexBuffers = tempBuffs;
 
@@ -64,21 +65,18 @@ void Mesh::Swap(Mesh &other)
 	mStrides = other.mStrides;
 	other.mStrides = tempStrides;
 
-	unsigned int tempMapIndex = mMapIndex;
-	mMapIndex = other.mMapIndex;
-	other.mMapIndex = tempMapIndex;
+	mAttributeStreams.swap(other.mAttributeStreams);
+	std::swap(mQuantization, other.mQuantization);
 
-	std::map<std::string, unsigned int> tempAttributeMap = mAttributeMapping;
-	mAttributeMapping = other.mAttributeMapping;
-	other.mAttributeMapping = tempAttributeMap;
-
-	ID3D11Buffer *tempRes = mIndexBuffer;
+	BufferHandle tempRes = mIndexBuffer;
 	mIndexBuffer = other.mIndexBuffer;
 	other.mIndexBuffer = tempRes;
 
 	unsigned int tempVertexCount = mVertexCount;
 	mVertexCount = other.mVertexCount;
 	other.mVertexCount = tempVertexCount;
+
+	mLODs.swap(other.mLODs);
 }
 
 void Mesh::Clear()
@@ -87,11 +85,11 @@ void Mesh::Clear()
 
 	if (mReferenceCount == 0)
 	{
-		for (ID3D11Buffer *buffer : mVertexBuffers)
-			buffer->Release();
+		for (BufferHandle buffer : mVertexBuffers)
+			GraphicsSystem::GetInstance().GetRenderDevice().ReleaseBuffer(buffer);
 
 		if (mIndexBuffer)
-			mIndexBuffer->Release();
+			GraphicsSystem::GetInstance().GetRenderDevice().ReleaseBuffer(mIndexBuffer);
 
 		delete mReferenceCount;
 	}
@@ -100,67 +98,111 @@ void Mesh::Clear()
 
 	mVertexBuffers.clear();
 	mStrides.clear();
-	mAttributeMapping.clear();
-	mMapIndex = 0;
+	mAttributeStreams.fill(-1);
+	mQuantization = VertexLayout::Quantization{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f) };
 	mIndexBuffer = nullptr;
 	mVertexCount = 0;
+	mLODs.clear();
 }
 
-void Mesh::LoadIndexBuffer(std::vector<unsigned int> indices)
+void Mesh::LoadVertices(const VertexLayout &layout, const VertexLayout::Sources &sources)
+{
+	VertexLayout::Quantization quantization = layout.ComputeQuantization(sources);
+
+	std::vector<std::vector<uint8_t>> data(layout.GetNumStreams());
+	std::vector<const void*> streams(layout.GetNumStreams());
+
+	for (unsigned int stream = 0; stream < layout.GetNumStreams(); stream++)
+	{
+		layout.PackStream(stream, sources, quantization, data[stream]);
+		streams[stream] = &data[stream][0];
+	}
+
+	LoadPackedVertices(layout, &streams[0], sources.numVertices, quantization);
+}
+
+void Mesh::LoadPackedVertices(const VertexLayout &layout, const void *const *streams, unsigned int numVertices, const VertexLayout::Quantization &quantization)
 {
-	// index buffer description
-	D3D11_BUFFER_DESC bufferDesc = {};
-	bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-	bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bufferDesc.ByteWidth = sizeof(unsigned int) * indices.size();
-	bufferDesc.CPUAccessFlags = 0;
-	bufferDesc.MiscFlags = 0;
-	bufferDesc.StructureByteStride = 0;
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	mQuantization = quantization;
 
-	// index buffer data
-	D3D11_SUBRESOURCE_DATA bufferData = {};
-	bufferData.pSysMem = &indices[0];
+	unsigned int firstStream = (unsigned int)mVertexBuffers.size();
 
+	for (unsigned int stream = 0; stream < layout.GetNumStreams(); stream++)
+	{
+		mVertexBuffers.push_back(renderDevice.CreateBuffer(RenderDevice::BufferType::VERTEX, RenderDevice::Usage::IMMUTABLE, layout.GetStride(stream) * numVertices, (void*)streams[stream]));
+		mStrides.push_back(layout.GetStride(stream));
+	}
+
+	for (unsigned int attribute = 0; attribute < VertexLayout::NUM_ATTRIBUTES; attribute++)
+		if (layout.GetStream((VertexLayout::Attribute)attribute) >= 0)
+			mAttributeStreams[attribute] = firstStream + layout.GetStream((VertexLayout::Attribute)attribute);
+}
+
+void Mesh::LoadIndexBuffer(std::vector<unsigned int> indices)
+{
+	LoadIndexBuffer(&indices[0], (unsigned int)indices.size());
+}
+
+void Mesh::LoadIndexBuffer(const unsigned int *indices, unsigned int numIndices)
+{
 	// create index buffer
-	GraphicsSystem::GetInstance().GetDevice()->CreateBuffer(&bufferDesc, &bufferData, &mIndexBuffer);
+	mIndexBuffer = GraphicsSystem::GetInstance().GetRenderDevice().CreateBuffer(RenderDevice::BufferType::INDEX, RenderDevice::Usage::IMMUTABLE, sizeof(unsigned int) * numIndices, (void*)indices);
 
 	// set number of vertices to draw
-	mVertexCount = indices.size();
+	mVertexCount = numIndices;
 }
 
-void Mesh::BindAttribute(std::string attributeSemantic, unsigned int slot) const
+void Mesh::SetLODs(const std::vector<LOD> &lods)
 {
-	unsigned int index = mAttributeMapping[attributeSemantic];
-	ID3D11Buffer *vertexBuffer = mVertexBuffers[index];
+	mLODs = lods;
 
-	unsigned int offset = 0;
-	GraphicsSystem::GetInstance().GetDeviceContext()->IASetVertexBuffers(slot, 1, &vertexBuffer, &mStrides[index], &offset);
+	if (!mLODs.empty())
+		mVertexCount = mLODs[0].indexCount;
+}
+
+void Mesh::BindAttribute(VertexLayout::Attribute attribute, unsigned int slot) const
+{
+	int stream = mAttributeStreams[(unsigned int)attribute];
+
+	if (stream < 0)
+		return;
+
+	GraphicsSystem::GetInstance().GetRenderDevice().SetVertexBuffers(slot, 1, &mVertexBuffers[stream], &mStrides[stream]);
 
 	// if present, bind index buffer 
 	if (mIndexBuffer)
-		GraphicsSystem::GetInstance().GetDeviceContext()->IASetIndexBuffer(mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		GraphicsSystem::GetInstance().GetRenderDevice().SetIndexBuffer(mIndexBuffer);
 }
 
 void Mesh::BindIndexBuffer() const
 {
 	if (mIndexBuffer)
-		GraphicsSystem::GetInstance().GetDeviceContext()->IASetIndexBuffer(mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		GraphicsSystem::GetInstance().GetRenderDevice().SetIndexBuffer(mIndexBuffer);
 }
 
 void Mesh::Bind() const
 {
-	std::vector<unsigned int> offsets(mVertexBuffers.size()); // all elements are 0
-	GraphicsSystem::GetInstance().GetDeviceContext()->IASetVertexBuffers(0, mVertexBuffers.size(), &mVertexBuffers[0], &mStrides[0], &offsets[0]);
+	GraphicsSystem::GetInstance().GetRenderDevice().SetVertexBuffers(0, mVertexBuffers.size(), &mVertexBuffers[0], &mStrides[0]);
 
 	// if present, bind index buffer 
 	if (mIndexBuffer)
-		GraphicsSystem::GetInstance().GetDeviceContext()->IASetIndexBuffer(mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		GraphicsSystem::GetInstance().GetRenderDevice().SetIndexBuffer(mIndexBuffer);
 }
 
 void Mesh::Draw() const
 {
 	if (mIndexBuffer)  
-		GraphicsSystem::GetInstance().GetDeviceContext()->DrawIndexed(mVertexCount, 0, 0);
+		GraphicsSystem::GetInstance().GetRenderDevice().DrawIndexed(mVertexCount, 0, 0);
 	else  
-		GraphicsSystem::GetInstance().GetDeviceContext()->Draw(mVertexCount, 0);
+		GraphicsSystem::GetInstance().GetRenderDevice().Draw(mVertexCount, 0);
+}
+
+void Mesh::DrawInstanced(unsigned int numInstances, unsigned int firstInstance) const
+{
+	if (mIndexBuffer)
+		GraphicsSystem::GetInstance().GetRenderDevice().DrawIndexedInstanced(mVertexCount, numInstances, 0, 0, firstInstance);
+	else
+		GraphicsSystem::GetInstance().GetRenderDevice().DrawInstanced(mVertexCount, numInstances, 0, firstInstance);
 }
\ No newline at end of file
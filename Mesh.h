@@ -2,10 +2,9 @@
 
 #include "Error.h"
 #include "GraphicsSystem.h"
-#include <d3d11.h>
-#include <map>
+#include "VertexLayout.h"
 #include <vector>
-#include <string>
+#include <array>
 
 class Mesh
 {
@@ -21,7 +20,16 @@ private:
 		int mReferenceCount;
 	};
 public:
-	Mesh() : mReferenceCount(new ReferenceCount) {}
+	static const unsigned int MAX_LODS = 4;
+
+	struct LOD      // detail level: a range of the index buffer over the same vertices
+	{
+		unsigned int firstIndex;
+		unsigned int indexCount;
+		float error;      // simplification error relative to the mesh extent
+	};
+public:
+	Mesh() : mReferenceCount(new ReferenceCount) { mAttributeStreams.fill(-1); }
 	Mesh(const Mesh &other);
 	Mesh(Mesh &&other);
 
@@ -30,80 +38,81 @@ public:
 	Mesh &operator=(const Mesh &other);
 	Mesh &operator=(Mesh &&other);
 
+	// packs the attributes in the streams of the layout, one vertex buffer per stream
+	void LoadVertices(const VertexLayout &layout, const VertexLayout::Sources &sources);
+	void LoadPackedVertices(const VertexLayout &layout, const void *const *streams, unsigned int numVertices, const VertexLayout::Quantization &quantization);     // one pointer per stream, already packed
+
+	// a stream with a single unpacked attribute
 	template <typename T>
-	void LoadAttribute(const std::string &attributeSemantic, T *data, unsigned int numElements, bool dynamic = false);
+	void LoadAttribute(VertexLayout::Attribute attribute, T *data, unsigned int numElements, bool dynamic = false);
 	
 	void LoadIndexBuffer(std::vector<unsigned int> indices);
+	void LoadIndexBuffer(const unsigned int *indices, unsigned int numIndices);
 	void SetVertexCount(unsigned int vertexCount) { mVertexCount = vertexCount; }
+	void SetLODs(const std::vector<LOD> &lods);     // ranges of the loaded index buffer, level 0 is drawn by Draw()
 	
 	template <typename T>
-	void UpdateDynamicAttribute(std::string const &attributeSemantic, T* data, unsigned int numElements, unsigned int offset = 0);
+	void UpdateDynamicAttribute(VertexLayout::Attribute attribute, T* data, unsigned int numElements, unsigned int offset = 0);
 
 	void Bind() const;
-	void BindAttribute(std::string attributeSemantic, unsigned int slot) const;
+	void BindAttribute(VertexLayout::Attribute attribute, unsigned int slot) const;     // binds the stream of the attribute
 	void BindIndexBuffer() const;
 	
 	void Draw() const;
+	void DrawInstanced(unsigned int numInstances, unsigned int firstInstance) const;   // per instance data is bound by the caller
+
+	// copies of a mesh share the same buffers and reference count: the count identifies the mesh data while a copy exists
+	const void *GetID() const { return mReferenceCount; }
+
+	const std::vector<BufferHandle> &GetVertexBuffers() const { return mVertexBuffers; }
+	const std::vector<unsigned int> &GetStrides() const { return mStrides; }
+	BufferHandle GetIndexBuffer() const { return mIndexBuffer; }
+	unsigned int GetVertexCount() const { return mVertexCount; }
+	int GetAttributeStream(VertexLayout::Attribute attribute) const { return mAttributeStreams[(unsigned int)attribute]; }    // index into GetVertexBuffers(), -1 if missing
+	const VertexLayout::Quantization &GetQuantization() const { return mQuantization; }     // identity unless positions are quantised
+	const std::vector<LOD> &GetLODs() const { return mLODs; }             // empty if the mesh has a single detail level
 
 	void Clear();
 
 	void Swap(Mesh &other);
 private:
-	std::vector<ID3D11Buffer*> mVertexBuffers;
+	std::vector<BufferHandle> mVertexBuffers;
 	std::vector<unsigned int> mStrides;
-	unsigned int mMapIndex = 0;
-	mutable std::map<std::string, unsigned int> mAttributeMapping;
+	std::array<int, VertexLayout::NUM_ATTRIBUTES> mAttributeStreams;
+	VertexLayout::Quantization mQuantization = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f) };
 
-	ID3D11Buffer *mIndexBuffer = nullptr;
+	BufferHandle mIndexBuffer = nullptr;
 	unsigned int mVertexCount = 0;	
+	std::vector<LOD> mLODs;
 	
 	ReferenceCount *mReferenceCount;
 };
 
 template <typename T>
-void Mesh::LoadAttribute(const std::string &attributeSemantic, T *data, unsigned int numElements, bool dynamic)
+void Mesh::LoadAttribute(VertexLayout::Attribute attribute, T *data, unsigned int numElements, bool dynamic)
 {
-	HRESULT hr;
-
-	// vertex buffer description
-	D3D11_BUFFER_DESC bufferDesc = {};
-	bufferDesc.Usage = dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_IMMUTABLE;
-	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bufferDesc.ByteWidth = sizeof(T) * numElements;
-	bufferDesc.CPUAccessFlags = dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
-	bufferDesc.MiscFlags = 0;
-	bufferDesc.StructureByteStride = 0;
-
-	// vertex buffer data - bufferData.SysMemPitch and bufferData.SysMemSlicePitch not needed (1D buffer)
-	D3D11_SUBRESOURCE_DATA bufferData = {};
-	bufferData.pSysMem = (void*)data; 
-
-	// create Vertex buffer
-	ID3D11Buffer *buffer;
-	hr = GraphicsSystem::GetInstance().GetDevice()->CreateBuffer(&bufferDesc, &bufferData, &buffer);
-	if (FAILED(hr))
-		ErrorBox("vertex buffer creation failed");
+	RenderDevice::Usage usage = dynamic ? RenderDevice::Usage::DYNAMIC : RenderDevice::Usage::IMMUTABLE;
+
+	// create vertex buffer
+	BufferHandle buffer = GraphicsSystem::GetInstance().GetRenderDevice().CreateBuffer(RenderDevice::BufferType::VERTEX, usage, sizeof(T) * numElements, (void*)data);
 
 	// add vertex buffer to list
 	mVertexBuffers.push_back(buffer);
 	mStrides.push_back(sizeof(T));
 
-	// add attribute to map
-	mAttributeMapping[attributeSemantic] = mMapIndex++;
+	mAttributeStreams[(unsigned int)attribute] = (int)mVertexBuffers.size() - 1;
 }
 
 template <typename T> 
-void Mesh::UpdateDynamicAttribute(std::string const &attributeSemantic, T* data, unsigned int numElements, unsigned int offset)
+void Mesh::UpdateDynamicAttribute(VertexLayout::Attribute attribute, T* data, unsigned int numElements, unsigned int offset)
 {
-	ID3D11Buffer *dynamicVertexBuffer = mVertexBuffers[mAttributeMapping[attributeSemantic]];  // TODO: attribute not present or not dynamic (error/exception)
-	
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	BufferHandle dynamicVertexBuffer = mVertexBuffers[mAttributeStreams[(unsigned int)attribute]];  // TODO: attribute not present or not dynamic (error/exception)
 	
-	GraphicsSystem::GetInstance().GetDeviceContext()->Map(dynamicVertexBuffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedResource);
-	
-	T *vertexData(static_cast<T*>(mappedResource.pData));
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	T *vertexData(static_cast<T*>(renderDevice.Map(dynamicVertexBuffer, RenderDevice::MapMode::WRITE_NO_OVERWRITE)));
 	for (int i = offset; i < offset + numElements; i++)
 		vertexData[i] = data[i - offset];
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Unmap(dynamicVertexBuffer, 0);
+	renderDevice.Unmap(dynamicVertexBuffer);
 }
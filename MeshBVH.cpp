@@ -0,0 +1,1041 @@
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+
+namespace
+{
+	const unsigned int MEDIAN_SPLIT_DEPTH = 32;   // below this depth splits are forced to halve the triangle count (bounds traversal stack depth)
+	const unsigned int PARALLEL_SUBTREE_SIZE = 4096;
+
+	const char FILE_MAGIC[4] = { 'M', 'B', 'V', 'H' };
+	const uint32_t FILE_VERSION = 1;
+
+	struct FileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t numNodes;
+		uint32_t numTriangles;
+		uint32_t root;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	float SurfaceArea(const XMFLOAT3 &min, const XMFLOAT3 &max)
+	{
+		float dx = max.x - min.x, dy = max.y - min.y, dz = max.z - min.z;
+
+		return 2.0f * (dx * dy + dy * dz + dz * dx);
+	}
+
+	void Grow(XMFLOAT3 &min, XMFLOAT3 &max, const XMFLOAT3 &otherMin, const XMFLOAT3 &otherMax)
+	{
+		min.x = std::min(min.x, otherMin.x); min.y = std::min(min.y, otherMin.y); min.z = std::min(min.z, otherMin.z);
+		max.x = std::max(max.x, otherMax.x); max.y = std::max(max.y, otherMax.y); max.z = std::max(max.z, otherMax.z);
+	}
+
+	float Component(const XMFLOAT3 &v, int axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	// keep only the deepest of contacts sharing (almost) the same normal - a sphere resting on a tessellated floor touches many coplanar triangles
+	void AddContact(Vector<MeshBVH::Contact> &contacts, size_t firstContact, const MeshBVH::Contact &contact)
+	{
+		for (size_t i = firstContact; i < contacts.Size(); i++)
+		{
+			float dot = contacts[i].normal.x * contact.normal.x + contacts[i].normal.y * contact.normal.y + contacts[i].normal.z * contact.normal.z;
+
+			if (dot > 0.99f)
+			{
+				if (contact.penetration > contacts[i].penetration)
+					contacts[i] = contact;
+
+				return;
+			}
+		}
+
+		contacts.InsertLast(contact);
+	}
+}
+
+/**** geometry helpers ****/
+
+// closest point on triangle abc to point p (Ericson, Real-Time Collision Detection 5.1.5)
+XMVECTOR MeshBVH::ClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+{
+	XMVECTOR ab = b - a;
+	XMVECTOR ac = c - a;
+	XMVECTOR ap = p - a;
+
+	float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+	float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return a;
+
+	XMVECTOR bp = p - b;
+	float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+	float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+	if (d3 >= 0.0f && d4 <= d3)
+		return b;
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return a + ab * (d1 / (d1 - d3));
+
+	XMVECTOR cp = p - c;
+	float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+	float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+	if (d6 >= 0.0f && d5 <= d6)
+		return c;
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return a + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float denominator = 1.0f / (va + vb + vc);
+
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// Moller-Trumbore ray/triangle intersection (double sided)
+bool MeshBVH::IntersectRayTriangle(FXMVECTOR origin, FXMVECTOR direction, FXMVECTOR a, GXMVECTOR b, HXMVECTOR c, float &distance)
+{
+	XMVECTOR edge1 = b - a;
+	XMVECTOR edge2 = c - a;
+
+	XMVECTOR p = XMVector3Cross(direction, edge2);
+	float determinant = XMVectorGetX(XMVector3Dot(edge1, p));
+
+	if (fabs(determinant) < 1e-9f)
+		return false;
+
+	float inverseDeterminant = 1.0f / determinant;
+	XMVECTOR s = origin - a;
+
+	float u = XMVectorGetX(XMVector3Dot(s, p)) * inverseDeterminant;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	XMVECTOR q = XMVector3Cross(s, edge1);
+	float v = XMVectorGetX(XMVector3Dot(direction, q)) * inverseDeterminant;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	distance = XMVectorGetX(XMVector3Dot(edge2, q)) * inverseDeterminant;
+
+	return distance >= 0.0f;
+}
+
+// swept sphere against the triangle: face, then the edges (cylinders) and the vertices (spheres) of the triangle inflated by the radius
+bool MeshBVH::IntersectSphereTriangle(FXMVECTOR origin, FXMVECTOR direction, float radius, GXMVECTOR a, HXMVECTOR b, HXMVECTOR c, float &distance, XMVECTOR &normal)
+{
+	// already touching
+	XMVECTOR closestPoint = ClosestPointOnTriangle(origin, a, b, c);
+	XMVECTOR offset = origin - closestPoint;
+	float distanceSq = XMVectorGetX(XMVector3LengthSq(offset));
+
+	XMVECTOR normalV = XMVector3Normalize(XMVector3Cross(b - a, c - a));
+	float planeDistance = XMVectorGetX(XMVector3Dot(normalV, origin - a));
+
+	if (planeDistance < 0.0f)   // double sided
+	{
+		normalV = -normalV;
+		planeDistance = -planeDistance;
+	}
+
+	if (distanceSq <= radius * radius)
+	{
+		distance = 0.0f;
+		normal = distanceSq > 1e-12f ? offset / sqrtf(distanceSq) : normalV;
+
+		return true;
+	}
+
+	// face - the sphere touches the plane at center - normal * radius
+	float approach = -XMVectorGetX(XMVector3Dot(direction, normalV));
+
+	if (planeDistance > radius && approach > 1e-9f)
+	{
+		float t = (planeDistance - radius) / approach;
+		XMVECTOR p = origin + direction * t - normalV * radius;
+
+		if (XMVectorGetX(XMVector3Dot(XMVector3Cross(b - a, p - a), normalV)) >= 0.0f &&
+			XMVectorGetX(XMVector3Dot(XMVector3Cross(c - b, p - b), normalV)) >= 0.0f &&
+			XMVectorGetX(XMVector3Dot(XMVector3Cross(a - c, p - c), normalV)) >= 0.0f)
+		{
+			distance = t;
+			normal = normalV;
+
+			return true;
+		}
+	}
+
+	// edges and vertices
+	const XMVECTOR vertices[3] = { a, b, c };
+	float closest = FLT_MAX;
+
+	for (int i = 0; i < 3; i++)
+	{
+		XMVECTOR p0 = vertices[i];
+		XMVECTOR edge = vertices[(i + 1) % 3] - p0;
+		XMVECTOR m = origin - p0;
+
+		// vertex sphere
+		float mDotD = XMVectorGetX(XMVector3Dot(m, direction));
+		float mDotM = XMVectorGetX(XMVector3Dot(m, m)) - radius * radius;
+		float discriminant = mDotD * mDotD - mDotM;
+
+		if (mDotD < 0.0f && discriminant >= 0.0f)
+		{
+			float t = -mDotD - sqrtf(discriminant);
+
+			if (t < closest)
+			{
+				closest = t;
+				normal = XMVector3Normalize(origin + direction * t - p0);
+			}
+		}
+
+		// edge cylinder, clamped to the segment
+		float edgeLengthSq = XMVectorGetX(XMVector3Dot(edge, edge));
+		XMVECTOR directionPerp = direction - edge * (XMVectorGetX(XMVector3Dot(direction, edge)) / edgeLengthSq);
+		XMVECTOR mPerp = m - edge * (XMVectorGetX(XMVector3Dot(m, edge)) / edgeLengthSq);
+
+		float qa = XMVectorGetX(XMVector3Dot(directionPerp, directionPerp));
+		float qb = XMVectorGetX(XMVector3Dot(mPerp, directionPerp));
+		float qc = XMVectorGetX(XMVector3Dot(mPerp, mPerp)) - radius * radius;
+
+		if (qa < 1e-9f || qc <= 0.0f || qb >= 0.0f)   // parallel, inside the infinite cylinder (the vertices are hit first) or moving away
+			continue;
+
+		discriminant = qb * qb - qa * qc;
+		if (discriminant < 0.0f)
+			continue;
+
+		float t = (-qb - sqrtf(discriminant)) / qa;
+		float s = XMVectorGetX(XMVector3Dot(m + direction * t, edge)) / edgeLengthSq;
+
+		if (s >= 0.0f && s <= 1.0f && t < closest)
+		{
+			closest = t;
+			normal = XMVector3Normalize(origin + direction * t - (p0 + edge * s));
+		}
+	}
+
+	if (closest == FLT_MAX)
+		return false;
+
+	distance = closest;
+
+	return true;
+}
+
+/**** construction ****/
+
+uint64_t MeshBVH::HashSource(const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices, const XMFLOAT3 &scale)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+
+	auto hashBytes = [&hash](const void *data, size_t size)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	if (!vertices.empty())
+		hashBytes(&vertices[0], vertices.size() * sizeof(XMFLOAT3));
+	if (!indices.empty())
+		hashBytes(&indices[0], indices.size() * sizeof(unsigned int));
+	hashBytes(&scale, sizeof(XMFLOAT3));
+
+	return hash;
+}
+
+void MeshBVH::Build(const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices, const XMFLOAT3 &scale, bool parallel)
+{
+	mNodes.clear();
+	mTriangles.clear();
+	mRoot = 0;
+	mSourceHash = HashSource(vertices, indices, scale);
+
+	unsigned int numTriangles = (unsigned int)indices.size() / 3;
+
+	if (numTriangles == 0)
+		return;
+
+	// collider world matrices are unscaled: bake the entity scale into the vertex positions
+	std::vector<XMFLOAT3> positions(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+		positions[i] = XMFLOAT3(vertices[i].x * scale.x, vertices[i].y * scale.y, vertices[i].z * scale.z);
+
+	// triangle bounds and centroids
+	std::vector<BuildTriangle> triangles(numTriangles);
+
+	BuildNode root;
+	root.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	root.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for (unsigned int i = 0; i < numTriangles; i++)
+	{
+		const XMFLOAT3 &a = positions[indices[i * 3]];
+		const XMFLOAT3 &b = positions[indices[i * 3 + 1]];
+		const XMFLOAT3 &c = positions[indices[i * 3 + 2]];
+
+		BuildTriangle &triangle = triangles[i];
+		triangle.min = XMFLOAT3(std::min(a.x, std::min(b.x, c.x)), std::min(a.y, std::min(b.y, c.y)), std::min(a.z, std::min(b.z, c.z)));
+		triangle.max = XMFLOAT3(std::max(a.x, std::max(b.x, c.x)), std::max(a.y, std::max(b.y, c.y)), std::max(a.z, std::max(b.z, c.z)));
+		triangle.centroid = XMFLOAT3((a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f);
+		triangle.index = i;
+
+		Grow(root.min, root.max, triangle.min, triangle.max);
+	}
+
+	mBoundsMin = root.min;
+	mBoundsMax = root.max;
+
+	// quantisation frame
+	XMFLOAT3 extent(mBoundsMax.x - mBoundsMin.x, mBoundsMax.y - mBoundsMin.y, mBoundsMax.z - mBoundsMin.z);
+	mQuantiseScale = XMFLOAT3(extent.x > 0.0f ? 65535.0f / extent.x : 0.0f, extent.y > 0.0f ? 65535.0f / extent.y : 0.0f, extent.z > 0.0f ? 65535.0f / extent.z : 0.0f);
+	mDequantiseScale = XMFLOAT3(extent.x / 65535.0f, extent.y / 65535.0f, extent.z / 65535.0f);
+
+	root.first = 0;
+	root.count = numTriangles;
+	root.children[0] = root.children[1] = -1;
+	root.subtree = -1;
+	root.depth = 0;
+
+	// trees[0] is the top of the hierarchy, the other trees are subtrees built in parallel
+	std::vector<std::vector<BuildNode>> trees(1);
+	trees[0].push_back(root);
+
+	if (parallel && numTriangles > PARALLEL_SUBTREE_SIZE && ThreadPool::GetInstance().GetNumThreads() > 1)
+	{
+		// split serially until the nodes are small enough, leaving the remaining work as independent subtrees
+		std::vector<int> pendingSubtrees;
+		unsigned int subtreeSize = std::max(PARALLEL_SUBTREE_SIZE, numTriangles / (ThreadPool::GetInstance().GetNumThreads() * 4));
+
+		BuildRange(triangles, trees[0], 0, &pendingSubtrees, subtreeSize);
+
+		trees.resize(pendingSubtrees.size() + 1);
+
+		for (size_t i = 0; i < pendingSubtrees.size(); i++)
+		{
+			BuildNode &placeholder = trees[0][pendingSubtrees[i]];
+			placeholder.subtree = (int)i + 1;
+			trees[i + 1].push_back(placeholder);
+			trees[i + 1][0].subtree = -1;
+		}
+
+		// subtrees own disjoint ranges of the triangle array
+		ThreadPool::GetInstance().ParallelFor((unsigned int)pendingSubtrees.size(), [this, &triangles, &trees](unsigned int i)
+		{
+			BuildRange(triangles, trees[i + 1], 0, nullptr, 0);
+		});
+	}
+	else
+		BuildRange(triangles, trees[0], 0, nullptr, 0);
+
+	// reorder triangles into leaf order
+	mTriangles.resize(numTriangles * 3);
+	for (unsigned int i = 0; i < numTriangles; i++)
+		for (int j = 0; j < 3; j++)
+			mTriangles[i * 3 + j] = positions[indices[triangles[i].index * 3 + j]];
+
+	// flatten to 32 byte nodes
+	mNodes.reserve(numTriangles);
+	mRoot = Flatten(trees, 0, 0);
+}
+
+void MeshBVH::BuildRange(std::vector<BuildTriangle> &triangles, std::vector<BuildNode> &nodes, int rootIndex, std::vector<int> *pendingSubtrees, unsigned int subtreeSize)
+{
+	std::vector<int> stack;
+	stack.push_back(rootIndex);
+
+	while (!stack.empty())
+	{
+		int nodeIndex = stack.back();
+		stack.pop_back();
+
+		// leave big enough nodes to the worker threads
+		if (pendingSubtrees && nodes[nodeIndex].count <= subtreeSize)
+		{
+			pendingSubtrees->push_back(nodeIndex);
+			continue;
+		}
+
+		if (nodes[nodeIndex].count <= 2)
+			continue;
+
+		unsigned int splitIndex;
+
+		if (nodes[nodeIndex].depth < MEDIAN_SPLIT_DEPTH)
+		{
+			if (!SplitNode(triangles, nodes[nodeIndex], splitIndex))
+				continue;   // making a leaf is cheaper than any split
+		}
+		else if (nodes[nodeIndex].count <= MAX_LEAF_TRIANGLES)
+			continue;
+		else
+		{
+			// median split along the longest axis
+			BuildNode &node = nodes[nodeIndex];
+			XMFLOAT3 extent(node.max.x - node.min.x, node.max.y - node.min.y, node.max.z - node.min.z);
+			int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+			splitIndex = node.first + node.count / 2;
+			std::nth_element(triangles.begin() + node.first, triangles.begin() + splitIndex, triangles.begin() + node.first + node.count,
+				[axis](const BuildTriangle &a, const BuildTriangle &b) { return Component(a.centroid, axis) < Component(b.centroid, axis); });
+		}
+
+		// create children
+		unsigned int first = nodes[nodeIndex].first;
+		unsigned int count = nodes[nodeIndex].count;
+		unsigned int depth = nodes[nodeIndex].depth;
+
+		unsigned int ranges[2][2] = { { first, splitIndex - first }, { splitIndex, first + count - splitIndex } };
+
+		for (int i = 0; i < 2; i++)
+		{
+			BuildNode child;
+			child.first = ranges[i][0];
+			child.count = ranges[i][1];
+			child.children[0] = child.children[1] = -1;
+			child.subtree = -1;
+			child.depth = depth + 1;
+			child.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			child.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+			for (unsigned int j = child.first; j < child.first + child.count; j++)
+				Grow(child.min, child.max, triangles[j].min, triangles[j].max);
+
+			nodes[nodeIndex].children[i] = (int)nodes.size();
+			nodes.push_back(child);
+
+			stack.push_back(nodes[nodeIndex].children[i]);
+		}
+	}
+}
+
+// binned SAH split, returns false if the node should stay a leaf
+bool MeshBVH::SplitNode(std::vector<BuildTriangle> &triangles, BuildNode &node, unsigned int &splitIndex)
+{
+	// centroid bounds
+	XMFLOAT3 centroidMin(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 centroidMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for (unsigned int i = node.first; i < node.first + node.count; i++)
+		Grow(centroidMin, centroidMax, triangles[i].centroid, triangles[i].centroid);
+
+	struct Bin
+	{
+		XMFLOAT3 min;
+		XMFLOAT3 max;
+		unsigned int count;
+	};
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	unsigned int bestBin = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float axisMin = Component(centroidMin, axis);
+		float axisMax = Component(centroidMax, axis);
+
+		if (axisMax - axisMin < 1e-6f)
+			continue;
+
+		Bin bins[NUM_BINS];
+		for (Bin &bin : bins)
+		{
+			bin.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			bin.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			bin.count = 0;
+		}
+
+		float binScale = NUM_BINS / (axisMax - axisMin);
+
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			unsigned int binIndex = std::min(NUM_BINS - 1, (unsigned int)((Component(triangles[i].centroid, axis) - axisMin) * binScale));
+			Grow(bins[binIndex].min, bins[binIndex].max, triangles[i].min, triangles[i].max);
+			bins[binIndex].count++;
+		}
+
+		// sweep from the right to accumulate right side areas, then from the left evaluating the cost of each plane
+		float rightArea[NUM_BINS - 1];
+		unsigned int rightCount[NUM_BINS - 1];
+
+		XMFLOAT3 accumulatedMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 accumulatedMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		unsigned int accumulatedCount = 0;
+
+		for (unsigned int i = NUM_BINS - 1; i > 0; i--)
+		{
+			Grow(accumulatedMin, accumulatedMax, bins[i].min, bins[i].max);
+			accumulatedCount += bins[i].count;
+			rightArea[i - 1] = accumulatedCount ? SurfaceArea(accumulatedMin, accumulatedMax) : 0.0f;
+			rightCount[i - 1] = accumulatedCount;
+		}
+
+		accumulatedMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		accumulatedMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		accumulatedCount = 0;
+
+		for (unsigned int i = 0; i < NUM_BINS - 1; i++)
+		{
+			Grow(accumulatedMin, accumulatedMax, bins[i].min, bins[i].max);
+			accumulatedCount += bins[i].count;
+
+			if (!accumulatedCount || !rightCount[i])
+				continue;
+
+			float cost = accumulatedCount * SurfaceArea(accumulatedMin, accumulatedMax) + rightCount[i] * rightArea[i];
+
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = i;
+			}
+		}
+	}
+
+	// compare with the cost of a leaf (traversal cost = 1, intersection cost = 1, both relative to the parent's area)
+	float leafCost = node.count * SurfaceArea(node.min, node.max);
+	float splitCost = SurfaceArea(node.min, node.max) + bestCost;
+
+	if (bestAxis == -1)
+	{
+		// all centroids coincide: split in half if the leaf would be too big
+		if (node.count <= MAX_LEAF_TRIANGLES)
+			return false;
+
+		splitIndex = node.first + node.count / 2;
+		return true;
+	}
+
+	if (node.count <= MAX_LEAF_TRIANGLES && leafCost <= splitCost)
+		return false;
+
+	// partition triangles on the chosen plane
+	float axisMin = Component(centroidMin, bestAxis);
+	float binScale = NUM_BINS / (Component(centroidMax, bestAxis) - axisMin);
+
+	BuildTriangle *middle = std::partition(&triangles[node.first], &triangles[node.first] + node.count, [=](const BuildTriangle &triangle)
+	{
+		return std::min(NUM_BINS - 1, (unsigned int)((Component(triangle.centroid, bestAxis) - axisMin) * binScale)) <= bestBin;
+	});
+
+	splitIndex = node.first + (unsigned int)(middle - &triangles[node.first]);
+
+	if (splitIndex == node.first || splitIndex == node.first + node.count)
+		splitIndex = node.first + node.count / 2;
+
+	return true;
+}
+
+uint32_t MeshBVH::Flatten(const std::vector<std::vector<BuildNode>> &trees, int treeIndex, int nodeIndex)
+{
+	const BuildNode *buildNode = &trees[treeIndex][nodeIndex];
+
+	// subtree placeholders are replaced by the subtree root
+	if (buildNode->subtree >= 0)
+		return Flatten(trees, buildNode->subtree, 0);
+
+	if (buildNode->children[0] < 0)
+		return LEAF_FLAG | ((buildNode->count - 1) << LEAF_COUNT_SHIFT) | buildNode->first;
+
+	uint32_t index = (uint32_t)mNodes.size();
+	mNodes.push_back(Node());
+
+	for (int i = 0; i < 2; i++)
+	{
+		const BuildNode &child = trees[treeIndex][buildNode->children[i]];
+		const BuildNode &bounds = child.subtree >= 0 ? trees[child.subtree][0] : child;
+
+		Node node = mNodes[index];
+		QuantiseBounds(bounds.min, bounds.max, node.childMin[i], node.childMax[i]);
+		mNodes[index] = node;
+
+		uint32_t reference = Flatten(trees, treeIndex, buildNode->children[i]);   // may reallocate mNodes
+		mNodes[index].child[i] = reference;
+	}
+
+	return index;
+}
+
+/**** quantisation - conservative (min rounded down, max rounded up) ****/
+
+void MeshBVH::QuantiseBounds(const XMFLOAT3 &min, const XMFLOAT3 &max, uint16_t (&qMin)[3], uint16_t (&qMax)[3]) const
+{
+	const float minValues[3] = { (min.x - mBoundsMin.x) * mQuantiseScale.x, (min.y - mBoundsMin.y) * mQuantiseScale.y, (min.z - mBoundsMin.z) * mQuantiseScale.z };
+	const float maxValues[3] = { (max.x - mBoundsMin.x) * mQuantiseScale.x, (max.y - mBoundsMin.y) * mQuantiseScale.y, (max.z - mBoundsMin.z) * mQuantiseScale.z };
+
+	for (int i = 0; i < 3; i++)
+	{
+		qMin[i] = (uint16_t)std::max(0.0f, std::min(65535.0f, floorf(minValues[i])));
+		qMax[i] = (uint16_t)std::max(0.0f, std::min(65535.0f, ceilf(maxValues[i])));
+	}
+}
+
+void MeshBVH::DequantiseBounds(const uint16_t (&qMin)[3], const uint16_t (&qMax)[3], XMFLOAT3 &min, XMFLOAT3 &max) const
+{
+	min = XMFLOAT3(mBoundsMin.x + qMin[0] * mDequantiseScale.x, mBoundsMin.y + qMin[1] * mDequantiseScale.y, mBoundsMin.z + qMin[2] * mDequantiseScale.z);
+	max = XMFLOAT3(mBoundsMin.x + qMax[0] * mDequantiseScale.x, mBoundsMin.y + qMax[1] * mDequantiseScale.y, mBoundsMin.z + qMax[2] * mDequantiseScale.z);
+}
+
+/**** serialisation ****/
+
+bool MeshBVH::Save(const std::string &filePath) const
+{
+	FILE *fileStream = nullptr;
+	if (fopen_s(&fileStream, filePath.c_str(), "wb"))
+		return false;
+
+	FileHeader header;
+	std::copy(FILE_MAGIC, FILE_MAGIC + 4, header.magic);
+	header.version = FILE_VERSION;
+	header.sourceHash = mSourceHash;
+	header.numNodes = (uint32_t)mNodes.size();
+	header.numTriangles = GetTriangleCount();
+	header.root = mRoot;
+	header.boundsMin[0] = mBoundsMin.x; header.boundsMin[1] = mBoundsMin.y; header.boundsMin[2] = mBoundsMin.z;
+	header.boundsMax[0] = mBoundsMax.x; header.boundsMax[1] = mBoundsMax.y; header.boundsMax[2] = mBoundsMax.z;
+
+	bool written = fwrite(&header, sizeof(FileHeader), 1, fileStream) == 1;
+
+	if (written && header.numNodes)
+		written = fwrite(&mNodes[0], sizeof(Node), mNodes.size(), fileStream) == mNodes.size();
+
+	if (written && header.numTriangles)
+		written = fwrite(&mTriangles[0], sizeof(XMFLOAT3), mTriangles.size(), fileStream) == mTriangles.size();
+
+	fclose(fileStream);
+
+	return written;
+}
+
+// load a saved hierarchy, fails if the file is missing, corrupted or was built from different source data
+bool MeshBVH::Load(const std::string &filePath, uint64_t sourceHash)
+{
+	FILE *fileStream = nullptr;
+	if (fopen_s(&fileStream, filePath.c_str(), "rb"))
+		return false;
+
+	int64_t fileSize = -1;
+	if (_fseeki64(fileStream, 0, SEEK_END) == 0)
+		fileSize = _ftelli64(fileStream);
+
+	FileHeader header;
+	bool read = fileSize >= 0 && _fseeki64(fileStream, 0, SEEK_SET) == 0 && fread(&header, sizeof(FileHeader), 1, fileStream) == 1 &&
+		std::equal(FILE_MAGIC, FILE_MAGIC + 4, header.magic) && header.version == FILE_VERSION && header.sourceHash == sourceHash;
+
+	// the counts must match the file size before anything is allocated, leaves address at most LEAF_FIRST_MASK + 1 triangles
+	read = read && header.numTriangles <= LEAF_FIRST_MASK + 1 &&
+		(uint64_t)fileSize == sizeof(FileHeader) + (uint64_t)header.numNodes * sizeof(Node) + (uint64_t)header.numTriangles * 3 * sizeof(XMFLOAT3);
+
+	for (int i = 0; i < 3; i++)
+		read = read && header.boundsMin[i] <= header.boundsMax[i] && std::isfinite(header.boundsMin[i]) && std::isfinite(header.boundsMax[i]);
+
+	std::vector<Node> nodes;
+	std::vector<XMFLOAT3> triangles;
+
+	if (read)
+	{
+		nodes.resize(header.numNodes);
+		triangles.resize((size_t)header.numTriangles * 3);
+
+		if (header.numNodes)
+			read = fread(&nodes[0], sizeof(Node), nodes.size(), fileStream) == nodes.size();
+		if (read && header.numTriangles)
+			read = fread(&triangles[0], sizeof(XMFLOAT3), triangles.size(), fileStream) == triangles.size();
+	}
+
+	fclose(fileStream);
+
+	if (!read || (header.numTriangles && !ValidateTree(nodes, header.root, header.numTriangles)))
+		return false;
+
+	mNodes.swap(nodes);
+	mTriangles.swap(triangles);
+	mRoot = header.root;
+	mSourceHash = header.sourceHash;
+	mBoundsMin = XMFLOAT3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	mBoundsMax = XMFLOAT3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+	XMFLOAT3 extent(mBoundsMax.x - mBoundsMin.x, mBoundsMax.y - mBoundsMin.y, mBoundsMax.z - mBoundsMin.z);
+	mQuantiseScale = XMFLOAT3(extent.x > 0.0f ? 65535.0f / extent.x : 0.0f, extent.y > 0.0f ? 65535.0f / extent.y : 0.0f, extent.z > 0.0f ? 65535.0f / extent.z : 0.0f);
+	mDequantiseScale = XMFLOAT3(extent.x / 65535.0f, extent.y / 65535.0f, extent.z / 65535.0f);
+
+	return true;
+}
+
+// walks a loaded tree once: every reference must be in range, each node reached once and no deeper than the traversal stacks allow
+bool MeshBVH::ValidateTree(const std::vector<Node> &nodes, uint32_t root, unsigned int numTriangles)
+{
+	std::vector<bool> visited(nodes.size(), false);
+	std::vector<std::pair<uint32_t, unsigned int>> stack(1, std::make_pair(root, 0u));      // reference, depth
+
+	while (stack.size())
+	{
+		uint32_t reference = stack.back().first;
+		unsigned int depth = stack.back().second;
+		stack.pop_back();
+
+		if (IsLeaf(reference))
+		{
+			if ((uint64_t)LeafFirst(reference) + LeafCount(reference) > numTriangles)
+				return false;
+
+			continue;
+		}
+
+		if (reference >= nodes.size() || visited[reference] || depth >= MAX_DEPTH)
+			return false;
+
+		visited[reference] = true;
+
+		for (int i = 0; i < 2; i++)
+			stack.push_back(std::make_pair(nodes[reference].child[i], depth + 1));
+	}
+
+	return true;
+}
+
+/**** queries ****/
+
+bool MeshBVH::RayCast(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float maxDistance, RayHit &hit) const
+{
+	if (mTriangles.empty())
+		return false;
+
+	XMFLOAT3 inverseDirection(direction.x != 0.0f ? 1.0f / direction.x : FLT_MAX, direction.y != 0.0f ? 1.0f / direction.y : FLT_MAX, direction.z != 0.0f ? 1.0f / direction.z : FLT_MAX);
+
+	// slab test, returns entry distance or FLT_MAX
+	auto intersectBox = [&](const XMFLOAT3 &min, const XMFLOAT3 &max, float tMax) -> float
+	{
+		float t1 = (min.x - origin.x) * inverseDirection.x, t2 = (max.x - origin.x) * inverseDirection.x;
+		float tNear = std::min(t1, t2), tFar = std::max(t1, t2);
+
+		t1 = (min.y - origin.y) * inverseDirection.y; t2 = (max.y - origin.y) * inverseDirection.y;
+		tNear = std::max(tNear, std::min(t1, t2)); tFar = std::min(tFar, std::max(t1, t2));
+
+		t1 = (min.z - origin.z) * inverseDirection.z; t2 = (max.z - origin.z) * inverseDirection.z;
+		tNear = std::max(tNear, std::min(t1, t2)); tFar = std::min(tFar, std::max(t1, t2));
+
+		return (tFar >= std::max(tNear, 0.0f) && tNear <= tMax) ? tNear : FLT_MAX;
+	};
+
+	if (intersectBox(mBoundsMin, mBoundsMax, maxDistance) == FLT_MAX)
+		return false;
+
+	XMVECTOR originV = XMLoadFloat3(&origin);
+	XMVECTOR directionV = XMLoadFloat3(&direction);
+
+	float closest = maxDistance;
+	bool found = false;
+
+	uint32_t stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = mRoot;
+
+	while (stackSize)
+	{
+		uint32_t reference = stack[--stackSize];
+
+		if (IsLeaf(reference))
+		{
+			unsigned int first = LeafFirst(reference);
+			unsigned int count = LeafCount(reference);
+
+			for (unsigned int i = first; i < first + count; i++)
+			{
+				XMVECTOR a = XMLoadFloat3(&mTriangles[i * 3]);
+				XMVECTOR b = XMLoadFloat3(&mTriangles[i * 3 + 1]);
+				XMVECTOR c = XMLoadFloat3(&mTriangles[i * 3 + 2]);
+
+				float t;
+				if (!IntersectRayTriangle(originV, directionV, a, b, c, t) || t > closest)
+					continue;
+
+				XMVECTOR edge1 = b - a;
+				XMVECTOR edge2 = c - a;
+
+				closest = t;
+				found = true;
+
+				XMVECTOR normalV = XMVector3Normalize(XMVector3Cross(edge1, edge2));
+				if (XMVectorGetX(XMVector3Dot(normalV, directionV)) > 0.0f)
+					normalV = -normalV;
+
+				hit.distance = t;
+				hit.triangle = i;
+				XMStoreFloat3(&hit.point, originV + directionV * t);
+				XMStoreFloat3(&hit.normal, normalV);
+			}
+
+			continue;
+		}
+
+		const Node &node = mNodes[reference];
+
+		float distances[2];
+		for (int i = 0; i < 2; i++)
+		{
+			XMFLOAT3 childMin, childMax;
+			DequantiseBounds(node.childMin[i], node.childMax[i], childMin, childMax);
+			distances[i] = intersectBox(childMin, childMax, closest);
+		}
+
+		// push the farther child first so that the nearer is visited first
+		int nearChild = distances[0] <= distances[1] ? 0 : 1;
+
+		if (distances[1 - nearChild] != FLT_MAX)
+			stack[stackSize++] = node.child[1 - nearChild];
+		if (distances[nearChild] != FLT_MAX)
+			stack[stackSize++] = node.child[nearChild];
+	}
+
+	return found;
+}
+
+// visits the triangles overlapping the bounds of the whole sweep, meant for short sweeps (character movement, projectiles)
+bool MeshBVH::SweepSphere(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float radius, float maxDistance, RayHit &hit) const
+{
+	XMFLOAT3 end(origin.x + direction.x * maxDistance, origin.y + direction.y * maxDistance, origin.z + direction.z * maxDistance);
+
+	XMFLOAT3 min(std::min(origin.x, end.x) - radius, std::min(origin.y, end.y) - radius, std::min(origin.z, end.z) - radius);
+	XMFLOAT3 max(std::max(origin.x, end.x) + radius, std::max(origin.y, end.y) + radius, std::max(origin.z, end.z) + radius);
+
+	XMVECTOR originV = XMLoadFloat3(&origin);
+	XMVECTOR directionV = XMLoadFloat3(&direction);
+
+	float closest = maxDistance;
+	bool found = false;
+
+	QueryAABB(min, max, [&](unsigned int triangle, const XMFLOAT3 *vertices)
+	{
+		float t;
+		XMVECTOR normalV;
+
+		if (!IntersectSphereTriangle(originV, directionV, radius, XMLoadFloat3(&vertices[0]), XMLoadFloat3(&vertices[1]), XMLoadFloat3(&vertices[2]), t, normalV) || t > closest)
+			return;
+
+		closest = t;
+		found = true;
+
+		hit.distance = t;
+		hit.triangle = triangle;
+		XMStoreFloat3(&hit.point, originV + directionV * t - normalV * radius);
+		XMStoreFloat3(&hit.normal, normalV);
+	});
+
+	return found;
+}
+
+bool MeshBVH::OverlapSphere(const XMFLOAT3 &center, float radius) const
+{
+	XMVECTOR centerV = XMLoadFloat3(&center);
+	bool overlap = false;
+
+	QueryAABB(XMFLOAT3(center.x - radius, center.y - radius, center.z - radius), XMFLOAT3(center.x + radius, center.y + radius, center.z + radius), [&](unsigned int, const XMFLOAT3 *vertices)
+	{
+		if (overlap)
+			return;
+
+		XMVECTOR closestPoint = ClosestPointOnTriangle(centerV, XMLoadFloat3(&vertices[0]), XMLoadFloat3(&vertices[1]), XMLoadFloat3(&vertices[2]));
+
+		if (XMVectorGetX(XMVector3LengthSq(centerV - closestPoint)) <= radius * radius)
+			overlap = true;
+	});
+
+	return overlap;
+}
+
+void MeshBVH::SphereContacts(const XMFLOAT3 &center, float radius, Vector<Contact> &contacts) const
+{
+	XMVECTOR centerV = XMLoadFloat3(&center);
+	size_t firstContact = contacts.Size();
+
+	QueryAABB(XMFLOAT3(center.x - radius, center.y - radius, center.z - radius), XMFLOAT3(center.x + radius, center.y + radius, center.z + radius), [&](unsigned int, const XMFLOAT3 *vertices)
+	{
+		XMVECTOR a = XMLoadFloat3(&vertices[0]);
+		XMVECTOR b = XMLoadFloat3(&vertices[1]);
+		XMVECTOR c = XMLoadFloat3(&vertices[2]);
+
+		XMVECTOR closestPoint = ClosestPointOnTriangle(centerV, a, b, c);
+		XMVECTOR offset = centerV - closestPoint;
+		float distance = XMVectorGetX(XMVector3Length(offset));
+
+		if (distance >= radius)
+			return;
+
+		XMVECTOR normalV;
+		if (distance > 1e-6f)
+			normalV = offset / distance;
+		else
+		{
+			// center on the triangle: push out along the face normal
+			normalV = XMVector3Normalize(XMVector3Cross(b - a, c - a));
+		}
+
+		Contact contact;
+		XMStoreFloat3(&contact.point, closestPoint);
+		XMStoreFloat3(&contact.normal, normalV);
+		contact.penetration = radius - distance;
+
+		AddContact(contacts, firstContact, contact);
+	});
+}
+
+void MeshBVH::BoxContacts(const XMFLOAT3 &center, const XMFLOAT3 (&axes)[3], const XMFLOAT3 &halfSize, Vector<Contact> &contacts) const
+{
+	XMVECTOR centerV = XMLoadFloat3(&center);
+	XMVECTOR axesV[3] = { XMLoadFloat3(&axes[0]), XMLoadFloat3(&axes[1]), XMLoadFloat3(&axes[2]) };
+	const float extents[3] = { halfSize.x, halfSize.y, halfSize.z };
+
+	// box local space aabb
+	XMFLOAT3 boxExtent;
+	boxExtent.x = fabs(axes[0].x) * halfSize.x + fabs(axes[1].x) * halfSize.y + fabs(axes[2].x) * halfSize.z;
+	boxExtent.y = fabs(axes[0].y) * halfSize.x + fabs(axes[1].y) * halfSize.y + fabs(axes[2].y) * halfSize.z;
+	boxExtent.z = fabs(axes[0].z) * halfSize.x + fabs(axes[1].z) * halfSize.y + fabs(axes[2].z) * halfSize.z;
+
+	// box vertices
+	XMVECTOR boxVertices[8];
+	for (int i = 0; i < 8; i++)
+		boxVertices[i] = centerV + axesV[0] * ((i & 1) ? extents[0] : -extents[0]) + axesV[1] * ((i & 2) ? extents[1] : -extents[1]) + axesV[2] * ((i & 4) ? extents[2] : -extents[2]);
+
+	size_t firstContact = contacts.Size();
+
+	QueryAABB(XMFLOAT3(center.x - boxExtent.x, center.y - boxExtent.y, center.z - boxExtent.z), XMFLOAT3(center.x + boxExtent.x, center.y + boxExtent.y, center.z + boxExtent.z), [&](unsigned int, const XMFLOAT3 *vertices)
+	{
+		XMVECTOR triangle[3] = { XMLoadFloat3(&vertices[0]) - centerV, XMLoadFloat3(&vertices[1]) - centerV, XMLoadFloat3(&vertices[2]) - centerV };   // relative to box center
+		XMVECTOR edges[3] = { triangle[1] - triangle[0], triangle[2] - triangle[1], triangle[0] - triangle[2] };
+		XMVECTOR normalV = XMVector3Cross(edges[0], edges[1]);
+
+		if (XMVectorGetX(XMVector3LengthSq(normalV)) < 1e-12f)
+			return;   // degenerate triangle
+
+		normalV = XMVector3Normalize(normalV);
+
+		// separating axis test: triangle normal, box axes, edge cross products
+		auto separated = [&](FXMVECTOR axis) -> bool
+		{
+			if (XMVectorGetX(XMVector3LengthSq(axis)) < 1e-12f)
+				return false;
+
+			float p0 = XMVectorGetX(XMVector3Dot(triangle[0], axis));
+			float p1 = XMVectorGetX(XMVector3Dot(triangle[1], axis));
+			float p2 = XMVectorGetX(XMVector3Dot(triangle[2], axis));
+
+			float r = extents[0] * fabs(XMVectorGetX(XMVector3Dot(axesV[0], axis))) + extents[1] * fabs(XMVectorGetX(XMVector3Dot(axesV[1], axis))) + extents[2] * fabs(XMVectorGetX(XMVector3Dot(axesV[2], axis)));
+
+			return std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r;
+		};
+
+		if (separated(normalV))
+			return;
+
+		for (int i = 0; i < 3; i++)
+			if (separated(axesV[i]))
+				return;
+
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				if (separated(XMVector3Cross(axesV[i], edges[j])))
+					return;
+
+		// face normal directed towards the box
+		float planeDistance = XMVectorGetX(XMVector3Dot(normalV, triangle[0]));   // signed distance of the box center from the triangle plane, negated
+		if (planeDistance > 0.0f)
+		{
+			normalV = -normalV;
+			planeDistance = -planeDistance;
+		}
+
+		bool foundContact = false;
+
+		// box vertices below the triangle plane that project inside the triangle
+		for (int i = 0; i < 8; i++)
+		{
+			XMVECTOR vertex = boxVertices[i] - centerV;
+			float distance = XMVectorGetX(XMVector3Dot(normalV, vertex)) - planeDistance;
+
+			if (distance >= 0.0f)
+				continue;
+
+			XMVECTOR projected = vertex - normalV * distance;
+
+			bool inside = true;
+			for (int j = 0; j < 3 && inside; j++)
+				inside = XMVectorGetX(XMVector3Dot(XMVector3Cross(edges[j], projected - triangle[j]), normalV)) * XMVectorGetX(XMVector3Dot(XMVector3Cross(edges[0], edges[1]), normalV)) >= 0.0f;
+
+			if (!inside)
+				continue;
+
+			Contact contact;
+			XMStoreFloat3(&contact.point, boxVertices[i]);
+			XMStoreFloat3(&contact.normal, normalV);
+			contact.penetration = -distance;
+			contacts.InsertLast(contact);
+
+			foundContact = true;
+		}
+
+		if (foundContact)
+			return;
+
+		// triangle vertices inside the box (triangle corner poking into a box face)
+		for (int i = 0; i < 3; i++)
+		{
+			float minPenetration = FLT_MAX;
+			int minAxis = -1;
+			float side = 1.0f;
+
+			for (int j = 0; j < 3; j++)
+			{
+				float projection = XMVectorGetX(XMVector3Dot(triangle[i], axesV[j]));
+				float penetration = extents[j] - fabs(projection);
+
+				if (penetration < 0.0f)
+				{
+					minAxis = -1;
+					break;
+				}
+
+				if (penetration < minPenetration)
+				{
+					minPenetration = penetration;
+					minAxis = j;
+					side = projection > 0.0f ? 1.0f : -1.0f;
+				}
+			}
+
+			if (minAxis == -1)
+				continue;
+
+			Contact contact;
+			XMStoreFloat3(&contact.point, triangle[i] + centerV);
+			XMStoreFloat3(&contact.normal, -axesV[minAxis] * side);
+			contact.penetration = minPenetration;
+
+			AddContact(contacts, firstContact, contact);
+		}
+	});
+}
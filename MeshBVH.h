@@ -0,0 +1,167 @@
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include "data structures/Vector.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+using namespace DirectX;
+
+/**** bounding volume hierarchy over a static triangle mesh ****/
+/**** built with the binned surface area heuristic, each 32 byte node stores the 16 bit quantised bounds of its two children ****/
+/**** all queries are in mesh local space ****/
+
+class MeshBVH
+{
+public:
+	struct Node
+	{
+		uint16_t childMin[2][3];    // children bounds quantised to the mesh bounds
+		uint16_t childMax[2][3];
+		uint32_t child[2];          // inner node index or leaf (LEAF_FLAG | count - 1 << LEAF_COUNT_SHIFT | first triangle)
+	};
+	struct RayHit
+	{
+		float distance;
+		XMFLOAT3 point;
+		XMFLOAT3 normal;
+		unsigned int triangle;
+	};
+	struct Contact
+	{
+		XMFLOAT3 point;
+		XMFLOAT3 normal;    // directed from the mesh to the query shape
+		float penetration;
+	};
+public:
+	MeshBVH() = default;
+
+	void Build(const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices, const XMFLOAT3 &scale = XMFLOAT3(1.0f, 1.0f, 1.0f), bool parallel = true);
+
+	bool Save(const std::string &filePath) const;
+	bool Load(const std::string &filePath, uint64_t sourceHash);
+
+	static uint64_t HashSource(const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices, const XMFLOAT3 &scale);
+	uint64_t GetSourceHash() const { return mSourceHash; }
+
+	bool IsEmpty() const { return mTriangles.empty(); }
+	unsigned int GetTriangleCount() const { return (unsigned int)mTriangles.size() / 3; }
+	unsigned int GetNodeCount() const { return (unsigned int)mNodes.size(); }
+	const XMFLOAT3 &GetBoundsMin() const { return mBoundsMin; }
+	const XMFLOAT3 &GetBoundsMax() const { return mBoundsMax; }
+
+	bool RayCast(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float maxDistance, RayHit &hit) const;
+	bool SweepSphere(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float radius, float maxDistance, RayHit &hit) const;
+	bool OverlapSphere(const XMFLOAT3 &center, float radius) const;
+	void SphereContacts(const XMFLOAT3 &center, float radius, Vector<Contact> &contacts) const;
+	void BoxContacts(const XMFLOAT3 &center, const XMFLOAT3 (&axes)[3], const XMFLOAT3 &halfSize, Vector<Contact> &contacts) const;
+
+	// closest point on triangle abc to point p
+	static XMVECTOR ClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c);
+
+	// double sided ray/triangle test, distance is along the (not necessarily normalised) direction
+	static bool IntersectRayTriangle(FXMVECTOR origin, FXMVECTOR direction, FXMVECTOR a, GXMVECTOR b, HXMVECTOR c, float &distance);
+
+	// first contact of a sphere moving along the unit direction with triangle abc, normal is directed from the triangle to the sphere
+	static bool IntersectSphereTriangle(FXMVECTOR origin, FXMVECTOR direction, float radius, GXMVECTOR a, HXMVECTOR b, HXMVECTOR c, float &distance, XMVECTOR &normal);
+
+	// visit the triangles whose leaves overlap the box: visitor(triangleIndex, const XMFLOAT3 *vertices)
+	template <typename Visitor>
+	void QueryAABB(const XMFLOAT3 &min, const XMFLOAT3 &max, Visitor &&visitor) const;
+private:
+	static const uint32_t LEAF_FLAG = 0x80000000u;
+	static const uint32_t LEAF_COUNT_SHIFT = 27;
+	static const uint32_t LEAF_FIRST_MASK = (1u << LEAF_COUNT_SHIFT) - 1;
+	static const unsigned int MAX_LEAF_TRIANGLES = 16;    // leaf count is stored in 4 bits
+	static const unsigned int NUM_BINS = 16;
+	static const unsigned int MAX_DEPTH = 63;             // deepest reference the 64 entry traversal stacks can hold
+
+	struct BuildTriangle
+	{
+		XMFLOAT3 min;
+		XMFLOAT3 max;
+		XMFLOAT3 centroid;
+		unsigned int index;
+	};
+	struct BuildNode
+	{
+		XMFLOAT3 min;
+		XMFLOAT3 max;
+		unsigned int first;
+		unsigned int count;
+		int children[2];
+		int subtree;          // >= 0 if the node is the placeholder of a subtree built by a worker thread
+		unsigned int depth;
+	};
+
+	void BuildRange(std::vector<BuildTriangle> &triangles, std::vector<BuildNode> &nodes, int rootIndex, std::vector<int> *pendingSubtrees, unsigned int subtreeSize);
+	bool SplitNode(std::vector<BuildTriangle> &triangles, BuildNode &node, unsigned int &splitIndex);
+	uint32_t Flatten(const std::vector<std::vector<BuildNode>> &trees, int treeIndex, int nodeIndex);
+
+	static bool ValidateTree(const std::vector<Node> &nodes, uint32_t root, unsigned int numTriangles);
+
+	void QuantiseBounds(const XMFLOAT3 &min, const XMFLOAT3 &max, uint16_t (&qMin)[3], uint16_t (&qMax)[3]) const;
+	void DequantiseBounds(const uint16_t (&qMin)[3], const uint16_t (&qMax)[3], XMFLOAT3 &min, XMFLOAT3 &max) const;
+
+	static bool IsLeaf(uint32_t reference) { return (reference & LEAF_FLAG) != 0; }
+	static unsigned int LeafFirst(uint32_t reference) { return reference & LEAF_FIRST_MASK; }
+	static unsigned int LeafCount(uint32_t reference) { return ((reference & ~LEAF_FLAG) >> LEAF_COUNT_SHIFT) + 1; }
+
+	std::vector<Node> mNodes;
+	std::vector<XMFLOAT3> mTriangles;   // 3 vertices per triangle, in leaf order
+	uint32_t mRoot = 0;
+
+	XMFLOAT3 mBoundsMin = XMFLOAT3();
+	XMFLOAT3 mBoundsMax = XMFLOAT3();
+	XMFLOAT3 mQuantiseScale = XMFLOAT3();
+	XMFLOAT3 mDequantiseScale = XMFLOAT3();
+
+	uint64_t mSourceHash = 0;
+};
+
+template <typename Visitor>
+void MeshBVH::QueryAABB(const XMFLOAT3 &min, const XMFLOAT3 &max, Visitor &&visitor) const
+{
+	if (mTriangles.empty())
+		return;
+
+	if (min.x > mBoundsMax.x || max.x < mBoundsMin.x || min.y > mBoundsMax.y || max.y < mBoundsMin.y || min.z > mBoundsMax.z || max.z < mBoundsMin.z)
+		return;
+
+	uint32_t stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = mRoot;
+
+	while (stackSize)
+	{
+		uint32_t reference = stack[--stackSize];
+
+		if (IsLeaf(reference))
+		{
+			unsigned int first = LeafFirst(reference);
+			unsigned int count = LeafCount(reference);
+
+			for (unsigned int i = first; i < first + count; i++)
+				visitor(i, &mTriangles[i * 3]);
+
+			continue;
+		}
+
+		const Node &node = mNodes[reference];
+
+		for (int i = 0; i < 2; i++)
+		{
+			XMFLOAT3 childMin, childMax;
+			DequantiseBounds(node.childMin[i], node.childMax[i], childMin, childMax);
+
+			if (min.x > childMax.x || max.x < childMin.x || min.y > childMax.y || max.y < childMin.y || min.z > childMax.z || max.z < childMin.z)
+				continue;
+
+			stack[stackSize++] = node.child[i];
+		}
+	}
+}
+
+#endif  // MESH_BVH_H
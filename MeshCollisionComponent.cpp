@@ -0,0 +1,16 @@
+#include "MeshCollisionComponent.h"
+#include "StaticMeshComponent.h"
+
+MeshCollisionComponent::MeshCollisionComponent(const StaticMeshComponent &mesh, const XMFLOAT3 &scale, const std::string &cacheFilePath, const XMFLOAT3 &relativePosition) : CollisionComponent(Type::MESH, relativePosition)
+{
+	const std::vector<XMFLOAT3> &vertices = mesh.GetVertices();
+	const std::vector<unsigned int> &indices = mesh.GetIndices();
+
+	if (!cacheFilePath.empty() && mBVH.Load(cacheFilePath, MeshBVH::HashSource(vertices, indices, scale)))
+		return;
+
+	mBVH.Build(vertices, indices, scale);
+
+	if (!cacheFilePath.empty())
+		mBVH.Save(cacheFilePath);
+}
@@ -0,0 +1,23 @@
+#ifndef MESH_COLLISION_COMPONENT_H
+#define MESH_COLLISION_COMPONENT_H
+
+#include "CollisionComponent.h"
+#include "MeshBVH.h"
+#include <string>
+
+class StaticMeshComponent;
+
+/**** static triangle mesh collider - the entity scale is baked into the BVH at build time ****/
+
+class MeshCollisionComponent : public CollisionComponent
+{
+public:
+	// if cacheFilePath is not empty the BVH is loaded from it when it was built from the same mesh, otherwise it is built and saved there
+	MeshCollisionComponent(const StaticMeshComponent &mesh, const XMFLOAT3 &scale = XMFLOAT3(1.0f, 1.0f, 1.0f), const std::string &cacheFilePath = "", const XMFLOAT3 &relativePosition = XMFLOAT3());
+
+	const MeshBVH &GetBVH() const { return mBVH; }
+private:
+	MeshBVH mBVH;
+};
+
+#endif  // MESH_COLLISION_COMPONENT_H
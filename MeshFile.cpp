@@ -0,0 +1,392 @@
+#include "MeshFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+namespace
+{
+	const char FILE_MAGIC[4] = { 'M', 'E', 'S', 'H' };
+	const uint32_t FILE_VERSION = 1;
+	const uint64_t BLOB_ALIGNMENT = 16;
+
+	struct FileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceTime;
+		uint64_t layoutHash;
+		uint32_t numMeshes;
+		uint32_t numTextures;
+		uint32_t numModelPositions;
+		uint32_t numModelIndices;
+		uint64_t modelPositionsOffset;
+		uint64_t modelIndicesOffset;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	struct MeshEntry
+	{
+		uint32_t numVertices;
+		uint32_t numIndices;
+		uint32_t numLODs;
+		uint32_t firstTexture;
+		uint32_t numTextures[MeshFile::NUM_TEXTURE_TYPES];
+		Mesh::LOD lods[Mesh::MAX_LODS];
+		float boundsMin[3];
+		float boundsMax[3];
+		float quantizationOffset[3];
+		float quantizationScale[3];
+		uint64_t streamOffsets[VertexLayout::MAX_STREAMS];
+		uint64_t indexOffset;
+	};
+
+	struct TextureName
+	{
+		char name[MeshFile::MAX_TEXTURE_NAME];
+	};
+
+	uint64_t Align(uint64_t offset)
+	{
+		return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+	}
+
+	// pads with zeroes up to the offset of the blob and writes it
+	bool WriteBlob(FILE *fileStream, uint64_t &position, uint64_t offset, const void *data, uint64_t size)
+	{
+		static const uint8_t padding[BLOB_ALIGNMENT] = {};
+
+		if (offset > position && fwrite(padding, 1, (size_t)(offset - position), fileStream) != offset - position)
+			return false;
+
+		position = offset + size;
+
+		return size == 0 || fwrite(data, 1, (size_t)size, fileStream) == size;
+	}
+
+	const FileHeader &GetHeader(const VirtualFileSystem::File &file)
+	{
+		return *reinterpret_cast<const FileHeader*>(file.GetData());
+	}
+
+	const MeshEntry &GetEntry(const VirtualFileSystem::File &file, unsigned int mesh)
+	{
+		return reinterpret_cast<const MeshEntry*>(file.GetData() + sizeof(FileHeader))[mesh];
+	}
+}
+
+const unsigned int MeshFile::NUM_TEXTURE_TYPES;
+const unsigned int MeshFile::MAX_TEXTURE_NAME;
+
+bool MeshFile::Save(const std::string &filePath, const VertexLayout &layout, uint64_t sourceTime, const std::vector<CookedMesh> &meshes, const std::vector<XMFLOAT3> &modelPositions, const std::vector<unsigned int> &modelIndices)
+{
+	FileHeader header;
+	std::copy(FILE_MAGIC, FILE_MAGIC + 4, header.magic);
+	header.version = FILE_VERSION;
+	header.sourceTime = sourceTime;
+	header.layoutHash = HashLayout(layout);
+	header.numMeshes = (uint32_t)meshes.size();
+	header.numTextures = 0;
+	header.numModelPositions = (uint32_t)modelPositions.size();
+	header.numModelIndices = (uint32_t)modelIndices.size();
+
+	// texture names are the only variable size records before the blobs
+	std::vector<TextureName> textureNames;
+	std::vector<MeshEntry> entries(meshes.size());
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		const CookedMesh &mesh = meshes[i];
+		MeshEntry &entry = entries[i];
+
+		memset(&entry, 0, sizeof(MeshEntry));
+		entry.numVertices = mesh.numVertices;
+		entry.numIndices = (uint32_t)mesh.indices.size();
+		entry.numLODs = (uint32_t)std::min<size_t>(mesh.lods.size(), Mesh::MAX_LODS);
+		std::copy(mesh.lods.begin(), mesh.lods.begin() + entry.numLODs, entry.lods);
+		entry.boundsMin[0] = mesh.boundsMin.x; entry.boundsMin[1] = mesh.boundsMin.y; entry.boundsMin[2] = mesh.boundsMin.z;
+		entry.boundsMax[0] = mesh.boundsMax.x; entry.boundsMax[1] = mesh.boundsMax.y; entry.boundsMax[2] = mesh.boundsMax.z;
+		entry.quantizationOffset[0] = mesh.quantization.offset.x; entry.quantizationOffset[1] = mesh.quantization.offset.y; entry.quantizationOffset[2] = mesh.quantization.offset.z;
+		entry.quantizationScale[0] = mesh.quantization.scale.x; entry.quantizationScale[1] = mesh.quantization.scale.y; entry.quantizationScale[2] = mesh.quantization.scale.z;
+
+		entry.firstTexture = (uint32_t)textureNames.size();
+		for (unsigned int type = 0; type < NUM_TEXTURE_TYPES; type++)
+		{
+			for (const std::string &texture : mesh.textures[type])
+			{
+				if (texture.size() >= MAX_TEXTURE_NAME)
+					return false;
+
+				TextureName textureName = {};
+				std::copy(texture.begin(), texture.end(), textureName.name);
+				textureNames.push_back(textureName);
+			}
+
+			entry.numTextures[type] = (uint32_t)mesh.textures[type].size();
+		}
+
+		if (mesh.streams.size() != layout.GetNumStreams() || mesh.lods.size() > Mesh::MAX_LODS)
+			return false;
+	}
+
+	header.numTextures = (uint32_t)textureNames.size();
+
+	// blob offsets
+	uint64_t offset = sizeof(FileHeader) + entries.size() * sizeof(MeshEntry) + textureNames.size() * sizeof(TextureName);
+
+	header.modelPositionsOffset = Align(offset);
+	offset = header.modelPositionsOffset + modelPositions.size() * sizeof(XMFLOAT3);
+	header.modelIndicesOffset = Align(offset);
+	offset = header.modelIndicesOffset + modelIndices.size() * sizeof(unsigned int);
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		for (unsigned int stream = 0; stream < layout.GetNumStreams(); stream++)
+		{
+			entries[i].streamOffsets[stream] = Align(offset);
+			offset = entries[i].streamOffsets[stream] + meshes[i].streams[stream].size();
+		}
+
+		entries[i].indexOffset = Align(offset);
+		offset = entries[i].indexOffset + meshes[i].indices.size() * sizeof(unsigned int);
+	}
+
+	// model bounds
+	XMFLOAT3 boundsMin(0.0f, 0.0f, 0.0f), boundsMax(0.0f, 0.0f, 0.0f);
+
+	if (!modelPositions.empty())
+	{
+		boundsMin = boundsMax = modelPositions[0];
+
+		for (const XMFLOAT3 &position : modelPositions)
+		{
+			boundsMin.x = std::min(boundsMin.x, position.x); boundsMin.y = std::min(boundsMin.y, position.y); boundsMin.z = std::min(boundsMin.z, position.z);
+			boundsMax.x = std::max(boundsMax.x, position.x); boundsMax.y = std::max(boundsMax.y, position.y); boundsMax.z = std::max(boundsMax.z, position.z);
+		}
+	}
+
+	header.boundsMin[0] = boundsMin.x; header.boundsMin[1] = boundsMin.y; header.boundsMin[2] = boundsMin.z;
+	header.boundsMax[0] = boundsMax.x; header.boundsMax[1] = boundsMax.y; header.boundsMax[2] = boundsMax.z;
+
+	FILE *fileStream = nullptr;
+	if (fopen_s(&fileStream, filePath.c_str(), "wb"))
+		return false;
+
+	uint64_t position = 0;
+
+	bool written = WriteBlob(fileStream, position, 0, &header, sizeof(FileHeader));
+
+	if (written && !entries.empty())
+		written = WriteBlob(fileStream, position, position, &entries[0], entries.size() * sizeof(MeshEntry));
+	if (written && !textureNames.empty())
+		written = WriteBlob(fileStream, position, position, &textureNames[0], textureNames.size() * sizeof(TextureName));
+	if (written)
+		written = WriteBlob(fileStream, position, header.modelPositionsOffset, modelPositions.empty() ? nullptr : &modelPositions[0], modelPositions.size() * sizeof(XMFLOAT3));
+	if (written)
+		written = WriteBlob(fileStream, position, header.modelIndicesOffset, modelIndices.empty() ? nullptr : &modelIndices[0], modelIndices.size() * sizeof(unsigned int));
+
+	for (unsigned int i = 0; written && i < meshes.size(); i++)
+	{
+		for (unsigned int stream = 0; written && stream < layout.GetNumStreams(); stream++)
+			written = WriteBlob(fileStream, position, entries[i].streamOffsets[stream], meshes[i].streams[stream].empty() ? nullptr : &meshes[i].streams[stream][0], meshes[i].streams[stream].size());
+
+		if (written)
+			written = WriteBlob(fileStream, position, entries[i].indexOffset, meshes[i].indices.empty() ? nullptr : &meshes[i].indices[0], meshes[i].indices.size() * sizeof(unsigned int));
+	}
+
+	fclose(fileStream);
+
+	// a partial file would be rejected by its size checks, but don't leave it around
+	if (!written)
+		remove(filePath.c_str());
+
+	return written;
+}
+
+bool MeshFile::Open(const std::string &filePath, const VertexLayout &layout, uint64_t sourceTime)
+{
+	Close();
+
+	if (!VirtualFileSystem::GetInstance().Open(filePath, mFile))
+		return false;
+
+	uint64_t size = mFile.GetSize();
+
+	// every record and blob must lie inside the file
+	auto InFile = [size](uint64_t offset, uint64_t blobSize) { return offset <= size && blobSize <= size - offset; };
+
+	bool valid = size >= sizeof(FileHeader);
+
+	if (valid)
+	{
+		const FileHeader &header = GetHeader(mFile);
+
+		valid = std::equal(FILE_MAGIC, FILE_MAGIC + 4, header.magic) && header.version == FILE_VERSION && (sourceTime == 0 || header.sourceTime == sourceTime) && header.layoutHash == HashLayout(layout);
+		valid = valid && InFile(sizeof(FileHeader), (uint64_t)header.numMeshes * sizeof(MeshEntry) + (uint64_t)header.numTextures * sizeof(TextureName));
+		valid = valid && InFile(header.modelPositionsOffset, (uint64_t)header.numModelPositions * sizeof(XMFLOAT3)) && InFile(header.modelIndicesOffset, (uint64_t)header.numModelIndices * sizeof(unsigned int));
+
+		for (unsigned int i = 0; valid && i < header.numMeshes; i++)
+		{
+			const MeshEntry &entry = GetEntry(mFile, i);
+
+			valid = entry.numLODs <= Mesh::MAX_LODS && InFile(entry.indexOffset, (uint64_t)entry.numIndices * sizeof(unsigned int));
+			valid = valid && (uint64_t)entry.firstTexture + entry.numTextures[0] + entry.numTextures[1] + entry.numTextures[2] <= header.numTextures;
+
+			for (unsigned int stream = 0; valid && stream < layout.GetNumStreams(); stream++)
+				valid = InFile(entry.streamOffsets[stream], (uint64_t)entry.numVertices * layout.GetStride(stream)) && entry.streamOffsets[stream] % BLOB_ALIGNMENT == 0;
+
+			// detail levels are ranges of the index buffer, indices address the mesh vertices
+			for (unsigned int lod = 0; valid && lod < entry.numLODs; lod++)
+				valid = (uint64_t)entry.lods[lod].firstIndex + entry.lods[lod].indexCount <= entry.numIndices;
+
+			const uint32_t *indices = reinterpret_cast<const uint32_t*>(mFile.GetData() + entry.indexOffset);
+
+			for (unsigned int index = 0; valid && index < entry.numIndices; index++)
+				valid = indices[index] < entry.numVertices;
+		}
+
+		// the model positions are indexed for collision
+		const uint32_t *modelIndices = reinterpret_cast<const uint32_t*>(mFile.GetData() + header.modelIndicesOffset);
+
+		for (unsigned int index = 0; valid && index < header.numModelIndices; index++)
+			valid = modelIndices[index] < header.numModelPositions;
+	}
+
+	if (!valid)
+	{
+		mFile.Close();
+		return false;
+	}
+
+	mLayout = &layout;
+
+	return true;
+}
+
+void MeshFile::Close()
+{
+	mFile.Close();
+	mLayout = nullptr;
+}
+
+unsigned int MeshFile::GetNumMeshes() const
+{
+	return GetHeader(mFile).numMeshes;
+}
+
+void MeshFile::LoadMesh(unsigned int mesh, Mesh &target) const
+{
+	const MeshEntry &entry = GetEntry(mFile, mesh);
+
+	const void *streams[VertexLayout::MAX_STREAMS];
+	for (unsigned int stream = 0; stream < mLayout->GetNumStreams(); stream++)
+		streams[stream] = mFile.GetData() + entry.streamOffsets[stream];
+
+	VertexLayout::Quantization quantization =
+	{
+		XMFLOAT3(entry.quantizationOffset[0], entry.quantizationOffset[1], entry.quantizationOffset[2]),
+		XMFLOAT3(entry.quantizationScale[0], entry.quantizationScale[1], entry.quantizationScale[2]),
+	};
+
+	target.LoadPackedVertices(*mLayout, streams, entry.numVertices, quantization);
+	target.LoadIndexBuffer(reinterpret_cast<const unsigned int*>(mFile.GetData() + entry.indexOffset), entry.numIndices);
+	target.SetLODs(std::vector<Mesh::LOD>(entry.lods, entry.lods + entry.numLODs));
+}
+
+void MeshFile::GetMeshBounds(unsigned int mesh, XMFLOAT3 &boundsMin, XMFLOAT3 &boundsMax) const
+{
+	const MeshEntry &entry = GetEntry(mFile, mesh);
+
+	boundsMin = XMFLOAT3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+	boundsMax = XMFLOAT3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+}
+
+unsigned int MeshFile::GetNumTextures(unsigned int mesh, TextureType type) const
+{
+	return GetEntry(mFile, mesh).numTextures[(unsigned int)type];
+}
+
+const char *MeshFile::GetTexture(unsigned int mesh, TextureType type, unsigned int texture) const
+{
+	const MeshEntry &entry = GetEntry(mFile, mesh);
+
+	// names follow the mesh entries, grouped by mesh and then by type
+	unsigned int index = entry.firstTexture + texture;
+	for (unsigned int i = 0; i < (unsigned int)type; i++)
+		index += entry.numTextures[i];
+
+	const TextureName *textureNames = reinterpret_cast<const TextureName*>(mFile.GetData() + sizeof(FileHeader) + GetHeader(mFile).numMeshes * sizeof(MeshEntry));
+
+	// names are written null terminated, a corrupted one is cut at the record size
+	return std::find(textureNames[index].name, textureNames[index].name + MAX_TEXTURE_NAME, '\0') == textureNames[index].name + MAX_TEXTURE_NAME ? "" : textureNames[index].name;
+}
+
+unsigned int MeshFile::GetNumModelPositions() const
+{
+	return GetHeader(mFile).numModelPositions;
+}
+
+const XMFLOAT3 *MeshFile::GetModelPositions() const
+{
+	return reinterpret_cast<const XMFLOAT3*>(mFile.GetData() + GetHeader(mFile).modelPositionsOffset);
+}
+
+unsigned int MeshFile::GetNumModelIndices() const
+{
+	return GetHeader(mFile).numModelIndices;
+}
+
+const unsigned int *MeshFile::GetModelIndices() const
+{
+	return reinterpret_cast<const unsigned int*>(mFile.GetData() + GetHeader(mFile).modelIndicesOffset);
+}
+
+void MeshFile::GetModelBounds(XMFLOAT3 &boundsMin, XMFLOAT3 &boundsMax) const
+{
+	const FileHeader &header = GetHeader(mFile);
+
+	boundsMin = XMFLOAT3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	boundsMax = XMFLOAT3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+}
+
+std::string MeshFile::GetCookedPath(const std::string &sourcePath)
+{
+	size_t extension = sourcePath.find_last_of('.');
+	size_t directory = sourcePath.find_last_of("/\\");
+
+	if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+		return sourcePath + ".mesh";
+
+	return sourcePath.substr(0, extension) + ".mesh";
+}
+
+bool MeshFile::Restamp(const std::string &filePath, uint64_t sourceTime)
+{
+	FILE *fileStream;
+
+	if (fopen_s(&fileStream, filePath.c_str(), "r+b"))
+		return false;
+
+	bool written = fseek(fileStream, offsetof(FileHeader, sourceTime), SEEK_SET) == 0 && fwrite(&sourceTime, sizeof(sourceTime), 1, fileStream) == 1;
+
+	return fclose(fileStream) == 0 && written;
+}
+
+// FNV-1a of the elements of the layout
+uint64_t MeshFile::HashLayout(const VertexLayout &layout)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (unsigned int i = 0; i < layout.GetNumElements(); i++)
+	{
+		const VertexLayout::Element &element = layout.GetElement(i);
+		uint32_t values[4] = { (uint32_t)element.attribute, (uint32_t)element.encoding, element.stream, element.offset };
+
+		const uint8_t *bytes = reinterpret_cast<const uint8_t*>(values);
+		for (size_t b = 0; b < sizeof(values); b++)
+			hash = (hash ^ bytes[b]) * 1099511628211ull;
+	}
+
+	return hash;
+}
@@ -0,0 +1,73 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include "Mesh.h"
+#include "VirtualFileSystem.h"
+#include "VertexLayout.h"
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace DirectX;
+
+/**** cooked static model (.mesh): header, per mesh entries (bounds, lod table, quantisation, blob offsets), texture names, then the ****/
+/**** packed vertex streams and index buffers as 16 byte aligned blobs in the static mesh layout. the file is memory mapped (or ****/
+/**** read from a pack) and the blobs are handed to the render device as they are, nothing is parsed or converted ****/
+
+class MeshFile
+{
+public:
+	enum class TextureType { DIFFUSE, SPECULAR, NORMAL, };
+
+	static const unsigned int NUM_TEXTURE_TYPES = 3;
+	static const unsigned int MAX_TEXTURE_NAME = 260;
+
+	struct CookedMesh        // a mesh as it's uploaded: vertices packed in the layout, indices of every detail level
+	{
+		std::vector<std::vector<uint8_t>> streams;
+		unsigned int numVertices;
+		std::vector<unsigned int> indices;
+		std::vector<Mesh::LOD> lods;
+		VertexLayout::Quantization quantization;
+		XMFLOAT3 boundsMin;
+		XMFLOAT3 boundsMax;
+		std::vector<std::string> textures[NUM_TEXTURE_TYPES];     // relative to the model directory
+	};
+public:
+	MeshFile() = default;
+
+	// the source time is the modification time of the imported model, layout changes are detected too
+	static bool Save(const std::string &filePath, const VertexLayout &layout, uint64_t sourceTime, const std::vector<CookedMesh> &meshes, const std::vector<XMFLOAT3> &modelPositions, const std::vector<unsigned int> &modelIndices);
+
+	// fails if the file is missing, corrupted, out of date or cooked with another layout; a source time of 0 (no source) accepts any file
+	bool Open(const std::string &filePath, const VertexLayout &layout, uint64_t sourceTime);
+	void Close();
+	bool IsOpen() const { return mLayout != nullptr; }
+	void Prefetch() const { mFile.Prefetch(); }
+
+	unsigned int GetNumMeshes() const;
+	void LoadMesh(unsigned int mesh, Mesh &target) const;      // gpu buffers are created from the mapped blobs
+	void GetMeshBounds(unsigned int mesh, XMFLOAT3 &boundsMin, XMFLOAT3 &boundsMax) const;
+	unsigned int GetNumTextures(unsigned int mesh, TextureType type) const;
+	const char *GetTexture(unsigned int mesh, TextureType type, unsigned int texture) const;
+
+	// positions and indices of all the meshes, for collision
+	unsigned int GetNumModelPositions() const;
+	const XMFLOAT3 *GetModelPositions() const;
+	unsigned int GetNumModelIndices() const;
+	const unsigned int *GetModelIndices() const;
+	void GetModelBounds(XMFLOAT3 &boundsMin, XMFLOAT3 &boundsMax) const;
+
+	static std::string GetCookedPath(const std::string &sourcePath);     // the source path with a .mesh extension
+	static uint64_t HashLayout(const VertexLayout &layout);
+
+	// rewrites the source time of a closed file whose source was touched but not changed
+	static bool Restamp(const std::string &filePath, uint64_t sourceTime);
+private:
+
+	VirtualFileSystem::File mFile;
+	const VertexLayout *mLayout = nullptr;
+};
+
+#endif  // MESH_FILE_H
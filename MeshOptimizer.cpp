@@ -0,0 +1,349 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+const unsigned int MeshOptimizer::CACHE_SIZE;
+const unsigned int MeshOptimizer::INVALID_VERTEX;
+
+// acmr increase allowed to the overdraw ordering
+static const float OVERDRAW_THRESHOLD = 1.05f;
+
+MeshOptimizer::Statistics MeshOptimizer::Optimize(std::vector<unsigned int> &indices, const std::vector<XMFLOAT3> &positions, std::vector<unsigned int> &remap)
+{
+	unsigned int vertexCount = (unsigned int)positions.size();
+
+	Statistics statistics;
+	statistics.numTriangles = (unsigned int)indices.size() / 3;
+	statistics.acmrBefore = ComputeACMR(indices, vertexCount);
+
+	// exported meshes are often ordered already, keep whichever order is better
+	std::vector<unsigned int> optimized = indices;
+	std::vector<unsigned int> clusters;
+	OptimizeVertexCache(optimized, vertexCount, &clusters);
+
+	float cacheACMR = ComputeACMR(optimized, vertexCount);
+
+	if (cacheACMR < statistics.acmrBefore)
+		indices.swap(optimized);
+	else
+		clusters.assign(1, 0);
+
+	// cluster order costs cache misses at the cluster boundaries: try the split clusters, then the hard clusters only, within the threshold
+	float maxACMR = OVERDRAW_THRESHOLD * std::min(cacheACMR, statistics.acmrBefore);
+
+	for (float threshold : { OVERDRAW_THRESHOLD, 1.0f })
+	{
+		std::vector<unsigned int> sorted = indices;
+		OptimizeOverdraw(sorted, positions, clusters, threshold);
+
+		if (ComputeACMR(sorted, vertexCount) <= maxACMR)
+		{
+			indices.swap(sorted);
+			break;
+		}
+	}
+
+	OptimizeVertexFetch(indices, vertexCount, remap);
+
+	statistics.acmrAfter = ComputeACMR(indices, vertexCount);
+
+	return statistics;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount, std::vector<unsigned int> *clusters)
+{
+	unsigned int numTriangles = (unsigned int)indices.size() / 3;
+
+	if (clusters)
+		clusters->clear();
+
+	if (numTriangles == 0)
+		return;
+
+	vertexCount = std::max(vertexCount, GetMaxVertex(indices) + 1);
+
+	// triangles using each vertex
+	std::vector<unsigned int> liveTriangles(vertexCount, 0);
+	for (unsigned int index : indices)
+		liveTriangles[index]++;
+
+	std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0);
+	for (unsigned int v = 0; v < vertexCount; v++)
+		triangleOffsets[v + 1] = triangleOffsets[v] + liveTriangles[v];
+
+	std::vector<unsigned int> adjacentTriangles(indices.size());
+	std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+	for (unsigned int i = 0; i < (unsigned int)indices.size(); i++)
+		adjacentTriangles[fill[indices[i]]++] = i / 3;
+
+	std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+	std::vector<bool> emitted(numTriangles, false);
+	std::vector<unsigned int> deadEnd;                 // recently used vertices, to continue from when a fan runs out of live neighbours
+	std::vector<unsigned int> candidates;
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+
+	unsigned int timestamp = CACHE_SIZE + 1;
+	unsigned int inputCursor = 0;                      // next vertex in input order, when the dead end stack is empty too
+	unsigned int fanningVertex = indices[0];
+
+	while (fanningVertex != INVALID_VERTEX)
+	{
+		candidates.clear();
+
+		// emit the remaining triangles around the fanning vertex
+		for (unsigned int i = triangleOffsets[fanningVertex]; i < triangleOffsets[fanningVertex + 1]; i++)
+		{
+			unsigned int triangle = adjacentTriangles[i];
+
+			if (emitted[triangle])
+				continue;
+
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				unsigned int vertex = indices[triangle * 3 + k];
+
+				result.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+
+				liveTriangles[vertex]--;
+
+				if (timestamp - cacheTimestamps[vertex] > CACHE_SIZE)
+					cacheTimestamps[vertex] = timestamp++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		// the next fan: the oldest candidate that is still cached after its own triangles are emitted
+		unsigned int nextVertex = INVALID_VERTEX;
+		int bestPriority = -1;
+
+		for (unsigned int vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			int priority = 0;
+			if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= CACHE_SIZE)
+				priority = timestamp - cacheTimestamps[vertex];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = vertex;
+			}
+		}
+
+		if (nextVertex == INVALID_VERTEX)
+		{
+			while (!deadEnd.empty() && nextVertex == INVALID_VERTEX)
+			{
+				unsigned int vertex = deadEnd.back();
+				deadEnd.pop_back();
+
+				if (liveTriangles[vertex] > 0)
+					nextVertex = vertex;
+			}
+
+			while (inputCursor < vertexCount && nextVertex == INVALID_VERTEX)
+			{
+				if (liveTriangles[inputCursor] > 0)
+					nextVertex = inputCursor;
+
+				inputCursor++;
+			}
+
+			// jumping to an uncached vertex starts a cluster that doesn't depend on the previous triangles
+			if (clusters && nextVertex != INVALID_VERTEX && timestamp - cacheTimestamps[nextVertex] > CACHE_SIZE)
+				clusters->push_back((unsigned int)result.size() / 3);
+		}
+
+		fanningVertex = nextVertex;
+	}
+
+	if (clusters)
+		clusters->insert(clusters->begin(), 0);
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<XMFLOAT3> &positions, const std::vector<unsigned int> &clusters, float threshold)
+{
+	unsigned int numTriangles = (unsigned int)indices.size() / 3;
+
+	if (numTriangles == 0 || clusters.empty() || positions.empty())
+		return;
+
+	unsigned int vertexCount = std::max((unsigned int)positions.size(), GetMaxVertex(indices) + 1);
+
+	// split the hard clusters where the cache behaviour up to then is already close to the whole cluster's
+	std::vector<unsigned int> softClusters;
+	std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+	unsigned int timestamp = CACHE_SIZE + 1;
+
+	for (unsigned int c = 0; c < (unsigned int)clusters.size(); c++)
+	{
+		unsigned int begin = clusters[c];
+		unsigned int end = c + 1 < (unsigned int)clusters.size() ? clusters[c + 1] : numTriangles;
+
+		// cluster acmr, with a cold cache
+		unsigned int clusterMisses = 0;
+		timestamp += CACHE_SIZE + 1;
+		for (unsigned int i = begin * 3; i < end * 3; i++)
+			if (timestamp - cacheTimestamps[indices[i]] > CACHE_SIZE)
+			{
+				cacheTimestamps[indices[i]] = timestamp++;
+				clusterMisses++;
+			}
+
+		float clusterThreshold = threshold * clusterMisses / (end - begin);
+
+		softClusters.push_back(begin);
+
+		unsigned int start = begin;
+		unsigned int misses = 0;
+		timestamp += CACHE_SIZE + 1;
+
+		for (unsigned int t = begin; t < end; t++)
+		{
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				unsigned int vertex = indices[t * 3 + k];
+
+				if (timestamp - cacheTimestamps[vertex] > CACHE_SIZE)
+				{
+					cacheTimestamps[vertex] = timestamp++;
+					misses++;
+				}
+			}
+
+			if (t + 1 < end && misses <= clusterThreshold * (t + 1 - start))
+			{
+				softClusters.push_back(t + 1);
+
+				start = t + 1;
+				misses = 0;
+				timestamp += CACHE_SIZE + 1;
+			}
+		}
+	}
+
+	// area weighted centroids and normals of the mesh and of every cluster
+	unsigned int numClusters = (unsigned int)softClusters.size();
+
+	std::vector<XMFLOAT3> clusterCentroids(numClusters);
+	std::vector<XMFLOAT3> clusterNormals(numClusters);
+
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0.0f;
+
+	for (unsigned int c = 0; c < numClusters; c++)
+	{
+		unsigned int begin = softClusters[c];
+		unsigned int end = c + 1 < numClusters ? softClusters[c + 1] : numTriangles;
+
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+
+		for (unsigned int t = begin; t < end; t++)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&positions[indices[t * 3]]);
+			XMVECTOR p1 = XMLoadFloat3(&positions[indices[t * 3 + 1]]);
+			XMVECTOR p2 = XMLoadFloat3(&positions[indices[t * 3 + 2]]);
+
+			XMVECTOR triangleNormal = XMVector3Cross(p1 - p0, p2 - p0);
+			float triangleArea = XMVectorGetX(XMVector3Length(triangleNormal));
+
+			centroid += XMVectorScale(p0 + p1 + p2, triangleArea / 3.0f);
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+
+		XMStoreFloat3(&clusterCentroids[c], area > 0.0f ? XMVectorScale(centroid, 1.0f / area) : XMLoadFloat3(&positions[indices[begin * 3]]));
+		XMStoreFloat3(&clusterNormals[c], XMVector3Normalize(normal));
+	}
+
+	if (meshArea > 0.0f)
+		meshCentroid = XMVectorScale(meshCentroid, 1.0f / meshArea);
+
+	// clusters facing away from the mesh center are on the outside and occlude the rest, draw them first
+	std::vector<float> sortKeys(numClusters);
+	for (unsigned int c = 0; c < numClusters; c++)
+		sortKeys[c] = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&clusterCentroids[c]) - meshCentroid, XMLoadFloat3(&clusterNormals[c])));
+
+	std::vector<unsigned int> order(numClusters);
+	for (unsigned int c = 0; c < numClusters; c++)
+		order[c] = c;
+
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+
+	for (unsigned int c : order)
+	{
+		unsigned int begin = softClusters[c];
+		unsigned int end = c + 1 < numClusters ? softClusters[c + 1] : numTriangles;
+
+		result.insert(result.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<unsigned int> &indices, unsigned int vertexCount, std::vector<unsigned int> &remap)
+{
+	vertexCount = std::max(vertexCount, indices.empty() ? 0 : GetMaxVertex(indices) + 1);
+
+	remap.assign(vertexCount, INVALID_VERTEX);
+
+	// vertices are stored in the order the triangles first reference them
+	unsigned int nextVertex = 0;
+	for (unsigned int &index : indices)
+	{
+		if (remap[index] == INVALID_VERTEX)
+			remap[index] = nextVertex++;
+
+		index = remap[index];
+	}
+}
+
+float MeshOptimizer::ComputeACMR(const std::vector<unsigned int> &indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+	unsigned int numTriangles = (unsigned int)indices.size() / 3;
+
+	if (numTriangles == 0)
+		return 0.0f;
+
+	vertexCount = std::max(vertexCount, GetMaxVertex(indices) + 1);
+
+	// fifo cache: a vertex is cached while fewer than cacheSize misses happened after its own
+	std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+	unsigned int misses = 0;
+
+	for (unsigned int index : indices)
+		if (timestamp - cacheTimestamps[index] > cacheSize)
+		{
+			cacheTimestamps[index] = timestamp++;
+			misses++;
+		}
+
+	return (float)misses / numTriangles;
+}
+
+unsigned int MeshOptimizer::GetMaxVertex(const std::vector<unsigned int> &indices)
+{
+	unsigned int maxVertex = 0;
+	for (unsigned int index : indices)
+		maxVertex = std::max(maxVertex, index);
+
+	return maxVertex;
+}
@@ -0,0 +1,63 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <DirectXMath.h>
+#include <vector>
+
+using namespace DirectX;
+
+/**** post-import ordering of indexed triangle lists for the gpu ****/
+/**** triangles are reordered for the post transform vertex cache (tipsify), the cache friendly clusters are then sorted ****/
+/**** outside in so that the surfaces facing out are drawn first (less overdraw), finally vertices are renumbered in order of first use ****/
+
+class MeshOptimizer
+{
+public:
+	static const unsigned int CACHE_SIZE = 16;                  // fifo cache entries assumed by the optimisation and the statistics
+	static const unsigned int INVALID_VERTEX = 0xFFFFFFFF;     // unreferenced vertices in the vertex remap
+
+	struct Statistics
+	{
+		unsigned int numTriangles;
+		float acmrBefore;      // average cache miss ratio: transformed vertices per triangle
+		float acmrAfter;
+	};
+public:
+	// all passes: cache, overdraw and fetch order; remap gives the new index of every vertex, the vertex data is reordered with RemapVertices()
+	static Statistics Optimize(std::vector<unsigned int> &indices, const std::vector<XMFLOAT3> &positions, std::vector<unsigned int> &remap);
+
+	// tipsify, the first triangle of each cluster that starts with a cold cache is added to clusters
+	static void OptimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount, std::vector<unsigned int> *clusters = nullptr);
+	// clusters are split further while they keep an acmr within threshold times their own, then sorted outside in
+	static void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<XMFLOAT3> &positions, const std::vector<unsigned int> &clusters, float threshold);
+	// renumbers the vertices in order of first use, unused vertices are dropped
+	static void OptimizeVertexFetch(std::vector<unsigned int> &indices, unsigned int vertexCount, std::vector<unsigned int> &remap);
+
+	template <typename T>
+	static void RemapVertices(std::vector<T> &vertices, const std::vector<unsigned int> &remap);
+
+	static float ComputeACMR(const std::vector<unsigned int> &indices, unsigned int vertexCount, unsigned int cacheSize = CACHE_SIZE);
+private:
+	MeshOptimizer() = default;
+
+	static unsigned int GetMaxVertex(const std::vector<unsigned int> &indices);
+};
+
+template <typename T>
+void MeshOptimizer::RemapVertices(std::vector<T> &vertices, const std::vector<unsigned int> &remap)
+{
+	unsigned int vertexCount = 0;
+	for (unsigned int newIndex : remap)
+		if (newIndex != INVALID_VERTEX)
+			vertexCount++;
+
+	std::vector<T> remapped(vertexCount);
+
+	for (unsigned int i = 0; i < (unsigned int)remap.size() && i < (unsigned int)vertices.size(); i++)
+		if (remap[i] != INVALID_VERTEX)
+			remapped[remap[i]] = vertices[i];
+
+	vertices.swap(remapped);
+}
+
+#endif  // MESH_OPTIMIZER_H
@@ -0,0 +1,546 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cfloat>
+#include <cmath>
+
+// attribute differences are weighted against distances in the unit cube of the mesh
+static const float NORMAL_WEIGHT = 0.05f;
+static const float TEXTURE_COORDINATES_WEIGHT = 0.05f;
+// border planes keep open borders in place
+static const float BORDER_WEIGHT = 10.0f;
+// a detail level must drop at least 15% of the indices of the previous one
+static const float MIN_LOD_REDUCTION = 0.85f;
+
+const unsigned int MeshSimplifier::INVALID_VERTEX;
+
+void MeshSimplifier::Quadric::AddPlane(const XMFLOAT3 &normal, float distance, float planeWeight)
+{
+	a00 += planeWeight * normal.x * normal.x;
+	a11 += planeWeight * normal.y * normal.y;
+	a22 += planeWeight * normal.z * normal.z;
+	a10 += planeWeight * normal.y * normal.x;
+	a20 += planeWeight * normal.z * normal.x;
+	a21 += planeWeight * normal.z * normal.y;
+	b0 += planeWeight * normal.x * distance;
+	b1 += planeWeight * normal.y * distance;
+	b2 += planeWeight * normal.z * distance;
+	c += planeWeight * distance * distance;
+	weight += planeWeight;
+}
+
+void MeshSimplifier::Quadric::Add(const Quadric &other)
+{
+	a00 += other.a00;
+	a11 += other.a11;
+	a22 += other.a22;
+	a10 += other.a10;
+	a20 += other.a20;
+	a21 += other.a21;
+	b0 += other.b0;
+	b1 += other.b1;
+	b2 += other.b2;
+	c += other.c;
+	weight += other.weight;
+}
+
+float MeshSimplifier::Quadric::Evaluate(const XMFLOAT3 &point) const
+{
+	if (weight <= 0.0)
+		return 0.0f;
+
+	double x = point.x, y = point.y, z = point.z;
+
+	double error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z) + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+	return (float)std::max(error / weight, 0.0);
+}
+
+MeshSimplifier::MeshSimplifier(const std::vector<XMFLOAT3> &positions, const std::vector<XMFLOAT3> &normals, const std::vector<XMFLOAT2> &textureCoordinates, const std::vector<unsigned int> &indices)
+	: mSourceIndices(indices)
+{
+	unsigned int numVertices = (unsigned int)positions.size();
+
+	// scale to the unit cube, errors are relative to the largest extent of the mesh
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+
+	for (const XMFLOAT3 &position : positions)
+	{
+		boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&position));
+		boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&position));
+	}
+
+	XMFLOAT3 extent;
+	XMStoreFloat3(&extent, boundsMax - boundsMin);
+	float maxExtent = std::max(std::max(extent.x, extent.y), extent.z);
+	float scale = maxExtent > 0.0f ? 1.0f / maxExtent : 1.0f;
+
+	mPositions.resize(numVertices);
+	mAttributes.assign(numVertices * NUM_ATTRIBUTES, 0.0f);
+
+	for (unsigned int v = 0; v < numVertices; v++)
+	{
+		XMStoreFloat3(&mPositions[v], (XMLoadFloat3(&positions[v]) - boundsMin) * scale);
+
+		float *attributes = &mAttributes[v * NUM_ATTRIBUTES];
+
+		if (!normals.empty())
+		{
+			attributes[0] = normals[v].x * NORMAL_WEIGHT;
+			attributes[1] = normals[v].y * NORMAL_WEIGHT;
+			attributes[2] = normals[v].z * NORMAL_WEIGHT;
+		}
+
+		if (!textureCoordinates.empty())
+		{
+			attributes[3] = textureCoordinates[v].x * TEXTURE_COORDINATES_WEIGHT;
+			attributes[4] = textureCoordinates[v].y * TEXTURE_COORDINATES_WEIGHT;
+		}
+	}
+
+	// weld vertices with the same position: position ids are the first of them
+	std::vector<unsigned int> order(numVertices);
+	for (unsigned int v = 0; v < numVertices; v++)
+		order[v] = v;
+
+	auto positionLess = [&positions](unsigned int a, unsigned int b)
+	{
+		if (positions[a].x != positions[b].x)
+			return positions[a].x < positions[b].x;
+		if (positions[a].y != positions[b].y)
+			return positions[a].y < positions[b].y;
+		if (positions[a].z != positions[b].z)
+			return positions[a].z < positions[b].z;
+
+		return a < b;
+	};
+	std::sort(order.begin(), order.end(), positionLess);
+
+	mPositionIds.resize(numVertices);
+
+	for (unsigned int i = 0; i < numVertices; i++)
+	{
+		unsigned int v = order[i];
+		unsigned int previous = i > 0 ? order[i - 1] : v;
+
+		bool samePosition = i > 0 && positions[v].x == positions[previous].x && positions[v].y == positions[previous].y && positions[v].z == positions[previous].z;
+		mPositionIds[v] = samePosition ? mPositionIds[previous] : v;
+	}
+
+	// duplicates of a vertex (same position and attributes) are replaced by the first one
+	auto vertexLess = [this](unsigned int a, unsigned int b)
+	{
+		if (mPositionIds[a] != mPositionIds[b])
+			return mPositionIds[a] < mPositionIds[b];
+
+		for (unsigned int k = 0; k < NUM_ATTRIBUTES; k++)
+			if (mAttributes[a * NUM_ATTRIBUTES + k] != mAttributes[b * NUM_ATTRIBUTES + k])
+				return mAttributes[a * NUM_ATTRIBUTES + k] < mAttributes[b * NUM_ATTRIBUTES + k];
+
+		return a < b;
+	};
+	std::sort(order.begin(), order.end(), vertexLess);
+
+	std::vector<unsigned int> firstDuplicate(numVertices);
+
+	for (unsigned int i = 0; i < numVertices; i++)
+	{
+		unsigned int v = order[i];
+		unsigned int previous = i > 0 ? order[i - 1] : v;
+
+		bool sameVertex = i > 0 && mPositionIds[v] == mPositionIds[previous] && std::equal(&mAttributes[v * NUM_ATTRIBUTES], &mAttributes[v * NUM_ATTRIBUTES] + NUM_ATTRIBUTES, &mAttributes[previous * NUM_ATTRIBUTES]);
+		firstDuplicate[v] = sameVertex ? firstDuplicate[previous] : v;
+	}
+
+	mIndices.resize(indices.size());
+	for (unsigned int i = 0; i < (unsigned int)indices.size(); i++)
+		mIndices[i] = firstDuplicate[indices[i]];
+}
+
+void MeshSimplifier::ClassifyVertices(const std::vector<unsigned int> &indices, std::vector<VertexKind> &kinds, std::vector<uint64_t> &borderEdges) const
+{
+	unsigned int numVertices = (unsigned int)mPositions.size();
+
+	// directed edges between welded positions
+	std::unordered_map<uint64_t, unsigned int> edgeCounts;
+	edgeCounts.reserve(indices.size());
+
+	for (unsigned int i = 0; i < (unsigned int)indices.size(); i += 3)
+		for (unsigned int e = 0; e < 3; e++)
+		{
+			unsigned int a = mPositionIds[indices[i + e]];
+			unsigned int b = mPositionIds[indices[i + (e + 1) % 3]];
+
+			edgeCounts[(uint64_t)a << 32 | b]++;
+		}
+
+	// an edge without its opposite is on a border, an edge used twice in the same direction is non-manifold
+	kinds.assign(numVertices, VertexKind::MANIFOLD);
+	borderEdges.clear();
+
+	std::vector<unsigned int> borderCounts(numVertices, 0);
+
+	for (const std::pair<const uint64_t, unsigned int> &edge : edgeCounts)
+	{
+		unsigned int a = (unsigned int)(edge.first >> 32);
+		unsigned int b = (unsigned int)(edge.first & 0xFFFFFFFF);
+
+		if (edge.second > 1)
+			kinds[a] = kinds[b] = VertexKind::LOCKED;
+		else if (edgeCounts.find((uint64_t)b << 32 | a) == edgeCounts.end())
+		{
+			borderCounts[a]++;
+			borderCounts[b]++;
+			borderEdges.push_back(GetEdgeKey(a, b));
+		}
+	}
+
+	// a border vertex has one incoming and one outgoing border edge, more make it a junction of borders
+	for (unsigned int v = 0; v < numVertices; v++)
+		if (kinds[v] != VertexKind::LOCKED && borderCounts[v] > 0)
+			kinds[v] = borderCounts[v] == 2 ? VertexKind::BORDER : VertexKind::LOCKED;
+
+	std::sort(borderEdges.begin(), borderEdges.end());
+}
+
+void MeshSimplifier::ComputeQuadrics(const std::vector<unsigned int> &indices, const std::vector<uint64_t> &borderEdges, std::vector<Quadric> &quadrics) const
+{
+	quadrics.assign(mPositions.size(), Quadric{});
+
+	for (unsigned int i = 0; i < (unsigned int)indices.size(); i += 3)
+	{
+		unsigned int vertices[3] = { mPositionIds[indices[i]], mPositionIds[indices[i + 1]], mPositionIds[indices[i + 2]] };
+
+		XMVECTOR p0 = XMLoadFloat3(&mPositions[vertices[0]]);
+		XMVECTOR p1 = XMLoadFloat3(&mPositions[vertices[1]]);
+		XMVECTOR p2 = XMLoadFloat3(&mPositions[vertices[2]]);
+
+		XMVECTOR normal = XMVector3Cross(p1 - p0, p2 - p0);
+		float doubleArea = XMVectorGetX(XMVector3Length(normal));
+
+		if (doubleArea == 0.0f)
+			continue;
+
+		normal = XMVectorScale(normal, 1.0f / doubleArea);
+
+		// triangle plane, weighted by area
+		XMFLOAT3 planeNormal;
+		XMStoreFloat3(&planeNormal, normal);
+		float distance = -XMVectorGetX(XMVector3Dot(normal, p0));
+
+		for (unsigned int vertex : vertices)
+			quadrics[vertex].AddPlane(planeNormal, distance, doubleArea * 0.5f);
+
+		// planes through the border edges, perpendicular to the triangle
+		for (unsigned int e = 0; e < 3; e++)
+		{
+			unsigned int a = vertices[e];
+			unsigned int b = vertices[(e + 1) % 3];
+
+			if (!std::binary_search(borderEdges.begin(), borderEdges.end(), GetEdgeKey(a, b)))
+				continue;
+
+			XMVECTOR edge = XMLoadFloat3(&mPositions[b]) - XMLoadFloat3(&mPositions[a]);
+			float edgeLengthSquared = XMVectorGetX(XMVector3LengthSq(edge));
+
+			XMVECTOR borderNormal = XMVector3Normalize(XMVector3Cross(edge, normal));
+
+			XMFLOAT3 borderPlaneNormal;
+			XMStoreFloat3(&borderPlaneNormal, borderNormal);
+			float borderDistance = -XMVectorGetX(XMVector3Dot(borderNormal, XMLoadFloat3(&mPositions[a])));
+
+			quadrics[a].AddPlane(borderPlaneNormal, borderDistance, edgeLengthSquared * BORDER_WEIGHT);
+			quadrics[b].AddPlane(borderPlaneNormal, borderDistance, edgeLengthSquared * BORDER_WEIGHT);
+		}
+	}
+}
+
+void MeshSimplifier::BuildAdjacency(const std::vector<unsigned int> &indices, Adjacency &adjacency) const
+{
+	unsigned int numVertices = (unsigned int)mPositions.size();
+
+	// triangles around each vertex (counting sort by vertex)
+	adjacency.triangleOffsets.assign(numVertices + 1, 0);
+
+	for (unsigned int index : indices)
+		adjacency.triangleOffsets[index + 1]++;
+
+	for (unsigned int v = 0; v < numVertices; v++)
+		adjacency.triangleOffsets[v + 1] += adjacency.triangleOffsets[v];
+
+	adjacency.triangles.resize(indices.size());
+	std::vector<unsigned int> cursors(adjacency.triangleOffsets.begin(), adjacency.triangleOffsets.end() - 1);
+
+	for (unsigned int i = 0; i < (unsigned int)indices.size(); i++)
+		adjacency.triangles[cursors[indices[i]]++] = i / 3;
+
+	// vertices in use at each welded position
+	adjacency.wedges.assign(numVertices, INVALID_VERTEX);
+	adjacency.nextWedge.assign(numVertices, INVALID_VERTEX);
+
+	for (unsigned int v = 0; v < numVertices; v++)
+		if (adjacency.triangleOffsets[v + 1] > adjacency.triangleOffsets[v])
+		{
+			adjacency.nextWedge[v] = adjacency.wedges[mPositionIds[v]];
+			adjacency.wedges[mPositionIds[v]] = v;
+		}
+}
+
+bool MeshSimplifier::CanCollapse(const std::vector<VertexKind> &kinds, const std::vector<uint64_t> &borderEdges, unsigned int source, unsigned int target) const
+{
+	switch (kinds[source])
+	{
+	case VertexKind::MANIFOLD:
+		return true;
+	case VertexKind::BORDER:      // along the border only
+		return kinds[target] == VertexKind::BORDER && std::binary_search(borderEdges.begin(), borderEdges.end(), GetEdgeKey(source, target));
+	default:
+		return false;
+	}
+}
+
+unsigned int MeshSimplifier::FindWedgeTarget(unsigned int vertex, unsigned int target, const std::vector<unsigned int> &indices, const Adjacency &adjacency) const
+{
+	// the vertex at the target position sharing a triangle with the vertex: attributes follow the surface on the same side of a seam
+	for (unsigned int t = adjacency.triangleOffsets[vertex]; t < adjacency.triangleOffsets[vertex + 1]; t++)
+	{
+		unsigned int triangle = adjacency.triangles[t];
+
+		for (unsigned int k = 0; k < 3; k++)
+			if (mPositionIds[indices[triangle * 3 + k]] == target)
+				return indices[triangle * 3 + k];
+	}
+
+	return INVALID_VERTEX;
+}
+
+float MeshSimplifier::GetAttributeError(unsigned int vertex, unsigned int target) const
+{
+	float error = 0.0f;
+
+	for (unsigned int k = 0; k < NUM_ATTRIBUTES; k++)
+	{
+		float difference = mAttributes[vertex * NUM_ATTRIBUTES + k] - mAttributes[target * NUM_ATTRIBUTES + k];
+		error += difference * difference;
+	}
+
+	return error;
+}
+
+bool MeshSimplifier::Flips(unsigned int source, unsigned int target, const std::vector<unsigned int> &indices, const Adjacency &adjacency) const
+{
+	XMVECTOR sourcePosition = XMLoadFloat3(&mPositions[source]);
+	XMVECTOR targetPosition = XMLoadFloat3(&mPositions[target]);
+
+	for (unsigned int vertex = adjacency.wedges[source]; vertex != INVALID_VERTEX; vertex = adjacency.nextWedge[vertex])
+		for (unsigned int t = adjacency.triangleOffsets[vertex]; t < adjacency.triangleOffsets[vertex + 1]; t++)
+		{
+			unsigned int triangle = adjacency.triangles[t];
+
+			// the other two corners in winding order
+			unsigned int k = indices[triangle * 3] == vertex ? 0 : indices[triangle * 3 + 1] == vertex ? 1 : 2;
+			unsigned int b = mPositionIds[indices[triangle * 3 + (k + 1) % 3]];
+			unsigned int c = mPositionIds[indices[triangle * 3 + (k + 2) % 3]];
+
+			// triangles on the collapsed edge disappear
+			if (b == target || c == target)
+				continue;
+
+			XMVECTOR pb = XMLoadFloat3(&mPositions[b]);
+			XMVECTOR pc = XMLoadFloat3(&mPositions[c]);
+
+			XMVECTOR normal = XMVector3Cross(pb - sourcePosition, pc - sourcePosition);
+			XMVECTOR collapsedNormal = XMVector3Cross(pb - targetPosition, pc - targetPosition);
+
+			float dot = XMVectorGetX(XMVector3Dot(normal, collapsedNormal));
+			float lengths = XMVectorGetX(XMVector3Length(normal) * XMVector3Length(collapsedNormal));
+
+			if (dot <= 1e-3f * lengths)
+				return true;
+		}
+
+	return false;
+}
+
+std::vector<unsigned int> MeshSimplifier::Simplify(unsigned int targetIndexCount, float targetError, float *resultError) const
+{
+	unsigned int numVertices = (unsigned int)mPositions.size();
+	std::vector<unsigned int> indices = mIndices;
+
+	std::vector<VertexKind> kinds;
+	std::vector<uint64_t> borderEdges;
+	ClassifyVertices(indices, kinds, borderEdges);
+
+	std::vector<Quadric> quadrics;
+	ComputeQuadrics(indices, borderEdges, quadrics);
+
+	Adjacency adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<float> bestCosts(numVertices);
+	std::vector<unsigned int> bestTargets(numVertices);
+	std::vector<unsigned int> remap(numVertices);
+	std::vector<bool> locked(numVertices);
+
+	float maxCost = targetError * targetError;
+	float error = 0.0f;
+
+	targetIndexCount = targetIndexCount / 3 * 3;
+
+	while (indices.size() > targetIndexCount)
+	{
+		BuildAdjacency(indices, adjacency);
+
+		// cheapest collapse of every welded position over the edges of the mesh
+		std::fill(bestCosts.begin(), bestCosts.end(), FLT_MAX);
+
+		for (unsigned int i = 0; i < (unsigned int)indices.size(); i++)
+		{
+			unsigned int edge[2] = { mPositionIds[indices[i]], mPositionIds[indices[i - i % 3 + (i + 1) % 3]] };
+
+			for (unsigned int d = 0; d < 2; d++)
+			{
+				unsigned int source = edge[d];
+				unsigned int target = edge[1 - d];
+
+				if (source == target || !CanCollapse(kinds, borderEdges, source, target))
+					continue;
+
+				float cost = quadrics[source].Evaluate(mPositions[target]);
+				if (cost >= bestCosts[source])
+					continue;
+
+				// every vertex at the source position needs a counterpart at the target position
+				float attributeError = 0.0f;
+				bool valid = true;
+
+				for (unsigned int vertex = adjacency.wedges[source]; vertex != INVALID_VERTEX && valid; vertex = adjacency.nextWedge[vertex])
+				{
+					unsigned int wedgeTarget = FindWedgeTarget(vertex, target, indices, adjacency);
+
+					if (wedgeTarget == INVALID_VERTEX)
+						valid = false;
+					else
+						attributeError = std::max(attributeError, GetAttributeError(vertex, wedgeTarget));
+				}
+
+				if (valid && cost + attributeError < bestCosts[source])
+				{
+					bestCosts[source] = cost + attributeError;
+					bestTargets[source] = target;
+				}
+			}
+		}
+
+		collapses.clear();
+
+		for (unsigned int v = 0; v < numVertices; v++)
+			if (bestCosts[v] <= maxCost)
+				collapses.push_back(Collapse{ v, bestTargets[v], bestCosts[v] });
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+		// cheapest first, the neighbourhood of a collapse waits for the next pass
+		std::fill(locked.begin(), locked.end(), false);
+
+		for (unsigned int v = 0; v < numVertices; v++)
+			remap[v] = v;
+
+		unsigned int triangleGoal = (unsigned int)(indices.size() - targetIndexCount) / 3;
+		unsigned int removedTriangles = 0;
+		unsigned int numCollapses = 0;
+
+		for (const Collapse &collapse : collapses)
+		{
+			if (removedTriangles >= triangleGoal)
+				break;
+
+			if (locked[collapse.source] || locked[collapse.target] || Flips(collapse.source, collapse.target, indices, adjacency))
+				continue;
+
+			for (unsigned int vertex = adjacency.wedges[collapse.source]; vertex != INVALID_VERTEX; vertex = adjacency.nextWedge[vertex])
+			{
+				remap[vertex] = FindWedgeTarget(vertex, collapse.target, indices, adjacency);
+
+				for (unsigned int t = adjacency.triangleOffsets[vertex]; t < adjacency.triangleOffsets[vertex + 1]; t++)
+				{
+					unsigned int triangle = adjacency.triangles[t];
+					bool removed = false;
+
+					for (unsigned int k = 0; k < 3; k++)
+					{
+						unsigned int position = mPositionIds[indices[triangle * 3 + k]];
+
+						locked[position] = true;
+						removed |= position == collapse.target;
+					}
+
+					removedTriangles += removed;
+				}
+			}
+
+			quadrics[collapse.target].Add(quadrics[collapse.source]);
+			error = std::max(error, collapse.cost);
+
+			numCollapses++;
+		}
+
+		if (numCollapses == 0)
+			break;
+
+		// apply the collapses, dropping the triangles that lost an edge
+		unsigned int numIndices = 0;
+
+		for (unsigned int i = 0; i < (unsigned int)indices.size(); i += 3)
+		{
+			unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+
+			if (mPositionIds[a] == mPositionIds[b] || mPositionIds[b] == mPositionIds[c] || mPositionIds[c] == mPositionIds[a])
+				continue;
+
+			indices[numIndices++] = a;
+			indices[numIndices++] = b;
+			indices[numIndices++] = c;
+		}
+
+		indices.resize(numIndices);
+
+		ClassifyVertices(indices, kinds, borderEdges);
+	}
+
+	if (resultError)
+		*resultError = sqrt(error);
+
+	return indices;
+}
+
+std::vector<Mesh::LOD> MeshSimplifier::BuildLODChain(std::vector<unsigned int> &lodIndices, float maxError) const
+{
+	std::vector<Mesh::LOD> lods;
+
+	lodIndices = mSourceIndices;
+
+	if (mSourceIndices.empty())
+		return lods;
+
+	lods.push_back(Mesh::LOD{ 0, (unsigned int)mSourceIndices.size(), 0.0f });
+
+	// every level is simplified from the source, so errors don't pile up through the chain
+	while (lods.size() < Mesh::MAX_LODS)
+	{
+		float error;
+		std::vector<unsigned int> indices = Simplify(lods.back().indexCount / 2, maxError, &error);
+
+		if (indices.empty() || indices.size() > lods.back().indexCount * MIN_LOD_REDUCTION)
+			break;
+
+		// collapses leave the source triangle order, reorder each level for the vertex cache
+		MeshOptimizer::OptimizeVertexCache(indices, (unsigned int)mPositions.size());
+
+		lods.push_back(Mesh::LOD{ (unsigned int)lodIndices.size(), (unsigned int)indices.size(), error });
+		lodIndices.insert(lodIndices.end(), indices.begin(), indices.end());
+	}
+
+	return lods;
+}
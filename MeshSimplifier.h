@@ -0,0 +1,76 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include "Mesh.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+using namespace DirectX;
+
+/**** quadric error metric simplification of indexed triangle lists, by edge collapses onto existing vertices ****/
+/**** simplified levels index the same vertices as the source, so every detail level of a mesh shares its vertex buffers ****/
+/**** collapses are rated by the distance from the planes of the merged triangles plus the change of normals and texture coordinates ****/
+/**** open borders only collapse along themselves, vertices on attribute seams only collapse along the seam ****/
+
+class MeshSimplifier
+{
+public:
+	// normals and texture coordinates are optional (empty), the source is a triangle list
+	MeshSimplifier(const std::vector<XMFLOAT3> &positions, const std::vector<XMFLOAT3> &normals, const std::vector<XMFLOAT2> &textureCoordinates, const std::vector<unsigned int> &indices);
+
+	// simplifies towards targetIndexCount indices, stopping before a collapse would exceed targetError (relative to the mesh extent)
+	std::vector<unsigned int> Simplify(unsigned int targetIndexCount, float targetError, float *resultError = nullptr) const;
+
+	// detail levels with about half the triangles of the previous one, concatenated in lodIndices: level 0 is the source
+	std::vector<Mesh::LOD> BuildLODChain(std::vector<unsigned int> &lodIndices, float maxError = 0.05f) const;
+private:
+	struct Quadric     // sum of squared distances from weighted planes
+	{
+		double a00, a11, a22, a10, a20, a21;
+		double b0, b1, b2;
+		double c;
+		double weight;
+
+		void AddPlane(const XMFLOAT3 &normal, float distance, float planeWeight);
+		void Add(const Quadric &other);
+		float Evaluate(const XMFLOAT3 &point) const;    // mean squared distance
+	};
+	struct Collapse      // welded positions
+	{
+		unsigned int source;
+		unsigned int target;
+		float cost;
+	};
+	struct Adjacency     // rebuilt every pass
+	{
+		std::vector<unsigned int> triangleOffsets;     // triangles of vertex v: triangles[triangleOffsets[v]] to triangles[triangleOffsets[v + 1]]
+		std::vector<unsigned int> triangles;
+		std::vector<unsigned int> wedges;              // first vertex at a welded position, INVALID_VERTEX if none is used
+		std::vector<unsigned int> nextWedge;           // next vertex at the same position
+	};
+	enum class VertexKind : uint8_t { MANIFOLD, BORDER, LOCKED, };
+
+	static const unsigned int NUM_ATTRIBUTES = 5;     // normal, texture coordinates
+	static const unsigned int INVALID_VERTEX = 0xFFFFFFFF;
+
+	void ClassifyVertices(const std::vector<unsigned int> &indices, std::vector<VertexKind> &kinds, std::vector<uint64_t> &borderEdges) const;
+	void ComputeQuadrics(const std::vector<unsigned int> &indices, const std::vector<uint64_t> &borderEdges, std::vector<Quadric> &quadrics) const;
+	void BuildAdjacency(const std::vector<unsigned int> &indices, Adjacency &adjacency) const;
+
+	bool CanCollapse(const std::vector<VertexKind> &kinds, const std::vector<uint64_t> &borderEdges, unsigned int source, unsigned int target) const;
+	unsigned int FindWedgeTarget(unsigned int vertex, unsigned int target, const std::vector<unsigned int> &indices, const Adjacency &adjacency) const;
+	float GetAttributeError(unsigned int vertex, unsigned int target) const;
+	bool Flips(unsigned int source, unsigned int target, const std::vector<unsigned int> &indices, const Adjacency &adjacency) const;
+
+	static uint64_t GetEdgeKey(unsigned int a, unsigned int b) { return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a; }
+
+	std::vector<unsigned int> mSourceIndices;
+
+	std::vector<XMFLOAT3> mPositions;            // scaled to the unit cube
+	std::vector<float> mAttributes;              // NUM_ATTRIBUTES weighted attributes per vertex
+	std::vector<unsigned int> mPositionIds;      // first vertex with the same position
+	std::vector<unsigned int> mIndices;          // source indices over the first vertex with the same position and attributes
+};
+
+#endif  // MESH_SIMPLIFIER_H
@@ -1,8 +1,183 @@
 #include "ModelLoader.h"
 #include "assimp/Importer.hpp"
 #include "assimp/postprocess.h"
+#include "assimp/IOSystem.hpp"
+#include "assimp/IOStream.hpp"
 #include "StaticMeshComponent.h"
 #include "Skeleton.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "VirtualFileSystem.h"
+#include "ThreadPool.h"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	// assimp reads the model and the files it references (materials) through the virtual file system
+	class VirtualIOStream : public Assimp::IOStream
+	{
+	public:
+		bool Open(const char *filePath)
+		{
+			return VirtualFileSystem::GetInstance().Open(filePath, mFile);
+		}
+
+		size_t Read(void *buffer, size_t size, size_t count) override
+		{
+			if (size == 0)
+				return 0;
+
+			size_t numRead = (mFile.GetSize() - mPosition) / size < count ? (mFile.GetSize() - mPosition) / size : count;
+			memcpy(buffer, mFile.GetData() + mPosition, numRead * size);
+			mPosition += numRead * size;
+
+			return numRead;
+		}
+
+		size_t Write(const void*, size_t, size_t) override
+		{
+			return 0;
+		}
+
+		aiReturn Seek(size_t offset, aiOrigin origin) override
+		{
+			size_t position = origin == aiOrigin_SET ? offset : origin == aiOrigin_CUR ? mPosition + offset : mFile.GetSize() + offset;
+
+			if (position > mFile.GetSize())
+				return aiReturn_FAILURE;
+
+			mPosition = position;
+
+			return aiReturn_SUCCESS;
+		}
+
+		size_t Tell() const override
+		{
+			return mPosition;
+		}
+
+		size_t FileSize() const override
+		{
+			return mFile.GetSize();
+		}
+
+		void Flush() override
+		{
+		}
+	private:
+		VirtualFileSystem::File mFile;
+		size_t mPosition = 0;
+	};
+
+	class VirtualIOSystem : public Assimp::IOSystem
+	{
+	public:
+		explicit VirtualIOSystem(std::vector<std::string> &openedFiles) : mOpenedFiles(openedFiles)
+		{
+		}
+
+		bool Exists(const char *filePath) const override
+		{
+			return VirtualFileSystem::GetInstance().Exists(filePath);
+		}
+
+		char getOsSeparator() const override
+		{
+			return '/';
+		}
+
+		Assimp::IOStream *Open(const char *filePath, const char *mode) override
+		{
+			if (strchr(mode, 'w') || strchr(mode, 'a'))
+				return nullptr;
+
+			VirtualIOStream *stream = new VirtualIOStream;
+
+			if (!stream->Open(filePath))
+			{
+				delete stream;
+				return nullptr;
+			}
+
+			if (std::find(mOpenedFiles.begin(), mOpenedFiles.end(), filePath) == mOpenedFiles.end())
+				mOpenedFiles.push_back(filePath);
+
+			return stream;
+		}
+
+		void Close(Assimp::IOStream *stream) override
+		{
+			delete stream;
+		}
+	private:
+		std::vector<std::string> &mOpenedFiles;
+	};
+
+	// tangent frames of a normal mapped mesh: the tangent of each triangle (the u direction of its texture coordinates) is
+	// added to its vertices, then orthogonalised against their normals. triangles and vertices are spread over the thread pool
+	void GenerateTangents(const std::vector<XMFLOAT3> &positions, const std::vector<XMFLOAT3> &normals, const std::vector<XMFLOAT2> &textureCoordinates, const std::vector<unsigned int> &indices, std::vector<XMFLOAT3> &tangents)
+	{
+		static const unsigned int TASK_SIZE = 4096;
+
+		unsigned int numTriangles = (unsigned int)indices.size() / 3;
+		unsigned int numVertices = (unsigned int)positions.size();
+
+		std::vector<XMFLOAT3> triangleTangents(numTriangles);
+
+		ThreadPool::GetInstance().ParallelFor((numTriangles + TASK_SIZE - 1) / TASK_SIZE, [&](unsigned int task)
+		{
+			unsigned int end = (task + 1) * TASK_SIZE < numTriangles ? (task + 1) * TASK_SIZE : numTriangles;
+
+			for (unsigned int triangle = task * TASK_SIZE; triangle < end; triangle++)
+			{
+				const unsigned int *triangleIndices = &indices[triangle * 3];
+
+				XMVECTOR p0 = XMLoadFloat3(&positions[triangleIndices[0]]);
+				XMVECTOR v1 = XMLoadFloat3(&positions[triangleIndices[1]]) - p0;
+				XMVECTOR v2 = XMLoadFloat3(&positions[triangleIndices[2]]) - p0;
+
+				float du1 = textureCoordinates[triangleIndices[1]].x - textureCoordinates[triangleIndices[0]].x;
+				float dv1 = textureCoordinates[triangleIndices[1]].y - textureCoordinates[triangleIndices[0]].y;
+				float du2 = textureCoordinates[triangleIndices[2]].x - textureCoordinates[triangleIndices[0]].x;
+				float dv2 = textureCoordinates[triangleIndices[2]].y - textureCoordinates[triangleIndices[0]].y;
+
+				float det = du1 * dv2 - dv1 * du2;
+
+				// triangles with degenerate texture coordinates don't orient their vertices
+				XMStoreFloat3(&triangleTangents[triangle], det != 0.0f ? (dv2 * v1 - dv1 * v2) / det : XMVectorZero());
+			}
+		});
+
+		// accumulated on one thread: vertices are shared by triangles of different tasks
+		std::fill(tangents.begin(), tangents.end(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+		for (unsigned int triangle = 0; triangle < numTriangles; triangle++)
+			for (unsigned int j = 0; j < 3; j++)
+				XMStoreFloat3(&tangents[indices[triangle * 3 + j]], XMLoadFloat3(&tangents[indices[triangle * 3 + j]]) + XMLoadFloat3(&triangleTangents[triangle]));
+
+		ThreadPool::GetInstance().ParallelFor((numVertices + TASK_SIZE - 1) / TASK_SIZE, [&](unsigned int task)
+		{
+			unsigned int end = (task + 1) * TASK_SIZE < numVertices ? (task + 1) * TASK_SIZE : numVertices;
+
+			for (unsigned int vertex = task * TASK_SIZE; vertex < end; vertex++)
+			{
+				XMVECTOR normal = XMLoadFloat3(&normals[vertex]);
+				XMVECTOR tangent = XMLoadFloat3(&tangents[vertex]);
+
+				tangent -= normal * XMVector3Dot(normal, tangent);
+
+				// vertices no triangle could orient get any tangent perpendicular to the normal
+				if (XMVectorGetX(XMVector3LengthSq(tangent)) > 1e-12f)
+					tangent = XMVector3Normalize(tangent);
+				else
+					tangent = XMVector3Normalize(XMVector3Orthogonal(normal));
+
+				XMStoreFloat3(&tangents[vertex], tangent);
+			}
+		});
+	}
+}
 
 ModelLoader &ModelLoader::GetInstance()
 {
@@ -13,201 +188,305 @@ ModelLoader &ModelLoader::GetInstance()
 
 StaticMeshComponent *ModelLoader::LoadStaticModel(const std::string &filePath)
 {
+	StaticModelData model;
+	std::string error;
+
+	if (!ReadStaticModel(filePath, model, error))
+		ErrorBox(error);
+
+	return CreateStaticModel(model);
+}
+
+bool ModelLoader::ReadStaticModel(const std::string &filePath, StaticModelData &model, std::string &error, bool import)
+{
+	model.directory = filePath.substr(0, filePath.find_last_of('/'));
+	model.statistics = MeshOptimizer::Statistics{};
+	model.importedFiles.clear();
+
+	// a model cooked by a previous import is mapped and uploaded as it is
+	std::string cookedFilePath = MeshFile::GetCookedPath(filePath);
+	uint64_t sourceTime = VirtualFileSystem::GetInstance().GetModificationTime(filePath);
+
+	if (!import && model.cookedFile.Open(cookedFilePath, VertexLayout::GetStaticMeshLayout(), sourceTime))
+	{
+		// page the file in on the reading thread rather than during the upload
+		model.cookedFile.Prefetch();
+
+		model.positions.assign(model.cookedFile.GetModelPositions(), model.cookedFile.GetModelPositions() + model.cookedFile.GetNumModelPositions());
+		model.indices.assign(model.cookedFile.GetModelIndices(), model.cookedFile.GetModelIndices() + model.cookedFile.GetNumModelIndices());
+
+		return true;
+	}
+
 	Assimp::Importer importer;
-	const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs);
+	importer.SetIOHandler(new VirtualIOSystem(model.importedFiles));      // owned by the importer
+
+	const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs);
 
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-		ErrorBox(importer.GetErrorString());
+	{
+		error = importer.GetErrorString();
+		return false;
+	}
+
+	ProcessMeshes(scene, model);
+
+	// if the cooked file can't be written the next load imports again
+	MeshFile::Save(cookedFilePath, VertexLayout::GetStaticMeshLayout(), sourceTime, model.meshes, model.positions, model.indices);
 
-	mDirectory = filePath.substr(0, filePath.find_last_of('/'));
+	return true;
+}
+
+StaticMeshComponent *ModelLoader::CreateStaticModel(StaticModelData &model)
+{
+	std::vector<Mesh> meshes;
+	std::vector<Material> materials;
 
-	mModelMeshes.clear();
-	mModelMaterials.clear();
-	mModelVertexPositions.clear();
+	if (model.cookedFile.IsOpen())
+	{
+		for (unsigned int i = 0; i < model.cookedFile.GetNumMeshes(); i++)
+		{
+			Mesh modelMesh;
+			model.cookedFile.LoadMesh(i, modelMesh);
+			meshes.push_back(modelMesh);
+
+			std::vector<std::string> textures[MeshFile::NUM_TEXTURE_TYPES];
+			for (unsigned int type = 0; type < MeshFile::NUM_TEXTURE_TYPES; type++)
+				for (unsigned int texture = 0; texture < model.cookedFile.GetNumTextures(i, (MeshFile::TextureType)type); texture++)
+					textures[type].push_back(model.cookedFile.GetTexture(i, (MeshFile::TextureType)type, texture));
+
+			materials.push_back(CreateMaterial(model.directory, textures));
+		}
 
-	ProcessNode(scene->mRootNode, scene);
+		model.cookedFile.Close();
+	}
+	else
+	{
+		const VertexLayout &layout = VertexLayout::GetStaticMeshLayout();
+
+		for (const MeshFile::CookedMesh &cookedMesh : model.meshes)
+		{
+			std::vector<const void*> streams(layout.GetNumStreams());
+			for (unsigned int stream = 0; stream < layout.GetNumStreams(); stream++)
+				streams[stream] = &cookedMesh.streams[stream][0];
+
+			// load vertex attributes and index buffer
+			Mesh modelMesh;
+
+			modelMesh.LoadPackedVertices(layout, &streams[0], cookedMesh.numVertices, cookedMesh.quantization);
+			modelMesh.LoadIndexBuffer(cookedMesh.indices);
+			modelMesh.SetLODs(cookedMesh.lods);
+
+			meshes.push_back(modelMesh);
+			materials.push_back(CreateMaterial(model.directory, cookedMesh.textures));
+		}
+	}
 
-	return new StaticMeshComponent(mModelMeshes, mModelMaterials, mModelVertexPositions);
+	return new StaticMeshComponent(meshes, materials, model.positions, model.indices);
 }
 
-void ModelLoader::ProcessNode(aiNode *node, const aiScene *scene)
+void ModelLoader::ProcessNode(aiNode *node, std::vector<unsigned int> &meshes)
 {
 	for (int i = 0; i < node->mNumMeshes; i++)
-		ProcessMesh(scene->mMeshes[node->mMeshes[i]], scene);
+		meshes.push_back(node->mMeshes[i]);
 
 	for (int i = 0; i < node->mNumChildren; i++)
-		ProcessNode(node->mChildren[i], scene);
+		ProcessNode(node->mChildren[i], meshes);
+}
+
+void ModelLoader::ProcessMeshes(const aiScene *scene, StaticModelData &model)
+{
+	// meshes in node order, each imported as an independent task
+	std::vector<unsigned int> meshes;
+	ProcessNode(scene->mRootNode, meshes);
+
+	// meshes without vertices or faces have nothing to draw, bound or cook
+	meshes.erase(std::remove_if(meshes.begin(), meshes.end(), [scene](unsigned int mesh) { return !scene->mMeshes[mesh]->mNumVertices || !scene->mMeshes[mesh]->mNumFaces; }), meshes.end());
+
+	std::vector<ImportedMesh> importedMeshes(meshes.size());
+
+	ThreadPool::GetInstance().ParallelFor((unsigned int)meshes.size(), [this, scene, &meshes, &importedMeshes](unsigned int mesh)
+	{
+		ProcessMesh(scene->mMeshes[meshes[mesh]], scene, importedMeshes[mesh]);
+	});
+
+	size_t numPositions = 0, numIndices = 0;
+	for (const ImportedMesh &importedMesh : importedMeshes)
+	{
+		numPositions += importedMesh.positions.size();
+		numIndices += importedMesh.indices.size();
+	}
+
+	model.positions.reserve(numPositions);
+	model.indices.reserve(numIndices);
+	model.meshes.reserve(importedMeshes.size());
+
+	for (ImportedMesh &importedMesh : importedMeshes)
+	{
+		// model acmr, weighted by the triangles of each mesh
+		const MeshOptimizer::Statistics &statistics = importedMesh.statistics;
+		MeshOptimizer::Statistics &modelStatistics = model.statistics;
+		unsigned int numTriangles = modelStatistics.numTriangles + statistics.numTriangles;
+		if (numTriangles > 0)
+		{
+			modelStatistics.acmrBefore = (modelStatistics.acmrBefore * modelStatistics.numTriangles + statistics.acmrBefore * statistics.numTriangles) / numTriangles;
+			modelStatistics.acmrAfter = (modelStatistics.acmrAfter * modelStatistics.numTriangles + statistics.acmrAfter * statistics.numTriangles) / numTriangles;
+			modelStatistics.numTriangles = numTriangles;
+		}
+
+		// model indices refer to the concatenated vertex positions of all meshes
+		unsigned int baseVertex = model.positions.size();
+
+		for (unsigned int index : importedMesh.indices)
+			model.indices.push_back(baseVertex + index);
+
+		model.positions.insert(model.positions.end(), importedMesh.positions.begin(), importedMesh.positions.end());
+
+		model.meshes.push_back(std::move(importedMesh.cookedMesh));
+	}
 }
 
-void ModelLoader::ProcessMesh(aiMesh *mesh, const aiScene *scene)
+void ModelLoader::ProcessMesh(aiMesh *mesh, const aiScene *scene, ImportedMesh &importedMesh)
 {
+	unsigned int numVertices = mesh->mNumVertices;
+
 	// load index buffer
-	std::vector<unsigned int> indices;
+	std::vector<unsigned int> &indices = importedMesh.indices;
 
+	unsigned int numIndices = 0;
 	for (int i = 0; i < mesh->mNumFaces; i++)
+		numIndices += mesh->mFaces[i].mNumIndices;
+
+	indices.resize(numIndices);
+
+	for (unsigned int i = 0, index = 0; i < mesh->mNumFaces; i++)
 	{
 		for (int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
-			indices.push_back(mesh->mFaces[i].mIndices[j]);
+			indices[index++] = mesh->mFaces[i].mIndices[j];
 	}
 
 	// load positions
-	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> &positions = importedMesh.positions;
+	positions.resize(numVertices);
 
-	for (int i = 0; i < mesh->mNumVertices; i++)
-	{
-		positions.push_back(XMFLOAT3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z));
-		mModelVertexPositions.push_back(positions[i]);
-	}
+	for (int i = 0; i < numVertices; i++)
+		positions[i] = XMFLOAT3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
 
 	// load normals
-	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT3> normals(numVertices);
 
 	if (mesh->HasNormals())
-		for (int i = 0; i < mesh->mNumVertices; i++)
-			normals.push_back(XMFLOAT3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z));
+		for (int i = 0; i < numVertices; i++)
+			normals[i] = XMFLOAT3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
 	else  // if model has no normal, procedurally calculate them
 	{
-		std::vector<std::vector<XMFLOAT3>> accumulatedNormals(mesh->mNumVertices);
-
-		// calculate normal for each triangle and add them to each vertex in the triangle
+		// add the normal of each triangle to its vertices
 		for (int i = 0; i < indices.size(); i += 3)
 		{
-			XMFLOAT3 p0 = positions[indices[i]];
-			XMFLOAT3 p1 = positions[indices[i + 1]];
-			XMFLOAT3 p2 = positions[indices[i + 2]];
+			XMVECTOR p0 = XMLoadFloat3(&positions[indices[i]]);
+			XMVECTOR triangleNormal = XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&positions[indices[i + 1]]) - p0, XMLoadFloat3(&positions[indices[i + 2]]) - p0));
 
-			XMVECTOR v1 = XMLoadFloat3(&p1) - XMLoadFloat3(&p0);
-			XMVECTOR v2 = XMLoadFloat3(&p2) - XMLoadFloat3(&p0);
-
-			XMFLOAT3 triangleNormal;
-			XMStoreFloat3(&triangleNormal, XMVector3Normalize(XMVector3Cross(v1, v2)));
-
-			accumulatedNormals[indices[i]].push_back(triangleNormal);
-			accumulatedNormals[indices[i + 1]].push_back(triangleNormal);
-			accumulatedNormals[indices[i + 2]].push_back(triangleNormal);
+			for (int j = 0; j < 3; j++)
+				XMStoreFloat3(&normals[indices[i + j]], XMLoadFloat3(&normals[indices[i + j]]) + triangleNormal);
 		}
 
 		// average vertex normals
-		for (std::vector<XMFLOAT3> vertexNormals : accumulatedNormals)
-		{
-			XMVECTOR sum = XMVectorZero();
-
-			for (XMFLOAT3 vertexNormal : vertexNormals)
-				sum += XMLoadFloat3(&vertexNormal);
-
-			XMFLOAT3 averagedNormal;
-			XMStoreFloat3(&averagedNormal, sum / XMVector3Length(sum));
-
-			normals.push_back(averagedNormal);
-		}
+		for (XMFLOAT3 &normal : normals)
+			XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&normal)));
 	}
 
 	//load texture coordinates
-	std::vector<XMFLOAT2> textureCoordinates;
+	std::vector<XMFLOAT2> textureCoordinates(numVertices, XMFLOAT2(0.0f, 0.0f));
 
 	if (mesh->HasTextureCoords(0))
-		for (int i = 0; i < mesh->mNumVertices; i++)
-			textureCoordinates.push_back(XMFLOAT2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y));
-	else
-		for (int i = 0; i < mesh->mNumVertices; i++)
-			textureCoordinates.push_back(XMFLOAT2(0.0f, 0.0f));
+		for (int i = 0; i < numVertices; i++)
+			textureCoordinates[i] = XMFLOAT2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
 
 	// load tangents
-	std::vector<XMFLOAT3> tangents;
+	std::vector<XMFLOAT3> tangents(numVertices);
+
+	aiMaterial *material = mesh->mMaterialIndex < scene->mNumMaterials ? scene->mMaterials[mesh->mMaterialIndex] : nullptr;
 
 	if (mesh->HasTangentsAndBitangents())
-		for (int i = 0; i < mesh->mNumVertices; i++)
-			tangents.push_back(XMFLOAT3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z));
-	else  // if model has no tangents, procedurally calculate them
+		for (int i = 0; i < numVertices; i++)
+			tangents[i] = XMFLOAT3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+	else if (material && material->GetTextureCount(aiTextureType_NORMALS) > 0)    // if model has no tangents, procedurally calculate them
+		GenerateTangents(positions, normals, textureCoordinates, indices, tangents);
+	else
 	{
-		std::vector<std::vector<XMFLOAT3>> accumulatedTangents(mesh->mNumVertices);
-
-		for (int i = 0; i < indices.size(); i += 3)
-		{
-			XMFLOAT3 p0 = positions[indices[i]];
-			XMFLOAT3 p1 = positions[indices[i + 1]];
-			XMFLOAT3 p2 = positions[indices[i + 2]];
-
-			XMVECTOR v1 = XMLoadFloat3(&p1) - XMLoadFloat3(&p0);
-			XMVECTOR v2 = XMLoadFloat3(&p2) - XMLoadFloat3(&p0);
-
-			float du1 = textureCoordinates[indices[i + 1]].x - textureCoordinates[indices[i]].x;
-			float dv1 = textureCoordinates[indices[i + 1]].y - textureCoordinates[indices[i]].y;
-			float du2 = textureCoordinates[indices[i + 2]].x - textureCoordinates[indices[i]].x;
-			float dv2 = textureCoordinates[indices[i + 2]].y - textureCoordinates[indices[i]].y;
+		// no normal map to orient: any tangent perpendicular to the normal will do
+		for (int i = 0; i < numVertices; i++)
+			XMStoreFloat3(&tangents[i], XMVector3Normalize(XMVector3Orthogonal(XMLoadFloat3(&normals[i]))));
+	}
 
-			float det = du1 * dv2 - dv1 * du2;
+	// reorder triangles for the vertex cache and overdraw, then vertices in order of use
+	std::vector<unsigned int> remap;
+	importedMesh.statistics = MeshOptimizer::Optimize(indices, positions, remap);
 
-			XMFLOAT3 triangleTangent;
-			XMStoreFloat3(&triangleTangent, (dv2 * v1 - dv1 * v2) / det);
+	MeshOptimizer::RemapVertices(positions, remap);
+	MeshOptimizer::RemapVertices(normals, remap);
+	MeshOptimizer::RemapVertices(tangents, remap);
+	MeshOptimizer::RemapVertices(textureCoordinates, remap);
 
-			accumulatedTangents[indices[i]].push_back(triangleTangent);
-			accumulatedTangents[indices[i + 1]].push_back(triangleTangent);
-			accumulatedTangents[indices[i + 2]].push_back(triangleTangent);
-		}
+	// pack the vertices as they are uploaded and cooked, the gpu buffers are created from them by CreateStaticModel
+	const VertexLayout &layout = VertexLayout::GetStaticMeshLayout();
+	VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], (unsigned int)positions.size() };
 
-		// average vertex tangents
-		for (std::vector<XMFLOAT3> vertexTangents : accumulatedTangents)
-		{
-			XMVECTOR sum = XMVectorZero();
+	MeshFile::CookedMesh &cookedMesh = importedMesh.cookedMesh;
+	cookedMesh.numVertices = sources.numVertices;
+	cookedMesh.quantization = layout.ComputeQuantization(sources);
+	cookedMesh.streams.resize(layout.GetNumStreams());
 
-			for (XMFLOAT3 vertexTangent : vertexTangents)
-				sum += XMLoadFloat3(&vertexTangent);
+	for (unsigned int stream = 0; stream < layout.GetNumStreams(); stream++)
+		layout.PackStream(stream, sources, cookedMesh.quantization, cookedMesh.streams[stream]);
 
-			XMFLOAT3 averagedTangent;
-			XMStoreFloat3(&averagedTangent, sum / XMVector3Length(sum));
-
-			tangents.push_back(averagedTangent);
-		}
+	cookedMesh.boundsMin = cookedMesh.boundsMax = positions[0];
+	for (const XMFLOAT3 &position : positions)
+	{
+		XMStoreFloat3(&cookedMesh.boundsMin, XMVectorMin(XMLoadFloat3(&cookedMesh.boundsMin), XMLoadFloat3(&position)));
+		XMStoreFloat3(&cookedMesh.boundsMax, XMVectorMax(XMLoadFloat3(&cookedMesh.boundsMax), XMLoadFloat3(&position)));
 	}
 
-	// load vertex attributes and index buffer
-	Mesh modelMesh;
-
-	modelMesh.LoadAttribute("POSITION", &positions[0], positions.size());
-	modelMesh.LoadAttribute("NORMAL", &normals[0], normals.size());
-	modelMesh.LoadAttribute("TANGENT", &tangents[0], tangents.size());
-	modelMesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], textureCoordinates.size());
-	modelMesh.LoadIndexBuffer(indices);
-
-	mModelMeshes.push_back(modelMesh);
+	// detail levels follow the full detail indices in the index buffer
+	cookedMesh.lods = MeshSimplifier(positions, normals, textureCoordinates, indices).BuildLODChain(cookedMesh.indices);
 
-	// load materials
-	Material modelMaterial;
-
-	if (mesh->mMaterialIndex >= 0)
+	// material textures
+	if (material)
 	{
-		aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-
-		std::vector<Texture> diffuseMaps = LoadMaterials(material, aiTextureType_DIFFUSE);
-		modelMaterial.AddDiffuseMaps(diffuseMaps);
-
-		std::vector<Texture> specularMaps = LoadMaterials(material, aiTextureType_SPECULAR);
-		modelMaterial.AddSpecularMaps(specularMaps);
-		
-		std::vector<Texture> normalMaps = LoadMaterials(material, aiTextureType_NORMALS);
-		modelMaterial.AddNormalMaps(normalMaps);
-
-		mModelMaterials.push_back(modelMaterial);
+		cookedMesh.textures[(unsigned int)MeshFile::TextureType::DIFFUSE] = GetTextureNames(material, aiTextureType_DIFFUSE);
+		cookedMesh.textures[(unsigned int)MeshFile::TextureType::SPECULAR] = GetTextureNames(material, aiTextureType_SPECULAR);
+		cookedMesh.textures[(unsigned int)MeshFile::TextureType::NORMAL] = GetTextureNames(material, aiTextureType_NORMALS);
 	}
 }
 
-std::vector<Texture> ModelLoader::LoadMaterials(aiMaterial *material, aiTextureType aiType)
+std::vector<std::string> ModelLoader::GetTextureNames(aiMaterial *material, aiTextureType aiType)
 {
-	std::vector<Texture> textures;
+	std::vector<std::string> names;
 
 	for (int i = 0; i < material->GetTextureCount(aiType); i++)
 	{
 		aiString s;
 		material->GetTexture(aiType, i, &s);
-		std::string path(mDirectory + "/");
-		path.append(s.C_Str());
-
-		Texture texture = TextureManager::GetInstance().GetTexture(path);
-		textures.push_back(texture);
+		names.push_back(s.C_Str());
 	}
 
-	return textures;
+	return names;
+}
+
+Material ModelLoader::CreateMaterial(const std::string &directory, const std::vector<std::string> (&textures)[MeshFile::NUM_TEXTURE_TYPES])
+{
+	Material material;
+
+	for (const std::string &name : textures[(unsigned int)MeshFile::TextureType::DIFFUSE])
+		material.AddDiffuseMap(directory + "/" + name);
+
+	for (const std::string &name : textures[(unsigned int)MeshFile::TextureType::SPECULAR])
+		material.AddSpecularMap(directory + "/" + name);
+
+	for (const std::string &name : textures[(unsigned int)MeshFile::TextureType::NORMAL])
+		material.AddNormalMap(directory + "/" + name);
+
+	return material;
 }
 
 //SkeletalMeshComponent *ModelLoader::LoadSkeletalModel(const std::string &filePath)
@@ -219,7 +498,7 @@ std::vector<Texture> ModelLoader::LoadMaterials(aiMaterial *material, aiTextureT
 //	mSkeleton->Load(filePath);
 //
 //	Assimp::Importer importer;
-//	const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs);
+//	const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs);
 //
 //	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 //		ErrorBox(importer.GetErrorString());
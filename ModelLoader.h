@@ -6,6 +6,8 @@
 #include "assimp/scene.h"
 #include "Texture.h"
 #include "Material.h"
+#include "MeshOptimizer.h"
+#include "MeshFile.h"
 
 using namespace DirectX;
 
@@ -15,21 +17,42 @@ class Mesh;
 
 class ModelLoader
 {
+public:
+	struct StaticModelData       // everything but the gpu resources of a static model
+	{
+		std::string directory;
+		MeshFile cookedFile;                          // open if the model was cooked by a previous import, the meshes are created from its blobs
+		std::vector<MeshFile::CookedMesh> meshes;     // imported meshes otherwise
+		std::vector<XMFLOAT3> positions;              // all meshes, for collision
+		std::vector<unsigned int> indices;
+		MeshOptimizer::Statistics statistics;         // vertex cache efficiency before and after the mesh optimisation, zero if loaded cooked
+		std::vector<std::string> importedFiles;       // read by the import: the model and its material libraries
+	};
 public:
 	static ModelLoader &GetInstance();
 	StaticMeshComponent *LoadStaticModel(const std::string &filePath);
+	// the two halves of LoadStaticModel for background loading: reading doesn't touch the render device and is thread safe,
+	// creating runs on the render thread. import ignores the cooked file (asset cook)
+	bool ReadStaticModel(const std::string &filePath, StaticModelData &model, std::string &error, bool import = false);
+	StaticMeshComponent *CreateStaticModel(StaticModelData &model);
 	SkeletalMeshComponent *LoadSkeletalModel(const std::string &filePath);
 private:
+	struct ImportedMesh          // a mesh imported on its own
+	{
+		MeshFile::CookedMesh cookedMesh;
+		std::vector<XMFLOAT3> positions;
+		std::vector<unsigned int> indices;
+		MeshOptimizer::Statistics statistics;
+	};
+
 	ModelLoader() = default;
-	void ProcessNode(aiNode *node, const aiScene *scene);
+	void ProcessNode(aiNode *node, std::vector<unsigned int> &meshes);
+	void ProcessMeshes(const aiScene *scene, StaticModelData &model);      // meshes are imported in parallel, then concatenated in node order
 	void ProcessSkeletalNode(aiNode *node, const aiScene *scene);
-	void ProcessMesh(aiMesh *mesh, const aiScene *scene);
+	void ProcessMesh(aiMesh *mesh, const aiScene *scene, ImportedMesh &importedMesh);
 	void ProcessSkeletalMesh(aiMesh *mesh, const aiScene *scene);
-	std::vector<Texture> LoadMaterials(aiMaterial *material, aiTextureType type);
-	std::string mDirectory;
-	std::vector<XMFLOAT3> mModelVertexPositions;
-	std::vector<Mesh> mModelMeshes;
-	std::vector<Material> mModelMaterials;
+	std::vector<std::string> GetTextureNames(aiMaterial *material, aiTextureType type);
+	Material CreateMaterial(const std::string &directory, const std::vector<std::string> (&textures)[MeshFile::NUM_TEXTURE_TYPES]);
 	//Skeleton *mSkeleton;
 };
 
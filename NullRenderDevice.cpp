@@ -0,0 +1,325 @@
+#include "NullRenderDevice.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace
+{
+	// render states and topologies are enumerators, tracked as non null pointers like the bound resources
+	template <typename T>
+	const void *StateKey(T state)
+	{
+		return reinterpret_cast<const void*>(static_cast<uintptr_t>(state) + 1);
+	}
+}
+
+NullRenderDevice::NullRenderDevice(unsigned int width, unsigned int height)
+{
+	mBackBufferWidth = width;
+	mBackBufferHeight = height;
+
+	mBackBuffer.width = mBackBufferDepth.width = width;
+	mBackBuffer.height = mBackBufferDepth.height = height;
+
+	mCurrentRenderTarget = GetBackBufferTarget();
+	mCurrentDepthTarget = GetBackBufferDepthTarget();
+	mViewport = { 0.0f, 0.0f, (float)width, (float)height };
+
+	ResetStatistics();
+	mLastFrameStatistics = mStatistics;
+}
+
+NullRenderDevice::~NullRenderDevice()
+{
+	for (NullResource *pipelineObject : mPipelineObjects)
+		delete pipelineObject;
+}
+
+void NullRenderDevice::ResetStatistics()
+{
+	memset(&mStatistics, 0, sizeof(Statistics));
+}
+
+NullRenderDevice::NullResource *NullRenderDevice::CreateResource(unsigned int size, unsigned int width, unsigned int height)
+{
+	NullResource *resource = new NullResource;
+	resource->data.resize(size);
+	resource->width = width;
+	resource->height = height;
+
+	return resource;
+}
+
+NullRenderDevice::NullResource *NullRenderDevice::CreatePipelineObject(unsigned int width)
+{
+	NullResource *pipelineObject = CreateResource(0, width, 0);      // distinct objects, so that shader and sampler rebinds are told apart
+	mPipelineObjects.push_back(pipelineObject);
+
+	return pipelineObject;
+}
+
+/**** recording ****/
+
+void NullRenderDevice::Record(Command command, unsigned int slot, const void *resource, unsigned int count, unsigned int instances, bool redundant)
+{
+	mStatistics.commands[static_cast<int>(command)]++;
+
+	if (mRecording)
+		mCommandLog.push_back({ command, slot, resource, count, instances, redundant });
+}
+
+void NullRenderDevice::RecordStateChange(Command command, unsigned int slot, const void *resource, const void *&boundResource)
+{
+	bool redundant = resource == boundResource;
+
+	mStatistics.stateChanges++;
+	if (redundant)
+		mStatistics.redundantStateChanges++;
+
+	boundResource = resource;
+
+	Record(command, slot, resource, 0, 0, redundant);
+}
+
+void NullRenderDevice::RecordDraw(Command command, unsigned int count, unsigned int instances)
+{
+	mStatistics.drawCalls++;
+	mStatistics.instances += instances;
+
+	unsigned int primitives = mTopology == Topology::TRIANGLE_LIST ? count / 3 : (count > 2 ? count - 2 : 0);
+	mStatistics.primitives += primitives * instances;
+
+	Record(command, 0, nullptr, count, instances, false);
+}
+
+/**** resources ****/
+
+BufferHandle NullRenderDevice::CreateBuffer(BufferType type, Usage usage, unsigned int size, const void *data)
+{
+	NullResource *buffer = CreateResource(size, size, 1);
+
+	if (data)
+		memcpy(buffer->data.data(), data, size);
+
+	return reinterpret_cast<BufferHandle>(buffer);
+}
+
+void NullRenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	delete reinterpret_cast<NullResource*>(buffer);
+}
+
+void *NullRenderDevice::Map(BufferHandle buffer, MapMode mode)
+{
+	NullResource *resource = reinterpret_cast<NullResource*>(buffer);
+
+	mStatistics.bytesUpdated += (unsigned int)resource->data.size();
+	Record(Command::MAP, 0, resource, (unsigned int)resource->data.size(), 0, false);
+
+	return resource->data.data();
+}
+
+TextureHandle NullRenderDevice::CreateTexture(unsigned int width, unsigned int height, Format format, const void *data)
+{
+	return reinterpret_cast<TextureHandle>(CreateResource(0, width, height));     // texel data is never read back
+}
+
+TextureHandle NullRenderDevice::LoadTexture(const std::string &filePath)
+{
+	return reinterpret_cast<TextureHandle>(CreateResource(0, 1, 1));              // no file access when headless
+}
+
+bool NullRenderDevice::DecodeTexture(const std::string &filePath, TextureData &textureData) const
+{
+	textureData = TextureData{ 1, 1, 1, Format::R8G8B8A8_UNORM, false, std::vector<uint8_t>(4, 255) };    // no file access when headless
+
+	return true;
+}
+
+TextureHandle NullRenderDevice::CreateTexture(const TextureData &textureData, unsigned int firstMip)
+{
+	return reinterpret_cast<TextureHandle>(CreateResource(0, std::max(textureData.width >> firstMip, 1u), std::max(textureData.height >> firstMip, 1u)));
+}
+
+void NullRenderDevice::UpdateTexture(TextureHandle texture, const void *data, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int rowPitch)
+{
+	mStatistics.bytesUpdated += rowPitch * height;
+	Record(Command::UPDATE_TEXTURE, 0, texture, rowPitch * height, 0, false);
+}
+
+void NullRenderDevice::ReleaseTexture(TextureHandle texture)
+{
+	delete reinterpret_cast<NullResource*>(texture);
+}
+
+RenderTargetHandle NullRenderDevice::CreateRenderTarget(unsigned int width, unsigned int height, TextureHandle &colorTexture)
+{
+	colorTexture = reinterpret_cast<TextureHandle>(CreateResource(0, width, height));
+
+	return reinterpret_cast<RenderTargetHandle>(CreateResource(0, width, height));
+}
+
+DepthTargetHandle NullRenderDevice::CreateDepthTarget(unsigned int width, unsigned int height, TextureHandle &depthTexture)
+{
+	depthTexture = reinterpret_cast<TextureHandle>(CreateResource(0, width, height));
+
+	return reinterpret_cast<DepthTargetHandle>(CreateResource(0, width, height));
+}
+
+void NullRenderDevice::ReleaseRenderTarget(RenderTargetHandle renderTarget)
+{
+	delete reinterpret_cast<NullResource*>(renderTarget);
+}
+
+void NullRenderDevice::ReleaseDepthTarget(DepthTargetHandle depthTarget)
+{
+	delete reinterpret_cast<NullResource*>(depthTarget);
+}
+
+SamplerHandle NullRenderDevice::CreateSampler(Filter filter, AddressMode addressMode)
+{
+	return reinterpret_cast<SamplerHandle>(CreatePipelineObject(0));
+}
+
+ShaderHandle NullRenderDevice::CreateShader(const wchar_t *vertexShaderFilePath, const wchar_t *geometryShaderFilePath, const wchar_t *pixelShaderFilePath)
+{
+	return reinterpret_cast<ShaderHandle>(CreatePipelineObject(0));               // shaders are not compiled when headless
+}
+
+InputLayoutHandle NullRenderDevice::CreateInputLayout(ShaderHandle shader, const InputElement *elements, unsigned int numElements)
+{
+	return reinterpret_cast<InputLayoutHandle>(CreatePipelineObject(numElements));
+}
+
+/**** pipeline state ****/
+
+void NullRenderDevice::SetShader(ShaderHandle shader, InputLayoutHandle inputLayout)
+{
+	RecordStateChange(Command::SET_SHADER, 0, shader, mBoundShader);
+}
+
+void NullRenderDevice::SetPrimitiveTopology(Topology topology)
+{
+	mTopology = topology;
+
+	RecordStateChange(Command::SET_PRIMITIVE_TOPOLOGY, 0, StateKey(topology), mBoundTopology);
+}
+
+void NullRenderDevice::SetVertexBuffers(unsigned int firstSlot, unsigned int numBuffers, const BufferHandle *buffers, const unsigned int *strides)
+{
+	for (unsigned int i = 0; i < numBuffers; i++)
+	{
+		unsigned int slot = firstSlot + i;
+
+		if (slot < MAX_SLOTS)
+			RecordStateChange(Command::SET_VERTEX_BUFFER, slot, buffers[i], mBoundVertexBuffers[slot]);
+	}
+}
+
+void NullRenderDevice::SetIndexBuffer(BufferHandle buffer)
+{
+	RecordStateChange(Command::SET_INDEX_BUFFER, 0, buffer, mBoundIndexBuffer);
+}
+
+void NullRenderDevice::SetConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer)
+{
+	if (slot < MAX_SLOTS)
+		RecordStateChange(Command::SET_CONSTANT_BUFFER, slot, buffer, mBoundConstantBuffers[static_cast<int>(stage)][slot]);
+}
+
+void NullRenderDevice::SetTexture(ShaderStage stage, unsigned int slot, TextureHandle texture)
+{
+	if (slot < MAX_SLOTS)
+		RecordStateChange(Command::SET_TEXTURE, slot, texture, mBoundTextures[static_cast<int>(stage)][slot]);
+}
+
+void NullRenderDevice::SetSampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler)
+{
+	if (slot < MAX_SLOTS)
+		RecordStateChange(Command::SET_SAMPLER, slot, sampler, mBoundSamplers[static_cast<int>(stage)][slot]);
+}
+
+void NullRenderDevice::SetRasterizerState(RasterizerState state)
+{
+	RecordStateChange(Command::SET_RASTERIZER_STATE, 0, StateKey(state), mBoundRasterizerState);
+}
+
+void NullRenderDevice::SetBlendState(BlendState state)
+{
+	RecordStateChange(Command::SET_BLEND_STATE, 0, StateKey(state), mBoundBlendState);
+}
+
+void NullRenderDevice::SetDepthStencilState(DepthStencilState state)
+{
+	RecordStateChange(Command::SET_DEPTH_STENCIL_STATE, 0, StateKey(state), mBoundDepthStencilState);
+}
+
+void NullRenderDevice::SetRenderTargets(RenderTargetHandle renderTarget, DepthTargetHandle depthTarget)
+{
+	bool redundant = renderTarget == mCurrentRenderTarget && depthTarget == mCurrentDepthTarget;
+
+	mStatistics.stateChanges++;
+	if (redundant)
+		mStatistics.redundantStateChanges++;
+
+	mCurrentRenderTarget = renderTarget;
+	mCurrentDepthTarget = depthTarget;
+
+	Record(Command::SET_RENDER_TARGETS, 0, renderTarget ? (const void*)renderTarget : (const void*)depthTarget, 0, 0, redundant);
+}
+
+void NullRenderDevice::GetRenderTargets(RenderTargetHandle &renderTarget, DepthTargetHandle &depthTarget) const
+{
+	renderTarget = mCurrentRenderTarget;
+	depthTarget = mCurrentDepthTarget;
+}
+
+void NullRenderDevice::SetViewport(const Viewport &viewport)
+{
+	mViewport = viewport;
+
+	Record(Command::SET_VIEWPORT, 0, nullptr, 0, 0, false);
+}
+
+/**** commands ****/
+
+void NullRenderDevice::ClearRenderTarget(RenderTargetHandle renderTarget, const float color[4])
+{
+	Record(Command::CLEAR_RENDER_TARGET, 0, renderTarget, 0, 0, false);
+}
+
+void NullRenderDevice::ClearDepthTarget(DepthTargetHandle depthTarget)
+{
+	Record(Command::CLEAR_DEPTH_TARGET, 0, depthTarget, 0, 0, false);
+}
+
+void NullRenderDevice::Draw(unsigned int vertexCount, unsigned int firstVertex)
+{
+	RecordDraw(Command::DRAW, vertexCount, 1);
+}
+
+void NullRenderDevice::DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex)
+{
+	RecordDraw(Command::DRAW_INDEXED, indexCount, 1);
+}
+
+void NullRenderDevice::DrawInstanced(unsigned int vertexCount, unsigned int instanceCount, unsigned int firstVertex, unsigned int firstInstance)
+{
+	RecordDraw(Command::DRAW_INSTANCED, vertexCount, instanceCount);
+}
+
+void NullRenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int firstIndex, int baseVertex, unsigned int firstInstance)
+{
+	RecordDraw(Command::DRAW_INDEXED_INSTANCED, indexCount, instanceCount);
+}
+
+void NullRenderDevice::Present()
+{
+	Record(Command::PRESENT, 0, nullptr, 0, 0, false);
+
+	// a frame ends at present: keep its statistics and start counting the next one
+	mLastFrameStatistics = mStatistics;
+	mFrameCount++;
+
+	ResetStatistics();
+}
@@ -0,0 +1,157 @@
+#ifndef NULL_RENDER_DEVICE_H
+#define NULL_RENDER_DEVICE_H
+
+#include "RenderDevice.h"
+#include <vector>
+
+/**** headless render device: resources are plain memory and nothing is drawn ****/
+/**** every state change, update and draw is counted (and optionally recorded) so the cpu cost of submission can be measured without a gpu ****/
+
+class NullRenderDevice : public RenderDevice
+{
+public:
+	enum class Command
+	{
+		SET_SHADER, SET_PRIMITIVE_TOPOLOGY, SET_VERTEX_BUFFER, SET_INDEX_BUFFER, SET_CONSTANT_BUFFER, SET_TEXTURE, SET_SAMPLER,
+		SET_RASTERIZER_STATE, SET_BLEND_STATE, SET_DEPTH_STENCIL_STATE, SET_RENDER_TARGETS, SET_VIEWPORT,
+		MAP, UPDATE_TEXTURE, CLEAR_RENDER_TARGET, CLEAR_DEPTH_TARGET,
+		DRAW, DRAW_INDEXED, DRAW_INSTANCED, DRAW_INDEXED_INSTANCED, PRESENT,
+		COUNT,
+	};
+	struct CommandRecord
+	{
+		Command command;
+		unsigned int slot;           // binding slot (vertex buffers, constant buffers, textures and samplers)
+		const void *resource;        // bound resource or state, null for commands without one
+		unsigned int count;          // vertices or indices for draws, bytes for updates
+		unsigned int instances;
+		bool redundant;              // state change that rebinds what is already bound
+	};
+	struct Statistics
+	{
+		unsigned int commands[static_cast<int>(Command::COUNT)];
+		unsigned int drawCalls;
+		unsigned int instances;
+		unsigned int primitives;
+		unsigned int stateChanges;
+		unsigned int redundantStateChanges;
+		unsigned int bytesUpdated;
+	};
+public:
+	NullRenderDevice(unsigned int width, unsigned int height);
+	~NullRenderDevice();
+
+	void SetRecording(bool recording) { mRecording = recording; }
+	bool IsRecording() const { return mRecording; }
+
+	const std::vector<CommandRecord> &GetCommandLog() const { return mCommandLog; }
+	void ClearCommandLog() { mCommandLog.clear(); }
+
+	const Statistics &GetStatistics() const { return mStatistics; }                      // since the last present
+	const Statistics &GetLastFrameStatistics() const { return mLastFrameStatistics; }
+	unsigned int GetFrameCount() const { return mFrameCount; }
+	void ResetStatistics();
+
+	RenderTargetHandle GetBackBufferTarget() const override { return reinterpret_cast<RenderTargetHandle>(const_cast<NullResource*>(&mBackBuffer)); }
+	DepthTargetHandle GetBackBufferDepthTarget() const override { return reinterpret_cast<DepthTargetHandle>(const_cast<NullResource*>(&mBackBufferDepth)); }
+
+	BufferHandle CreateBuffer(BufferType type, Usage usage, unsigned int size, const void *data) override;
+	void ReleaseBuffer(BufferHandle buffer) override;
+
+	void *Map(BufferHandle buffer, MapMode mode) override;
+	void Unmap(BufferHandle buffer) override {}
+
+	TextureHandle CreateTexture(unsigned int width, unsigned int height, Format format, const void *data) override;
+	TextureHandle LoadTexture(const std::string &filePath) override;
+	bool DecodeTexture(const std::string &filePath, TextureData &textureData) const override;
+	TextureHandle CreateTexture(const TextureData &textureData, unsigned int firstMip) override;
+	void UpdateTexture(TextureHandle texture, const void *data, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int rowPitch) override;
+	void ReleaseTexture(TextureHandle texture) override;
+
+	RenderTargetHandle CreateRenderTarget(unsigned int width, unsigned int height, TextureHandle &colorTexture) override;
+	DepthTargetHandle CreateDepthTarget(unsigned int width, unsigned int height, TextureHandle &depthTexture) override;
+	void ReleaseRenderTarget(RenderTargetHandle renderTarget) override;
+	void ReleaseDepthTarget(DepthTargetHandle depthTarget) override;
+
+	SamplerHandle CreateSampler(Filter filter, AddressMode addressMode) override;
+
+	ShaderHandle CreateShader(const wchar_t *vertexShaderFilePath, const wchar_t *geometryShaderFilePath, const wchar_t *pixelShaderFilePath) override;
+	InputLayoutHandle CreateInputLayout(ShaderHandle shader, const InputElement *elements, unsigned int numElements) override;
+
+	void SetShader(ShaderHandle shader, InputLayoutHandle inputLayout) override;
+	void SetPrimitiveTopology(Topology topology) override;
+
+	void SetVertexBuffers(unsigned int firstSlot, unsigned int numBuffers, const BufferHandle *buffers, const unsigned int *strides) override;
+	void SetIndexBuffer(BufferHandle buffer) override;
+	void SetConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) override;
+	void SetTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) override;
+	void SetSampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) override;
+
+	void SetRasterizerState(RasterizerState state) override;
+	void SetBlendState(BlendState state) override;
+	void SetDepthStencilState(DepthStencilState state) override;
+
+	void SetRenderTargets(RenderTargetHandle renderTarget, DepthTargetHandle depthTarget) override;
+	void GetRenderTargets(RenderTargetHandle &renderTarget, DepthTargetHandle &depthTarget) const override;
+
+	void SetViewport(const Viewport &viewport) override;
+	Viewport GetViewport() const override { return mViewport; }
+
+	void ClearRenderTarget(RenderTargetHandle renderTarget, const float color[4]) override;
+	void ClearDepthTarget(DepthTargetHandle depthTarget) override;
+
+	void Draw(unsigned int vertexCount, unsigned int firstVertex) override;
+	void DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex) override;
+	void DrawInstanced(unsigned int vertexCount, unsigned int instanceCount, unsigned int firstVertex, unsigned int firstInstance) override;
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int firstIndex, int baseVertex, unsigned int firstInstance) override;
+
+	void Present() override;
+private:
+	struct NullResource
+	{
+		std::vector<unsigned char> data;     // buffer contents, so that mapped writes land somewhere
+		unsigned int width;
+		unsigned int height;
+	};
+
+	static const unsigned int MAX_SLOTS = 16;   // tracked binding slots per stage
+	static const unsigned int NUM_STAGES = 3;
+
+	NullResource *CreateResource(unsigned int size, unsigned int width, unsigned int height);
+	NullResource *CreatePipelineObject(unsigned int width);     // samplers, shaders and input layouts have no release call: the device owns them
+
+	void Record(Command command, unsigned int slot, const void *resource, unsigned int count, unsigned int instances, bool redundant);
+	void RecordStateChange(Command command, unsigned int slot, const void *resource, const void *&boundResource);  // counts redundant rebinds
+	void RecordDraw(Command command, unsigned int count, unsigned int instances);
+
+	NullResource mBackBuffer;
+	NullResource mBackBufferDepth;
+
+	std::vector<NullResource*> mPipelineObjects;
+
+	bool mRecording = false;
+	std::vector<CommandRecord> mCommandLog;
+
+	Statistics mStatistics;
+	Statistics mLastFrameStatistics;
+	unsigned int mFrameCount = 0;
+
+	// currently bound state, to detect redundant state changes
+	const void *mBoundShader = nullptr;
+	const void *mBoundTopology = nullptr;
+	const void *mBoundVertexBuffers[MAX_SLOTS] = {};
+	const void *mBoundIndexBuffer = nullptr;
+	const void *mBoundConstantBuffers[NUM_STAGES][MAX_SLOTS] = {};
+	const void *mBoundTextures[NUM_STAGES][MAX_SLOTS] = {};
+	const void *mBoundSamplers[NUM_STAGES][MAX_SLOTS] = {};
+	const void *mBoundRasterizerState = nullptr;
+	const void *mBoundBlendState = nullptr;
+	const void *mBoundDepthStencilState = nullptr;
+
+	Topology mTopology = Topology::TRIANGLE_LIST;
+	RenderTargetHandle mCurrentRenderTarget;
+	DepthTargetHandle mCurrentDepthTarget;
+	Viewport mViewport;
+};
+
+#endif  // NULL_RENDER_DEVICE_H
@@ -0,0 +1,261 @@
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace
+{
+	const float MIN_W = 1e-4f;       // clip space w below which a vertex is considered to cross the near plane
+}
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height)
+{
+	// width is a multiple of the 4 pixels rasterised at a time, both sizes are multiples of the tile size
+	mWidth = (std::max(width, TILE_SIZE) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+	mHeight = (std::max(height, TILE_SIZE) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+
+	mTilesWidth = mWidth / TILE_SIZE;
+	mTilesHeight = mHeight / TILE_SIZE;
+
+	mDepthBuffer.assign(mWidth * mHeight, 1.0f);
+	mTileMaxDepth.assign(mTilesWidth * mTilesHeight, 1.0f);
+
+	XMStoreFloat4x4(&mViewProjectionMatrix, XMMatrixIdentity());
+}
+
+void OcclusionCuller::BeginFrame(const XMFLOAT4X4 &viewProjectionMatrix)
+{
+	mViewProjectionMatrix = viewProjectionMatrix;
+
+	std::fill(mDepthBuffer.begin(), mDepthBuffer.end(), 1.0f);
+	std::fill(mTileMaxDepth.begin(), mTileMaxDepth.end(), 1.0f);
+
+	mOccluders.clear();
+	mNumTriangles = 0;
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices, const XMFLOAT4X4 &worldMatrix)
+{
+	if (indices.size() < 3)
+		return;
+
+	mOccluders.push_back(Occluder{ &vertices, &indices, worldMatrix, mNumTriangles });
+	mNumTriangles += (unsigned int)indices.size() / 3;
+}
+
+void OcclusionCuller::RasteriseOccluders()
+{
+	if (mOccluders.empty())
+		return;
+
+	if (mTriangles.size() < mNumTriangles)
+		mTriangles.resize(mNumTriangles);
+
+	// transform occluders to screen space, then rasterise bands of rows - each task writes its own rows only
+	ThreadPool::GetInstance().ParallelFor((unsigned int)mOccluders.size(), [this](unsigned int occluder) { SetupTriangles(mOccluders[occluder]); });
+	ThreadPool::GetInstance().ParallelFor((mHeight + BAND_HEIGHT - 1) / BAND_HEIGHT, [this](unsigned int band) { RasteriseBand(band); });
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder &occluder)
+{
+	const std::vector<XMFLOAT3> &vertices = *occluder.vertices;
+	const std::vector<unsigned int> &indices = *occluder.indices;
+
+	XMMATRIX worldViewProjectionMatrix = XMMatrixMultiply(XMLoadFloat4x4(&occluder.worldMatrix), XMLoadFloat4x4(&mViewProjectionMatrix));
+
+	unsigned int numTriangles = (unsigned int)indices.size() / 3;
+
+	for (unsigned int t = 0; t < numTriangles; t++)
+	{
+		ScreenTriangle &triangle = mTriangles[occluder.firstTriangle + t];
+		triangle.valid = true;
+
+		for (int v = 0; v < 3; v++)
+		{
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&vertices[indices[t * 3 + v]]), worldViewProjectionMatrix));
+
+			if (clip.w < MIN_W)
+			{
+				triangle.valid = false;
+				break;
+			}
+
+			// clip space to pixel coordinates, y down
+			float inverseW = 1.0f / clip.w;
+			triangle.x[v] = (clip.x * inverseW * 0.5f + 0.5f) * mWidth;
+			triangle.y[v] = (0.5f - clip.y * inverseW * 0.5f) * mHeight;
+			triangle.z[v] = clip.z * inverseW;
+		}
+	}
+}
+
+void OcclusionCuller::RasteriseBand(unsigned int band)
+{
+	unsigned int firstRow = band * BAND_HEIGHT;
+	unsigned int lastRow = std::min(firstRow + BAND_HEIGHT, mHeight);   // exclusive
+
+	const XMVECTOR pixelOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+
+	for (unsigned int t = 0; t < mNumTriangles; t++)
+	{
+		const ScreenTriangle &triangle = mTriangles[t];
+		if (!triangle.valid)
+			continue;
+
+		// triangle bounds clipped to the band
+		float minY = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+		float maxY = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+
+		int rowStart = std::max((int)floorf(minY), (int)firstRow);
+		int rowEnd = std::min((int)ceilf(maxY), (int)lastRow);    // exclusive
+		if (rowStart >= rowEnd)
+			continue;
+
+		float minX = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+		float maxX = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+
+		int columnStart = std::max((int)floorf(minX), 0) & ~3;
+		int columnEnd = std::min((int)ceilf(maxX), (int)mWidth);  // exclusive
+		if (columnStart >= columnEnd)
+			continue;
+
+		// occluders are rasterised double sided: orient the triangle counterclockwise (on screen)
+		float x0 = triangle.x[0], y0 = triangle.y[0], z0 = triangle.z[0];
+		float x1 = triangle.x[1], y1 = triangle.y[1], z1 = triangle.z[1];
+		float x2 = triangle.x[2], y2 = triangle.y[2], z2 = triangle.z[2];
+
+		float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+		if (fabs(area) < 1e-6f)
+			continue;
+
+		if (area < 0.0f)
+		{
+			std::swap(x1, x2); std::swap(y1, y2); std::swap(z1, z2);
+			area = -area;
+		}
+
+		// edge functions: weight of vertex i is w_i(x, y) = a_i * x + b_i * y + c_i, inside if all weights are not negative
+		float a0 = y1 - y2, b0 = x2 - x1, c0 = x1 * y2 - x2 * y1;
+		float a1 = y2 - y0, b1 = x0 - x2, c1 = x2 * y0 - x0 * y2;
+		float a2 = y0 - y1, b2 = x1 - x0, c2 = x0 * y1 - x1 * y0;
+
+		// depth is linear in screen space: z = (w0 * z0 + w1 * z1 + w2 * z2) / area
+		float inverseArea = 1.0f / area;
+		XMVECTOR z0V = XMVectorReplicate(z0 * inverseArea), z1V = XMVectorReplicate(z1 * inverseArea), z2V = XMVectorReplicate(z2 * inverseArea);
+		XMVECTOR a0V = XMVectorReplicate(a0), a1V = XMVectorReplicate(a1), a2V = XMVectorReplicate(a2);
+
+		for (int row = rowStart; row < rowEnd; row++)
+		{
+			float y = row + 0.5f;
+			float *depthRow = &mDepthBuffer[row * mWidth];
+
+			for (int column = columnStart; column < columnEnd; column += 4)
+			{
+				XMVECTOR x = XMVectorReplicate((float)column) + pixelOffsets;
+
+				XMVECTOR w0 = a0V * x + XMVectorReplicate(b0 * y + c0);
+				XMVECTOR w1 = a1V * x + XMVectorReplicate(b1 * y + c1);
+				XMVECTOR w2 = a2V * x + XMVectorReplicate(b2 * y + c2);
+
+				XMVECTOR inside = XMVectorAndInt(XMVectorAndInt(XMVectorGreaterOrEqual(w0, XMVectorZero()), XMVectorGreaterOrEqual(w1, XMVectorZero())), XMVectorGreaterOrEqual(w2, XMVectorZero()));
+				if (XMVector4EqualInt(inside, XMVectorZero()))
+					continue;
+
+				XMVECTOR depth = w0 * z0V + w1 * z1V + w2 * z2V;
+
+				XMFLOAT4 *pixels = reinterpret_cast<XMFLOAT4*>(&depthRow[column]);
+				XMVECTOR bufferDepth = XMLoadFloat4(pixels);
+
+				XMStoreFloat4(pixels, XMVectorSelect(bufferDepth, XMVectorMin(bufferDepth, depth), inside));
+			}
+		}
+	}
+
+	UpdateTiles(firstRow, lastRow);
+}
+
+// farthest depth of each tile in the rows (whole tile rows, bands are multiples of the tile size)
+void OcclusionCuller::UpdateTiles(unsigned int firstRow, unsigned int lastRow)
+{
+	for (unsigned int tileY = firstRow / TILE_SIZE; tileY < (lastRow + TILE_SIZE - 1) / TILE_SIZE; tileY++)
+	{
+		for (unsigned int tileX = 0; tileX < mTilesWidth; tileX++)
+		{
+			XMVECTOR maxDepth = XMVectorZero();
+
+			for (unsigned int row = tileY * TILE_SIZE; row < (tileY + 1) * TILE_SIZE; row++)
+			{
+				const float *pixels = &mDepthBuffer[row * mWidth + tileX * TILE_SIZE];
+
+				maxDepth = XMVectorMax(maxDepth, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pixels)));
+				maxDepth = XMVectorMax(maxDepth, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pixels + 4)));
+			}
+
+			XMFLOAT4 lanes;
+			XMStoreFloat4(&lanes, maxDepth);
+
+			mTileMaxDepth[tileY * mTilesWidth + tileX] = std::max(std::max(lanes.x, lanes.y), std::max(lanes.z, lanes.w));
+		}
+	}
+}
+
+bool OcclusionCuller::IsVisible(const XMFLOAT3 &center, const XMFLOAT3 &extent) const
+{
+	XMMATRIX viewProjectionMatrix = XMLoadFloat4x4(&mViewProjectionMatrix);
+
+	// screen rectangle and nearest depth of the box corners
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float minDepth = FLT_MAX;
+
+	for (int i = 0; i < 8; i++)
+	{
+		XMFLOAT3 corner(center.x + (i & 1 ? extent.x : -extent.x), center.y + (i & 2 ? extent.y : -extent.y), center.z + (i & 4 ? extent.z : -extent.z));
+
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corner), viewProjectionMatrix));
+
+		// box crossing the near plane
+		if (clip.w < MIN_W)
+			return true;
+
+		float inverseW = 1.0f / clip.w;
+		float x = (clip.x * inverseW * 0.5f + 0.5f) * mWidth;
+		float y = (0.5f - clip.y * inverseW * 0.5f) * mHeight;
+
+		minX = std::min(minX, x); maxX = std::max(maxX, x);
+		minY = std::min(minY, y); maxY = std::max(maxY, y);
+		minDepth = std::min(minDepth, clip.z * inverseW);
+	}
+
+	int columnStart = std::max((int)floorf(minX), 0);
+	int columnEnd = std::min((int)ceilf(maxX), (int)mWidth);   // exclusive
+	int rowStart = std::max((int)floorf(minY), 0);
+	int rowEnd = std::min((int)ceilf(maxY), (int)mHeight);
+
+	// off screen (not expected after frustum culling): don't cull
+	if (columnStart >= columnEnd || rowStart >= rowEnd)
+		return true;
+
+	for (int tileY = rowStart / (int)TILE_SIZE; tileY <= (rowEnd - 1) / (int)TILE_SIZE; tileY++)
+	{
+		for (int tileX = columnStart / (int)TILE_SIZE; tileX <= (columnEnd - 1) / (int)TILE_SIZE; tileX++)
+		{
+			// every pixel of the tile is nearer than the box
+			if (mTileMaxDepth[tileY * mTilesWidth + tileX] < minDepth)
+				continue;
+
+			// look at the pixels of the tile covered by the box
+			int rowFirst = std::max(rowStart, tileY * (int)TILE_SIZE), rowLast = std::min(rowEnd, (tileY + 1) * (int)TILE_SIZE);
+			int columnFirst = std::max(columnStart, tileX * (int)TILE_SIZE), columnLast = std::min(columnEnd, (tileX + 1) * (int)TILE_SIZE);
+
+			for (int row = rowFirst; row < rowLast; row++)
+				for (int column = columnFirst; column < columnLast; column++)
+					if (mDepthBuffer[row * mWidth + column] >= minDepth)
+						return true;
+		}
+	}
+
+	return false;
+}
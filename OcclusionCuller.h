@@ -0,0 +1,70 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <DirectXMath.h>
+#include <vector>
+
+using namespace DirectX;
+
+/**** software occlusion culling - occluder triangles are rasterised into a low resolution depth buffer on the CPU ****/
+/**** the buffer is split in bands of rows rasterised by worker threads, 4 pixels at a time ****/
+/**** each 8x8 tile keeps the farthest depth of its pixels so most occludee tests never read single pixels ****/
+/**** depth is z/w of the D3D clip space (0 near, 1 far), the buffer is cleared to 1 ****/
+
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(unsigned int width = 256, unsigned int height = 128);
+
+	// start a frame: clear the depth buffer and the occluder list
+	void BeginFrame(const XMFLOAT4X4 &viewProjectionMatrix);
+
+	// vertices and indices are referenced until RasteriseOccluders returns
+	void AddOccluder(const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices, const XMFLOAT4X4 &worldMatrix);
+	void RasteriseOccluders();
+
+	// world space axis aligned box (center, half extent), false only if every pixel it covers is behind an occluder
+	bool IsVisible(const XMFLOAT3 &center, const XMFLOAT3 &extent) const;
+
+	unsigned int GetWidth() const { return mWidth; }
+	unsigned int GetHeight() const { return mHeight; }
+	const std::vector<float> &GetDepthBuffer() const { return mDepthBuffer; }
+private:
+	struct Occluder
+	{
+		const std::vector<XMFLOAT3> *vertices;
+		const std::vector<unsigned int> *indices;
+		XMFLOAT4X4 worldMatrix;
+		unsigned int firstTriangle;
+	};
+	struct ScreenTriangle
+	{
+		float x[3];
+		float y[3];
+		float z[3];
+		bool valid;     // false if the triangle is degenerate or crosses the near plane (never rasterised, which is conservative)
+	};
+
+	static const unsigned int TILE_SIZE = 8;
+	static const unsigned int BAND_HEIGHT = 16;    // rows rasterised by a single task, multiple of TILE_SIZE
+
+	void SetupTriangles(const Occluder &occluder);
+	void RasteriseBand(unsigned int band);
+	void UpdateTiles(unsigned int firstRow, unsigned int lastRow);
+
+	unsigned int mWidth;
+	unsigned int mHeight;
+	unsigned int mTilesWidth;
+	unsigned int mTilesHeight;
+
+	XMFLOAT4X4 mViewProjectionMatrix;
+
+	std::vector<float> mDepthBuffer;
+	std::vector<float> mTileMaxDepth;
+
+	std::vector<Occluder> mOccluders;
+	std::vector<ScreenTriangle> mTriangles;
+	unsigned int mNumTriangles = 0;
+};
+
+#endif  // OCCLUSION_CULLER_H
@@ -0,0 +1,432 @@
+#include "PackFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+namespace
+{
+	const char FILE_MAGIC[4] = { 'P', 'A', 'C', 'K' };
+	const uint32_t FILE_VERSION = 1;
+
+	struct FileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t numEntries;
+		uint32_t _padding;
+		uint64_t entriesOffset;
+		uint64_t namesOffset;
+		uint64_t namesSize;
+	};
+
+	// compression: a token (literal run length, match length - MIN_MATCH, 4 bits each, 15 continues with 255 valued bytes),
+	// the literals, a 16 bit match offset. the last sequence is literals only
+	const size_t MIN_MATCH = 4;
+	const size_t MAX_OFFSET = 65535;
+	const unsigned int HASH_BITS = 16;
+	const size_t NO_POSITION = (size_t)-1;
+
+	uint32_t Read32(const uint8_t *data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+
+		return value;
+	}
+
+	unsigned int HashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	void WriteLength(std::vector<uint8_t> &compressed, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+			compressed.push_back(255);
+
+		compressed.push_back((uint8_t)length);
+	}
+
+	bool ReadLength(const uint8_t *compressed, size_t compressedSize, size_t &position, size_t &length)
+	{
+		uint8_t value;
+
+		do
+		{
+			if (position == compressedSize)
+				return false;
+
+			value = compressed[position++];
+			length += value;
+		} while (value == 255);
+
+		return true;
+	}
+
+	// a match length of 0 writes the last sequence
+	void WriteSequence(std::vector<uint8_t> &compressed, const uint8_t *literals, size_t numLiterals, size_t offset, size_t matchLength)
+	{
+		size_t extraLength = matchLength ? matchLength - MIN_MATCH : 0;
+
+		compressed.push_back((uint8_t)((numLiterals < 15 ? numLiterals : 15) << 4 | (extraLength < 15 ? extraLength : 15)));
+
+		if (numLiterals >= 15)
+			WriteLength(compressed, numLiterals - 15);
+
+		compressed.insert(compressed.end(), literals, literals + numLiterals);
+
+		if (matchLength == 0)
+			return;
+
+		compressed.push_back((uint8_t)(offset & 0xFF));
+		compressed.push_back((uint8_t)(offset >> 8));
+
+		if (extraLength >= 15)
+			WriteLength(compressed, extraLength - 15);
+	}
+
+	uint64_t Align(uint64_t offset)
+	{
+		return (offset + PackFile::ENTRY_ALIGNMENT - 1) & ~(uint64_t)(PackFile::ENTRY_ALIGNMENT - 1);
+	}
+
+	// pads with zeroes up to the offset of the blob and writes it
+	bool WriteBlob(FILE *fileStream, uint64_t &position, uint64_t offset, const void *data, uint64_t size)
+	{
+		static const uint8_t padding[PackFile::ENTRY_ALIGNMENT] = {};
+
+		if (offset > position && fwrite(padding, 1, (size_t)(offset - position), fileStream) != offset - position)
+			return false;
+
+		position = offset + size;
+
+		return size == 0 || fwrite(data, 1, (size_t)size, fileStream) == size;
+	}
+
+	bool EntryLess(const PackFile::Entry &entry, uint64_t hash)
+	{
+		return entry.hash < hash;
+	}
+}
+
+const unsigned int PackFile::ENTRY_ALIGNMENT;
+const uint32_t PackFile::COMPRESSED;
+
+std::string PackFile::NormalizePath(const std::string &path)
+{
+	std::vector<std::string> segments;
+	std::string segment;
+
+	for (size_t i = 0; i <= path.size(); i++)
+	{
+		char c = i < path.size() ? path[i] : '/';
+
+		if (c != '/' && c != '\\')
+		{
+			segment += (char)tolower((unsigned char)c);
+			continue;
+		}
+
+		if (segment == ".." && !segments.empty() && segments.back() != "..")
+			segments.pop_back();
+		else if (!segment.empty() && segment != ".")
+			segments.push_back(segment);
+
+		segment.clear();
+	}
+
+	std::string normalizedPath;
+
+	for (const std::string &segment : segments)
+		normalizedPath += normalizedPath.empty() ? segment : "/" + segment;
+
+	return normalizedPath;
+}
+
+uint64_t PackFile::HashPath(const std::string &normalizedPath)
+{
+	// fnv-1a
+	uint64_t hash = 14695981039346656037ull;
+
+	for (char c : normalizedPath)
+	{
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+void PackFile::Compress(const uint8_t *data, size_t size, std::vector<uint8_t> &compressed)
+{
+	compressed.clear();
+	compressed.reserve(size + size / 255 + 16);
+
+	// last position of each hashed 4 byte sequence
+	std::vector<size_t> positions((size_t)1 << HASH_BITS, NO_POSITION);
+
+	size_t anchor = 0;
+	size_t i = 0;
+
+	while (i + MIN_MATCH <= size)
+	{
+		uint32_t sequence = Read32(data + i);
+		size_t &position = positions[HashSequence(sequence)];
+		size_t candidate = position;
+		position = i;
+
+		if (candidate == NO_POSITION || i - candidate > MAX_OFFSET || Read32(data + candidate) != sequence)
+		{
+			i++;
+			continue;
+		}
+
+		size_t matchLength = MIN_MATCH;
+
+		while (i + matchLength < size && data[candidate + matchLength] == data[i + matchLength])
+			matchLength++;
+
+		WriteSequence(compressed, data + anchor, i - anchor, i - candidate, matchLength);
+
+		i += matchLength;
+		anchor = i;
+	}
+
+	WriteSequence(compressed, data + anchor, size - anchor, 0, 0);
+}
+
+bool PackFile::Decompress(const uint8_t *compressed, size_t compressedSize, uint8_t *data, size_t size)
+{
+	size_t in = 0;
+	size_t out = 0;
+
+	// every length and offset is checked: a corrupted archive fails instead of writing out of bounds
+	while (in < compressedSize)
+	{
+		uint8_t token = compressed[in++];
+
+		size_t numLiterals = token >> 4;
+
+		if (numLiterals == 15 && !ReadLength(compressed, compressedSize, in, numLiterals))
+			return false;
+
+		if (numLiterals > compressedSize - in || numLiterals > size - out)
+			return false;
+
+		memcpy(data + out, compressed + in, numLiterals);
+		in += numLiterals;
+		out += numLiterals;
+
+		if (in == compressedSize)
+			break;
+
+		if (compressedSize - in < 2)
+			return false;
+
+		size_t offset = compressed[in] | (size_t)compressed[in + 1] << 8;
+		in += 2;
+
+		size_t matchLength = token & 0xF;
+
+		if (matchLength == 15 && !ReadLength(compressed, compressedSize, in, matchLength))
+			return false;
+
+		matchLength += MIN_MATCH;
+
+		if (offset == 0 || offset > out || matchLength > size - out)
+			return false;
+
+		// byte by byte: the match can overlap the bytes it produces
+		for (size_t j = 0; j < matchLength; j++, out++)
+			data[out] = data[out - offset];
+	}
+
+	return out == size;
+}
+
+bool PackFile::Build(const std::string &packFilePath, const std::vector<std::string> &filePaths, bool compress)
+{
+	struct Source
+	{
+		std::string filePath;
+		std::string name;
+		uint64_t hash;
+	};
+
+	std::vector<Source> sources;
+
+	for (const std::string &filePath : filePaths)
+	{
+		std::string name = NormalizePath(filePath);
+		sources.push_back({ filePath, name, HashPath(name) });
+	}
+
+	// entries are laid out by path so that files of the same directory (a model and its textures) are close on disk
+	std::sort(sources.begin(), sources.end(), [](const Source &a, const Source &b) { return a.name < b.name; });
+
+	for (size_t i = 1; i < sources.size(); i++)
+		if (sources[i].name == sources[i - 1].name)
+			return false;
+
+	FILE *fileStream;
+
+	if (fopen_s(&fileStream, packFilePath.c_str(), "wb"))
+		return false;
+
+	FileHeader header = {};
+	uint64_t position = 0;
+
+	bool written = WriteBlob(fileStream, position, 0, &header, sizeof(header));
+
+	std::vector<Entry> entries;
+	std::string names;
+	std::vector<uint8_t> compressed;
+
+	for (size_t i = 0; i < sources.size() && written; i++)
+	{
+		Entry entry = {};
+		entry.hash = sources[i].hash;
+		entry.modificationTime = MappedFile::GetModificationTime(sources[i].filePath);
+		entry.nameOffset = (uint32_t)names.size();
+		entry.nameLength = (uint32_t)sources[i].name.size();
+		entry.offset = Align(position);
+
+		names += sources[i].name;
+
+		if (entry.modificationTime == 0)
+		{
+			written = false;
+			break;
+		}
+
+		MappedFile file;
+
+		// empty files can't be mapped, they're stored as empty entries
+		if (file.Open(sources[i].filePath))
+		{
+			entry.size = entry.storedSize = file.GetSize();
+
+			const uint8_t *data = file.GetData();
+
+			if (compress)
+			{
+				Compress(file.GetData(), file.GetSize(), compressed);
+
+				if (compressed.size() < entry.size - entry.size / 8)
+				{
+					entry.storedSize = compressed.size();
+					entry.flags |= COMPRESSED;
+					data = compressed.data();
+				}
+			}
+
+			written = WriteBlob(fileStream, position, entry.offset, data, entry.storedSize);
+		}
+
+		entries.push_back(entry);
+	}
+
+	// the table of contents is sorted by hash for the lookup, ties (hash collisions) by name
+	std::sort(entries.begin(), entries.end(), [&names](const Entry &a, const Entry &b)
+	{
+		if (a.hash != b.hash)
+			return a.hash < b.hash;
+
+		return names.compare(a.nameOffset, a.nameLength, names, b.nameOffset, b.nameLength) < 0;
+	});
+
+	memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+	header.version = FILE_VERSION;
+	header.numEntries = (uint32_t)entries.size();
+	header.namesOffset = Align(position);
+	header.namesSize = names.size();
+	header.entriesOffset = (header.namesOffset + header.namesSize + 7) & ~7ull;
+
+	written = written && WriteBlob(fileStream, position, header.namesOffset, names.data(), header.namesSize);
+	written = written && WriteBlob(fileStream, position, header.entriesOffset, entries.data(), entries.size() * sizeof(Entry));
+	written = written && fseek(fileStream, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fileStream) == 1;
+
+	written = fclose(fileStream) == 0 && written;
+
+	if (!written)
+		remove(packFilePath.c_str());
+
+	return written;
+}
+
+bool PackFile::Open(const std::string &filePath)
+{
+	Close();
+
+	if (!mFile.Open(filePath))
+		return false;
+
+	const uint8_t *data = mFile.GetData();
+	uint64_t size = mFile.GetSize();
+
+	if (size < sizeof(FileHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const FileHeader &header = *reinterpret_cast<const FileHeader*>(data);
+
+	bool valid = memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 && header.version == FILE_VERSION &&
+	             header.namesOffset <= size && header.namesSize <= size - header.namesOffset && header.entriesOffset % 8 == 0 &&
+	             header.entriesOffset <= size && header.numEntries <= (size - header.entriesOffset) / sizeof(Entry);
+
+	const Entry *entries = reinterpret_cast<const Entry*>(data + header.entriesOffset);
+
+	for (uint32_t i = 0; i < header.numEntries && valid; i++)
+	{
+		const Entry &entry = entries[i];
+
+		valid = entry.offset <= size && entry.storedSize <= size - entry.offset && entry.nameOffset <= header.namesSize &&
+		        entry.nameLength <= header.namesSize - entry.nameOffset && (entry.flags & COMPRESSED || entry.storedSize == entry.size) &&
+		        (i == 0 || entries[i - 1].hash <= entry.hash);
+	}
+
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+
+	mEntries = entries;
+	mNumEntries = header.numEntries;
+	mNames = reinterpret_cast<const char*>(data + header.namesOffset);
+
+	return true;
+}
+
+void PackFile::Close()
+{
+	mFile.Close();
+
+	mEntries = nullptr;
+	mNumEntries = 0;
+	mNames = nullptr;
+}
+
+const PackFile::Entry *PackFile::Find(const std::string &normalizedPath) const
+{
+	uint64_t hash = HashPath(normalizedPath);
+
+	for (const Entry *entry = std::lower_bound(mEntries, mEntries + mNumEntries, hash, EntryLess); entry != mEntries + mNumEntries && entry->hash == hash; entry++)
+		if (entry->nameLength == normalizedPath.size() && memcmp(mNames + entry->nameOffset, normalizedPath.data(), entry->nameLength) == 0)
+			return entry;
+
+	return nullptr;
+}
+
+bool PackFile::Read(const Entry &entry, uint8_t *data) const
+{
+	if (entry.flags & COMPRESSED)
+		return Decompress(GetData(entry), (size_t)entry.storedSize, data, (size_t)entry.size);
+
+	memcpy(data, GetData(entry), (size_t)entry.size);
+
+	return true;
+}
@@ -0,0 +1,61 @@
+#ifndef PACK_FILE_H
+#define PACK_FILE_H
+
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**** asset archive (.pak): header, then the entries, each on its own 4 KB aligned pages, then the path strings and the table ****/
+/**** of contents sorted by path hash, looked up with a binary search. the archive is memory mapped: stored entries are read ****/
+/**** in place, compressed ones (lz77, kept only when it pays) are decompressed into the caller's buffer ****/
+
+class PackFile
+{
+public:
+	static const unsigned int ENTRY_ALIGNMENT = 4096;
+	static const uint32_t COMPRESSED = 0x1;
+
+	struct Entry             // table of contents record
+	{
+		uint64_t hash;                  // of the normalised path
+		uint64_t offset;
+		uint64_t size;
+		uint64_t storedSize;            // compressed size, or size
+		uint64_t modificationTime;      // of the file the entry was built from
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t flags;
+		uint32_t _padding;
+	};
+public:
+	PackFile() = default;
+
+	// files are read from disk and stored under their normalised paths, compressed when it saves an eighth of their size
+	static bool Build(const std::string &packFilePath, const std::vector<std::string> &filePaths, bool compress = true);
+
+	bool Open(const std::string &filePath);      // fails if the archive is missing or corrupted
+	void Close();
+
+	const Entry *Find(const std::string &normalizedPath) const;      // null if there's no such entry
+	const uint8_t *GetData(const Entry &entry) const { return mFile.GetData() + entry.offset; }     // stored bytes
+	bool Read(const Entry &entry, uint8_t *data) const;              // size bytes, decompressed if needed
+
+	unsigned int GetNumEntries() const { return mNumEntries; }
+	const Entry &GetEntry(unsigned int entry) const { return mEntries[entry]; }
+	std::string GetName(const Entry &entry) const { return std::string(mNames + entry.nameOffset, entry.nameLength); }
+
+	static std::string NormalizePath(const std::string &path);      // forward slashes, lower case, no . and .. segments
+	static uint64_t HashPath(const std::string &normalizedPath);
+
+	// byte oriented lz77: runs of literals followed by a match within the last 64 KB
+	static void Compress(const uint8_t *data, size_t size, std::vector<uint8_t> &compressed);
+	static bool Decompress(const uint8_t *compressed, size_t compressedSize, uint8_t *data, size_t size);
+private:
+	MappedFile mFile;
+	const Entry *mEntries = nullptr;
+	unsigned int mNumEntries = 0;
+	const char *mNames = nullptr;
+};
+
+#endif  // PACK_FILE_H
@@ -1,6 +1,9 @@
 #include "Picker.h"
 #include "GraphicsSystem.h"
 #include "CollisionSystem.h"
+#include "CollisionComponent.h"
+#include "MotionComponent.h"
+#include "Entity.h"
 
 void Picker::CreateRay(int x, int y)
 {
@@ -37,5 +40,24 @@ void Picker::CreateRay(int x, int y)
 
 	XMStoreFloat3(&mRay, rayWorld);
 
-	CollisionSystem::GetInstance().AddRay(this);
+	// push every picked entity along the ray
+	std::vector<CollisionSystem::RayQuery> queries(1, CollisionSystem::RayQuery{ GetOrigin(), mRay, cameraFar });
+	CollisionSystem::QueryResults results;
+
+	CollisionSystem::GetInstance().RayCast(queries, CollisionSystem::QueryMode::ALL, results);
+
+	const CollisionSystem::QueryHit *hits = results.GetHits(0);
+
+	for (unsigned int i = 0; i < results.GetNumHits(0); i++)
+	{
+		Entity *entity = hits[i].collider->GetOwner();
+
+		if (entity->HasComponent<MotionComponent>())
+		{
+			XMFLOAT3 velocity;
+			XMStoreFloat3(&velocity, XMLoadFloat3(&mRay) * 3.0f);
+
+			entity->GetComponent<MotionComponent>()->AddVelocity(velocity);
+		}
+	}
 }
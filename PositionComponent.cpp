@@ -1,4 +1,5 @@
 #include "PositionComponent.h"
+#include "RenderScene.h"
 
 PositionComponent::PositionComponent(const XMFLOAT3 &position, const XMFLOAT3 &eulerAngles, const XMFLOAT3 &scale)
 	: mPosition(position), mOrientationEulerAngles(eulerAngles), mScale(scale)
@@ -43,6 +44,16 @@ PositionComponent::PositionComponent(const XMFLOAT3 &position, const XMFLOAT3 &e
 	XMStoreFloat4(&mOrientationQuaternion, XMQuaternionMultiply(rollQuaternion, XMQuaternionMultiply(pitchQuaternion, yawQuaternion)));
 }
 
+PositionComponent::~PositionComponent()
+{
+	RenderScene::GetInstance().RemoveEntity(GetOwner());
+}
+
+void PositionComponent::Init()
+{
+	RenderScene::GetInstance().UpdateEntity(GetOwner());
+}
+
 void PositionComponent::SetScale(const XMFLOAT3 &scale)
 {
 	mScale = scale;
@@ -72,6 +83,10 @@ void PositionComponent::SetScale(const XMFLOAT3 &scale)
 	// update world matrix
 	XMMATRIX newWorldMatrixScale = XMMatrixMultiply(newScaleMatrix, XMLoadFloat4x4(&mWorldMatrix));
 	XMStoreFloat4x4(&mWorldMatrixScale, newWorldMatrixScale);
+
+	mNormalMatrixDirty = true;
+
+	RenderScene::GetInstance().MarkTransformChanged(GetOwner());
 }
 
 void PositionComponent::SetPosition(const XMFLOAT3 &position)
@@ -103,6 +118,8 @@ void PositionComponent::SetPosition(const XMFLOAT3 &position)
 	mInverseWorldMatrix.m[3][0] = tx;
 	mInverseWorldMatrix.m[3][1] = ty;
 	mInverseWorldMatrix.m[3][2] = tz;
+
+	RenderScene::GetInstance().MarkTransformChanged(GetOwner());
 }
 
 void PositionComponent::SetOrientationEulerAngles(const XMFLOAT3 &orientationEulerAngles)
@@ -138,6 +155,8 @@ void PositionComponent::SetOrientationEulerAngles(const XMFLOAT3 &orientationEul
 	XMMATRIX inverseWorldMatrix = XMMatrixInverse(nullptr, XMLoadFloat4x4(&mWorldMatrix));
 	XMStoreFloat4x4(&mInverseWorldMatrix, inverseWorldMatrix);
 
+	mNormalMatrixDirty = true;
+
 	// update orientation quaternion 
 	// XMVECTOR orientationQuaternion = XMQuaternionRotationRollPitchYaw(mOrientationEulerAngles.x, mOrientationEulerAngles.y, mOrientationEulerAngles.z);
 	// XMStoreFloat4(&mOrientationQuaternion, orientationQuaternion);
@@ -148,6 +167,8 @@ void PositionComponent::SetOrientationEulerAngles(const XMFLOAT3 &orientationEul
 	XMVECTOR yawQuaternion = XMVectorSet(0.0f, sin(mOrientationEulerAngles.y / 2.0f), 0.0f, cos(mOrientationEulerAngles.y / 2.0f));
 
 	XMStoreFloat4(&mOrientationQuaternion, XMQuaternionMultiply(rollQuaternion, XMQuaternionMultiply(pitchQuaternion, yawQuaternion)));
+
+	RenderScene::GetInstance().MarkTransformChanged(GetOwner());
 }
 
 void PositionComponent::SetOrientationQuaternion(const XMFLOAT4 &orientationQuaternion)
@@ -167,6 +188,26 @@ void PositionComponent::SetOrientationQuaternion(const XMFLOAT4 &orientationQuat
 	XMStoreFloat4x4(&mWorldMatrix, worldMatrix);
 	XMStoreFloat4x4(&mInverseWorldMatrix, XMMatrixInverse(nullptr, worldMatrix));
 	XMStoreFloat4x4(&mWorldMatrixScale, worldMatrixScale);
+
+	mNormalMatrixDirty = true;
+
+	RenderScene::GetInstance().MarkTransformChanged(GetOwner());
+}
+
+const XMFLOAT4X4 &PositionComponent::GetNormalMatrix() const
+{
+	// translation doesn't affect normals: SetPosition leaves the cached matrix valid
+	if (mNormalMatrixDirty)
+	{
+		XMMATRIX worldMatrixScale = XMLoadFloat4x4(&mWorldMatrixScale);
+		worldMatrixScale.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+		XMStoreFloat4x4(&mNormalMatrix, XMMatrixTranspose(XMMatrixInverse(nullptr, worldMatrixScale)));
+
+		mNormalMatrixDirty = false;
+	}
+
+	return mNormalMatrix;
 }
 
 const XMFLOAT3 PositionComponent::GetAxisX() const
@@ -13,6 +13,9 @@ class PositionComponent : public Component
 {
 public:
 	PositionComponent(const XMFLOAT3 &position, const XMFLOAT3 &eulerAngles, const XMFLOAT3 &scale);
+	~PositionComponent();
+
+	void Init() override;
 
 	XMFLOAT3 GetScale() const { return mScale; }
 	void SetScale(const XMFLOAT3 &scale);
@@ -45,6 +48,9 @@ public:
 	const XMFLOAT4X4 &GetWorldMatrixScale() const { return mWorldMatrixScale; }
 	const XMFLOAT4X4 &GetWorldMatrix() const { return mWorldMatrix; }    
 	const XMFLOAT4X4 &GetInverseWorldMatrix() const { return mInverseWorldMatrix; } 
+
+	// inverse transpose of the scaled world matrix without translation, recomputed only after a rotation or scale change
+	const XMFLOAT4X4 &GetNormalMatrix() const;
 private:
 	// entity's pose (position + orientation) relative to world coordinate system
 	XMFLOAT3 mPosition;     
@@ -55,6 +61,9 @@ private:
 	XMFLOAT4X4 mWorldMatrixScale;
 	XMFLOAT4X4 mWorldMatrix;
 	XMFLOAT4X4 mInverseWorldMatrix;
+
+	mutable XMFLOAT4X4 mNormalMatrix;
+	mutable bool mNormalMatrixDirty = true;
 };
 
 #endif  // POSITION_COMPONENT_H
\ No newline at end of file
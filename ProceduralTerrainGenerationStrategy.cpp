@@ -1,6 +1,7 @@
 #include "TerrainGenerationStrategy.h"
 #include "Terrain.h"
 #include "StaticMeshComponent.h"
+#include "MeshOptimizer.h"
 
 StaticMeshComponent *ProceduralTerrainGenerationStrategy::GenerateTerrain(Terrain *terrain)
 {
@@ -84,10 +85,18 @@ StaticMeshComponent *ProceduralTerrainGenerationStrategy::GenerateTerrain(Terrai
 		normals.push_back(normal);
 	}
 
+	// grid rows run past the vertex cache, reorder triangles and vertices for the gpu (heights keep the grid layout)
+	std::vector<unsigned int> remap;
+	MeshOptimizer::Optimize(indices, positions, remap);
+
+	MeshOptimizer::RemapVertices(positions, remap);
+	MeshOptimizer::RemapVertices(normals, remap);
+	MeshOptimizer::RemapVertices(textureCoordinates, remap);
+
 	Mesh mesh;
-	mesh.LoadAttribute("POSITION", &positions[0], positions.size());
-	mesh.LoadAttribute("NORMAL", &normals[0], normals.size());
-	mesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], textureCoordinates.size());
+	mesh.LoadAttribute(VertexLayout::Attribute::POSITION, &positions[0], positions.size());
+	mesh.LoadAttribute(VertexLayout::Attribute::NORMAL, &normals[0], normals.size());
+	mesh.LoadAttribute(VertexLayout::Attribute::TEX_COORD, &textureCoordinates[0], textureCoordinates.size());
 	mesh.LoadIndexBuffer(indices);
 
 	Material material;
@@ -6,8 +6,8 @@ QuadRenderer::QuadRenderer()
 	XMFLOAT2 positions[] = { XMFLOAT2(-0.5f, 0.5f), XMFLOAT2(0.5f, 0.5f), XMFLOAT2(-0.5f, -0.5f), XMFLOAT2(0.5f, -0.5f) };
 	XMFLOAT2 texCoords[] = { XMFLOAT2(0.0f, 0.0f), XMFLOAT2(1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f), XMFLOAT2(1.0f, 1.0f) };
 
-	mMesh.LoadAttribute("POSITION", positions, 4);
-	mMesh.LoadAttribute("TEX_COORD", texCoords, 4);
+	mMesh.LoadAttribute(VertexLayout::Attribute::POSITION, positions, 4);
+	mMesh.LoadAttribute(VertexLayout::Attribute::TEX_COORD, texCoords, 4);
 	mMesh.SetVertexCount(4);
 }
 
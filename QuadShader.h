@@ -25,8 +25,8 @@ private:
 	void CreateInputLayout() override;
 	void CreateConstantBuffers();
 	void CreateSamplerStates();
-	ID3D11Buffer *mTransformConstantBuffer;
-	ID3D11Buffer *mMaterialConstantBuffer;
-	ID3D11SamplerState *mSamplerState;
+	BufferHandle mTransformConstantBuffer;
+	BufferHandle mMaterialConstantBuffer;
+	SamplerHandle mSamplerState;
 };
 
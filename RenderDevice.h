@@ -0,0 +1,135 @@
+#ifndef RENDER_DEVICE_H
+#define RENDER_DEVICE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**** graphics backend interface: every resource creation, state change and draw of the engine goes through the render device ****/
+/**** resources are opaque handles, only the device that created a handle knows what it points to ****/
+
+typedef struct RenderBuffer *BufferHandle;
+typedef struct RenderTexture *TextureHandle;              // texture bound as shader resource
+typedef struct RenderTargetView *RenderTargetHandle;
+typedef struct DepthTargetView *DepthTargetHandle;
+typedef struct RenderSampler *SamplerHandle;
+typedef struct RenderShaderProgram *ShaderHandle;         // vertex, geometry and pixel shaders
+typedef struct RenderInputLayout *InputLayoutHandle;
+
+class RenderDevice
+{
+public:
+	enum class BufferType { VERTEX, INDEX, CONSTANT, };      // index buffers have 32 bit indices
+	enum class Usage { IMMUTABLE, DEFAULT, DYNAMIC, };
+	enum class MapMode { WRITE_DISCARD, WRITE_NO_OVERWRITE, };
+	enum class Format { UNKNOWN, R8_UNORM, R8G8B8A8_UNORM, R32_FLOAT, R32G32_FLOAT, R32G32B32_FLOAT, R32G32B32A32_FLOAT, R16G16_FLOAT, R16G16_SNORM, R16G16B16A16_UNORM, };
+	enum class Filter { POINT, LINEAR, };
+	enum class AddressMode { WRAP, CLAMP, };
+	enum class Topology { TRIANGLE_LIST, TRIANGLE_STRIP, };
+	enum class ShaderStage { VERTEX, GEOMETRY, PIXEL, };
+
+	enum class RasterizerState { SOLID, WIREFRAME, };        // render states are created at initialization
+	enum class BlendState { DISABLED, ADDITIVE, };
+	enum class DepthStencilState { ENABLED, DISABLED, };
+
+	static const unsigned int APPEND_ALIGNED = 0xFFFFFFFF;  // input element offset right after the previous element of the same slot
+
+	struct InputElement
+	{
+		const char *semantic;
+		unsigned int semanticIndex;
+		Format format;
+		unsigned int slot;
+		unsigned int offset;
+		bool perInstance;        // per instance elements advance once per instance
+	};
+	struct TextureData       // texture decoded off the render thread, ready to be created
+	{
+		unsigned int width;
+		unsigned int height;
+		unsigned int mipLevels;
+		Format format;               // unknown for files
+		bool isFile;                 // the file as is, for formats the device creates directly (dds)
+		std::vector<uint8_t> data;   // otherwise the mip levels one after the other, tightly packed
+	};
+	struct Viewport
+	{
+		float x;
+		float y;
+		float width;
+		float height;
+	};
+public:
+	virtual ~RenderDevice() = default;
+
+	unsigned int GetBackBufferWidth() const { return mBackBufferWidth; }
+	unsigned int GetBackBufferHeight() const { return mBackBufferHeight; }
+
+	virtual RenderTargetHandle GetBackBufferTarget() const = 0;
+	virtual DepthTargetHandle GetBackBufferDepthTarget() const = 0;
+
+	/**** resources ****/
+
+	virtual BufferHandle CreateBuffer(BufferType type, Usage usage, unsigned int size, const void *data) = 0;   // data can be null for dynamic buffers
+	virtual void ReleaseBuffer(BufferHandle buffer) = 0;
+
+	virtual void *Map(BufferHandle buffer, MapMode mode) = 0;
+	virtual void Unmap(BufferHandle buffer) = 0;
+
+	virtual TextureHandle CreateTexture(unsigned int width, unsigned int height, Format format, const void *data) = 0;
+	virtual TextureHandle LoadTexture(const std::string &filePath) = 0;
+	// background loading: decoding reads the file and does no gpu work (thread safe), creation runs on the render thread
+	virtual bool DecodeTexture(const std::string &filePath, TextureData &textureData) const = 0;
+	virtual TextureHandle CreateTexture(const TextureData &textureData, unsigned int firstMip) = 0;      // mips finer than firstMip are skipped
+	virtual void UpdateTexture(TextureHandle texture, const void *data, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int rowPitch) = 0;
+	virtual void ReleaseTexture(TextureHandle texture) = 0;
+
+	// render targets that can also be sampled through the returned texture
+	virtual RenderTargetHandle CreateRenderTarget(unsigned int width, unsigned int height, TextureHandle &colorTexture) = 0;
+	virtual DepthTargetHandle CreateDepthTarget(unsigned int width, unsigned int height, TextureHandle &depthTexture) = 0;
+	virtual void ReleaseRenderTarget(RenderTargetHandle renderTarget) = 0;
+	virtual void ReleaseDepthTarget(DepthTargetHandle depthTarget) = 0;
+
+	virtual SamplerHandle CreateSampler(Filter filter, AddressMode addressMode) = 0;
+
+	virtual ShaderHandle CreateShader(const wchar_t *vertexShaderFilePath, const wchar_t *geometryShaderFilePath, const wchar_t *pixelShaderFilePath) = 0;
+	virtual InputLayoutHandle CreateInputLayout(ShaderHandle shader, const InputElement *elements, unsigned int numElements) = 0;
+
+	/**** pipeline state ****/
+
+	virtual void SetShader(ShaderHandle shader, InputLayoutHandle inputLayout) = 0;
+	virtual void SetPrimitiveTopology(Topology topology) = 0;
+
+	virtual void SetVertexBuffers(unsigned int firstSlot, unsigned int numBuffers, const BufferHandle *buffers, const unsigned int *strides) = 0;
+	virtual void SetIndexBuffer(BufferHandle buffer) = 0;
+	virtual void SetConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) = 0;
+	virtual void SetTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) = 0;
+	virtual void SetSampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) = 0;
+
+	virtual void SetRasterizerState(RasterizerState state) = 0;
+	virtual void SetBlendState(BlendState state) = 0;
+	virtual void SetDepthStencilState(DepthStencilState state) = 0;
+
+	virtual void SetRenderTargets(RenderTargetHandle renderTarget, DepthTargetHandle depthTarget) = 0;   // null render target for depth only passes
+	virtual void GetRenderTargets(RenderTargetHandle &renderTarget, DepthTargetHandle &depthTarget) const = 0;
+
+	virtual void SetViewport(const Viewport &viewport) = 0;
+	virtual Viewport GetViewport() const = 0;
+
+	/**** commands ****/
+
+	virtual void ClearRenderTarget(RenderTargetHandle renderTarget, const float color[4]) = 0;
+	virtual void ClearDepthTarget(DepthTargetHandle depthTarget) = 0;
+
+	virtual void Draw(unsigned int vertexCount, unsigned int firstVertex) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex) = 0;
+	virtual void DrawInstanced(unsigned int vertexCount, unsigned int instanceCount, unsigned int firstVertex, unsigned int firstInstance) = 0;
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int firstIndex, int baseVertex, unsigned int firstInstance) = 0;
+
+	virtual void Present() = 0;
+protected:
+	unsigned int mBackBufferWidth = 0;
+	unsigned int mBackBufferHeight = 0;
+};
+
+#endif  // RENDER_DEVICE_H
@@ -0,0 +1,283 @@
+#include "RenderResources.h"
+#include "GraphicsSystem.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Error.h"
+#include <cstring>
+
+bool RenderResources::MaterialKey::operator<(const MaterialKey &other) const
+{
+	if (diffuseMap != other.diffuseMap)
+		return diffuseMap < other.diffuseMap;
+	if (specularMap != other.specularMap)
+		return specularMap < other.specularMap;
+	if (normalMap != other.normalMap)
+		return normalMap < other.normalMap;
+
+	return memcmp(constants, other.constants, sizeof(constants)) < 0;
+}
+
+MeshHandle RenderResources::AddMesh(const Mesh &mesh)
+{
+	std::map<const void*, MeshHandle>::iterator it = mMeshHandles.find(mesh.GetID());
+	if (mesh.GetID() && it != mMeshHandles.end())
+	{
+		mMeshReferences[it->second]++;
+		return it->second;
+	}
+
+	const std::vector<BufferHandle> &vertexBuffers = mesh.GetVertexBuffers();
+
+	if (vertexBuffers.size() > MAX_VERTEX_BUFFERS)
+		ErrorBox("too many vertex attributes");
+
+	MeshRecord record;
+	record.numVertexBuffers = (unsigned int)vertexBuffers.size();
+
+	for (unsigned int i = 0; i < record.numVertexBuffers && i < MAX_VERTEX_BUFFERS; i++)
+	{
+		record.vertexBuffers[i] = vertexBuffers[i];
+		record.strides[i] = mesh.GetStrides()[i];
+	}
+
+	record.positionBuffer = mesh.GetAttributeStream(VertexLayout::Attribute::POSITION);
+	record.positionOffset = mesh.GetQuantization().offset;
+	record.positionScale = mesh.GetQuantization().scale;
+	record.indexBuffer = mesh.GetIndexBuffer();
+	record.vertexCount = mesh.GetVertexCount();
+
+	const std::vector<Mesh::LOD> &lods = mesh.GetLODs();
+	record.numLODs = 1;
+	record.lods[0] = LODRecord{ 0, record.vertexCount, 0.0f };
+
+	for (unsigned int i = 1; i < (unsigned int)lods.size() && i < MAX_LODS && record.indexBuffer; i++)
+		record.lods[record.numLODs++] = LODRecord{ lods[i].firstIndex, lods[i].indexCount, lods[i].error };
+
+	MeshHandle handle;
+
+	if (mFreeMeshes.size())
+	{
+		handle = mFreeMeshes.back();
+		mFreeMeshes.pop_back();
+
+		mMeshes[handle] = record;
+		mMeshReferences[handle] = 1;
+		mMeshKeys[handle] = mesh.GetID();
+	}
+	else
+	{
+		handle = (MeshHandle)mMeshes.size();
+
+		mMeshes.push_back(record);
+		mMeshReferences.push_back(1);
+		mMeshKeys.push_back(mesh.GetID());
+	}
+
+	if (mesh.GetID())
+		mMeshHandles[mesh.GetID()] = handle;
+
+	return handle;
+}
+
+MaterialHandle RenderResources::AddMaterial(const Material &material)
+{
+	MaterialRecord record;
+	record.diffuseMap = material.HasDiffuseMap() ? ResolveTexture(material.GetDiffuseMaps()[0].GetResourceView()) : nullptr;
+	record.specularMap = material.HasSpecularMap() ? ResolveTexture(material.GetSpecularMaps()[0].GetResourceView()) : nullptr;
+	record.normalMap = material.HasNormalMap() ? ResolveTexture(material.GetNormalMaps()[0].GetResourceView()) : nullptr;
+
+	memset(&record.block, 0, sizeof(MaterialBlock));
+	record.block.hasDiffuseMap = material.HasDiffuseMap();
+	record.block.hasSpecularMap = material.HasSpecularMap();
+	record.block.hasNormalMap = material.HasNormalMap();
+	record.block.diffuseColor = material.GetDiffuseColor();
+	record.block.specularColor = material.GetSpecularColor();
+	record.block.specularPower = material.GetSpecularPower();
+	record.block.tilingH = material.GetHorizontalTiling();
+	record.block.tilingV = material.GetVerticalTiling();
+
+	MaterialKey key;
+	key.diffuseMap = record.diffuseMap;
+	key.specularMap = record.specularMap;
+	key.normalMap = record.normalMap;
+
+	float constants[9] = { record.block.diffuseColor.x, record.block.diffuseColor.y, record.block.diffuseColor.z, record.block.specularColor.x, record.block.specularColor.y, record.block.specularColor.z, record.block.specularPower, record.block.tilingH, record.block.tilingV };
+	memcpy(key.constants, constants, sizeof(constants));
+
+	std::map<MaterialKey, MaterialHandle>::iterator it = mMaterialHandles.find(key);
+	if (it != mMaterialHandles.end())
+	{
+		mMaterialReferences[it->second]++;
+		return it->second;
+	}
+
+	MaterialHandle handle;
+
+	if (mFreeMaterials.size())
+	{
+		handle = mFreeMaterials.back();
+		mFreeMaterials.pop_back();
+
+		mMaterials[handle] = record;
+		mMaterialReferences[handle] = 1;
+		mMaterialKeys[handle] = key;
+	}
+	else
+	{
+		handle = (MaterialHandle)mMaterials.size();
+
+		mMaterials.push_back(record);
+		mMaterialReferences.push_back(1);
+		mMaterialKeys.push_back(key);
+	}
+
+	mMaterialHandles[key] = handle;
+
+	return handle;
+}
+
+// the mesh buffers belong to the Mesh copies, releasing a handle only frees its slot
+void RenderResources::ReleaseMesh(MeshHandle mesh)
+{
+	if (--mMeshReferences[mesh])
+		return;
+
+	std::map<const void*, MeshHandle>::iterator it = mMeshHandles.find(mMeshKeys[mesh]);
+	if (it != mMeshHandles.end() && it->second == mesh)
+		mMeshHandles.erase(it);
+
+	mMeshKeys[mesh] = nullptr;
+	mFreeMeshes.push_back(mesh);
+}
+
+void RenderResources::ReleaseMaterial(MaterialHandle material)
+{
+	if (--mMaterialReferences[material])
+		return;
+
+	// the key may belong to another handle if a texture replacement made the two materials equal
+	std::map<MaterialKey, MaterialHandle>::iterator it = mMaterialHandles.find(mMaterialKeys[material]);
+	if (it != mMaterialHandles.end() && it->second == material)
+		mMaterialHandles.erase(it);
+
+	mFreeMaterials.push_back(material);
+}
+
+void RenderResources::ReplaceTexture(TextureHandle texture, TextureHandle replacement)
+{
+	// textures are replaced again when their mips change: replacements point at the live texture directly, and a live
+	// texture created where a released one was is never redirected
+	for (std::pair<const TextureHandle, TextureHandle> &entry : mTextureReplacements)
+		if (entry.second == texture)
+			entry.second = replacement;
+
+	mTextureReplacements.erase(replacement);
+
+	if (texture != replacement)
+		mTextureReplacements[texture] = replacement;
+
+	for (MaterialRecord &record : mMaterials)
+	{
+		if (record.diffuseMap == texture)
+			record.diffuseMap = replacement;
+		if (record.specularMap == texture)
+			record.specularMap = replacement;
+		if (record.normalMap == texture)
+			record.normalMap = replacement;
+	}
+
+	for (MaterialKey &key : mMaterialKeys)
+	{
+		key.diffuseMap = key.diffuseMap == texture ? replacement : key.diffuseMap;
+		key.specularMap = key.specularMap == texture ? replacement : key.specularMap;
+		key.normalMap = key.normalMap == texture ? replacement : key.normalMap;
+	}
+
+	// keys follow their records, a key that now matches another material keeps the first handle
+	std::map<MaterialKey, MaterialHandle> materialHandles;
+
+	for (const std::pair<const MaterialKey, MaterialHandle> &entry : mMaterialHandles)
+	{
+		MaterialKey key = entry.first;
+		key.diffuseMap = key.diffuseMap == texture ? replacement : key.diffuseMap;
+		key.specularMap = key.specularMap == texture ? replacement : key.specularMap;
+		key.normalMap = key.normalMap == texture ? replacement : key.normalMap;
+
+		materialHandles.insert(std::make_pair(key, entry.second));
+	}
+
+	mMaterialHandles.swap(materialHandles);
+}
+
+TextureHandle RenderResources::ResolveTexture(TextureHandle texture) const
+{
+	std::map<TextureHandle, TextureHandle>::const_iterator it = mTextureReplacements.find(texture);
+
+	return it != mTextureReplacements.end() ? it->second : texture;
+}
+
+void RenderResources::BindMesh(MeshHandle mesh) const
+{
+	const MeshRecord &record = mMeshes[mesh];
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	renderDevice.SetVertexBuffers(0, record.numVertexBuffers, record.vertexBuffers, record.strides);
+
+	// if present, bind index buffer
+	if (record.indexBuffer)
+		renderDevice.SetIndexBuffer(record.indexBuffer);
+}
+
+void RenderResources::BindMeshPositions(MeshHandle mesh) const
+{
+	const MeshRecord &record = mMeshes[mesh];
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	if (record.positionBuffer >= 0)
+		renderDevice.SetVertexBuffers(0, 1, &record.vertexBuffers[record.positionBuffer], &record.strides[record.positionBuffer]);
+
+	if (record.indexBuffer)
+		renderDevice.SetIndexBuffer(record.indexBuffer);
+}
+
+XMMATRIX RenderResources::GetDequantizationMatrix(MeshHandle mesh) const
+{
+	const MeshRecord &record = mMeshes[mesh];
+
+	return XMMatrixMultiply(XMMatrixScaling(record.positionScale.x, record.positionScale.y, record.positionScale.z), XMMatrixTranslation(record.positionOffset.x, record.positionOffset.y, record.positionOffset.z));
+}
+
+void RenderResources::BindMaterialTextures(MaterialHandle material, unsigned int diffuseSlot, unsigned int specularSlot, unsigned int normalSlot) const
+{
+	const MaterialRecord &record = mMaterials[material];
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	if (record.diffuseMap)
+		renderDevice.SetTexture(RenderDevice::ShaderStage::PIXEL, diffuseSlot, record.diffuseMap);
+
+	if (record.specularMap)
+		renderDevice.SetTexture(RenderDevice::ShaderStage::PIXEL, specularSlot, record.specularMap);
+
+	if (record.normalMap)
+		renderDevice.SetTexture(RenderDevice::ShaderStage::PIXEL, normalSlot, record.normalMap);
+}
+
+void RenderResources::DrawMesh(MeshHandle mesh, unsigned int lod) const
+{
+	const MeshRecord &record = mMeshes[mesh];
+
+	if (record.indexBuffer)
+		GraphicsSystem::GetInstance().GetRenderDevice().DrawIndexed(record.lods[lod].indexCount, record.lods[lod].firstIndex, 0);
+	else
+		GraphicsSystem::GetInstance().GetRenderDevice().Draw(record.vertexCount, 0);
+}
+
+void RenderResources::DrawMeshInstanced(MeshHandle mesh, unsigned int numInstances, unsigned int firstInstance, unsigned int lod) const
+{
+	const MeshRecord &record = mMeshes[mesh];
+
+	if (record.indexBuffer)
+		GraphicsSystem::GetInstance().GetRenderDevice().DrawIndexedInstanced(record.lods[lod].indexCount, numInstances, record.lods[lod].firstIndex, 0, firstInstance);
+	else
+		GraphicsSystem::GetInstance().GetRenderDevice().DrawInstanced(record.vertexCount, numInstances, 0, firstInstance);
+}
@@ -0,0 +1,126 @@
+#ifndef RENDER_RESOURCES_H
+#define RENDER_RESOURCES_H
+
+#include "RenderDevice.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+using namespace DirectX;
+
+class Mesh;
+class Material;
+
+/**** resource tables of the immutable meshes and materials drawn by the renderers, referenced through small integer handles ****/
+/**** meshes and materials are resolved once when they're registered: records are plain data, binding and drawing them never allocates ****/
+/**** material parameters are packed in the constant buffer layout of the shaders, uploaded as they are ****/
+
+typedef uint32_t MeshHandle;
+typedef uint32_t MaterialHandle;
+
+class RenderResources
+{
+public:
+	static const uint32_t INVALID_HANDLE = 0xFFFFFFFF;
+	static const unsigned int MAX_VERTEX_BUFFERS = 8;
+	static const unsigned int MAX_LODS = 4;
+
+	struct MaterialBlock     // material constant buffer layout (cbuffer Materials)
+	{
+		uint32_t hasDiffuseMap;
+		uint32_t hasSpecularMap;
+		uint32_t hasNormalMap;
+		float _padding0;
+		XMFLOAT3 diffuseColor;
+		float _padding1;
+		XMFLOAT3 specularColor;
+		float specularPower;
+		float tilingH;
+		float tilingV;
+		float _padding2[2];
+	};
+	struct MaterialRecord
+	{
+		TextureHandle diffuseMap;
+		TextureHandle specularMap;
+		TextureHandle normalMap;
+		MaterialBlock block;
+	};
+	struct LODRecord
+	{
+		unsigned int firstIndex;
+		unsigned int indexCount;
+		float error;                 // relative to the mesh extent
+	};
+	struct MeshRecord
+	{
+		BufferHandle vertexBuffers[MAX_VERTEX_BUFFERS];
+		unsigned int strides[MAX_VERTEX_BUFFERS];
+		unsigned int numVertexBuffers;
+		int positionBuffer;          // vertex buffer of the POSITION attribute, -1 if missing
+		XMFLOAT3 positionOffset;     // dequantisation of the positions: offset + position * scale
+		XMFLOAT3 positionScale;
+		BufferHandle indexBuffer;
+		unsigned int vertexCount;    // indices if indexed
+		LODRecord lods[MAX_LODS];    // detail levels in the index buffer, level 0 draws vertexCount indices
+		unsigned int numLODs;
+	};
+public:
+	static RenderResources &GetInstance() { static RenderResources instance; return instance; }
+
+	// copies of the same mesh and materials with the same textures and parameters share a handle. handles are reference counted:
+	// every Add is matched by a Release, the slot of a handle released by all its users is reused
+	MeshHandle AddMesh(const Mesh &mesh);
+	MaterialHandle AddMaterial(const Material &material);
+	void ReleaseMesh(MeshHandle mesh);
+	void ReleaseMaterial(MaterialHandle material);
+
+	// a texture (a placeholder, or a texture reloaded with other mips) is swapped for its replacement in every material,
+	// and in materials added later
+	void ReplaceTexture(TextureHandle texture, TextureHandle replacement);
+
+	const MeshRecord &GetMesh(MeshHandle mesh) const { return mMeshes[mesh]; }
+	const MaterialRecord &GetMaterial(MaterialHandle material) const { return mMaterials[material]; }
+	unsigned int GetNumMeshes() const { return (unsigned int)mMeshes.size(); }
+	unsigned int GetNumMaterials() const { return (unsigned int)mMaterials.size(); }
+
+	void BindMesh(MeshHandle mesh) const;
+	void BindMeshPositions(MeshHandle mesh) const;      // position attribute only (slot 0), for depth only passes
+	XMMATRIX GetDequantizationMatrix(MeshHandle mesh) const;     // positions to object space, prepended to world matrices of position only shaders
+	void BindMaterialTextures(MaterialHandle material, unsigned int diffuseSlot, unsigned int specularSlot, unsigned int normalSlot) const;
+
+	void DrawMesh(MeshHandle mesh, unsigned int lod = 0) const;
+	void DrawMeshInstanced(MeshHandle mesh, unsigned int numInstances, unsigned int firstInstance, unsigned int lod = 0) const;
+private:
+	struct MaterialKey
+	{
+		TextureHandle diffuseMap;
+		TextureHandle specularMap;
+		TextureHandle normalMap;
+		float constants[9];
+
+		bool operator<(const MaterialKey &other) const;
+	};
+
+	RenderResources() = default;
+
+	TextureHandle ResolveTexture(TextureHandle texture) const;
+
+	std::vector<MeshRecord> mMeshes;
+	std::vector<MaterialRecord> mMaterials;
+
+	std::vector<unsigned int> mMeshReferences;            // users of each handle, 0 for free slots
+	std::vector<unsigned int> mMaterialReferences;
+	std::vector<MeshHandle> mFreeMeshes;
+	std::vector<MaterialHandle> mFreeMaterials;
+
+	std::vector<const void*> mMeshKeys;                   // key of each handle, to remove it when released
+	std::vector<MaterialKey> mMaterialKeys;
+
+	std::map<const void*, MeshHandle> mMeshHandles;       // by mesh id: it lives as long as a copy of the mesh, so as long as the handle
+	std::map<MaterialKey, MaterialHandle> mMaterialHandles;
+	std::map<TextureHandle, TextureHandle> mTextureReplacements;
+};
+
+#endif  // RENDER_RESOURCES_H
@@ -0,0 +1,202 @@
+#include "RenderScene.h"
+#include "Entity.h"
+#include "PositionComponent.h"
+#include "StaticMeshComponent.h"
+#include "CameraComponent.h"
+#include "LightComponent.h"
+#include "ShadowComponent.h"
+#include "SkyboxComponent.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+	int Find(const Vector<Entity*> &entities, const Entity *entity)
+	{
+		for (int i = 0; i < (int)entities.Size(); i++)
+			if (entities[i] == entity)
+				return i;
+
+		return -1;
+	}
+
+	uint32_t GetProxyFlags(const Entity *entity)
+	{
+		uint32_t flags = 0;
+
+		if (entity->HasComponent<ShadowComponent>())
+			flags |= RenderScene::SHADOW_CASTER;
+		if (entity->GetComponent<StaticMeshComponent>()->IsOccluder())
+			flags |= RenderScene::OCCLUDER;
+
+		return flags;
+	}
+}
+
+void RenderScene::UpdateEntity(Entity *entity)
+{
+	if (!entity)
+		return;
+
+	bool hasPosition = entity->HasComponent<PositionComponent>();
+
+	// drawable entities (the skybox is drawn on its own)
+	std::unordered_map<const Entity*, unsigned int>::iterator it = mProxyIndices.find(entity);
+
+	if (hasPosition && entity->HasComponent<StaticMeshComponent>() && !entity->HasComponent<SkyboxComponent>())
+	{
+		if (it == mProxyIndices.end())
+			AddProxy(entity);
+		else
+		{
+			Proxy &proxy = mProxies[it->second];
+			proxy.staticMesh = entity->GetComponent<StaticMeshComponent>();
+			proxy.position = entity->GetComponent<PositionComponent>();
+			proxy.flags = GetProxyFlags(entity);
+
+			MarkTransformChanged(entity);
+		}
+	}
+	else if (it != mProxyIndices.end())
+		RemoveProxy(it->second);
+
+	if (hasPosition && entity->HasComponent<LightComponent>() && Find(mLights, entity) < 0)
+		mLights.InsertLast(entity);
+
+	if (entity->HasComponent<CameraComponent>() && Find(mCameras, entity) < 0)
+		mCameras.InsertLast(entity);
+
+	if (entity->HasComponent<SkyboxComponent>())
+		mSkybox = entity;
+}
+
+void RenderScene::RemoveEntity(Entity *entity)
+{
+	// components may already be destroyed: only the entity pointer is used
+	std::unordered_map<const Entity*, unsigned int>::iterator it = mProxyIndices.find(entity);
+	if (it != mProxyIndices.end())
+		RemoveProxy(it->second);
+
+	int light = Find(mLights, entity);
+	if (light >= 0)
+		mLights.Remove(light);
+
+	int camera = Find(mCameras, entity);
+	if (camera >= 0)
+		mCameras.Remove(camera);
+
+	if (mSkybox == entity)
+		mSkybox = nullptr;
+}
+
+void RenderScene::AddProxy(Entity *entity)
+{
+	Proxy proxy;
+	proxy.entity = entity;
+	proxy.staticMesh = entity->GetComponent<StaticMeshComponent>();
+	proxy.position = entity->GetComponent<PositionComponent>();
+	proxy.flags = GetProxyFlags(entity);
+	proxy.dirty = false;
+	proxy.lodSize = 0.0f;
+
+	mProxyIndices[entity] = (unsigned int)mProxies.size();
+
+	mProxies.push_back(proxy);
+	mTransforms.push_back(InstanceBatcher::Instance());
+	mCuller.AddBounds(XMFLOAT3(), XMFLOAT3());
+
+	MarkTransformChanged(entity);
+}
+
+void RenderScene::RemoveProxy(unsigned int proxy)
+{
+	mProxyIndices.erase(mProxies[proxy].entity);
+
+	// the last proxy takes the place of the removed one
+	unsigned int last = (unsigned int)mProxies.size() - 1;
+
+	if (proxy != last)
+	{
+		mProxies[proxy] = mProxies[last];
+		mTransforms[proxy] = mTransforms[last];
+
+		mProxyIndices[mProxies[proxy].entity] = proxy;
+	}
+
+	mProxies.pop_back();
+	mTransforms.pop_back();
+	mCuller.RemoveBounds(proxy);
+}
+
+void RenderScene::MarkTransformChanged(const Entity *entity)
+{
+	std::unordered_map<const Entity*, unsigned int>::iterator it = mProxyIndices.find(entity);
+	if (it == mProxyIndices.end())
+		return;
+
+	Proxy &proxy = mProxies[it->second];
+	if (!proxy.dirty)
+	{
+		proxy.dirty = true;
+		mDirty.push_back(entity);      // proxies move when others are removed, the entity finds them again at update time
+	}
+}
+
+void RenderScene::UpdateProxy(unsigned int index)
+{
+	Proxy &proxy = mProxies[index];
+
+	const XMFLOAT4X4 &worldMatrix = proxy.position->GetWorldMatrixScale();
+
+	XMFLOAT3 center, extent(FLT_MAX, FLT_MAX, FLT_MAX);    // meshes without vertex data are never culled
+	if (proxy.staticMesh->HasBounds())
+		proxy.staticMesh->GetWorldBounds(worldMatrix, center, extent);
+	else
+		center = XMFLOAT3();
+
+	mCuller.SetBounds(index, center, extent);
+
+	InstanceBatcher::MakeInstance(worldMatrix, proxy.position->GetNormalMatrix(), mTransforms[index]);
+
+	proxy.dirty = false;
+}
+
+void RenderScene::Update()
+{
+	mDirtyProxies.clear();
+
+	for (const Entity *entity : mDirty)
+	{
+		std::unordered_map<const Entity*, unsigned int>::iterator it = mProxyIndices.find(entity);
+		if (it != mProxyIndices.end() && mProxies[it->second].dirty)     // removed after the change
+			mDirtyProxies.push_back(it->second);
+	}
+
+	mDirty.clear();
+
+	mNumUpdated = (unsigned int)mDirtyProxies.size();
+
+	// each proxy writes only its own slots
+	unsigned int numTasks = (mNumUpdated + PROXIES_PER_TASK - 1) / PROXIES_PER_TASK;
+
+	ThreadPool::GetInstance().ParallelFor(numTasks, [this](unsigned int task)
+	{
+		unsigned int first = task * PROXIES_PER_TASK;
+		unsigned int last = std::min(first + PROXIES_PER_TASK, mNumUpdated);
+
+		for (unsigned int i = first; i < last; i++)
+			UpdateProxy(mDirtyProxies[i]);
+	});
+}
+
+Entity *RenderScene::GetActiveCamera() const
+{
+	Entity *activeCamera = nullptr;
+
+	for (Entity *camera : mCameras)
+		if (camera->GetComponent<CameraComponent>()->IsActive())
+			activeCamera = camera;
+
+	return activeCamera;
+}
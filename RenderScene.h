@@ -0,0 +1,81 @@
+#ifndef RENDER_SCENE_H
+#define RENDER_SCENE_H
+
+#include "data structures/Vector.h"
+#include "FrustumCuller.h"
+#include "InstanceBatcher.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class Entity;
+class StaticMeshComponent;
+class PositionComponent;
+
+/**** retained render scene: one compact proxy per drawable entity, kept across frames ****/
+/**** proxies are created and removed when render related components are added or destroyed, and refreshed only when their transform changes ****/
+/**** proxies, instance transforms and culling bounds are parallel arrays: the proxy index is also the transform and the bounds index ****/
+
+class RenderScene
+{
+public:
+	enum Flags : uint32_t
+	{
+		SHADOW_CASTER = 1 << 0,
+		OCCLUDER = 1 << 1,
+	};
+	struct Proxy
+	{
+		Entity *entity;
+		const StaticMeshComponent *staticMesh;       // meshes and materials
+		const PositionComponent *position;
+		uint32_t flags;
+		bool dirty;                                  // transform changed since the last update
+		float lodSize;                               // projected size the detail levels were last selected for (0 until drawn)
+	};
+public:
+	static RenderScene &GetInstance() { static RenderScene instance; return instance; }
+
+	// called by the components when they are added to or removed from an entity
+	void UpdateEntity(Entity *entity);
+	void RemoveEntity(Entity *entity);
+
+	void MarkTransformChanged(const Entity *entity);
+
+	// refresh bounds and instance transforms of the proxies whose transform changed
+	void Update();
+	unsigned int GetNumUpdated() const { return mNumUpdated; }
+
+	unsigned int GetNumProxies() const { return (unsigned int)mProxies.size(); }
+	const Proxy &GetProxy(unsigned int proxy) const { return mProxies[proxy]; }
+	void SetLODSize(unsigned int proxy, float lodSize) { mProxies[proxy].lodSize = lodSize; }
+	const InstanceBatcher::Instance &GetTransform(unsigned int proxy) const { return mTransforms[proxy]; }
+	const FrustumCuller &GetCuller() const { return mCuller; }
+
+	Entity *GetActiveCamera() const;
+	Entity *GetSkybox() const { return mSkybox; }
+	const Vector<Entity*> &GetLights() const { return mLights; }
+private:
+	RenderScene() = default;
+
+	static const unsigned int PROXIES_PER_TASK = 64;
+
+	void AddProxy(Entity *entity);
+	void RemoveProxy(unsigned int proxy);
+	void UpdateProxy(unsigned int proxy);
+
+	std::vector<Proxy> mProxies;
+	std::vector<InstanceBatcher::Instance> mTransforms;
+	FrustumCuller mCuller;
+
+	std::unordered_map<const Entity*, unsigned int> mProxyIndices;
+	std::vector<const Entity*> mDirty;
+	std::vector<unsigned int> mDirtyProxies;
+	unsigned int mNumUpdated = 0;
+
+	Vector<Entity*> mLights;        // in the order they were added
+	Vector<Entity*> mCameras;
+	Entity *mSkybox = nullptr;
+};
+
+#endif  // RENDER_SCENE_H
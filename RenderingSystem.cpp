@@ -1,41 +1,22 @@
 #include "RenderingSystem.h"
-#include "EntitySystem.h"
+#include "RenderScene.h"
 #include "PositionComponent.h"
 #include "StaticMeshComponent.h"
 #include "CameraComponent.h"
-#include "LightComponent.h"
-#include "ShadowComponent.h"
-#include "SkyboxComponent.h"
 #include "data structures/Vector.h"
 
 void RenderingSystem::Render()
 {
-	Entity *activeCamera = nullptr;
-	Entity *skybox = nullptr;
+	RenderScene &scene = RenderScene::GetInstance();
 
-	Vector<Entity*> lights;
+	// refresh the proxies moved since the last frame
+	scene.Update();
 
-	// dispatch entities to renderers
-	for (Entity *entity : EntitySystem::GetInstance().GetEntities())
-	{
-		if (entity->HasComponent<CameraComponent>())
-		{
-			CameraComponent *cameraComponent = entity->GetComponent<CameraComponent>();
-			if (cameraComponent->IsActive())
-				activeCamera = entity;
-		}
+	Entity *activeCamera = scene.GetActiveCamera();
+	Entity *skybox = scene.GetSkybox();
 
-		if (entity->HasComponent<LightComponent>() && entity->HasComponent<PositionComponent>())  // embed position component in entity?
-			lights.InsertLast(entity);
-
-		if (entity->HasComponent<SkyboxComponent>())
-			skybox = entity;
-		else if (entity->HasComponent<StaticMeshComponent>() && entity->HasComponent<PositionComponent>())
-			mStaticEntityRenderer.AddEntity(entity);
-
-		if (entity->HasComponent<ShadowComponent>())
-			mShadowRenderer.AddEntity(entity);
-	}
+	const Vector<Entity*> &lights = scene.GetLights();
+	const FrustumCuller &culler = scene.GetCuller();
 
 	if (activeCamera)
 	{
@@ -45,15 +26,64 @@ void RenderingSystem::Render()
 			mSkyBoxRenderer.Render(skybox, activeCamera);
 			GraphicsSystem::GetInstance().SetDepthStencilState(GraphicsSystem::DepthStencilState::ENABLED);
 		}
+
+		// cull shadow casters against each cascade and the spot light frustum, the light volumes include the casters between the light and the view frustum
+		mShadowRenderer.UpdateLightViewProjection(activeCamera, lights);
+
+		if (mShadowRenderer.HasDirectionalLight())
+			for (unsigned int c = 0; c < ShadowCascades::NUM_CASCADES; c++)
+			{
+				culler.Cull(mShadowRenderer.GetCascades().GetViewProjectionMatrix(c), mVisible);
+				for (unsigned int index : mVisible)
+					if (scene.GetProxy(index).flags & RenderScene::SHADOW_CASTER)
+						mShadowRenderer.AddEntity(scene.GetProxy(index).entity, ShadowRenderer::ShadowMap::DIRECTIONAL, c);
+			}
+
+		if (mShadowRenderer.HasSpotLight())
+		{
+			culler.Cull(mShadowRenderer.GetLightViewProjectionMatrixSpot(), mVisible);
+			for (unsigned int index : mVisible)
+				if (scene.GetProxy(index).flags & RenderScene::SHADOW_CASTER)
+					mShadowRenderer.AddEntity(scene.GetProxy(index).entity, ShadowRenderer::ShadowMap::SPOT);
+		}
 		
-		// render shadows to shadow map
-		//for (Entity *light : lights)
-			//if (light->GetComponent<LightComponent>()->GetType() == LightComponent::Type::DIRECTIONAL || light->GetComponent<LightComponent>()->GetType() == LightComponent::Type::SPOT)
-				mShadowRenderer.Render(activeCamera, lights[0], lights[1]);
+		// render shadows to the shadow maps
+		mShadowRenderer.Render();
+
+		// cull entities against the camera frustum
+		CameraComponent *cameraComponent = activeCamera->GetComponent<CameraComponent>();
+
+		XMFLOAT4X4 viewMatrix = cameraComponent->GetViewMatrix();
+		XMFLOAT4X4 viewProjectionMatrix;
+		XMStoreFloat4x4(&viewProjectionMatrix, XMMatrixMultiply(XMLoadFloat4x4(&viewMatrix), XMLoadFloat4x4(&cameraComponent->GetProjectionMatrix())));
+
+		culler.Cull(viewProjectionMatrix, mVisible);
+
+		// rasterise the occluders in the frustum, then test every entity in the frustum against them
+		mOcclusionCuller.BeginFrame(viewProjectionMatrix);
+
+		for (unsigned int index : mVisible)
+		{
+			const RenderScene::Proxy &proxy = scene.GetProxy(index);
+
+			if (proxy.flags & RenderScene::OCCLUDER)
+				mOcclusionCuller.AddOccluder(proxy.staticMesh->GetVertices(), proxy.staticMesh->GetIndices(), proxy.position->GetWorldMatrixScale());
+		}
+
+		mOcclusionCuller.RasteriseOccluders();
+
+		for (unsigned int index : mVisible)
+		{
+			XMFLOAT3 center, extent;
+			culler.GetBounds(index, center, extent);
+
+			if (mOcclusionCuller.IsVisible(center, extent))
+				mStaticEntityRenderer.AddProxy(index);
+		}
 
 		// render entities
-		mStaticEntityRenderer.Render(activeCamera, lights, mShadowRenderer.GetShadowMap(), mShadowRenderer.GetShadowMapSpot(), mShadowRenderer.GetLightViewProjectionMatrix(), mShadowRenderer.GetLightViewProjectionMatrixSpot(), mShadowRenderer.GetShadowDistance());
+		mStaticEntityRenderer.Render(activeCamera, lights, mShadowRenderer);
 	} 
 
 	mGUIRenderer.Render();
-}
\ No newline at end of file
+}
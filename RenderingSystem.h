@@ -6,6 +6,8 @@
 #include "StaticEntityRenderer.h"
 //#include "TerrainRenderer.h"
 #include "ShadowRenderer.h"
+#include "OcclusionCuller.h"
+#include <vector>
 
 class Entity;
 
@@ -22,7 +24,11 @@ private:
 	SkyBoxRenderer mSkyBoxRenderer;
 	StaticEntityRenderer mStaticEntityRenderer;
 	//TerrainRenderer mTerrainRenderer;
-	ShadowRenderer mShadowRenderer{ 1024 * 2, 768 * 2, 100.0f};
+	ShadowRenderer mShadowRenderer{ 1024, 1024, 100.0f };     // 2048 x 2048 cascade atlas
+
+	std::vector<unsigned int> mVisible;     // proxies of the render scene
+
+	OcclusionCuller mOcclusionCuller;
 };
 
 #endif  // RENDERING_SYSTEM_H
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "ResourceCache.h"
+#include <algorithm>
+#include <cmath>
+
+// target of the resources to evict
+static const unsigned int EVICT = 0xFFFFFFFF;
+
+const ResourceCache::ResourceID ResourceCache::INVALID_RESOURCE;
+const unsigned int ResourceCache::MAX_MIPS;
+
+ResourceCache::ResourceID ResourceCache::Add(unsigned int width, unsigned int height, unsigned int numMips, uint64_t size, unsigned int firstMip)
+{
+	ResourceID id;
+
+	if (!mFreeResources.empty())
+	{
+		id = mFreeResources.back();
+		mFreeResources.pop_back();
+	}
+	else
+	{
+		id = (ResourceID)mResources.size();
+		mResources.push_back(Resource());
+	}
+
+	Resource &resource = mResources[id];
+
+	resource.numMips = std::min(std::max(numMips, 1u), MAX_MIPS);
+
+	// split the size among the mips by texel count, then sum from the coarsest mip up
+	uint64_t texels[MAX_MIPS];
+	uint64_t totalTexels = 0;
+
+	for (unsigned int mip = 0; mip < resource.numMips; mip++)
+	{
+		texels[mip] = (uint64_t)std::max(width >> mip, 1u) * std::max(height >> mip, 1u);
+		totalTexels += texels[mip];
+	}
+
+	uint64_t chainSize = 0;
+
+	for (int mip = resource.numMips - 1; mip >= 0; mip--)
+	{
+		chainSize += size * texels[mip] / totalTexels;
+		resource.chainSizes[mip] = chainSize;
+	}
+
+	resource.firstMip = resource.desiredMip = std::min(firstMip, resource.numMips - 1);
+	resource.requestedMip = resource.numMips;
+	resource.references = 0;
+	resource.lastUsed = mFrame;          // just loaded: evicted after resources nobody looked at for longer
+	resource.used = true;
+
+	mResidentSize += GetSize(resource, resource.firstMip);
+
+	return id;
+}
+
+void ResourceCache::AddReference(ResourceID resource)
+{
+	mResources[resource].references++;
+}
+
+void ResourceCache::Release(ResourceID resource)
+{
+	if (mResources[resource].references > 0)
+		mResources[resource].references--;
+}
+
+void ResourceCache::Request(ResourceID resource, unsigned int mip)
+{
+	Resource &target = mResources[resource];
+
+	target.requestedMip = std::min(target.requestedMip, std::min(mip, target.numMips - 1));
+}
+
+const std::vector<ResourceCache::Change> &ResourceCache::Update()
+{
+	mFrame++;
+	mChanges.clear();
+	mOrder.clear();
+	mTargets.assign(mResources.size(), EVICT);
+
+	uint64_t residentSize = 0;
+
+	// resources requested this frame get the detail they need and drop the mips finer than that (the renderer keeps the
+	// projected sizes in a hysteresis band, so this doesn't stream mips in and out), the others keep at most what they last needed
+	for (ResourceID id = 0; id < (ResourceID)mResources.size(); id++)
+	{
+		Resource &resource = mResources[id];
+
+		if (!resource.used)
+			continue;
+
+		if (resource.requestedMip < resource.numMips)
+		{
+			resource.desiredMip = resource.requestedMip;
+			resource.requestedMip = resource.numMips;
+			resource.lastUsed = mFrame;
+		}
+
+		mTargets[id] = resource.lastUsed == mFrame ? resource.desiredMip : std::max(resource.firstMip, resource.desiredMip);
+		residentSize += GetSize(resource, mTargets[id]);
+
+		mOrder.push_back(id);
+	}
+
+	// least recently used first, the largest first among resources used in the same frame
+	std::sort(mOrder.begin(), mOrder.end(), [this](ResourceID a, ResourceID b)
+	{
+		const Resource &resourceA = mResources[a], &resourceB = mResources[b];
+
+		if (resourceA.lastUsed != resourceB.lastUsed)
+			return resourceA.lastUsed < resourceB.lastUsed;
+
+		return GetSize(resourceA, mTargets[a]) > GetSize(resourceB, mTargets[b]);
+	});
+
+	// over budget: evict unreferenced resources
+	for (unsigned int i = 0; i < (unsigned int)mOrder.size() && residentSize > mBudget; i++)
+	{
+		ResourceID id = mOrder[i];
+
+		if (mResources[id].references == 0)
+		{
+			residentSize -= GetSize(mResources[id], mTargets[id]);
+			mTargets[id] = EVICT;
+		}
+	}
+
+	// then coarsen the least recently used resources, one mip at a time
+	for (unsigned int i = 0; i < (unsigned int)mOrder.size() && residentSize > mBudget; i++)
+	{
+		ResourceID id = mOrder[i];
+		const Resource &resource = mResources[id];
+
+		while (residentSize > mBudget && mTargets[id] != EVICT && mTargets[id] + 1 < resource.numMips)
+		{
+			residentSize -= GetSize(resource, mTargets[id]) - GetSize(resource, mTargets[id] + 1);
+			mTargets[id]++;
+		}
+	}
+
+	// commit
+	for (ResourceID id : mOrder)
+	{
+		Resource &resource = mResources[id];
+
+		if (mTargets[id] == EVICT)
+		{
+			resource.used = false;
+			mFreeResources.push_back(id);
+
+			mChanges.push_back(Change{ id, 0, true });
+		}
+		else if (mTargets[id] != resource.firstMip)
+		{
+			resource.firstMip = mTargets[id];
+
+			mChanges.push_back(Change{ id, resource.firstMip, false });
+		}
+	}
+
+	mResidentSize = residentSize;
+
+	return mChanges;
+}
+
+unsigned int ResourceCache::GetDesiredMip(unsigned int width, unsigned int height, unsigned int numMips, float projectedSize)
+{
+	if (numMips <= 1)
+		return 0;
+
+	float texels = (float)std::max(width, height);
+
+	if (projectedSize >= texels)
+		return 0;
+	if (projectedSize < 1.0f)
+		return numMips - 1;
+
+	unsigned int mip = (unsigned int)floorf(log2f(texels / projectedSize));
+
+	return std::min(mip, numMips - 1);
+}
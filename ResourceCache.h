@@ -0,0 +1,76 @@
+#ifndef RESOURCE_CACHE_H
+#define RESOURCE_CACHE_H
+
+#include <vector>
+#include <cstdint>
+
+/**** residency of mip mapped resources under a memory budget. resources are reference counted, the renderer reports the mip ****/
+/**** each one needs this frame and Update() decides what stays resident: every resource is streamed to the detail it needs ****/
+/**** and drops the mips finer than that, unreferenced resources stay resident (it's a cache) until the budget is short. over ****/
+/**** budget they are evicted least recently used first, then the least recently used resources are coarsened. no render ****/
+/**** device here, the owner applies the changes (so the policy runs against any simulated budget) ****/
+
+class ResourceCache
+{
+public:
+	typedef uint32_t ResourceID;
+
+	static const ResourceID INVALID_RESOURCE = 0xFFFFFFFF;
+	static const unsigned int MAX_MIPS = 16;
+
+	struct Change
+	{
+		ResourceID resource;
+		unsigned int firstMip;       // most detailed mip to keep resident
+		bool evict;                  // the resource is gone (its id is reused)
+	};
+public:
+	ResourceCache(uint64_t budget) : mBudget(budget) {}
+
+	// size of the full mip chain (bytes), each mip is assumed to take its share of texels; added resident from firstMip, unreferenced
+	ResourceID Add(unsigned int width, unsigned int height, unsigned int numMips, uint64_t size, unsigned int firstMip = 0);
+
+	void AddReference(ResourceID resource);
+	void Release(ResourceID resource);        // unreferenced resources stay resident until the budget needs their memory
+
+	// the renderer wants the resource at this mip (the finest request of the frame counts)
+	void Request(ResourceID resource, unsigned int mip);
+
+	// once per frame, the returned changes are already committed: the owner recreates or releases the resources
+	const std::vector<Change> &Update();
+
+	void SetBudget(uint64_t budget) { mBudget = budget; }
+	uint64_t GetBudget() const { return mBudget; }
+	uint64_t GetResidentSize() const { return mResidentSize; }
+	unsigned int GetFirstMip(ResourceID resource) const { return mResources[resource].firstMip; }
+	unsigned int GetNumReferences(ResourceID resource) const { return mResources[resource].references; }
+
+	// coarsest mip with at least one texel per pixel when the whole resource covers projectedSize pixels across
+	static unsigned int GetDesiredMip(unsigned int width, unsigned int height, unsigned int numMips, float projectedSize);
+private:
+	struct Resource
+	{
+		uint64_t chainSizes[MAX_MIPS];       // bytes of mips i..numMips-1
+		unsigned int numMips;
+		unsigned int firstMip;
+		unsigned int desiredMip;
+		unsigned int requestedMip;           // finest request since the last update, numMips if none
+		unsigned int references;
+		uint64_t lastUsed;                   // frame of the last request
+		bool used;                           // slot holds a resource
+	};
+
+	uint64_t GetSize(const Resource &resource, unsigned int firstMip) const { return resource.chainSizes[firstMip]; }
+
+	std::vector<Resource> mResources;
+	std::vector<ResourceID> mFreeResources;
+	std::vector<ResourceID> mOrder;          // scratch: resources by last use
+	std::vector<unsigned int> mTargets;      // scratch: first mip to keep, numMips + 1 to evict
+	std::vector<Change> mChanges;
+
+	uint64_t mBudget;
+	uint64_t mResidentSize = 0;
+	uint64_t mFrame = 0;
+};
+
+#endif  // RESOURCE_CACHE_H
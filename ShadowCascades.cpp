@@ -0,0 +1,62 @@
+#include "ShadowCascades.h"
+#include <algorithm>
+#include <cmath>
+
+ShadowCascades::ShadowCascades()
+{
+	for (XMFLOAT4X4 &viewProjectionMatrix : mViewProjectionMatrices)
+		XMStoreFloat4x4(&viewProjectionMatrix, XMMatrixIdentity());
+}
+
+void ShadowCascades::Update(const XMFLOAT4X4 &inverseViewMatrix, float verticalFOV, float aspectRatio, float nearDistance, float shadowDistance, const XMFLOAT3 &lightDirection, unsigned int resolutionX, unsigned int resolutionY)
+{
+	XMMATRIX inverseView = XMLoadFloat4x4(&inverseViewMatrix);
+
+	// squared half diagonal of a frustum section at unit depth
+	float tanY = tan(verticalFOV / 2.0f);
+	float tanX = aspectRatio * tanY;
+	float diagonalSquared = tanX * tanX + tanY * tanY;
+
+	// the light view is a rotation only, cascades move in light space and can be snapped to texels
+	XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+	XMVECTOR up = fabs(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	XMMATRIX lightViewMatrix = XMMatrixLookToLH(XMVectorZero(), direction, up);
+
+	float cascadeNear = nearDistance;
+
+	for (unsigned int c = 0; c < NUM_CASCADES; c++)
+	{
+		// practical split: blend of the logarithmic split (even texel density) and the uniform split
+		float fraction = (float)(c + 1) / NUM_CASCADES;
+		float logSplit = nearDistance * pow(shadowDistance / nearDistance, fraction);
+		float uniformSplit = nearDistance + (shadowDistance - nearDistance) * fraction;
+
+		float cascadeFar = mSplitLambda * logSplit + (1.0f - mSplitLambda) * uniformSplit;
+		mSplitDistances[c] = cascadeFar;
+
+		// smallest sphere around the frustum slice, its center is on the view axis; the radius doesn't change when the camera turns
+		float centerDepth = std::min((cascadeNear + cascadeFar) * (1.0f + diagonalSquared) / 2.0f, cascadeFar);
+		float nearRadiusSquared = (centerDepth - cascadeNear) * (centerDepth - cascadeNear) + cascadeNear * cascadeNear * diagonalSquared;
+		float farRadiusSquared = (cascadeFar - centerDepth) * (cascadeFar - centerDepth) + cascadeFar * cascadeFar * diagonalSquared;
+		float radius = sqrt(std::max(nearRadiusSquared, farRadiusSquared));
+
+		// a texel of margin, snapping moves the projection by up to a texel
+		radius *= 1.0f + 2.0f / std::min(resolutionX, resolutionY);
+
+		XMFLOAT3 center;
+		XMStoreFloat3(&center, XMVector3Transform(XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, centerDepth, 1.0f), inverseView), lightViewMatrix));
+
+		// move the projection by whole texels only
+		float texelX = 2.0f * radius / resolutionX;
+		float texelY = 2.0f * radius / resolutionY;
+		center.x = floor(center.x / texelX) * texelX;
+		center.y = floor(center.y / texelY) * texelY;
+
+		// the near plane is pulled towards the light, casters between the light and the cascade still write depth
+		XMMATRIX projectionMatrix = XMMatrixOrthographicOffCenterLH(center.x - radius, center.x + radius, center.y - radius, center.y + radius, center.z - radius - mCasterDistance, center.z + radius);
+
+		XMStoreFloat4x4(&mViewProjectionMatrices[c], XMMatrixMultiply(lightViewMatrix, projectionMatrix));
+
+		cascadeNear = cascadeFar;
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef SHADOW_CASCADES_H
+#define SHADOW_CASCADES_H
+
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+/**** cascaded shadow maps for the directional light: the view frustum up to the shadow distance is split in NUM_CASCADES depth ranges ****/
+/**** split distances blend logarithmic and uniform splits (practical split scheme), each cascade gets its own orthographic light projection ****/
+/**** projections bound the cascade with a sphere and are snapped to shadow map texels, so shadows don't swim when the camera moves or turns ****/
+/**** the light volumes reach back towards the light to catch casters outside the view frustum; no graphics api calls ****/
+
+class ShadowCascades
+{
+public:
+	static const unsigned int NUM_CASCADES = 4;
+public:
+	ShadowCascades();
+
+	// 0 uniform splits, 1 logarithmic splits
+	void SetSplitLambda(float splitLambda) { mSplitLambda = splitLambda; }
+	// how far the light volumes extend towards the light past the cascade bounds
+	void SetCasterDistance(float casterDistance) { mCasterDistance = casterDistance; }
+
+	void Update(const XMFLOAT4X4 &inverseViewMatrix, float verticalFOV, float aspectRatio, float nearDistance, float shadowDistance, const XMFLOAT3 &lightDirection, unsigned int resolutionX, unsigned int resolutionY);
+
+	const XMFLOAT4X4 &GetViewProjectionMatrix(unsigned int cascade) const { return mViewProjectionMatrices[cascade]; }
+	float GetSplitDistance(unsigned int cascade) const { return mSplitDistances[cascade]; }      // far view depth of a cascade
+	float GetCasterDistance() const { return mCasterDistance; }
+private:
+	float mSplitLambda = 0.75f;
+	float mCasterDistance = 200.0f;
+
+	float mSplitDistances[NUM_CASCADES] = {};
+	XMFLOAT4X4 mViewProjectionMatrices[NUM_CASCADES];
+};
+
+#endif  // SHADOW_CASCADES_H
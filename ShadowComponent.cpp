@@ -0,0 +1,12 @@
+#include "ShadowComponent.h"
+#include "RenderScene.h"
+
+ShadowComponent::~ShadowComponent()
+{
+	RenderScene::GetInstance().RemoveEntity(GetOwner());
+}
+
+void ShadowComponent::Init()
+{
+	RenderScene::GetInstance().UpdateEntity(GetOwner());
+}
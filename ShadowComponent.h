@@ -6,6 +6,10 @@
 class ShadowComponent : public Component
 {
 	// tag component
+public:
+	~ShadowComponent();
+
+	void Init() override;
 };
 
 #endif  // SHADOW_COMPONENT_H
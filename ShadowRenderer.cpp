@@ -5,75 +5,52 @@
 #include "LightComponent.h"
 //#include "SkeletalMeshComponent.h"
 #include "CameraComponent.h"
+#include <algorithm>
 
 ShadowRenderer::ShadowRenderer(int width, int height, float shadowDistance)
-	: mFrameBuffer(width, height), mFrameBufferSpot(width, height), mShadowDistance(shadowDistance)
+	: mCascadeWidth(width), mCascadeHeight(height), mFrameBuffer(2 * width, 2 * height), mFrameBufferSpot(width, height), mShadowDistance(shadowDistance)
 {
 	mShadowMap.SetResourceView(mFrameBuffer.GetDepthStencilBuffer());
 	mShadowMapSpot.SetResourceView(mFrameBufferSpot.GetDepthStencilBuffer());
+
+	mCascades.SetCasterDistance(shadowDistance);
 }
 
-void ShadowRenderer::ComputeLightViewProjection(Entity *camera, Entity *light)
+void ShadowRenderer::UpdateLightViewProjection(Entity *camera, const Vector<Entity*> &lights)
 {
-	if (light->GetComponent<LightComponent>()->GetType() == LightComponent::Type::DIRECTIONAL)
+	mHasDirectionalLight = false;
+	mHasSpotLight = false;
+
+	for (Entity *light : lights)
 	{
-		CameraComponent::Frustum frustum = camera->GetComponent<CameraComponent>()->GetFrustum(mShadowDistance);
-		XMFLOAT3 lightDirection = light->GetComponent<PositionComponent>()->GetAxisZ();
-		XMFLOAT3 lightPosition = light->GetComponent<PositionComponent>()->GetPosition();
-
-		XMMATRIX inverseCameraViewMatrix = XMLoadFloat4x4(&camera->GetComponent<CameraComponent>()->GetInverseViewMatrix());
-		XMMATRIX lightViewMatrix = XMMatrixLookAtLH(XMLoadFloat3(&lightPosition), XMLoadFloat3(&lightDirection), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
-		XMMATRIX transform = XMMatrixMultiply(inverseCameraViewMatrix, lightViewMatrix);
-
-		// view frustum vertices in light space coordinates
-		XMFLOAT3 frustumVertices[8];
-		XMStoreFloat3(&frustumVertices[0], XMVector3TransformCoord(XMLoadFloat3(&frustum.nearTopLeft), transform));
-		XMStoreFloat3(&frustumVertices[1], XMVector3TransformCoord(XMLoadFloat3(&frustum.nearTopRight), transform));
-		XMStoreFloat3(&frustumVertices[2], XMVector3TransformCoord(XMLoadFloat3(&frustum.nearBottomLeft), transform));
-		XMStoreFloat3(&frustumVertices[3], XMVector3TransformCoord(XMLoadFloat3(&frustum.nearBottomRight), transform));
-		XMStoreFloat3(&frustumVertices[4], XMVector3TransformCoord(XMLoadFloat3(&frustum.farTopLeft), transform));
-		XMStoreFloat3(&frustumVertices[5], XMVector3TransformCoord(XMLoadFloat3(&frustum.farTopRight), transform));
-		XMStoreFloat3(&frustumVertices[6], XMVector3TransformCoord(XMLoadFloat3(&frustum.farBottomLeft), transform));
-		XMStoreFloat3(&frustumVertices[7], XMVector3TransformCoord(XMLoadFloat3(&frustum.farBottomRight), transform));
-
-		float xMin = frustumVertices[0].x, xMax = xMin;
-		float yMin = frustumVertices[0].y, yMax = yMin;
-		float zMin = frustumVertices[0].z, zMax = zMin;
-
-		for (XMFLOAT3 frustumVertex : frustumVertices)
-		{
-			if (frustumVertex.x < xMin)
-				xMin = frustumVertex.x;
-			if (frustumVertex.x > xMax)
-				xMax = frustumVertex.x;
-			if (frustumVertex.y < yMin)
-				yMin = frustumVertex.y;
-			if (frustumVertex.y > yMax)
-				yMax = frustumVertex.y;
-			if (frustumVertex.z < zMin)
-				zMin = frustumVertex.z;
-			if (frustumVertex.z > zMax)
-				zMax = frustumVertex.z;
-		}
+		LightComponent *lightComponent = light->GetComponent<LightComponent>();
 
-		// calculate width, height and depth of view cuboid
-		float width = xMax - xMin;
-		float height = yMax - yMin;
-		float depth = zMax - zMin;
+		if (!lightComponent->IsEnabled())
+			continue;
 
-		// calculate light's position in light space coordinates
-		float x = (xMin + xMax) / 2.0f;
-		float y = (yMin + yMax) / 2.0f;
-		float z = zMin - 0.1f;
+		if (lightComponent->GetType() == LightComponent::Type::DIRECTIONAL && !mHasDirectionalLight)
+		{
+			ComputeLightViewProjection(camera, light);
+			mHasDirectionalLight = true;
+		}
+		else if (lightComponent->GetType() == LightComponent::Type::SPOT && !mHasSpotLight)
+		{
+			ComputeLightViewProjection(camera, light);
+			mHasSpotLight = true;
+		}
+	}
+}
 
-		// light's position in world space coordinates
-		XMVECTOR viewPosition = XMVectorSet(x, y, z, 1.0f);
-		XMVECTOR worldViewPosition = XMVector3TransformCoord(viewPosition, XMMatrixInverse(nullptr, lightViewMatrix));
-		XMMATRIX viewMatrix = XMMatrixLookAtLH(worldViewPosition, worldViewPosition + XMLoadFloat3(&lightDirection), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+void ShadowRenderer::ComputeLightViewProjection(Entity *camera, Entity *light)
+{
+	if (light->GetComponent<LightComponent>()->GetType() == LightComponent::Type::DIRECTIONAL)
+	{
+		CameraComponent *cameraComponent = camera->GetComponent<CameraComponent>();
+		XMFLOAT3 lightDirection = light->GetComponent<PositionComponent>()->GetAxisZ();
 
-		XMMATRIX projectionMatrix = XMMatrixOrthographicLH(width, height, 0.1f, 0.1f + depth);
+		float shadowDistance = std::min(mShadowDistance, cameraComponent->GetFarDistance());
 
-		XMStoreFloat4x4(&mLightViewProjectionMatrix, XMMatrixMultiply(viewMatrix, projectionMatrix));
+		mCascades.Update(cameraComponent->GetInverseViewMatrix(), cameraComponent->GetVerticalFOV(), cameraComponent->GetAspectRatio(), cameraComponent->GetNearDistance(), shadowDistance, lightDirection, mCascadeWidth, mCascadeHeight);
 	}
 
 	if (light->GetComponent<LightComponent>()->GetType() == LightComponent::Type::SPOT)
@@ -84,57 +61,39 @@ void ShadowRenderer::ComputeLightViewProjection(Entity *camera, Entity *light)
 		XMFLOAT3 lightDirection = positionComponent->GetAxisZ();
 
 		XMMATRIX lightViewMatrix = XMMatrixLookAtLH(XMLoadFloat3(&lightPosition), XMLoadFloat3(&lightPosition) + XMLoadFloat3(&lightDirection), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
-		XMMATRIX lightProjectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(90.0f), 3.0f / 2.0f, 0.1f, 500.0f);
+		XMMATRIX lightProjectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(90.0f), (float)mFrameBufferSpot.GetWidth() / mFrameBufferSpot.GetHeight(), 0.1f, 500.0f);
 
 		XMStoreFloat4x4(&mLightViewProjectionMatrixSpot, XMMatrixMultiply(lightViewMatrix, lightProjectionMatrix));
 	}
 }
 
-void ShadowRenderer::Render(Entity *camera, Entity *light, Entity *spotlight)
+void ShadowRenderer::Render()
 {
-	ComputeLightViewProjection(camera, light);  // call from rendering system (multiple light sources)
-	ComputeLightViewProjection(camera, spotlight);
-
-	Vector<Entity*> staticEntities;
-	Vector<Entity*> animatedEntities;
-
-	for (Entity *entity : mEntities)
-		if (entity->HasComponent<StaticMeshComponent>())
-			staticEntities.InsertLast(entity);
-		else
-			animatedEntities.InsertLast(entity);
-
 	// render static entities' shadows
 	mShader.Use();
 
+	// cascades are rendered in the quadrants of the atlas, cascade c at column c % 2 and row c / 2
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
 	mFrameBuffer.Set(true);
 
-	for (Entity *entity : staticEntities)
+	for (unsigned int c = 0; c < ShadowCascades::NUM_CASCADES; c++)
 	{
-		StaticMeshComponent *staticMeshComponent = entity->GetComponent<StaticMeshComponent>();
+		RenderDevice::Viewport viewport;
+		viewport.x = (float)(c % 2 * mCascadeWidth);
+		viewport.y = (float)(c / 2 * mCascadeHeight);
+		viewport.width = (float)mCascadeWidth;
+		viewport.height = (float)mCascadeHeight;
 
-		mShader.UpdateTransformConstantBuffer(entity->GetComponent<PositionComponent>()->GetWorldMatrixScale(), mLightViewProjectionMatrix);
+		renderDevice.SetViewport(viewport);
 
-		Mesh mesh = staticMeshComponent->GetMeshes()[0];
-		mesh.BindAttribute("POSITION", 0);  // bind just position vertex attribute
-		mesh.Draw();
+		RenderShadowMap(mEntities[c], mCascades.GetViewProjectionMatrix(c));
 	}
 
 	mFrameBuffer.Unset();
 
 	mFrameBufferSpot.Set(true);
-
-	for (Entity *entity : staticEntities)
-	{
-		StaticMeshComponent *staticMeshComponent = entity->GetComponent<StaticMeshComponent>();
-
-		mShader.UpdateTransformConstantBuffer(entity->GetComponent<PositionComponent>()->GetWorldMatrixScale(), mLightViewProjectionMatrixSpot);
-
-		Mesh mesh = staticMeshComponent->GetMeshes()[0];
-		mesh.BindAttribute("POSITION", 0);  // bind just position vertex attribute
-		mesh.Draw();
-	}
-
+	RenderShadowMap(mEntitiesSpot, mLightViewProjectionMatrixSpot);
 	mFrameBufferSpot.Unset();
 
 	// render animated entities' shadows
@@ -149,13 +108,35 @@ void ShadowRenderer::Render(Entity *camera, Entity *light, Entity *spotlight)
 
 		for (Mesh *mesh : skeletalMeshComponent->GetMeshes())
 		{
-			mesh->BindAttribute("POSITION", 0);
-			mesh->BindAttribute("BONE_IDS", 1);
-			mesh->BindAttribute("BONE_WEIGHTS", 2);
+			mesh->BindAttribute(VertexLayout::Attribute::POSITION, 0);
+			mesh->BindAttribute(VertexLayout::Attribute::BONE_IDS, 1);
+			mesh->BindAttribute(VertexLayout::Attribute::BONE_WEIGHTS, 2);
 			mesh->BindIndexBuffer();
 			mesh->Draw();
 		}		
 	}*/
+}
+
+void ShadowRenderer::RenderShadowMap(Vector<Entity*> &entities, const XMFLOAT4X4 &lightViewProjectionMatrix)
+{
+	for (Entity *entity : entities)
+	{
+		if (!entity->HasComponent<StaticMeshComponent>())   // TODO: animated entities' shadows
+			continue;
+
+		StaticMeshComponent *staticMeshComponent = entity->GetComponent<StaticMeshComponent>();
+
+		MeshHandle mesh = staticMeshComponent->GetMeshHandles()[0];
+
+		// quantised positions are dequantised by the world matrix
+		XMFLOAT4X4 worldMatrix;
+		XMStoreFloat4x4(&worldMatrix, XMMatrixMultiply(RenderResources::GetInstance().GetDequantizationMatrix(mesh), XMLoadFloat4x4(&entity->GetComponent<PositionComponent>()->GetWorldMatrixScale())));
+
+		mShader.UpdateTransformConstantBuffer(worldMatrix, lightViewProjectionMatrix);
+
+		RenderResources::GetInstance().BindMeshPositions(mesh);  // bind just position vertex attribute
+		RenderResources::GetInstance().DrawMesh(mesh);
+	}
 
-	mEntities.Clear();
+	entities.Clear();
 }
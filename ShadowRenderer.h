@@ -5,40 +5,61 @@
 #include "FrameBuffer.h"
 #include "Texture.h"
 #include "StaticShadowShader.h"
+#include "ShadowCascades.h"
 //#include "AnimatedShadowShader.h"
 
 class Entity;
 
+/**** the directional light casts shadows through ShadowCascades::NUM_CASCADES cascades, rendered in the quadrants of one shadow map atlas ****/
+/**** casters are culled against each cascade before they are added, so each pass only draws the casters of its own cascade ****/
+
 class ShadowRenderer
 {
 public:
+	enum class ShadowMap { DIRECTIONAL, SPOT, };
+public:
+	// width and height of a cascade, the atlas is twice as wide and high
 	ShadowRenderer(int width, int height, float shadowDistance = 200.0f);
 
-	void AddEntity(Entity *entity) { mEntities.InsertLast(entity); }
+	void AddEntity(Entity *entity, ShadowMap shadowMap, unsigned int cascade = 0) { shadowMap == ShadowMap::DIRECTIONAL ? mEntities[cascade].InsertLast(entity) : mEntitiesSpot.InsertLast(entity); }
+
+	// light matrices are needed to cull the shadow casters before they are added, the first enabled directional and spot lights cast shadows
+	void UpdateLightViewProjection(Entity *camera, const Vector<Entity*> &lights);
 
-	void Render(Entity *camera, Entity *light, Entity *spotlight);
+	void Render();
 
-	const XMFLOAT4X4 &GetLightViewProjectionMatrix() const { return mLightViewProjectionMatrix; }
-	Texture GetShadowMap() { return mShadowMap; }
+	bool HasDirectionalLight() const { return mHasDirectionalLight; }
+	const ShadowCascades &GetCascades() const { return mCascades; }
+	Texture GetShadowMap() const { return mShadowMap; }
 
+	bool HasSpotLight() const { return mHasSpotLight; }
 	const XMFLOAT4X4 &GetLightViewProjectionMatrixSpot() const { return mLightViewProjectionMatrixSpot; }
-	Texture GetShadowMapSpot() { return mShadowMapSpot; }
+	Texture GetShadowMapSpot() const { return mShadowMapSpot; }
 
 	float GetShadowDistance() const { return mShadowDistance; }
 private:
-	Vector<Entity*> mEntities;
+	void RenderShadowMap(Vector<Entity*> &entities, const XMFLOAT4X4 &lightViewProjectionMatrix);
+
+	Vector<Entity*> mEntities[ShadowCascades::NUM_CASCADES];
+	Vector<Entity*> mEntitiesSpot;
 
 	StaticShadowShader mShader;
 	//AnimationShadowShader mAnimationShader;
 
-	FrameBuffer mFrameBuffer;	
+	int mCascadeWidth;
+	int mCascadeHeight;
+
+	FrameBuffer mFrameBuffer;        // cascade atlas
 	FrameBuffer mFrameBufferSpot;
 	Texture mShadowMap;
 	Texture mShadowMapSpot;
 
 	void ComputeLightViewProjection(Entity *camera, Entity *light);
-	XMFLOAT4X4 mLightViewProjectionMatrix;
+	ShadowCascades mCascades;
 	XMFLOAT4X4 mLightViewProjectionMatrixSpot;
+
+	bool mHasDirectionalLight = false;
+	bool mHasSpotLight = false;
 	
 	float mShadowDistance;
 };
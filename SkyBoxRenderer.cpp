@@ -20,8 +20,12 @@ void SkyBoxRenderer::Render(Entity *skyBox, Entity *camera)
 	XMStoreFloat4x4(&worldViewProjectionMatrix, XMMatrixMultiply(XMMatrixMultiply(XMLoadFloat4x4(&worldMatrix), XMLoadFloat4x4(&viewMatrix)), XMLoadFloat4x4(&projectionMatrix)));
 	mShader.UpdateTransformConstantBuffer(worldViewProjectionMatrix);
 
-	skyBox->GetComponent<StaticMeshComponent>()->GetMaterials()[0].GetDiffuseMaps()[0].Bind(0);
+	StaticMeshComponent *staticMeshComponent = skyBox->GetComponent<StaticMeshComponent>();
+	RenderResources &resources = RenderResources::GetInstance();
 
-	skyBox->GetComponent<StaticMeshComponent>()->GetMeshes()[0].Bind();
-	skyBox->GetComponent<StaticMeshComponent>()->GetMeshes()[0].Draw();
+	// cube map is the diffuse map
+	GraphicsSystem::GetInstance().GetRenderDevice().SetTexture(RenderDevice::ShaderStage::PIXEL, 0, resources.GetMaterial(staticMeshComponent->GetMaterialHandles()[0]).diffuseMap);
+
+	resources.BindMesh(staticMeshComponent->GetMeshHandles()[0]);
+	resources.DrawMesh(staticMeshComponent->GetMeshHandles()[0]);
 }
\ No newline at end of file
@@ -21,8 +21,8 @@ private:
 	void CreateConstantBuffers();
 	void CreateSamplerStates();
 
-	ID3D11Buffer *mTransformConstantBuffer;
-	ID3D11SamplerState *mSamplerState;
+	BufferHandle mTransformConstantBuffer;
+	SamplerHandle mSamplerState;
 };
 
 #endif  // SKYBOX_SHADER_H
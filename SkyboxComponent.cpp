@@ -1 +1,12 @@
 #include "SkyboxComponent.h"
+#include "RenderScene.h"
+
+SkyboxComponent::~SkyboxComponent()
+{
+	RenderScene::GetInstance().RemoveEntity(GetOwner());
+}
+
+void SkyboxComponent::Init()
+{
+	RenderScene::GetInstance().UpdateEntity(GetOwner());
+}
@@ -6,6 +6,10 @@
 class SkyboxComponent : public Component
 {
 	// tag component
+public:
+	~SkyboxComponent();
+
+	void Init() override;
 };
 
 #endif  // SKYBOX_COMPONENT_H
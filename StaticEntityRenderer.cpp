@@ -1,70 +1,219 @@
 #include "StaticEntityRenderer.h"
 #include "Entity.h"
 #include "Texture.h"
+#include "TextureManager.h"
 #include "PositionComponent.h"
 #include "StaticMeshComponent.h"
 #include "CameraComponent.h"
+#include "LightComponent.h"
+#include "GraphicsSystem.h"
 #include "Game.h"
+#include "RenderScene.h"
+#include "ShadowRenderer.h"
+#include "utility/RadixSort.h"
+#include <algorithm>
+
+// simplification error allowed on screen, in pixels
+static const float MAX_PIXEL_ERROR = 1.0f;
+// relative change of the projected size before the detail levels are selected again
+static const float LOD_HYSTERESIS = 0.15f;
+// tiling below this doesn't make textures wanted at more detail
+static const float MIN_TILING = 0.01f;
+
+unsigned int StaticEntityRenderer::SelectLOD(const RenderResources::MeshRecord &mesh, float projectedSize)
+{
+	unsigned int lod = 0;
+
+	while (lod + 1 < mesh.numLODs && mesh.lods[lod + 1].error * projectedSize <= MAX_PIXEL_ERROR)
+		lod++;
+
+	return lod;
+}
+
+void StaticEntityRenderer::PrepareLights(const CameraComponent *cameraComponent, const XMFLOAT4X4 &viewMatrix, Vector<Entity*> const &lights)
+{
+	mShaderLights.clear();
+	mClusterLights.clear();
+
+	// directional lights light every fragment
+	for (Entity *light : lights)
+	{
+		LightComponent *lightComponent = light->GetComponent<LightComponent>();
+
+		if (lightComponent->IsEnabled() && lightComponent->GetType() == LightComponent::Type::DIRECTIONAL && mShaderLights.size() < LightClusterer::MAX_LIGHTS)
+			mShaderLights.push_back(light);
+	}
+
+	unsigned int numGlobalLights = (unsigned int)mShaderLights.size();
+
+	// point and spot lights are binned into the clusters they reach
+	for (Entity *light : lights)
+	{
+		LightComponent *lightComponent = light->GetComponent<LightComponent>();
+
+		if (!lightComponent->IsEnabled() || lightComponent->GetType() == LightComponent::Type::DIRECTIONAL || mShaderLights.size() == LightClusterer::MAX_LIGHTS)
+			continue;
 
-void StaticEntityRenderer::Render(Entity *camera, Vector<Entity*> const &lights, Texture shadowMap, Texture shadowMapSpot, XMFLOAT4X4 const &lightViewProjectionMatrix, XMFLOAT4X4 const &lightViewProjectionMatrixSpot, float shadowDistance)
+		PositionComponent *positionComponent = light->GetComponent<PositionComponent>();
+
+		LightClusterer::Light clusterLight;
+		clusterLight.position = positionComponent->GetPosition();
+		clusterLight.range = lightComponent->GetRange();
+		clusterLight.direction = positionComponent->GetAxisZ();
+		clusterLight.spotAngle = lightComponent->GetType() == LightComponent::Type::SPOT ? lightComponent->GetSpotLightAngle() : 0.0f;
+
+		mShaderLights.push_back(light);
+		mClusterLights.push_back(clusterLight);
+	}
+
+	mClusterer.SetProjection(cameraComponent->GetVerticalFOV(), cameraComponent->GetAspectRatio(), cameraComponent->GetNearDistance(), cameraComponent->GetFarDistance());
+	mClusterer.BinLights(viewMatrix, mClusterLights);
+
+	RenderDevice::Viewport viewport = GraphicsSystem::GetInstance().GetRenderDevice().GetViewport();
+
+	mShader.UpdateLightConstantBuffer(mShaderLights);
+	mShader.UpdateClusterConstantBuffers(mClusterer, numGlobalLights, viewport.width, viewport.height);
+}
+
+void StaticEntityRenderer::Render(Entity *camera, Vector<Entity*> const &lights, const ShadowRenderer &shadowRenderer)
 {
 	mShader.Use();
 
-	mShader.UpdateCameraConstantBuffer(camera->GetComponent<CameraComponent>()->GetPosition(), shadowDistance);
-	mShader.UpdateLightConstantBuffer(lights);
+	CameraComponent *cameraComponent = camera->GetComponent<CameraComponent>();
 
-	XMFLOAT4X4 viewMatrix = camera->GetComponent<CameraComponent>()->GetViewMatrix();
-	XMFLOAT4X4 projectionMatrix = camera->GetComponent<CameraComponent>()->GetProjectionMatrix();
+	mShader.UpdateCameraConstantBuffer(cameraComponent->GetPosition(), shadowRenderer.GetShadowDistance());
+	mShader.UpdateShadowConstantBuffer(shadowRenderer.GetCascades());
+
+	XMFLOAT4X4 viewMatrix = cameraComponent->GetViewMatrix();
+
+	PrepareLights(cameraComponent, viewMatrix, lights);
+
+	XMFLOAT4X4 projectionMatrix = cameraComponent->GetProjectionMatrix();
+	XMMATRIX viewProjectionMatrix = XMMatrixMultiply(XMLoadFloat4x4(&viewMatrix), XMLoadFloat4x4(&projectionMatrix));
+	float depthScale = ((1u << DEPTH_BITS) - 1) / cameraComponent->GetFarDistance();
+
+	Texture shadowMap = shadowRenderer.GetShadowMap();
+	Texture shadowMapSpot = shadowRenderer.GetShadowMapSpot();
 
 	shadowMap.Bind(0);
 	shadowMapSpot.Bind(4);
 
-	for (Entity *entity : mEntities)
+	RenderScene &scene = RenderScene::GetInstance();
+	const RenderResources &resources = RenderResources::GetInstance();
+	TextureManager &textureManager = TextureManager::GetInstance();
+
+	// depth only needs the w column of the view projection matrix
+	XMVECTOR viewProjectionW = XMMatrixTranspose(viewProjectionMatrix).r[3];
+
+	// pixels covered by a unit length at unit depth
+	float pixelScale = projectionMatrix._22 * GraphicsSystem::GetInstance().GetRenderDevice().GetViewport().height / 2.0f;
+
+	// build draw packets, world and normal matrices are kept up to date by the render scene
+	mDrawPackets.clear();
+
+	for (unsigned int proxy : mProxies)
 	{
-		PositionComponent *positionComponent = entity->GetComponent<PositionComponent>();
-		StaticMeshComponent *staticMeshComponent = entity->GetComponent<StaticMeshComponent>();
+		const StaticMeshComponent *staticMeshComponent = scene.GetProxy(proxy).staticMesh;
 
-		XMFLOAT4X4 worldMatrix = positionComponent->GetWorldMatrixScale();
+		// view depth of the entity origin (w of the clip space position), front to back within the same material and mesh
+		const XMFLOAT4 &origin = scene.GetTransform(proxy).worldMatrix[3];
+		float depth = XMVectorGetX(XMVector4Dot(XMLoadFloat4(&origin), viewProjectionW));
 
-		XMFLOAT4X4 worldInverseTransposeMatrix;
-		XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixTranspose(XMMatrixInverse(nullptr, XMLoadFloat4x4(&worldMatrix))));
+		uint64_t depthKey = (uint64_t)std::min(std::max(depth * depthScale, 0.0f), (float)((1u << DEPTH_BITS) - 1));
 
-		XMFLOAT4X4 worldViewProjectionMatrix;
-		XMStoreFloat4x4(&worldViewProjectionMatrix, XMMatrixMultiply(XMMatrixMultiply(XMLoadFloat4x4(&worldMatrix), XMLoadFloat4x4(&viewMatrix)), XMLoadFloat4x4(&projectionMatrix)));
+		// projected diameter of the bounds, detail levels change only when it moves out of the hysteresis band
+		XMFLOAT3 center, extent;
+		scene.GetCuller().GetBounds(proxy, center, extent);
 
-		mShader.UpdateTransformConstantBuffer(worldMatrix, worldInverseTransposeMatrix, worldViewProjectionMatrix, lightViewProjectionMatrix, lightViewProjectionMatrixSpot);
+		float projectedSize = 2.0f * XMVectorGetX(XMVector3Length(XMLoadFloat3(&extent))) * pixelScale / std::max(depth, cameraComponent->GetNearDistance());
+		float lodSize = scene.GetProxy(proxy).lodSize;
 
-		Material material = staticMeshComponent->GetMaterials()[0];
-		mShader.UpdateMaterialConstantBuffer(material);
+		if (projectedSize > lodSize * (1.0f + LOD_HYSTERESIS) || projectedSize < lodSize * (1.0f - LOD_HYSTERESIS))
+		{
+			lodSize = projectedSize;
+			scene.SetLODSize(proxy, lodSize);
+		}
 
-		Mesh mesh = staticMeshComponent->GetMeshes()[0];
+		const std::vector<MeshHandle> &meshes = staticMeshComponent->GetMeshHandles();
+		const std::vector<MaterialHandle> &materials = staticMeshComponent->GetMaterialHandles();
 
-		if (staticMeshComponent->GetMaterials()[0].HasDiffuseMap())
+		for (unsigned int j = 0; j < (unsigned int)meshes.size(); j++)
 		{
-			Texture texture = staticMeshComponent->GetMaterials()[0].GetDiffuseMaps()[0];
-			texture.Bind(1);
+			DrawPacket packet;
+			packet.lod = SelectLOD(resources.GetMesh(meshes[j]), lodSize);
+
+			// textures are wanted at the size of one repeat on screen
+			const RenderResources::MaterialRecord &material = resources.GetMaterial(materials[j]);
+			float textureSize = lodSize / std::max(std::max(material.block.tilingH, material.block.tilingV), MIN_TILING);
+
+			textureManager.UseTexture(material.diffuseMap, textureSize);
+			textureManager.UseTexture(material.specularMap, textureSize);
+			textureManager.UseTexture(material.normalMap, textureSize);
+
+			packet.key = (uint64_t)Pass::OPAQUE_PASS << PASS_SHIFT | (uint64_t)0 << SHADER_SHIFT | GetID(materials[j]) << MATERIAL_SHIFT | GetID(meshes[j]) << MESH_SHIFT | (uint64_t)packet.lod << LOD_SHIFT | depthKey;
+			packet.proxy = proxy;
+			packet.mesh = meshes[j];
+			packet.material = materials[j];
+
+			mDrawPackets.push_back(packet);
 		}
+	}
+
+	RadixSort(mDrawPackets, mSortScratch, [](const DrawPacket &packet) { return packet.key; });
+
+	// merge consecutive packets with the same pass, shader, material, mesh and detail level
+	mBatcher.Clear();
+
+	for (unsigned int i = 0; i < (unsigned int)mDrawPackets.size(); i++)
+	{
+		const DrawPacket &packet = mDrawPackets[i];
 
-		if (staticMeshComponent->GetMaterials()[0].HasSpecularMap())
+		uint64_t batchKey = packet.key >> LOD_SHIFT;
+		if ((packet.key >> MESH_SHIFT & 0xFFFF) == MAX_IDS || (packet.key >> MATERIAL_SHIFT & 0xFFFF) == MAX_IDS)
+			batchKey = InstanceBatcher::UNIQUE_KEY;
+
+		mBatcher.Add(batchKey, i, scene.GetTransform(packet.proxy));
+	}
+
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, viewProjectionMatrix);
+
+	mShader.UpdateTransformConstantBuffer(viewProjection, shadowRenderer.GetLightViewProjectionMatrixSpot());
+	mShader.UpdateInstanceBuffer(mBatcher.GetInstances());
+
+	// submit, rebinding material and mesh only when they change
+	uint64_t currentMaterial = ~0ull;
+	uint64_t currentMesh = ~0ull;
+
+	for (const InstanceBatcher::Batch &batch : mBatcher.GetBatches())
+	{
+		const DrawPacket &packet = mDrawPackets[batch.item];
+
+		uint64_t material = packet.key >> MATERIAL_SHIFT;            // pass, shader and material bits
+		uint64_t mesh = packet.key >> MESH_SHIFT & 0xFFFF;
+
+		if (material != currentMaterial || (material & 0xFFFF) == MAX_IDS)
 		{
-			Texture texture = staticMeshComponent->GetMaterials()[0].GetSpecularMaps()[0];
-			texture.Bind(2);
+			mShader.UpdateMaterialConstantBuffer(resources.GetMaterial(packet.material).block);
+			resources.BindMaterialTextures(packet.material, 1, 2, 3);
+
+			currentMaterial = material;
 		}
 
-		if (staticMeshComponent->GetMaterials()[0].HasNormalMap())
+		if (mesh != currentMesh || mesh == MAX_IDS)
 		{
-			Texture texture = staticMeshComponent->GetMaterials()[0].GetNormalMaps()[0];
-			texture.Bind(3);
+			resources.BindMesh(packet.mesh);
+			mShader.UpdateMeshConstantBuffer(resources.GetMesh(packet.mesh));
+
+			currentMesh = mesh;
 		}
-	
-		// bind and draw mesh
-		mesh.Bind();
-		mesh.Draw();
+
+		resources.DrawMeshInstanced(packet.mesh, batch.numInstances, batch.firstInstance, packet.lod);
 	}
 
 	shadowMap.Unbind();
 	shadowMapSpot.Unbind();
 
-	// clear entities queue
-	mEntities.Clear();
-}
\ No newline at end of file
+	// clear proxies queue
+	mProxies.clear();
+}
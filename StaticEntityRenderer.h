@@ -3,19 +3,66 @@
 
 #include "data structures/Vector.h"
 #include "StaticEntityShader.h"
+#include "InstanceBatcher.h"
+#include "RenderResources.h"
+#include "LightClusterer.h"
+#include <vector>
+#include <cstdint>
 
 class Entity;
 class Texture;
+class CameraComponent;
+class ShadowRenderer;
+
+/**** every sub-mesh is a draw packet with a 64 bit sort key: pass | shader | material | mesh | depth, material and mesh ids are their resource handles ****/
+/**** packets are radix sorted each frame so that consecutive draws sharing a material (or a mesh) skip the rebinds ****/
+/**** packets sharing material, mesh and detail level are merged into instance batches, one instanced draw per batch ****/
+/**** detail levels are picked from the projected size of the entity bounds, which is only refreshed when it leaves a hysteresis band ****/
+/**** point and spot lights are binned into view frustum clusters, each fragment shades only the lights of its cluster ****/
 
 class StaticEntityRenderer
 {
 public:
-	void Render(Entity *camera, Vector<Entity*> const &lights, Texture shadowMap, Texture shadowMapSpot, XMFLOAT4X4 const &lightViewProjectionMatrix, XMFLOAT4X4 const &lightViewProjectionMatrixSpot, float shadowDistance);
-	void AddEntity(Entity *entity) { mEntities.InsertLast(entity); }
+	void Render(Entity *camera, Vector<Entity*> const &lights, const ShadowRenderer &shadowRenderer);
+	void AddProxy(unsigned int proxy) { mProxies.push_back(proxy); }    // render scene proxy
 private:
+	struct DrawPacket
+	{
+		uint64_t key;
+		unsigned int proxy;      // render scene proxy
+		MeshHandle mesh;
+		MaterialHandle material;
+		unsigned int lod;
+	};
+
+	// sort key layout
+	static const unsigned int PASS_SHIFT = 62;
+	static const unsigned int SHADER_SHIFT = 56;
+	static const unsigned int MATERIAL_SHIFT = 40;
+	static const unsigned int MESH_SHIFT = 24;
+	static const unsigned int LOD_SHIFT = 22;
+	static const unsigned int DEPTH_BITS = 22;
+	static const unsigned int MAX_IDS = 0xFFFF;     // handles past the id bits are never merged or skipped
+
+	enum class Pass { OPAQUE_PASS = 0, };
+
+	static uint64_t GetID(uint32_t handle) { return handle < MAX_IDS ? handle : MAX_IDS; }
+
+	// coarsest detail level whose error is small enough at the given projected size (pixels)
+	static unsigned int SelectLOD(const RenderResources::MeshRecord &mesh, float projectedSize);
+
+	void PrepareLights(const CameraComponent *cameraComponent, const XMFLOAT4X4 &viewMatrix, Vector<Entity*> const &lights);
+
 	StaticEntityShader mShader;
-	Vector<Entity*> mEntities;
+	std::vector<unsigned int> mProxies;
+
+	std::vector<DrawPacket> mDrawPackets;
+	std::vector<DrawPacket> mSortScratch;
+	InstanceBatcher mBatcher;
+
+	LightClusterer mClusterer;
+	std::vector<Entity*> mShaderLights;                        // directional lights, then the clustered lights
+	std::vector<LightClusterer::Light> mClusterLights;
 };
 
 #endif  // STATIC_ENTITY_RENDERER_H
-
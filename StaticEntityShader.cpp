@@ -2,9 +2,9 @@
 #include "Entity.h"
 #include "PositionComponent.h"
 #include "LightComponent.h"
-#include "Material.h"
 #include "GraphicsSystem.h"
-#include "Error.h"
+#include "VertexLayout.h"
+#include <cstring>
 
 StaticEntityShader::StaticEntityShader() : Shader(L"shaders/StaticEntityVertexShader.hlsl", nullptr, L"shaders/StaticEntityPixelShader.hlsl")
 {
@@ -15,133 +15,117 @@ StaticEntityShader::StaticEntityShader() : Shader(L"shaders/StaticEntityVertexSh
 
 void StaticEntityShader::CreateInputLayout()
 {
-	HRESULT hr;
+	typedef RenderDevice::Format Format;
+	const unsigned int APPEND_ALIGNED = RenderDevice::APPEND_ALIGNED;
 
-	// describe input layout
-	D3D11_INPUT_ELEMENT_DESC inputLayout[] =
+	// mesh streams of the static mesh layout
+	std::vector<RenderDevice::InputElement> inputLayout;
+	VertexLayout::GetStaticMeshLayout().GetInputElements(inputLayout);
+
+	// per instance world matrix and world inverse transpose matrix rows
+	RenderDevice::InputElement instanceElements[] =
 	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 2, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEX_COORD", 0, DXGI_FORMAT_R32G32_FLOAT, 3, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "INSTANCE_WORLD", 0, Format::R32G32B32A32_FLOAT, INSTANCE_SLOT, 0, true },
+		{ "INSTANCE_WORLD", 1, Format::R32G32B32A32_FLOAT, INSTANCE_SLOT, APPEND_ALIGNED, true },
+		{ "INSTANCE_WORLD", 2, Format::R32G32B32A32_FLOAT, INSTANCE_SLOT, APPEND_ALIGNED, true },
+		{ "INSTANCE_WORLD", 3, Format::R32G32B32A32_FLOAT, INSTANCE_SLOT, APPEND_ALIGNED, true },
+		{ "INSTANCE_WORLD_INVERSE_TRANSPOSE", 0, Format::R32G32B32A32_FLOAT, INSTANCE_SLOT, APPEND_ALIGNED, true },
+		{ "INSTANCE_WORLD_INVERSE_TRANSPOSE", 1, Format::R32G32B32A32_FLOAT, INSTANCE_SLOT, APPEND_ALIGNED, true },
+		{ "INSTANCE_WORLD_INVERSE_TRANSPOSE", 2, Format::R32G32B32A32_FLOAT, INSTANCE_SLOT, APPEND_ALIGNED, true },
 	};
 
-	// create input layout
-	hr = GraphicsSystem::GetInstance().GetDevice()->CreateInputLayout(inputLayout, 4, mVertexShaderCode->GetBufferPointer(), mVertexShaderCode->GetBufferSize(), &mInputLayout);
-	if (FAILED(hr))
-		ErrorBox("input layout creation failed");
+	inputLayout.insert(inputLayout.end(), instanceElements, instanceElements + sizeof(instanceElements) / sizeof(instanceElements[0]));
 
-	mVertexShaderCode->Release();
+	// create input layout
+	mInputLayout = GraphicsSystem::GetInstance().GetRenderDevice().CreateInputLayout(mShader, &inputLayout[0], (unsigned int)inputLayout.size());
 }
 
 void StaticEntityShader::CreateConstantBuffers()
 {
-	HRESULT hr;
-
-	// create transform constant buffer
-	D3D11_BUFFER_DESC transformBufDesc = {};
-	transformBufDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	transformBufDesc.ByteWidth = sizeof(TransformConstantBuffer);
-	transformBufDesc.Usage = D3D11_USAGE_DYNAMIC;
-	transformBufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	transformBufDesc.MiscFlags = 0;
-	transformBufDesc.StructureByteStride = 0;
-
-	hr = GraphicsSystem::GetInstance().GetDevice()->CreateBuffer(&transformBufDesc, nullptr, &mTransformConstantBuffer);  // empty buffer
-	if (FAILED(hr))
-		ErrorBox("constant buffer creation failed");
-
-	// create material constant buffer
-	D3D11_BUFFER_DESC matBufDesc = {};
-	matBufDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	matBufDesc.ByteWidth = sizeof(MaterialConstantBuffer);
-	matBufDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matBufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	matBufDesc.MiscFlags = 0;
-	matBufDesc.StructureByteStride = 0;
-
-	hr = GraphicsSystem::GetInstance().GetDevice()->CreateBuffer(&matBufDesc, nullptr, &mMaterialConstantBuffer);  // empty buffer
-	if (FAILED(hr))
-		ErrorBox("constant buffer creation failed");
-
-	// create lights constant buffer
-	D3D11_BUFFER_DESC lightsBufDesc = {};
-	lightsBufDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightsBufDesc.ByteWidth = sizeof(LightConstantBuffer);
-	lightsBufDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightsBufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightsBufDesc.MiscFlags = 0;
-	lightsBufDesc.StructureByteStride = 0;
-
-	hr = GraphicsSystem::GetInstance().GetDevice()->CreateBuffer(&lightsBufDesc, nullptr, &mLightConstantBuffer);  // empty buffer
-	if (FAILED(hr))
-		ErrorBox("constant buffer creation failed");
-
-	// create camera constant buffer
-	D3D11_BUFFER_DESC cameraBufDesc = {};
-	cameraBufDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	cameraBufDesc.ByteWidth = sizeof(CameraConstantBuffer);
-	cameraBufDesc.Usage = D3D11_USAGE_DYNAMIC;
-	cameraBufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	cameraBufDesc.MiscFlags = 0;
-	cameraBufDesc.StructureByteStride = 0;
-
-	hr = GraphicsSystem::GetInstance().GetDevice()->CreateBuffer(&cameraBufDesc, nullptr, &mCameraConstantBuffer);  // empty buffer
-	if (FAILED(hr))
-		ErrorBox("constant buffer creation failed");
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	// create constant buffers (empty)
+	mTransformConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(TransformConstantBuffer), nullptr);
+	mMeshConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(MeshConstantBuffer), nullptr);
+	mMaterialConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(MaterialConstantBuffer), nullptr);
+	mLightConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(LightConstantBuffer), nullptr);
+	mCameraConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(CameraConstantBuffer), nullptr);
+	mShadowConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(ShadowConstantBuffer), nullptr);
+	mClusterConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(ClusterConstantBuffer), nullptr);
+	mLightIndexConstantBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::CONSTANT, RenderDevice::Usage::DYNAMIC, sizeof(LightIndexConstantBuffer), nullptr);
 }
 
 void StaticEntityShader::CreateSamplerStates()
 {
-	HRESULT hr;
-
-	// describe sampler state
-	D3D11_SAMPLER_DESC samplerDesc = {};
-	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.MipLODBias = 0.0f;
-	samplerDesc.MaxAnisotropy = 1;
-	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-	samplerDesc.BorderColor[0] = 0;
-	samplerDesc.BorderColor[1] = 0;
-	samplerDesc.BorderColor[2] = 0;
-	samplerDesc.BorderColor[3] = 0;
-	samplerDesc.MinLOD = 0.0f;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-	// create sampler state
-	hr = GraphicsSystem::GetInstance().GetDevice()->CreateSamplerState(&samplerDesc, &mSamplerState);
-	if (FAILED(hr))
-		ErrorBox("sampler state creation failed");
+	mSamplerState = GraphicsSystem::GetInstance().GetRenderDevice().CreateSampler(RenderDevice::Filter::LINEAR, RenderDevice::AddressMode::WRAP);
+}
+
+void StaticEntityShader::CreateInstanceBuffer(unsigned int capacity)
+{
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	if (mInstanceBuffer)
+		renderDevice.ReleaseBuffer(mInstanceBuffer);
+
+	// dynamic vertex buffer, rewritten every frame
+	mInstanceBuffer = renderDevice.CreateBuffer(RenderDevice::BufferType::VERTEX, RenderDevice::Usage::DYNAMIC, sizeof(InstanceBatcher::Instance) * capacity, nullptr);
+
+	mInstanceCapacity = capacity;
 }
 
-void StaticEntityShader::UpdateTransformConstantBuffer(const XMFLOAT4X4 &worldMatrix, const XMFLOAT4X4 &worldInverseTransposeMatrix, const XMFLOAT4X4 &worldViewProjectionMatrix, const XMFLOAT4X4 &lightViewProjectionMatrix, const XMFLOAT4X4 &lightViewProjectionMatrixSpot)
+void StaticEntityShader::UpdateInstanceBuffer(const std::vector<InstanceBatcher::Instance> &instances)
 {
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	if (instances.empty())
+		return;
+
+	// grow geometrically so that the buffer is recreated only a few times
+	if (instances.size() > mInstanceCapacity)
+	{
+		unsigned int capacity = mInstanceCapacity ? mInstanceCapacity : 256;
+		while (capacity < instances.size())
+			capacity *= 2;
+
+		CreateInstanceBuffer(capacity);
+	}
+
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	memcpy(renderDevice.Map(mInstanceBuffer, RenderDevice::MapMode::WRITE_DISCARD), &instances[0], sizeof(InstanceBatcher::Instance) * instances.size());
+	renderDevice.Unmap(mInstanceBuffer);
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Map(mTransformConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	unsigned int stride = sizeof(InstanceBatcher::Instance);
+	renderDevice.SetVertexBuffers(INSTANCE_SLOT, 1, &mInstanceBuffer, &stride);
+}
+
+void StaticEntityShader::UpdateTransformConstantBuffer(const XMFLOAT4X4 &viewProjectionMatrix, const XMFLOAT4X4 &lightViewProjectionMatrixSpot)
+{
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
 
-	TransformConstantBuffer *data(static_cast<TransformConstantBuffer*>(mappedResource.pData));
-	data->worldMatrix = worldMatrix;
-	data->worldInverseTransposeMatrix = worldInverseTransposeMatrix;
-	data->worldViewProjectionMatrix = worldViewProjectionMatrix;
-	data->lightViewProjectionMatrix = lightViewProjectionMatrix;
+	TransformConstantBuffer *data(static_cast<TransformConstantBuffer*>(renderDevice.Map(mTransformConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
+	data->viewProjectionMatrix = viewProjectionMatrix;
 	data->lightViewProjectionMatrixSpot = lightViewProjectionMatrixSpot;
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Unmap(mTransformConstantBuffer, 0);
+	renderDevice.Unmap(mTransformConstantBuffer);
 }
 
-void StaticEntityShader::UpdateLightConstantBuffer(const Vector<Entity*> &lights)
+void StaticEntityShader::UpdateMeshConstantBuffer(const RenderResources::MeshRecord &mesh)
 {
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	MeshConstantBuffer *data(static_cast<MeshConstantBuffer*>(renderDevice.Map(mMeshConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
+	data->positionOffset = mesh.positionOffset;
+	data->positionScale = mesh.positionScale;
+
+	renderDevice.Unmap(mMeshConstantBuffer);
+}
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Map(mLightConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+void StaticEntityShader::UpdateLightConstantBuffer(const std::vector<Entity*> &lights)
+{
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
 
-	LightConstantBuffer *data(static_cast<LightConstantBuffer*>(mappedResource.pData));
+	LightConstantBuffer *data(static_cast<LightConstantBuffer*>(renderDevice.Map(mLightConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
 	int i;
-	for (i = 0; i < lights.Size() && i < max_lights; i++)
+	for (i = 0; i < (int)lights.size() && i < max_lights; i++)
 	{
 		PositionComponent *positionComponent = lights[i]->GetComponent<PositionComponent>();
 		LightComponent *lightComponent = lights[i]->GetComponent<LightComponent>();
@@ -160,58 +144,93 @@ void StaticEntityShader::UpdateLightConstantBuffer(const Vector<Entity*> &lights
 		while (i < max_lights - 1)
 			data->lights[i++].mEnabled = 0;
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Unmap(mLightConstantBuffer, 0);
+	renderDevice.Unmap(mLightConstantBuffer);
 }
 
-void StaticEntityShader::UpdateMaterialConstantBuffer(Material const &material)
+void StaticEntityShader::UpdateClusterConstantBuffers(const LightClusterer &clusterer, unsigned int numGlobalLights, float viewportWidth, float viewportHeight)
 {
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	ClusterConstantBuffer *clusterData(static_cast<ClusterConstantBuffer*>(renderDevice.Map(mClusterConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
+	clusterData->tileScaleX = LightClusterer::TILES_X / viewportWidth;
+	clusterData->tileScaleY = LightClusterer::TILES_Y / viewportHeight;
+	clusterData->sliceScale = clusterer.GetSliceScale();
+	clusterData->sliceBias = clusterer.GetSliceBias();
+	clusterData->numGlobalLights = numGlobalLights;
+
+	const std::vector<LightClusterer::Cluster> &clusters = clusterer.GetClusters();
+	for (unsigned int i = 0; i < LightClusterer::NUM_CLUSTERS; i++)
+		clusterData->clusters[i] = clusters[i].offset | clusters[i].count << 16;
+
+	renderDevice.Unmap(mClusterConstantBuffer);
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Map(mMaterialConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	// only the used part of the index lists is written
+	const std::vector<uint16_t> &lightIndices = clusterer.GetLightIndices();
 
-	MaterialConstantBuffer *data(static_cast<MaterialConstantBuffer*>(mappedResource.pData));
-	data->material.hasDiffuseMap = material.HasDiffuseMap();
-	data->material.hasSpecularMap = material.HasSpecularMap();
-	data->material.hasNormalMap = material.HasNormalMap();
-	data->material.diffuseColor = material.GetDiffuseColor();
-	data->material.specularColor = material.GetSpecularColor();
-	data->material.specularPower = material.GetSpecularPower();
-	data->material.tilingH = material.GetHorizontalTiling();
-	data->material.tilingV = material.GetVerticalTiling();
+	LightIndexConstantBuffer *indexData(static_cast<LightIndexConstantBuffer*>(renderDevice.Map(mLightIndexConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
+	if (!lightIndices.empty())
+		memcpy(indexData->lightIndices, &lightIndices[0], sizeof(uint16_t) * lightIndices.size());
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Unmap(mMaterialConstantBuffer, 0);
+	renderDevice.Unmap(mLightIndexConstantBuffer);
 }
 
-void StaticEntityShader::UpdateCameraConstantBuffer(XMFLOAT3 const &cameraWorldPosition, float shadowDistance)
+void StaticEntityShader::UpdateMaterialConstantBuffer(const RenderResources::MaterialBlock &material)
 {
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	MaterialConstantBuffer *data(static_cast<MaterialConstantBuffer*>(renderDevice.Map(mMaterialConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
+	data->material = material;
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Map(mCameraConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	renderDevice.Unmap(mMaterialConstantBuffer);
+}
+
+void StaticEntityShader::UpdateCameraConstantBuffer(XMFLOAT3 const &cameraWorldPosition, float shadowDistance)
+{
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
 
-	CameraConstantBuffer *data(static_cast<CameraConstantBuffer*>(mappedResource.pData));
+	CameraConstantBuffer *data(static_cast<CameraConstantBuffer*>(renderDevice.Map(mCameraConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
 	data->cameraWorldPosition = cameraWorldPosition;
 	data->shadowDistance = shadowDistance;
 
-	GraphicsSystem::GetInstance().GetDeviceContext()->Unmap(mCameraConstantBuffer, 0);
+	renderDevice.Unmap(mCameraConstantBuffer);
+}
+
+void StaticEntityShader::UpdateShadowConstantBuffer(const ShadowCascades &cascades)
+{
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
+	ShadowConstantBuffer *data(static_cast<ShadowConstantBuffer*>(renderDevice.Map(mShadowConstantBuffer, RenderDevice::MapMode::WRITE_DISCARD)));
+	for (unsigned int c = 0; c < ShadowCascades::NUM_CASCADES; c++)
+	{
+		data->cascadeViewProjectionMatrices[c] = cascades.GetViewProjectionMatrix(c);
+		data->cascadeSplits[c] = cascades.GetSplitDistance(c);
+	}
+
+	renderDevice.Unmap(mShadowConstantBuffer);
 }
 
 void StaticEntityShader::Use()
 {
+	RenderDevice &renderDevice = GraphicsSystem::GetInstance().GetRenderDevice();
+
 	// common shader set up
 	Shader::Use();
 
 	// set primitive topology
-	GraphicsSystem::GetInstance().GetDeviceContext()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	renderDevice.SetPrimitiveTopology(RenderDevice::Topology::TRIANGLE_LIST);
 
 	// set constant buffers
 	// vertex shader
-	GraphicsSystem::GetInstance().GetDeviceContext()->VSSetConstantBuffers(0, 1, &mTransformConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::VERTEX, 0, mTransformConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::VERTEX, 1, mMeshConstantBuffer);
 	// pixel shader
-	GraphicsSystem::GetInstance().GetDeviceContext()->PSSetConstantBuffers(0, 1, &mMaterialConstantBuffer);
-	GraphicsSystem::GetInstance().GetDeviceContext()->PSSetConstantBuffers(1, 1, &mLightConstantBuffer);
-	GraphicsSystem::GetInstance().GetDeviceContext()->PSSetConstantBuffers(2, 1, &mCameraConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::PIXEL, 0, mMaterialConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::PIXEL, 1, mLightConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::PIXEL, 2, mCameraConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::PIXEL, 3, mClusterConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::PIXEL, 4, mLightIndexConstantBuffer);
+	renderDevice.SetConstantBuffer(RenderDevice::ShaderStage::PIXEL, 5, mShadowConstantBuffer);
 
 	// set sampler state
-	GraphicsSystem::GetInstance().GetDeviceContext()->PSSetSamplers(0, 1, &mSamplerState);
+	renderDevice.SetSampler(RenderDevice::ShaderStage::PIXEL, 0, mSamplerState);
 }
-
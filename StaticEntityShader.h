@@ -1,12 +1,15 @@
 #ifndef STATIC_ENTITY_SHADER_H
 #define STATIC_ENTITY_SHADER_H
 
-#include "data structures/Vector.h"
 #include "Shader.h"
+#include "InstanceBatcher.h"
+#include "RenderResources.h"
+#include "LightClusterer.h"
+#include "ShadowCascades.h"
+#include <vector>
 #include <cstdint>
 
 class Entity;
-class Material;
 
 class StaticEntityShader : public Shader
 {
@@ -15,37 +18,34 @@ public:
 
 	void Use() override;
 
-	void UpdateTransformConstantBuffer(const XMFLOAT4X4 &worldMatrix, const XMFLOAT4X4 &worldInverseTransposeMatrix, const XMFLOAT4X4 &worldViewProjectionMatrix, const XMFLOAT4X4 &lightViewProjectionMatrix, const XMFLOAT4X4 &lightViewProjectionMatrixSpot);
-	void UpdateLightConstantBuffer(Vector<Entity*> const &lights);
-	void UpdateMaterialConstantBuffer(Material const &material);
+	void UpdateTransformConstantBuffer(const XMFLOAT4X4 &viewProjectionMatrix, const XMFLOAT4X4 &lightViewProjectionMatrixSpot);
+	void UpdateMeshConstantBuffer(const RenderResources::MeshRecord &mesh);     // position dequantisation, when the bound mesh changes
+	void UpdateInstanceBuffer(const std::vector<InstanceBatcher::Instance> &instances);    // binds the instance buffer to slot INSTANCE_SLOT
+	void UpdateLightConstantBuffer(const std::vector<Entity*> &lights);     // directional lights first, then the lights binned by the clusterer
+	void UpdateClusterConstantBuffers(const LightClusterer &clusterer, unsigned int numGlobalLights, float viewportWidth, float viewportHeight);
+	void UpdateMaterialConstantBuffer(const RenderResources::MaterialBlock &material);
 	void UpdateCameraConstantBuffer(const XMFLOAT3 &cameraWorldPosition, float shadowDistance);
+	void UpdateShadowConstantBuffer(const ShadowCascades &cascades);
+
+	static const unsigned int INSTANCE_SLOT = 4;    // mesh streams use slots 0 - 3
 private:
-	struct TransformConstantBuffer
+	struct TransformConstantBuffer    // per frame, world matrices are per instance vertex data
 	{
-		XMFLOAT4X4 worldMatrix;
-		XMFLOAT4X4 worldInverseTransposeMatrix;
-		XMFLOAT4X4 worldViewProjectionMatrix;
-		XMFLOAT4X4 lightViewProjectionMatrix;
+		XMFLOAT4X4 viewProjectionMatrix;
 		XMFLOAT4X4 lightViewProjectionMatrixSpot;
 	};
+	struct MeshConstantBuffer
+	{
+		XMFLOAT3 positionOffset;
+		float _padding0;
+		XMFLOAT3 positionScale;
+		float _padding1;
+	};
 	struct MaterialConstantBuffer
 	{
-		struct
-		{
-			uint32_t hasDiffuseMap;
-			uint32_t hasSpecularMap;
-			uint32_t hasNormalMap;
-			float _padding0;
-			XMFLOAT3 diffuseColor;
-			float _padding1;
-			XMFLOAT3 specularColor;
-			float specularPower;
-			float tilingH;
-			float tilingV;
-			float _padding2[2];
-		} material;
+		RenderResources::MaterialBlock material;     // packed when the material is registered
 	};
-	static const int max_lights = 10;
+	static const int max_lights = LightClusterer::MAX_LIGHTS;
 	struct LightConstantBuffer
 	{
 		struct
@@ -69,16 +69,43 @@ private:
 		XMFLOAT3 cameraWorldPosition;
 		float shadowDistance;
 	};
+	struct ShadowConstantBuffer     // directional light cascades, sampled in the pixel shader
+	{
+		XMFLOAT4X4 cascadeViewProjectionMatrices[ShadowCascades::NUM_CASCADES];
+		float cascadeSplits[ShadowCascades::NUM_CASCADES];
+	};
+	struct ClusterConstantBuffer
+	{
+		float tileScaleX;           // pixels to tiles
+		float tileScaleY;
+		float sliceScale;           // view depth to slice
+		float sliceBias;
+		uint32_t numGlobalLights;
+		float _padding0[3];
+		uint32_t clusters[LightClusterer::NUM_CLUSTERS];            // offset | count << 16
+	};
+	struct LightIndexConstantBuffer
+	{
+		uint16_t lightIndices[LightClusterer::MAX_INDICES];         // 64 KB, the constant buffer size limit
+	};
 
 	void CreateInputLayout() override;
 	void CreateConstantBuffers();
 	void CreateSamplerStates();
+	void CreateInstanceBuffer(unsigned int capacity);
+
+	SamplerHandle mSamplerState;
+	BufferHandle mTransformConstantBuffer;
+	BufferHandle mMeshConstantBuffer;
+	BufferHandle mMaterialConstantBuffer;
+	BufferHandle mLightConstantBuffer;
+	BufferHandle mCameraConstantBuffer;
+	BufferHandle mShadowConstantBuffer;
+	BufferHandle mClusterConstantBuffer;
+	BufferHandle mLightIndexConstantBuffer;
 
-	ID3D11SamplerState *mSamplerState;
-	ID3D11Buffer *mTransformConstantBuffer;
-	ID3D11Buffer *mMaterialConstantBuffer;
-	ID3D11Buffer *mLightConstantBuffer;
-	ID3D11Buffer *mCameraConstantBuffer;
+	BufferHandle mInstanceBuffer = nullptr;
+	unsigned int mInstanceCapacity = 0;
 };
 
 #endif  // STATIC_ENTITY_SHADER_H
@@ -1 +1,72 @@
 #include "StaticMeshComponent.h"
+#include "RenderScene.h"
+#include "TextureManager.h"
+#include <algorithm>
+#include <cmath>
+
+StaticMeshComponent::StaticMeshComponent(const std::vector<Mesh> &meshes, const std::vector<Material> &materials, const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices)
+	: mMeshes(meshes), mMaterials(materials), mVertices(vertices), mIndices(indices)
+{
+	for (const Mesh &mesh : mMeshes)
+		mMeshHandles.push_back(RenderResources::GetInstance().AddMesh(mesh));
+
+	for (const Material &material : mMaterials)
+	{
+		mMaterialHandles.push_back(RenderResources::GetInstance().AddMaterial(material));
+
+		// the textures stay cached while the component uses them
+		for (const std::string &textureName : material.GetTextureNames())
+			TextureManager::GetInstance().AcquireTexture(textureName);
+	}
+
+	if (mVertices.empty())
+		return;
+
+	mBoundsMin = mBoundsMax = mVertices[0];
+
+	for (const XMFLOAT3 &vertex : mVertices)
+	{
+		mBoundsMin = XMFLOAT3(std::min(mBoundsMin.x, vertex.x), std::min(mBoundsMin.y, vertex.y), std::min(mBoundsMin.z, vertex.z));
+		mBoundsMax = XMFLOAT3(std::max(mBoundsMax.x, vertex.x), std::max(mBoundsMax.y, vertex.y), std::max(mBoundsMax.z, vertex.z));
+	}
+}
+
+void StaticMeshComponent::GetWorldBounds(const XMFLOAT4X4 &worldMatrix, XMFLOAT3 &center, XMFLOAT3 &extent) const
+{
+	XMFLOAT3 localCenter((mBoundsMin.x + mBoundsMax.x) * 0.5f, (mBoundsMin.y + mBoundsMax.y) * 0.5f, (mBoundsMin.z + mBoundsMax.z) * 0.5f);
+	XMFLOAT3 localExtent((mBoundsMax.x - mBoundsMin.x) * 0.5f, (mBoundsMax.y - mBoundsMin.y) * 0.5f, (mBoundsMax.z - mBoundsMin.z) * 0.5f);
+
+	XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&localCenter), XMLoadFloat4x4(&worldMatrix)));
+
+	// extent of the transformed box along the world axes
+	extent.x = fabs(worldMatrix._11) * localExtent.x + fabs(worldMatrix._21) * localExtent.y + fabs(worldMatrix._31) * localExtent.z;
+	extent.y = fabs(worldMatrix._12) * localExtent.x + fabs(worldMatrix._22) * localExtent.y + fabs(worldMatrix._32) * localExtent.z;
+	extent.z = fabs(worldMatrix._13) * localExtent.x + fabs(worldMatrix._23) * localExtent.y + fabs(worldMatrix._33) * localExtent.z;
+}
+
+StaticMeshComponent::~StaticMeshComponent()
+{
+	RenderScene::GetInstance().RemoveEntity(GetOwner());
+
+	for (MeshHandle mesh : mMeshHandles)
+		RenderResources::GetInstance().ReleaseMesh(mesh);
+
+	for (MaterialHandle material : mMaterialHandles)
+		RenderResources::GetInstance().ReleaseMaterial(material);
+
+	for (const Material &material : mMaterials)
+		for (const std::string &textureName : material.GetTextureNames())
+			TextureManager::GetInstance().ReleaseTexture(textureName);
+}
+
+void StaticMeshComponent::Init()
+{
+	RenderScene::GetInstance().UpdateEntity(GetOwner());
+}
+
+void StaticMeshComponent::SetOccluder(bool occluder)
+{
+	mIsOccluder = occluder;
+
+	RenderScene::GetInstance().UpdateEntity(GetOwner());
+}
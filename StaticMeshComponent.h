@@ -5,19 +5,52 @@
 #include "Component.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "RenderResources.h"
 
 class StaticMeshComponent : public Component
 {
 public:
-	StaticMeshComponent(const std::vector<Mesh> &meshes, const std::vector<Material> &materials, const std::vector<XMFLOAT3> &vertices) : mMeshes(meshes), mMaterials(materials), mVertices(vertices) {}
+	StaticMeshComponent(const std::vector<Mesh> &meshes, const std::vector<Material> &materials, const std::vector<XMFLOAT3> &vertices, const std::vector<unsigned int> &indices = std::vector<unsigned int>());
+	~StaticMeshComponent();
+
+	// the component holds references to render resources and cached textures: entities take ownership of it by pointer
+	StaticMeshComponent(const StaticMeshComponent&) = delete;
+	StaticMeshComponent &operator=(const StaticMeshComponent&) = delete;
+
+	void Init() override;
 
 	const std::vector<Mesh> &GetMeshes() const { return mMeshes; }
 	const std::vector<Material> &GetMaterials() const { return mMaterials; }
+
+	// render resource handles of the sub-meshes and their materials, registered at construction
+	const std::vector<MeshHandle> &GetMeshHandles() const { return mMeshHandles; }
+	const std::vector<MaterialHandle> &GetMaterialHandles() const { return mMaterialHandles; }
 	const std::vector<XMFLOAT3> &GetVertices() const { return mVertices; }
+	const std::vector<unsigned int> &GetIndices() const { return mIndices; }    // triangle list over GetVertices() (all sub-meshes)
+
+	// local space bounds of all sub-meshes
+	const XMFLOAT3 &GetBoundsMin() const { return mBoundsMin; }
+	const XMFLOAT3 &GetBoundsMax() const { return mBoundsMax; }
+	bool HasBounds() const { return !mVertices.empty(); }
+
+	// world space axis aligned bounds (center and half extent) under the given transform
+	void GetWorldBounds(const XMFLOAT4X4 &worldMatrix, XMFLOAT3 &center, XMFLOAT3 &extent) const;
+
+	// large meshes hiding what's behind them (buildings, walls) - rasterised by the occlusion culler, needs indices
+	void SetOccluder(bool occluder);
+	bool IsOccluder() const { return mIsOccluder && !mIndices.empty(); }
 private:
 	std::vector<XMFLOAT3> mVertices;
+	std::vector<unsigned int> mIndices;
 	std::vector<Mesh> mMeshes;
 	std::vector<Material> mMaterials;
+	std::vector<MeshHandle> mMeshHandles;
+	std::vector<MaterialHandle> mMaterialHandles;
+
+	XMFLOAT3 mBoundsMin = XMFLOAT3();
+	XMFLOAT3 mBoundsMax = XMFLOAT3();
+
+	bool mIsOccluder = false;
 };
 
 #endif  // STATIC_MESH_COMPONENT_H
\ No newline at end of file
@@ -17,6 +17,6 @@ private:
 	};
 	void CreateInputLayout() override;
 	void CreateConstantBuffers();
-	ID3D11Buffer *mTransformConstantBuffer;
+	BufferHandle mTransformConstantBuffer;
 };
 
@@ -47,6 +47,11 @@ std::vector<float> &Terrain::GetHeights()
 	return mHeights;
 }
 
+const std::vector<float> &Terrain::GetHeights() const
+{
+	return mHeights;
+}
+
 Model *Terrain::GetModel()
 {
 	return mModel;
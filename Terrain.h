@@ -20,6 +20,7 @@ public:
 	unsigned int GetNumNodesDepth() const;
 	StaticMeshComponent *GetModel();
 	std::vector<float> &GetHeights();
+	const std::vector<float> &GetHeights() const;
 	float GetHeight(float x, float z) const;
 	std::vector<std::array<XMFLOAT3, 3>> GetTriangleSubset(float x, float z, float radius);
 private:
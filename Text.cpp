@@ -48,8 +48,8 @@ void Text::AllocateBuffer(unsigned int bufferSize)  // allocate a vertex buffer
 	std::vector<XMFLOAT2> positions(bufferSize * 6);
 	std::vector<XMFLOAT2> textureCoordinates(bufferSize * 6);
 
-	mMesh.LoadAttribute("POSITION", &positions[0], positions.size(), true);
-	mMesh.LoadAttribute("TEX_COORD", &textureCoordinates[0], textureCoordinates.size(), true);
+	mMesh.LoadAttribute(VertexLayout::Attribute::POSITION, &positions[0], positions.size(), true);
+	mMesh.LoadAttribute(VertexLayout::Attribute::TEX_COORD, &textureCoordinates[0], textureCoordinates.size(), true);
 }
 
 void Text::SetText(const std::string &text)
@@ -89,8 +89,8 @@ void Text::AppendChar(char character)
 	{
 		AllocateBuffer(mBufferSize = mTextString.size() * 2);
 
-		mMesh.UpdateDynamicAttribute("POSITION", &mPositions[0], mPositions.size());
-		mMesh.UpdateDynamicAttribute("TEX_COORD", &mTextureCoordinates[0], mTextureCoordinates.size());
+		mMesh.UpdateDynamicAttribute(VertexLayout::Attribute::POSITION, &mPositions[0], mPositions.size());
+		mMesh.UpdateDynamicAttribute(VertexLayout::Attribute::TEX_COORD, &mTextureCoordinates[0], mTextureCoordinates.size());
 
 		mMesh.SetVertexCount(mTextString.size() * 6);
 	}
@@ -139,8 +139,8 @@ void Text::AppendChar(char character)
 	unsigned int offset = (mTextString.size() - 1 - mControlCharacters) * 6;
 	unsigned int numElements = 6;
 
-	mMesh.UpdateDynamicAttribute("POSITION", &mPositions[offset], numElements, offset);
-	mMesh.UpdateDynamicAttribute("TEX_COORD", &mTextureCoordinates[offset], numElements, offset);
+	mMesh.UpdateDynamicAttribute(VertexLayout::Attribute::POSITION, &mPositions[offset], numElements, offset);
+	mMesh.UpdateDynamicAttribute(VertexLayout::Attribute::TEX_COORD, &mTextureCoordinates[offset], numElements, offset);
 
 	mMesh.SetVertexCount((mTextString.size() - mControlCharacters + 1) * 6);
 
@@ -239,8 +239,8 @@ void Text::UpdateMesh()
 	}
 
 	// update vertex buffer
-	mMesh.UpdateDynamicAttribute("POSITION", &mPositions[0], mPositions.size());
-	mMesh.UpdateDynamicAttribute("TEX_COORD", &mTextureCoordinates[0], mTextureCoordinates.size());
+	mMesh.UpdateDynamicAttribute(VertexLayout::Attribute::POSITION, &mPositions[0], mPositions.size());
+	mMesh.UpdateDynamicAttribute(VertexLayout::Attribute::TEX_COORD, &mTextureCoordinates[0], mTextureCoordinates.size());
 
 	mMesh.SetVertexCount((mTextString.size() - mControlCharacters) * 6);
 
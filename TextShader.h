@@ -23,8 +23,8 @@ private:
 	void CreateInputLayout() override;
 	void CreateConstantBuffers();
 	void CreateSamplerStates();
-	ID3D11Buffer *mTransformConstantBuffer;
-	ID3D11Buffer *mTextParamsConstantBuffer;
-	ID3D11SamplerState *mSamplerState;
+	BufferHandle mTransformConstantBuffer;
+	BufferHandle mTextParamsConstantBuffer;
+	SamplerHandle mSamplerState;
 };
 
@@ -1,7 +1,7 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
-#include <d3d11.h>
+#include "RenderDevice.h"
 #include <string>
 
 class Texture
@@ -9,20 +9,18 @@ class Texture
 public:
 	Texture() : mShaderResourceView(nullptr) {}
 	Texture(std::string const &textureFilePath);
-	Texture(ID3D11ShaderResourceView *resourceView) : mShaderResourceView(resourceView) {}
-	Texture(unsigned width, unsigned height, DXGI_FORMAT format);
+	Texture(TextureHandle resourceView) : mShaderResourceView(resourceView) {}
+	Texture(unsigned width, unsigned height, RenderDevice::Format format);
 
 	void Update(void *data, unsigned xOffset, unsigned yOffset, unsigned width, unsigned height);  
 
-	void SetResourceView(ID3D11ShaderResourceView *shaderResourceView) { mShaderResourceView = shaderResourceView; }
+	void SetResourceView(TextureHandle shaderResourceView) { mShaderResourceView = shaderResourceView; }
+	TextureHandle GetResourceView() const { return mShaderResourceView; }
 
 	void Bind(unsigned int slot) const;
 	void Unbind() const;
 private:
-	void LoadDDS(const std::wstring &textureFilePath);
-	void LoadWIC(const std::wstring &textureFilePath);
-	
-	ID3D11ShaderResourceView *mShaderResourceView;
+	TextureHandle mShaderResourceView;
 	mutable int mSlot = -1;
 };
 
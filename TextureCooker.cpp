@@ -0,0 +1,462 @@
+#include "TextureCooker.h"
+#include "VirtualFileSystem.h"
+#include "ThreadPool.h"
+#include <DirectXMath.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t DDS_MAGIC = 0x20534444;          // "DDS "
+
+	const uint32_t DDSD_CAPS = 0x1;
+	const uint32_t DDSD_HEIGHT = 0x2;
+	const uint32_t DDSD_WIDTH = 0x4;
+	const uint32_t DDSD_PIXELFORMAT = 0x1000;
+	const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	const uint32_t DDSD_LINEARSIZE = 0x80000;
+	const uint32_t DDPF_FOURCC = 0x4;
+	const uint32_t DDSCAPS_COMPLEX = 0x8;
+	const uint32_t DDSCAPS_TEXTURE = 0x1000;
+	const uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+	struct DDSPixelFormat
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t bitMasks[4];
+	};
+
+	struct DDSHeader
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		DDSPixelFormat pixelFormat;
+		uint32_t caps[4];
+		uint32_t reserved2;
+	};
+
+	// block rows (or texel rows when filtering) of a thread pool task
+	const unsigned int ROWS_PER_TASK = 8;
+
+	uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)(uint8_t)a | (uint32_t)(uint8_t)b << 8 | (uint32_t)(uint8_t)c << 16 | (uint32_t)(uint8_t)d << 24;
+	}
+
+	// srgb to linear of the 8 bit values
+	struct SRGBTable
+	{
+		SRGBTable()
+		{
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				float value = i / 255.0f;
+				values[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			}
+		}
+
+		float values[256];
+	};
+
+	const SRGBTable &GetSRGBTable()
+	{
+		static const SRGBTable table;
+		return table;
+	}
+
+	// 8 bit texel to the space mips are filtered in: linear color, normals in [-1, 1]
+	XMVECTOR LoadTexel(const uint8_t *texel, TextureCooker::Usage usage)
+	{
+		const SRGBTable &table = GetSRGBTable();
+
+		switch (usage)
+		{
+		case TextureCooker::Usage::COLOR:
+			return XMVectorSet(table.values[texel[0]], table.values[texel[1]], table.values[texel[2]], texel[3] / 255.0f);
+		case TextureCooker::Usage::NORMAL:
+			return XMVectorSet(texel[0] * (2.0f / 255.0f) - 1.0f, texel[1] * (2.0f / 255.0f) - 1.0f, texel[2] * (2.0f / 255.0f) - 1.0f, texel[3] / 255.0f);
+		default:
+			return XMVectorSet(texel[0], texel[1], texel[2], texel[3]) * (1.0f / 255.0f);
+		}
+	}
+
+	void StoreTexel(XMVECTOR value, TextureCooker::Usage usage, uint8_t *texel)
+	{
+		if (usage == TextureCooker::Usage::COLOR)
+		{
+			// linear to srgb, alpha stays linear
+			XMVECTOR color = XMVectorSaturate(value);
+			XMVECTOR low = color * 12.92f;
+			XMVECTOR high = XMVectorPow(color, XMVectorReplicate(1.0f / 2.4f)) * 1.055f - XMVectorReplicate(0.055f);
+
+			value = XMVectorSelect(high, low, XMVectorLessOrEqual(color, XMVectorReplicate(0.0031308f)));
+			value = XMVectorSetW(value, XMVectorGetW(color));
+		}
+		else if (usage == TextureCooker::Usage::NORMAL)
+			value = XMVectorSetW(value * 0.5f + XMVectorReplicate(0.5f), XMVectorGetW(value));
+
+		XMFLOAT4 result;
+		XMStoreFloat4(&result, XMVectorRound(XMVectorSaturate(value) * 255.0f));
+
+		texel[0] = (uint8_t)result.x;
+		texel[1] = (uint8_t)result.y;
+		texel[2] = (uint8_t)result.z;
+		texel[3] = (uint8_t)result.w;
+	}
+
+	// 2x2 box filter of the previous level, odd sizes clamp the second texel to the edge
+	void Downsample(const std::vector<XMFLOAT4> &source, unsigned int width, unsigned int height, TextureCooker::Usage usage, std::vector<XMFLOAT4> &level, std::vector<uint8_t> &texels)
+	{
+		unsigned int levelWidth = std::max(width / 2, 1u), levelHeight = std::max(height / 2, 1u);
+
+		level.resize(levelWidth * levelHeight);
+		texels.resize(levelWidth * levelHeight * 4);
+
+		ThreadPool::GetInstance().ParallelFor((levelHeight + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](unsigned int task)
+		{
+			unsigned int lastRow = std::min((task + 1) * ROWS_PER_TASK, levelHeight);
+
+			for (unsigned int y = task * ROWS_PER_TASK; y < lastRow; y++)
+				for (unsigned int x = 0; x < levelWidth; x++)
+				{
+					unsigned int x0 = x * 2, x1 = std::min(x * 2 + 1, width - 1);
+					unsigned int y0 = y * 2, y1 = std::min(y * 2 + 1, height - 1);
+
+					XMVECTOR sum = XMLoadFloat4(&source[y0 * width + x0]) + XMLoadFloat4(&source[y0 * width + x1]) + XMLoadFloat4(&source[y1 * width + x0]) + XMLoadFloat4(&source[y1 * width + x1]);
+					XMVECTOR average = sum * 0.25f;
+
+					if (usage == TextureCooker::Usage::NORMAL)
+						average = XMVectorSetW(XMVector3Normalize(average), XMVectorGetW(average));
+
+					XMStoreFloat4(&level[y * levelWidth + x], average);
+					StoreTexel(average, usage, &texels[(y * levelWidth + x) * 4]);
+				}
+		});
+	}
+
+	uint16_t PackColor565(XMVECTOR color)
+	{
+		XMFLOAT4 scaled;
+		XMStoreFloat4(&scaled, XMVectorRound(XMVectorClamp(color, XMVectorZero(), XMVectorReplicate(255.0f)) * XMVectorSet(31.0f / 255.0f, 63.0f / 255.0f, 31.0f / 255.0f, 0.0f)));
+
+		return (uint16_t)((unsigned int)scaled.x << 11 | (unsigned int)scaled.y << 5 | (unsigned int)scaled.z);
+	}
+
+	XMVECTOR UnpackColor565(uint16_t color)
+	{
+		unsigned int r = color >> 11 & 0x1F, g = color >> 5 & 0x3F, b = color & 0x1F;
+
+		return XMVectorSet((float)(r << 3 | r >> 2), (float)(g << 2 | g >> 4), (float)(b << 3 | b >> 2), 0.0f);
+	}
+}
+
+bool TextureCooker::Read(const RenderDevice &renderDevice, const std::string &filePath, Usage usage, RenderDevice::TextureData &textureData)
+{
+	std::string cookedPath = GetCookedPath(filePath);
+	uint64_t cookedTime = VirtualFileSystem::GetInstance().GetModificationTime(cookedPath);
+
+	if (cookedTime != 0 && cookedTime >= VirtualFileSystem::GetInstance().GetModificationTime(filePath) && renderDevice.DecodeTexture(cookedPath, textureData))
+		return true;
+
+	if (!renderDevice.DecodeTexture(filePath, textureData))
+		return false;
+
+	// dds sources are used as they are, textures that can't be block compressed stay decoded
+	std::vector<uint8_t> ddsFile;
+
+	if (textureData.isFile || textureData.format != RenderDevice::Format::R8G8B8A8_UNORM || !Cook(&textureData.data[0], textureData.width, textureData.height, usage, ddsFile))
+		return true;
+
+	// if the cooked file can't be written the next load cooks again
+	Save(cookedPath, ddsFile);
+
+	const DDSHeader *header = reinterpret_cast<const DDSHeader*>(&ddsFile[sizeof(uint32_t)]);
+
+	textureData.mipLevels = header->mipMapCount;
+	textureData.format = RenderDevice::Format::UNKNOWN;
+	textureData.isFile = true;
+	textureData.data.swap(ddsFile);
+
+	return true;
+}
+
+bool TextureCooker::Save(const std::string &cookedPath, const std::vector<uint8_t> &ddsFile)
+{
+	FILE *fileStream = nullptr;
+	if (fopen_s(&fileStream, cookedPath.c_str(), "wb"))
+		return false;
+
+	bool written = fwrite(&ddsFile[0], 1, ddsFile.size(), fileStream) == ddsFile.size();
+	written = fclose(fileStream) == 0 && written;
+
+	if (!written)
+		remove(cookedPath.c_str());
+
+	return written;
+}
+
+bool TextureCooker::Cook(const uint8_t *texels, unsigned int width, unsigned int height, Usage usage, std::vector<uint8_t> &ddsFile)
+{
+	// the top level of block compressed textures is made of whole blocks
+	if (width == 0 || height == 0 || width % 4 || height % 4)
+		return false;
+
+	BlockFormat format = GetBlockFormat(texels, width, height, usage);
+	unsigned int blockSize = format == BlockFormat::BC1 ? 8 : 16;
+
+	unsigned int numMips = 1;
+	while (std::max(width, height) >> numMips)
+		numMips++;
+
+	DDSHeader header = {};
+	header.size = sizeof(DDSHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = width / 4 * height / 4 * blockSize;
+	header.mipMapCount = numMips;
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = DDPF_FOURCC;
+	header.pixelFormat.fourCC = format == BlockFormat::BC1 ? MakeFourCC('D', 'X', 'T', '1') : format == BlockFormat::BC3 ? MakeFourCC('D', 'X', 'T', '5') : MakeFourCC('A', 'T', 'I', '2');
+	header.caps[0] = DDSCAPS_TEXTURE | (numMips > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	ddsFile.resize(sizeof(uint32_t) + sizeof(DDSHeader));
+	memcpy(&ddsFile[0], &DDS_MAGIC, sizeof(uint32_t));
+	memcpy(&ddsFile[sizeof(uint32_t)], &header, sizeof(DDSHeader));
+
+	// mips are filtered in float from the top level, each level is encoded from its 8 bit texels
+	std::vector<XMFLOAT4> level, nextLevel;
+	std::vector<uint8_t> levelTexels;
+	const uint8_t *mipTexels = texels;
+	unsigned int mipWidth = width, mipHeight = height;
+
+	for (unsigned int mip = 0; mip < numMips; mip++)
+	{
+		unsigned int numBlocksX = std::max((mipWidth + 3) / 4, 1u), numBlocksY = std::max((mipHeight + 3) / 4, 1u);
+		size_t offset = ddsFile.size();
+
+		ddsFile.resize(offset + (size_t)numBlocksX * numBlocksY * blockSize);
+
+		ThreadPool::GetInstance().ParallelFor((numBlocksY + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](unsigned int task)
+		{
+			unsigned int lastRow = std::min((task + 1) * ROWS_PER_TASK, numBlocksY);
+
+			for (unsigned int blockY = task * ROWS_PER_TASK; blockY < lastRow; blockY++)
+				for (unsigned int blockX = 0; blockX < numBlocksX; blockX++)
+				{
+					// blocks of mips smaller than 4x4 repeat the edge texels
+					uint8_t blockTexels[64];
+
+					for (unsigned int y = 0; y < 4; y++)
+						for (unsigned int x = 0; x < 4; x++)
+						{
+							unsigned int texelX = std::min(blockX * 4 + x, mipWidth - 1), texelY = std::min(blockY * 4 + y, mipHeight - 1);
+							memcpy(&blockTexels[(y * 4 + x) * 4], &mipTexels[(texelY * mipWidth + texelX) * 4], 4);
+						}
+
+					uint8_t *block = &ddsFile[offset + ((size_t)blockY * numBlocksX + blockX) * blockSize];
+
+					if (format == BlockFormat::BC1)
+						EncodeBC1(blockTexels, block);
+					else if (format == BlockFormat::BC3)
+						EncodeBC3(blockTexels, block);
+					else
+						EncodeBC5(blockTexels, block);
+				}
+		});
+
+		if (mip + 1 == numMips)
+			break;
+
+		if (mip == 0)
+		{
+			level.resize(width * height);
+
+			ThreadPool::GetInstance().ParallelFor((height + ROWS_PER_TASK - 1) / ROWS_PER_TASK, [&](unsigned int task)
+			{
+				unsigned int lastRow = std::min((task + 1) * ROWS_PER_TASK, height);
+
+				for (unsigned int i = task * ROWS_PER_TASK * width; i < lastRow * width; i++)
+					XMStoreFloat4(&level[i], LoadTexel(&texels[i * 4], usage));
+			});
+		}
+
+		Downsample(level, mipWidth, mipHeight, usage, nextLevel, levelTexels);
+		level.swap(nextLevel);
+
+		mipTexels = &levelTexels[0];
+		mipWidth = std::max(mipWidth / 2, 1u);
+		mipHeight = std::max(mipHeight / 2, 1u);
+	}
+
+	return true;
+}
+
+TextureCooker::BlockFormat TextureCooker::GetBlockFormat(const uint8_t *texels, unsigned int width, unsigned int height, Usage usage)
+{
+	if (usage == Usage::NORMAL)
+		return BlockFormat::BC5;
+
+	for (unsigned int i = 0; i < width * height; i++)
+		if (texels[i * 4 + 3] != 255)
+			return BlockFormat::BC3;
+
+	return BlockFormat::BC1;
+}
+
+std::string TextureCooker::GetCookedPath(const std::string &sourcePath)
+{
+	return sourcePath + ".dds";
+}
+
+void TextureCooker::EncodeBC1(const uint8_t *texels, uint8_t *block)
+{
+	EncodeColorBlock(texels, block);
+}
+
+void TextureCooker::EncodeBC3(const uint8_t *texels, uint8_t *block)
+{
+	EncodeChannelBlock(texels, 3, block);
+	EncodeColorBlock(texels, block + 8);
+}
+
+void TextureCooker::EncodeBC5(const uint8_t *texels, uint8_t *block)
+{
+	EncodeChannelBlock(texels, 0, block);
+	EncodeChannelBlock(texels, 1, block + 8);
+}
+
+void TextureCooker::EncodeColorBlock(const uint8_t *texels, uint8_t *block)
+{
+	XMVECTOR colors[16];
+	XMVECTOR mean = XMVectorZero();
+	XMVECTOR minColor = XMVectorReplicate(255.0f), maxColor = XMVectorZero();
+
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		colors[i] = XMVectorSet(texels[i * 4], texels[i * 4 + 1], texels[i * 4 + 2], 0.0f);
+		mean += colors[i];
+		minColor = XMVectorMin(minColor, colors[i]);
+		maxColor = XMVectorMax(maxColor, colors[i]);
+	}
+
+	mean = mean * (1.0f / 16.0f);
+
+	// principal axis of the colors: power iterations on their covariance, from the diagonal of their bounds
+	XMVECTOR covarianceX = XMVectorZero(), covarianceY = XMVectorZero(), covarianceZ = XMVectorZero();
+
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		XMVECTOR offset = colors[i] - mean;
+
+		covarianceX += offset * XMVectorSplatX(offset);
+		covarianceY += offset * XMVectorSplatY(offset);
+		covarianceZ += offset * XMVectorSplatZ(offset);
+	}
+
+	XMVECTOR axis = maxColor - minColor;
+
+	for (unsigned int iteration = 0; iteration < 4 && XMVectorGetX(XMVector3LengthSq(axis)) > 0.0f; iteration++)
+		axis = XMVector3Normalize(covarianceX * XMVectorSplatX(axis) + covarianceY * XMVectorSplatY(axis) + covarianceZ * XMVectorSplatZ(axis));
+
+	// endpoints: the extremes of the colors along the axis, inset by 1/16 of the range to cut the quantisation error
+	float minProjection = 0.0f, maxProjection = 0.0f;
+
+	if (XMVectorGetX(XMVector3LengthSq(axis)) > 0.0f)
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			float projection = XMVectorGetX(XMVector3Dot(colors[i] - mean, axis));
+
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+	float inset = (maxProjection - minProjection) / 16.0f;
+
+	uint16_t color0 = PackColor565(mean + axis * (maxProjection - inset));
+	uint16_t color1 = PackColor565(mean + axis * (minProjection + inset));
+
+	// four color mode needs color0 > color1, equal endpoints leave every index at color0
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	uint32_t indices = 0;
+
+	if (color0 != color1)
+	{
+		XMVECTOR palette[4];
+		palette[0] = UnpackColor565(color0);
+		palette[1] = UnpackColor565(color1);
+		palette[2] = (palette[0] * 2.0f + palette[1]) * (1.0f / 3.0f);
+		palette[3] = (palette[0] + palette[1] * 2.0f) * (1.0f / 3.0f);
+
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			unsigned int bestIndex = 0;
+			float bestDistance = XMVectorGetX(XMVector3LengthSq(colors[i] - palette[0]));
+
+			for (unsigned int index = 1; index < 4; index++)
+			{
+				float distance = XMVectorGetX(XMVector3LengthSq(colors[i] - palette[index]));
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+
+			indices |= bestIndex << (i * 2);
+		}
+	}
+
+	block[0] = (uint8_t)color0;
+	block[1] = (uint8_t)(color0 >> 8);
+	block[2] = (uint8_t)color1;
+	block[3] = (uint8_t)(color1 >> 8);
+
+	for (unsigned int i = 0; i < 4; i++)
+		block[4 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+void TextureCooker::EncodeChannelBlock(const uint8_t *texels, unsigned int channel, uint8_t *block)
+{
+	unsigned int minValue = 255, maxValue = 0;
+
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		minValue = std::min(minValue, (unsigned int)texels[i * 4 + channel]);
+		maxValue = std::max(maxValue, (unsigned int)texels[i * 4 + channel]);
+	}
+
+	// eight value mode (value0 > value1): index 0 is value0, 1 is value1, 2 to 7 interpolate from value0 to value1
+	block[0] = (uint8_t)maxValue;
+	block[1] = (uint8_t)minValue;
+
+	uint64_t indices = 0;
+
+	if (maxValue > minValue)
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			unsigned int step = (unsigned int)((texels[i * 4 + channel] - minValue) * 7.0f / (maxValue - minValue) + 0.5f);
+			uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+
+			indices |= index << (i * 3);
+		}
+
+	for (unsigned int i = 0; i < 6; i++)
+		block[2 + i] = (uint8_t)(indices >> (i * 8));
+}
@@ -0,0 +1,40 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include "RenderDevice.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**** textures are cooked on their first load: the mip chain is generated from the top level (color averaged in linear space, ****/
+/**** normals renormalised) and block compressed - bc1 for opaque color, bc3 with alpha, bc5 (x and y) for normal maps - into a ****/
+/**** dds file next to the source. later loads read the dds as it is. mip levels and block rows are spread over the thread pool, ****/
+/**** texels are filtered and fitted as DirectXMath vectors ****/
+
+class TextureCooker
+{
+public:
+	enum class Usage { COLOR, DATA, NORMAL, };      // srgb color, linear data (specular), tangent space normals
+	enum class BlockFormat { BC1, BC3, BC5, };
+public:
+	// the cooked file if it's up to date, otherwise the source decoded, cooked and saved; the cooked texture either way, the
+	// decoded source if it can't be cooked. thread safe (loading threads)
+	static bool Read(const RenderDevice &renderDevice, const std::string &filePath, Usage usage, RenderDevice::TextureData &textureData);
+
+	// rgba8 texels of the top level to a dds file with the full mip chain, fails unless the dimensions are multiples of 4
+	static bool Cook(const uint8_t *texels, unsigned int width, unsigned int height, Usage usage, std::vector<uint8_t> &ddsFile);
+	static bool Save(const std::string &cookedPath, const std::vector<uint8_t> &ddsFile);     // a partly written file is removed
+
+	static BlockFormat GetBlockFormat(const uint8_t *texels, unsigned int width, unsigned int height, Usage usage);
+	static std::string GetCookedPath(const std::string &sourcePath);     // the source path with .dds appended
+
+	// a 4x4 block of rgba8 texels, row by row, to an 8 (bc1) or 16 byte block
+	static void EncodeBC1(const uint8_t *texels, uint8_t *block);
+	static void EncodeBC3(const uint8_t *texels, uint8_t *block);
+	static void EncodeBC5(const uint8_t *texels, uint8_t *block);
+private:
+	static void EncodeColorBlock(const uint8_t *texels, uint8_t *block);
+	static void EncodeChannelBlock(const uint8_t *texels, unsigned int channel, uint8_t *block);
+};
+
+#endif  // TEXTURE_COOKER_H
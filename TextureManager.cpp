@@ -1,15 +1,197 @@
-
 #include "TextureManager.h"
+#include "GraphicsSystem.h"
+#include "RenderResources.h"
+
+// video memory for requested textures
+static const uint64_t DEFAULT_MEMORY_BUDGET = 256ull * 1024 * 1024;
+
+// dds header, not part of the texture memory
+static const uint64_t DDS_HEADER_SIZE = 128;
+
+TextureManager::TextureManager() : mCache(DEFAULT_MEMORY_BUDGET)
+{
+}
 
 Texture &TextureManager::GetTexture(const std::string &textureFilePath)
 {
-	std::map<std::string, Texture>::iterator it = mLoadedTextures.find(textureFilePath);
+	std::map<std::string, Entry>::iterator it = mLoadedTextures.find(textureFilePath);
+
+	if (it == mLoadedTextures.end())
+	{
+		Entry entry = { Texture(textureFilePath), nullptr, ResourceCache::INVALID_RESOURCE, 0, 0, 0, 0, 0, TextureCooker::Usage::COLOR, AssetLoader::INVALID_REQUEST, true, false };
+		it = mLoadedTextures.insert(std::pair<std::string, Entry>(textureFilePath, entry)).first;
+	}
+	else if (!it->second.permanent)
+	{
+		// the caller keeps a pointer to the texture: it's never released
+		it->second.permanent = true;
+		AcquireTexture(textureFilePath);
+	}
+
+	return it->second.texture;
+}
+
+Texture &TextureManager::RequestTexture(const std::string &textureFilePath, Placeholder placeholder, TextureCooker::Usage usage, AssetLoader::Priority priority)
+{
+	std::map<std::string, Entry>::iterator it = mLoadedTextures.find(textureFilePath);
+
+	if (it != mLoadedTextures.end())
+	{
+		if (it->second.evicted)
+			Load(it, priority);
+
+		return it->second.texture;
+	}
+
+	// each request gets its own 1x1 placeholder so that materials can be patched when the texture lands, placeholders are
+	// never released since copies of materials made before that may still refer to them
+	static const uint8_t placeholderColors[][4] = { { 255, 255, 255, 255 }, { 0, 0, 0, 255 }, { 128, 128, 255, 255 }, };
+
+	TextureHandle placeholderTexture = GraphicsSystem::GetInstance().GetRenderDevice().CreateTexture(1, 1, RenderDevice::Format::R8G8B8A8_UNORM, placeholderColors[(unsigned int)placeholder]);
+
+	Entry entry = { Texture(placeholderTexture), placeholderTexture, ResourceCache::INVALID_RESOURCE, 0, 0, 0, 0, 0, usage, AssetLoader::INVALID_REQUEST, false, false };
+	it = mLoadedTextures.insert(std::pair<std::string, Entry>(textureFilePath, entry)).first;
+
+	Load(it, priority);
+
+	return it->second.texture;
+}
+
+void TextureManager::Load(EntryIterator it, AssetLoader::Priority priority)
+{
+	it->second.evicted = false;
+
+	it->second.request = AssetLoader::GetInstance().LoadTexture(it->first, it->second.usage, priority, [this, it](TextureHandle loadedTexture, const RenderDevice::TextureData &textureData)
+	{
+		OnLanded(it, loadedTexture, textureData);
+	});
+}
+
+void TextureManager::OnLanded(EntryIterator it, TextureHandle texture, const RenderDevice::TextureData &textureData)
+{
+	Entry &entry = it->second;
+
+	entry.request = AssetLoader::INVALID_REQUEST;
+	SetTexture(entry, texture);
+
+	// textures the device loaded on the render thread (no dimensions) stay resident as they are
+	if (textureData.width == 0 || textureData.height == 0)
+		return;
+
+	entry.width = textureData.width;
+	entry.height = textureData.height;
+	entry.numMips = textureData.mipLevels;
+	entry.firstMip = 0;
+
+	uint64_t size = textureData.isFile ? textureData.data.size() - DDS_HEADER_SIZE : textureData.data.size();
+	entry.resource = mCache.Add(entry.width, entry.height, entry.numMips, size);
+
+	for (unsigned int i = 0; i < entry.references; i++)
+		mCache.AddReference(entry.resource);
+
+	if (entry.resource >= mResourceEntries.size())
+		mResourceEntries.resize(entry.resource + 1);
+
+	mResourceEntries[entry.resource] = it;
+	mResources[texture] = entry.resource;
+}
+
+void TextureManager::AcquireTexture(const std::string &textureFilePath)
+{
+	std::map<std::string, Entry>::iterator it = mLoadedTextures.find(textureFilePath);
 
 	if (it == mLoadedTextures.end())
+		return;
+
+	it->second.references++;
+
+	if (it->second.resource != ResourceCache::INVALID_RESOURCE)
+		mCache.AddReference(it->second.resource);
+	else if (it->second.evicted)
+		Load(it, AssetLoader::Priority::NORMAL);     // the references are handed to the cache when it lands
+}
+
+void TextureManager::ReleaseTexture(const std::string &textureFilePath)
+{
+	std::map<std::string, Entry>::iterator it = mLoadedTextures.find(textureFilePath);
+
+	if (it == mLoadedTextures.end() || it->second.references == 0)
+		return;
+
+	it->second.references--;
+
+	if (it->second.resource != ResourceCache::INVALID_RESOURCE)
+		mCache.Release(it->second.resource);
+}
+
+void TextureManager::UseTexture(TextureHandle texture, float projectedSize)
+{
+	std::unordered_map<TextureHandle, ResourceCache::ResourceID>::const_iterator it = mResources.find(texture);
+
+	if (it == mResources.end())
+		return;
+
+	const Entry &entry = mResourceEntries[it->second]->second;
+
+	mCache.Request(it->second, ResourceCache::GetDesiredMip(entry.width, entry.height, entry.numMips, projectedSize));
+}
+
+void TextureManager::Update()
+{
+	for (const ResourceCache::Change &change : mCache.Update())
 	{
-		Texture texture(textureFilePath);
-		mLoadedTextures.insert(std::pair<std::string, Texture>(textureFilePath, texture));
+		if (change.evict)
+			Evict(mResourceEntries[change.resource]);
+		else
+			Reload(mResourceEntries[change.resource], change.firstMip);
 	}
+}
+
+void TextureManager::SetTexture(Entry &entry, TextureHandle texture)
+{
+	TextureHandle previous = entry.texture.GetResourceView();
+
+	entry.texture.SetResourceView(texture);
+	RenderResources::GetInstance().ReplaceTexture(previous, texture);
+
+	if (previous != entry.placeholder)
+		GraphicsSystem::GetInstance().GetRenderDevice().ReleaseTexture(previous);
+}
+
+void TextureManager::Reload(EntryIterator it, unsigned int firstMip)
+{
+	Entry &entry = it->second;
+
+	// the mips are read again from the file, a change not landed yet is superseded
+	AssetLoader::GetInstance().Cancel(entry.request);
+
+	AssetLoader::Priority priority = firstMip < entry.firstMip ? AssetLoader::Priority::NORMAL : AssetLoader::Priority::LOW;
+	entry.firstMip = firstMip;
+
+	entry.request = AssetLoader::GetInstance().LoadTexture(it->first, entry.usage, priority, [this, it](TextureHandle loadedTexture, const RenderDevice::TextureData &textureData)
+	{
+		Entry &entry = it->second;
+
+		entry.request = AssetLoader::INVALID_REQUEST;
+
+		mResources.erase(entry.texture.GetResourceView());
+		SetTexture(entry, loadedTexture);
+		mResources[loadedTexture] = entry.resource;
+	}, firstMip);
+}
+
+void TextureManager::Evict(EntryIterator it)
+{
+	Entry &entry = it->second;
+
+	AssetLoader::GetInstance().Cancel(entry.request);
+
+	entry.request = AssetLoader::INVALID_REQUEST;
+
+	// materials still registered with the texture fall back to the placeholder, the entry stays so that it can be loaded again
+	mResources.erase(entry.texture.GetResourceView());
+	SetTexture(entry, entry.placeholder);
 
-	return mLoadedTextures.at(textureFilePath);
+	entry.resource = ResourceCache::INVALID_RESOURCE;
+	entry.evicted = true;
 }
@@ -2,17 +2,74 @@
 #define TEXTURE_MANAGER_H
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <string>
+#include <cstdint>
 #include "Texture.h"
+#include "AssetLoader.h"
+#include "ResourceCache.h"
+
+/**** requested textures are reference counted by their users and kept by a resource cache under a memory budget: the renderer ****/
+/**** reports the size they are drawn at, the mips they need are streamed in (and the ones they don't streamed out when the ****/
+/**** budget is short) by reloading them in the background, unreferenced textures are evicted least recently used first ****/
+/**** and fall back to their placeholder until they're requested or acquired again ****/
+/**** textures loaded on the spot (gui) are never evicted ****/
 
 class TextureManager
 {
 public:
+	enum class Placeholder { WHITE, BLACK, FLAT_NORMAL, };     // what a requested texture shows until it lands: no tint, no specular, unperturbed normals
+
 	static TextureManager &GetInstance() { static TextureManager instance; return instance; }
-	Texture &GetTexture(const std::string &textureName);
+	Texture &GetTexture(const std::string &textureName);     // loads on the spot unless cached (a requested texture can still be its placeholder)
+
+	// returns at once: the texture is loaded in the background and replaces the placeholder here and in the materials using it
+	Texture &RequestTexture(const std::string &textureName, Placeholder placeholder, TextureCooker::Usage usage, AssetLoader::Priority priority = AssetLoader::Priority::NORMAL);
+
+	// held by the users of requested textures (static mesh components), unreferenced textures are evicted when memory is needed
+	void AcquireTexture(const std::string &textureName);
+	void ReleaseTexture(const std::string &textureName);
+
+	// renderer: the texture is drawn across projectedSize pixels this frame
+	void UseTexture(TextureHandle texture, float projectedSize);
+
+	// once per frame: applies the residency decisions of the cache
+	void Update();
+
+	void SetMemoryBudget(uint64_t budget) { mCache.SetBudget(budget); }
+	uint64_t GetMemoryBudget() const { return mCache.GetBudget(); }
+	uint64_t GetResidentSize() const { return mCache.GetResidentSize(); }     // requested textures that landed
 private:
-	TextureManager() = default;
-	std::map<std::string, Texture> mLoadedTextures;  // texture cache
+	struct Entry
+	{
+		Texture texture;
+		TextureHandle placeholder;                  // null for textures loaded on the spot
+		ResourceCache::ResourceID resource;         // invalid until the texture lands, and for textures the cache can't manage
+		unsigned int width;
+		unsigned int height;
+		unsigned int numMips;
+		unsigned int firstMip;
+		unsigned int references;
+		TextureCooker::Usage usage;
+		AssetLoader::RequestID request;             // load or mip change in flight
+		bool permanent;                             // loaded or handed out on the spot, never evicted
+		bool evicted;                               // showing the placeholder until it's loaded again
+	};
+	typedef std::map<std::string, Entry>::iterator EntryIterator;
+
+	TextureManager();
+
+	void Load(EntryIterator entry, AssetLoader::Priority priority);
+	void OnLanded(EntryIterator entry, TextureHandle texture, const RenderDevice::TextureData &textureData);
+	void SetTexture(Entry &entry, TextureHandle texture);
+	void Reload(EntryIterator entry, unsigned int firstMip);
+	void Evict(EntryIterator entry);
+
+	std::map<std::string, Entry> mLoadedTextures;  // texture cache
+	std::unordered_map<TextureHandle, ResourceCache::ResourceID> mResources;     // cache resources by current texture
+	std::vector<EntryIterator> mResourceEntries;                                 // entries by cache resource
+	ResourceCache mCache;
 };
 
 #endif  // TEXTURE_MANAGER_H
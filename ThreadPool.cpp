@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool()
+{
+	unsigned int numWorkers = std::thread::hardware_concurrency();
+	numWorkers = numWorkers > 1 ? numWorkers - 1 : 1;   // leave a core to the calling (main) thread
+
+	for (unsigned int i = 0; i < numWorkers; i++)
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+
+	mJobAvailable.notify_all();
+
+	for (std::thread &worker : mWorkers)
+		worker.join();
+}
+
+// run one claimed task of the job - the job must not be touched after its completion count has been increased
+void ThreadPool::RunTask(Job *job, unsigned int taskIndex)
+{
+	unsigned int numTasks = job->numTasks;
+
+	(*job->task)(taskIndex);
+
+	if (job->completedTasks.fetch_add(1) + 1 == numTasks)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);  // lock so that the waiting thread can't miss the notification
+		mJobCompleted.notify_all();
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		Job *job;
+		unsigned int taskIndex;
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mJobAvailable.wait(lock, [this]() { return mShutdown || !mJobs.empty(); });
+
+			if (mShutdown)
+				return;
+
+			job = mJobs.front();
+
+			// claim the task while holding the lock: the job can't complete (and go out of scope) before the task has run
+			taskIndex = job->nextTask.fetch_add(1);
+
+			// every task of the front job has been claimed: retire it from the queue
+			if (taskIndex >= job->numTasks)
+			{
+				mJobs.pop_front();
+				continue;
+			}
+		}
+
+		RunTask(job, taskIndex);
+	}
+}
+
+void ThreadPool::ParallelFor(unsigned int numTasks, const std::function<void(unsigned int)> &task)
+{
+	if (numTasks == 0)
+		return;
+
+	if (numTasks == 1)
+	{
+		task(0);
+		return;
+	}
+
+	Job job;
+	job.task = &task;
+	job.numTasks = numTasks;
+	job.nextTask = 0;
+	job.completedTasks = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(&job);
+	}
+
+	mJobAvailable.notify_all();
+
+	// calling thread works on its own job until every task has been claimed
+	unsigned int taskIndex;
+	while ((taskIndex = job.nextTask.fetch_add(1)) < numTasks)
+		RunTask(&job, taskIndex);
+
+	// wait for tasks still running on worker threads, then make sure no worker can see the job anymore (it lives on this stack frame)
+	std::unique_lock<std::mutex> lock(mMutex);
+	mJobCompleted.wait(lock, [&job]() { return job.completedTasks.load() == job.numTasks; });
+
+	std::deque<Job*>::iterator it = std::find(mJobs.begin(), mJobs.end(), &job);
+	if (it != mJobs.end())
+		mJobs.erase(it);
+}
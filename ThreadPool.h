@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+/**** fixed size pool of worker threads - the calling thread always takes part in the work it submits, so nested calls can't deadlock ****/
+
+class ThreadPool
+{
+private:
+	struct Job
+	{
+		const std::function<void(unsigned int)> *task;
+		unsigned int numTasks;
+		std::atomic<unsigned int> nextTask;
+		std::atomic<unsigned int> completedTasks;
+	};
+public:
+	static ThreadPool &GetInstance() { static ThreadPool instance; return instance; }
+	~ThreadPool();
+
+	unsigned int GetNumThreads() const { return (unsigned int)mWorkers.size() + 1; }   // workers + calling thread
+
+	// invoke task(i) for i in [0, numTasks) and return when all invocations are completed
+	void ParallelFor(unsigned int numTasks, const std::function<void(unsigned int)> &task);
+private:
+	ThreadPool();
+
+	void WorkerLoop();
+	void RunTask(Job *job, unsigned int taskIndex);
+
+	std::vector<std::thread> mWorkers;
+	std::deque<Job*> mJobs;          // jobs with unclaimed tasks
+
+	std::mutex mMutex;
+	std::condition_variable mJobAvailable;
+	std::condition_variable mJobCompleted;
+
+	bool mShutdown = false;
+};
+
+#endif  // THREAD_POOL_H
@@ -0,0 +1,251 @@
+#include "VertexLayout.h"
+#include "Error.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+// full precision static meshes, to tell quantisation artifacts from other errors
+static const bool COMPRESS_STATIC_MESHES = true;
+
+VertexLayout::VertexLayout()
+{
+	for (int &stream : mStreams)
+		stream = -1;
+}
+
+VertexLayout &VertexLayout::Add(Attribute attribute, Encoding encoding, unsigned int stream)
+{
+	if (mNumElements == MAX_ELEMENTS || stream >= MAX_STREAMS)
+		ErrorBox("too many vertex elements or streams");
+
+	mElements[mNumElements++] = Element{ attribute, encoding, stream, mStrides[stream] };
+
+	mStrides[stream] += GetSize(encoding);
+	mNumStreams = std::max(mNumStreams, stream + 1);
+	mStreams[(unsigned int)attribute] = stream;
+
+	return *this;
+}
+
+bool VertexLayout::IsQuantized() const
+{
+	for (unsigned int i = 0; i < mNumElements; i++)
+		if (mElements[i].encoding == Encoding::QUANTIZED_UNORM16)
+			return true;
+
+	return false;
+}
+
+void VertexLayout::GetInputElements(std::vector<RenderDevice::InputElement> &elements, unsigned int firstStream, unsigned int numStreams) const
+{
+	for (unsigned int i = 0; i < mNumElements; i++)
+		if (mElements[i].stream >= firstStream && mElements[i].stream < firstStream + numStreams)
+			elements.push_back(RenderDevice::InputElement{ GetSemantic(mElements[i].attribute), 0, GetFormat(mElements[i].encoding), mElements[i].stream - firstStream, mElements[i].offset, false });
+}
+
+VertexLayout::Quantization VertexLayout::ComputeQuantization(const Sources &sources) const
+{
+	Quantization quantization = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f) };
+
+	if (!IsQuantized() || !sources.positions || sources.numVertices == 0)
+		return quantization;
+
+	XMVECTOR minimum = XMLoadFloat3(&sources.positions[0]);
+	XMVECTOR maximum = minimum;
+
+	for (unsigned int i = 1; i < sources.numVertices; i++)
+	{
+		minimum = XMVectorMin(minimum, XMLoadFloat3(&sources.positions[i]));
+		maximum = XMVectorMax(maximum, XMLoadFloat3(&sources.positions[i]));
+	}
+
+	// flat meshes keep a non zero scale on every axis
+	XMStoreFloat3(&quantization.offset, minimum);
+	XMStoreFloat3(&quantization.scale, XMVectorMax(maximum - minimum, XMVectorReplicate(1e-6f)));
+
+	return quantization;
+}
+
+void VertexLayout::PackStream(unsigned int stream, const Sources &sources, const Quantization &quantization, std::vector<uint8_t> &data) const
+{
+	unsigned int stride = mStrides[stream];
+
+	data.assign(stride * sources.numVertices, 0);
+
+	for (unsigned int i = 0; i < mNumElements; i++)
+	{
+		const Element &element = mElements[i];
+
+		if (element.stream != stream)
+			continue;
+
+		const XMFLOAT3 *vectors = nullptr;
+		const XMFLOAT2 *pairs = nullptr;
+
+		switch (element.attribute)
+		{
+			case Attribute::POSITION:
+				vectors = sources.positions;
+				break;
+			case Attribute::NORMAL:
+				vectors = sources.normals;
+				break;
+			case Attribute::TANGENT:
+				vectors = sources.tangents;
+				break;
+			case Attribute::TEX_COORD:
+				pairs = sources.textureCoordinates;
+				break;
+			default:     // bone attributes are loaded unpacked
+				break;
+		}
+
+		if (!vectors && !pairs)
+			continue;
+
+		for (unsigned int v = 0; v < sources.numVertices; v++)
+		{
+			uint8_t *destination = &data[v * stride + element.offset];
+
+			switch (element.encoding)
+			{
+				case Encoding::FLOAT2:
+				{
+					float values[2] = { pairs ? pairs[v].x : vectors[v].x, pairs ? pairs[v].y : vectors[v].y };
+					memcpy(destination, values, sizeof(values));
+					break;
+				}
+				case Encoding::FLOAT3:
+				{
+					float values[3] = { vectors ? vectors[v].x : pairs[v].x, vectors ? vectors[v].y : pairs[v].y, vectors ? vectors[v].z : 0.0f };
+					memcpy(destination, values, sizeof(values));
+					break;
+				}
+				case Encoding::HALF2:
+				{
+					PackedVector::HALF values[2] = { PackedVector::XMConvertFloatToHalf(pairs ? pairs[v].x : vectors[v].x), PackedVector::XMConvertFloatToHalf(pairs ? pairs[v].y : vectors[v].y) };
+					memcpy(destination, values, sizeof(values));
+					break;
+				}
+				case Encoding::OCTAHEDRAL_FLOAT:
+				case Encoding::OCTAHEDRAL_SNORM16:
+				{
+					float values[2];
+					EncodeOctahedral(vectors ? vectors[v] : XMFLOAT3(0.0f, 0.0f, 1.0f), values[0], values[1]);
+
+					if (element.encoding == Encoding::OCTAHEDRAL_FLOAT)
+						memcpy(destination, values, sizeof(values));
+					else
+					{
+						int16_t snorm[2] = { (int16_t)lround(values[0] * 32767.0f), (int16_t)lround(values[1] * 32767.0f) };
+						memcpy(destination, snorm, sizeof(snorm));
+					}
+					break;
+				}
+				case Encoding::QUANTIZED_UNORM16:
+				{
+					const XMFLOAT3 &position = vectors[v];
+
+					// w is 1 so that the padding reads as a point
+					uint16_t unorm[4] =
+					{
+						(uint16_t)std::min(std::max(lround((position.x - quantization.offset.x) / quantization.scale.x * 65535.0f), 0l), 65535l),
+						(uint16_t)std::min(std::max(lround((position.y - quantization.offset.y) / quantization.scale.y * 65535.0f), 0l), 65535l),
+						(uint16_t)std::min(std::max(lround((position.z - quantization.offset.z) / quantization.scale.z * 65535.0f), 0l), 65535l),
+						65535,
+					};
+					memcpy(destination, unorm, sizeof(unorm));
+					break;
+				}
+			}
+		}
+	}
+}
+
+const VertexLayout &VertexLayout::GetStaticMeshLayout()
+{
+	static const VertexLayout compressedLayout = VertexLayout()
+		.Add(Attribute::POSITION, Encoding::QUANTIZED_UNORM16, 0)
+		.Add(Attribute::NORMAL, Encoding::OCTAHEDRAL_SNORM16, 1)
+		.Add(Attribute::TANGENT, Encoding::OCTAHEDRAL_SNORM16, 1)
+		.Add(Attribute::TEX_COORD, Encoding::HALF2, 1);
+
+	static const VertexLayout fullPrecisionLayout = VertexLayout()
+		.Add(Attribute::POSITION, Encoding::FLOAT3, 0)
+		.Add(Attribute::NORMAL, Encoding::OCTAHEDRAL_FLOAT, 1)
+		.Add(Attribute::TANGENT, Encoding::OCTAHEDRAL_FLOAT, 1)
+		.Add(Attribute::TEX_COORD, Encoding::FLOAT2, 1);
+
+	return COMPRESS_STATIC_MESHES ? compressedLayout : fullPrecisionLayout;
+}
+
+const char *VertexLayout::GetSemantic(Attribute attribute)
+{
+	static const char *semantics[NUM_ATTRIBUTES] = { "POSITION", "NORMAL", "TANGENT", "TEX_COORD", "BONE_IDS", "BONE_WEIGHTS", };
+
+	return semantics[(unsigned int)attribute];
+}
+
+RenderDevice::Format VertexLayout::GetFormat(Encoding encoding)
+{
+	switch (encoding)
+	{
+		case Encoding::FLOAT2:
+		case Encoding::OCTAHEDRAL_FLOAT:
+			return RenderDevice::Format::R32G32_FLOAT;
+		case Encoding::FLOAT3:
+			return RenderDevice::Format::R32G32B32_FLOAT;
+		case Encoding::HALF2:
+			return RenderDevice::Format::R16G16_FLOAT;
+		case Encoding::OCTAHEDRAL_SNORM16:
+			return RenderDevice::Format::R16G16_SNORM;
+		case Encoding::QUANTIZED_UNORM16:
+			return RenderDevice::Format::R16G16B16A16_UNORM;
+		default:
+			return RenderDevice::Format::UNKNOWN;
+	}
+}
+
+unsigned int VertexLayout::GetSize(Encoding encoding)
+{
+	switch (encoding)
+	{
+		case Encoding::FLOAT2:
+		case Encoding::OCTAHEDRAL_FLOAT:
+			return 8;
+		case Encoding::FLOAT3:
+			return 12;
+		case Encoding::HALF2:
+		case Encoding::OCTAHEDRAL_SNORM16:
+			return 4;
+		case Encoding::QUANTIZED_UNORM16:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+void VertexLayout::EncodeOctahedral(const XMFLOAT3 &vector, float &x, float &y)
+{
+	// project on the octahedron |x| + |y| + |z| = 1, the lower half is folded over the diagonals
+	float length = fabs(vector.x) + fabs(vector.y) + fabs(vector.z);
+
+	if (length == 0.0f)
+	{
+		x = y = 0.0f;
+		return;
+	}
+
+	x = vector.x / length;
+	y = vector.y / length;
+
+	if (vector.z < 0.0f)
+	{
+		float foldedX = (1.0f - fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+		x = foldedX;
+		y = foldedY;
+	}
+}
@@ -0,0 +1,89 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include "RenderDevice.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+using namespace DirectX;
+
+/**** declarative vertex formats: each attribute has an encoding and a stream, attributes of the same stream are interleaved ****/
+/**** meshes pack their full precision attributes on the cpu when they're loaded, shaders build their input layouts from the same layout ****/
+/**** compressed encodings: unit vectors on the octahedron in 2 x 16 bits, half float texture coordinates, positions quantised ****/
+/**** to 16 bits in the mesh bounds (the vertex shader dequantises them with the mesh offset and scale) ****/
+
+class VertexLayout
+{
+public:
+	enum class Attribute { POSITION, NORMAL, TANGENT, TEX_COORD, BONE_IDS, BONE_WEIGHTS, };
+	enum class Encoding
+	{
+		FLOAT2,
+		FLOAT3,
+		HALF2,
+		OCTAHEDRAL_FLOAT,        // unit vector, read as float2 and decoded by the vertex shader
+		OCTAHEDRAL_SNORM16,
+		QUANTIZED_UNORM16,       // position in the mesh bounds, read as float3 and dequantised by the vertex shader
+	};
+
+	struct Element
+	{
+		Attribute attribute;
+		Encoding encoding;
+		unsigned int stream;
+		unsigned int offset;     // in the stream vertex
+	};
+	struct Quantization          // position = offset + unorm position * scale, the scale is the extent of the bounds
+	{
+		XMFLOAT3 offset;
+		XMFLOAT3 scale;
+	};
+	struct Sources               // full precision attributes, one per vertex; attributes the layout has but the mesh doesn't can be null
+	{
+		const XMFLOAT3 *positions;
+		const XMFLOAT3 *normals;
+		const XMFLOAT3 *tangents;
+		const XMFLOAT2 *textureCoordinates;
+		unsigned int numVertices;
+	};
+
+	static const unsigned int NUM_ATTRIBUTES = 6;
+	static const unsigned int MAX_ELEMENTS = 8;
+	static const unsigned int MAX_STREAMS = 4;
+public:
+	VertexLayout();
+
+	// elements are appended at the end of their stream vertex
+	VertexLayout &Add(Attribute attribute, Encoding encoding, unsigned int stream);
+
+	unsigned int GetNumElements() const { return mNumElements; }
+	const Element &GetElement(unsigned int element) const { return mElements[element]; }
+	unsigned int GetNumStreams() const { return mNumStreams; }
+	unsigned int GetStride(unsigned int stream) const { return mStrides[stream]; }
+	int GetStream(Attribute attribute) const { return mStreams[(unsigned int)attribute]; }     // -1 if missing
+	bool IsQuantized() const;
+
+	// input elements of the streams from firstStream, in slots from 0
+	void GetInputElements(std::vector<RenderDevice::InputElement> &elements, unsigned int firstStream = 0, unsigned int numStreams = MAX_STREAMS) const;
+
+	Quantization ComputeQuantization(const Sources &sources) const;     // identity if positions aren't quantised
+	void PackStream(unsigned int stream, const Sources &sources, const Quantization &quantization, std::vector<uint8_t> &data) const;
+
+	// positions in stream 0 (depth only passes bind them alone), normals, tangents and texture coordinates interleaved in stream 1
+	static const VertexLayout &GetStaticMeshLayout();
+
+	static const char *GetSemantic(Attribute attribute);
+	static RenderDevice::Format GetFormat(Encoding encoding);
+	static unsigned int GetSize(Encoding encoding);
+private:
+	static void EncodeOctahedral(const XMFLOAT3 &vector, float &x, float &y);
+
+	Element mElements[MAX_ELEMENTS];
+	unsigned int mNumElements = 0;
+	unsigned int mStrides[MAX_STREAMS] = {};
+	unsigned int mNumStreams = 0;
+	int mStreams[NUM_ATTRIBUTES];
+};
+
+#endif  // VERTEX_LAYOUT_H
@@ -0,0 +1,112 @@
+#include "VirtualFileSystem.h"
+
+void VirtualFileSystem::File::Close()
+{
+	mMappedFile.Close();
+	mBuffer.clear();
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+void VirtualFileSystem::File::Prefetch() const
+{
+	static const size_t PAGE_SIZE = 4096;
+
+	volatile uint8_t sum = 0;
+	for (size_t offset = 0; offset < mSize; offset += PAGE_SIZE)
+		sum += mData[offset];
+}
+
+VirtualFileSystem::~VirtualFileSystem()
+{
+	for (PackFile *pack : mPacks)
+		delete pack;
+}
+
+bool VirtualFileSystem::Mount(const std::string &packFilePath)
+{
+	PackFile *pack = new PackFile;
+
+	if (!pack->Open(packFilePath))
+	{
+		delete pack;
+		return false;
+	}
+
+	mPacks.push_back(pack);
+
+	return true;
+}
+
+const PackFile::Entry *VirtualFileSystem::Find(const std::string &filePath, const PackFile *&pack) const
+{
+	if (mPacks.empty())
+		return nullptr;
+
+	std::string normalizedPath = PackFile::NormalizePath(filePath);
+
+	for (std::vector<PackFile*>::const_reverse_iterator it = mPacks.rbegin(); it != mPacks.rend(); ++it)
+	{
+		const PackFile::Entry *entry = (*it)->Find(normalizedPath);
+
+		if (entry)
+		{
+			pack = *it;
+			return entry;
+		}
+	}
+
+	return nullptr;
+}
+
+bool VirtualFileSystem::Open(const std::string &filePath, File &file) const
+{
+	file.Close();
+
+	const PackFile *pack;
+	const PackFile::Entry *entry = Find(filePath, pack);
+
+	if (!entry)
+	{
+		if (!file.mMappedFile.Open(filePath))
+			return false;
+
+		file.mData = file.mMappedFile.GetData();
+		file.mSize = file.mMappedFile.GetSize();
+
+		return true;
+	}
+
+	if (entry->flags & PackFile::COMPRESSED)
+	{
+		file.mBuffer.resize((size_t)entry->size);
+
+		if (!pack->Read(*entry, file.mBuffer.data()))
+		{
+			file.mBuffer.clear();
+			return false;
+		}
+
+		file.mData = file.mBuffer.data();
+	}
+	else
+		file.mData = pack->GetData(*entry);
+
+	file.mSize = (size_t)entry->size;
+
+	return true;
+}
+
+bool VirtualFileSystem::Exists(const std::string &filePath) const
+{
+	return GetModificationTime(filePath) != 0;
+}
+
+uint64_t VirtualFileSystem::GetModificationTime(const std::string &filePath) const
+{
+	const PackFile *pack;
+	const PackFile::Entry *entry = Find(filePath, pack);
+
+	return entry ? entry->modificationTime : MappedFile::GetModificationTime(filePath);
+}
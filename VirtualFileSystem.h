@@ -0,0 +1,55 @@
+#ifndef VIRTUAL_FILE_SYSTEM_H
+#define VIRTUAL_FILE_SYSTEM_H
+
+#include "PackFile.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**** asset files by path: mounted packs are searched first (the last mounted first), files on disk otherwise. stored pack ****/
+/**** entries and loose files are memory mapped and read in place, compressed entries are decompressed on open. packs are ****/
+/**** mounted before loading starts, lookups are thread safe after that ****/
+
+class VirtualFileSystem
+{
+public:
+	class File
+	{
+	public:
+		File() = default;
+
+		File(const File&) = delete;
+		File &operator=(const File&) = delete;
+
+		void Close();
+		void Prefetch() const;      // touches every page so that later reads don't fault
+
+		const uint8_t *GetData() const { return mData; }
+		size_t GetSize() const { return mSize; }
+	private:
+		friend class VirtualFileSystem;
+
+		MappedFile mMappedFile;           // loose file
+		std::vector<uint8_t> mBuffer;     // decompressed pack entry
+		const uint8_t *mData = nullptr;
+		size_t mSize = 0;
+	};
+public:
+	static VirtualFileSystem &GetInstance() { static VirtualFileSystem instance; return instance; }
+	~VirtualFileSystem();
+
+	bool Mount(const std::string &packFilePath);
+
+	bool Open(const std::string &filePath, File &file) const;      // fails if the file is missing (or empty on disk)
+	bool Exists(const std::string &filePath) const;
+	uint64_t GetModificationTime(const std::string &filePath) const;     // 0 if the file is missing
+private:
+	VirtualFileSystem() = default;
+
+	const PackFile::Entry *Find(const std::string &filePath, const PackFile *&pack) const;
+
+	std::vector<PackFile*> mPacks;
+};
+
+#endif  // VIRTUAL_FILE_SYSTEM_H
@@ -1,8 +1,38 @@
 #include <Windows.h>
+#include <cstring>
+#include <cstdio>
 #include "Game.h"
+#include "AssetCooker.h"
+#include "D3D11RenderDevice.h"
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPSTR commandLine, int show)
 {
+	// asset build (-cook): cooks the changed assets and exits, no window or device is created
+	if (strstr(commandLine, "-cook"))
+	{
+		AssetCooker cooker(&D3D11RenderDevice::DecodeTextureFile);
+		bool cooked = cooker.Cook({ "models" }, "assets.manifest");
+
+		for (const std::string &error : cooker.GetErrors())
+			OutputDebugStringA((error + "\n").c_str());
+
+		// vertex cache efficiency (average cache miss ratio) of the imported models
+		char line[1024];
+
+		for (const AssetCooker::ModelStatistics &model : cooker.GetModelStatistics())
+		{
+			snprintf(line, sizeof(line), "%s: %u triangles, acmr %.3f -> %.3f\n", model.filePath.c_str(), model.vertexCache.numTriangles, model.vertexCache.acmrBefore, model.vertexCache.acmrAfter);
+			OutputDebugStringA(line);
+		}
+
+		const AssetCooker::Statistics &statistics = cooker.GetStatistics();
+		snprintf(line, sizeof(line), "%u cooked, %u up to date, %u failed - acmr %.3f -> %.3f over %u triangles\n", statistics.numCooked, statistics.numUpToDate, statistics.numFailed,
+			statistics.vertexCache.acmrBefore, statistics.vertexCache.acmrAfter, statistics.vertexCache.numTriangles);
+		OutputDebugStringA(line);
+
+		return cooked ? 0 : 1;
+	}
+
 	Game::GetInstance().Initialize(hInstance);
 	return Game::GetInstance().Run();
-}
\ No newline at end of file
+}
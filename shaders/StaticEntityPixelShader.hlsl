@@ -40,11 +40,11 @@ struct Light
 	float spotLightAngle;
 };
 
-#define NUM_LIGHTS 10
+#define NUM_LIGHTS 256
 
 cbuffer Lights : register(b1)
 {
-	Light lights[NUM_LIGHTS];
+	Light lights[NUM_LIGHTS];    // directional lights first, then the clustered lights
 };
 
 /**** camera position ****/
@@ -54,6 +54,53 @@ cbuffer Camera : register(b2)
 	float shadowDistance;
 };
 
+/**** directional light cascades (ShadowCascades), cascade c is in the quadrant at column c % 2 and row c / 2 of the shadow map ****/
+#define NUM_CASCADES 4
+
+cbuffer Shadows : register(b5)
+{
+	float4x4 cascadeViewProjectionMatrices[NUM_CASCADES];
+	float4 cascadeSplits;         // far view depth of each cascade
+};
+
+/**** light clusters (LightClusterer) ****/
+#define TILES_X 16
+#define TILES_Y 8
+#define SLICES 24
+#define NUM_CLUSTERS (TILES_X * TILES_Y * SLICES)
+#define MAX_LIGHT_INDICES 32768
+
+cbuffer Clusters : register(b3)
+{
+	float2 tileScale;                      // pixels to tiles
+	float sliceScale;                      // log view depth to slice
+	float sliceBias;
+	uint numGlobalLights;
+	uint4 clusters[NUM_CLUSTERS / 4];      // offset | count << 16
+};
+
+cbuffer LightIndices : register(b4)
+{
+	uint4 lightIndices[MAX_LIGHT_INDICES / 8];    // 16 bit indices, relative to the first clustered light
+};
+
+uint getClusterLightIndex(uint i)
+{
+	uint word = lightIndices[i >> 3][(i >> 1) & 3];
+	return (i & 1) ? word >> 16 : word & 0xFFFF;
+}
+
+struct PixelShaderInput
+{
+	float4 position : SV_POSITION;
+	float4 worldPosition : WORLD_POSITION;
+	float4 clipPosition : CLIP_POSITION;
+	float4 lightClipPositionSpot : LIGHT_CLIP_POSITION_SPOT;
+	float3 worldNormal : WORLD_NORMAL;
+	float3 worldTangent : WORLD_TANGENT;
+	float2 textureCoordinates : TEX_COORD;
+};
+
 float3 doNormalMapping(float3 tangentSpaceNormal, float3 worldNormal, float3 worldTangent);
 float3 doBumpMapping(Texture2D bumpMap, float2 textureCoordinates, float3 worldNormal, float3 worldTangent);
 
@@ -63,6 +110,7 @@ struct LightResult
 	float3 specular;
 };
 
+LightResult shadeLight(Light light, float3 normal, PixelShaderInput input);
 LightResult calculateLighting(Light light, Material material, float3 worldNormal, float3 worldPosition, float3 cameraWorldPosition);
 LightResult calculateDirectionalLight(Light light, float3 worldNormal, float3 toEyeVector, Material material);
 LightResult calculatePointLight(Light light, float3 worldPosition, float3 worldNormal, float3 toEyeVector, Material material);
@@ -72,18 +120,6 @@ float3 specularLight(float3 lightColor, float3 fromLightVector, float3 worldNorm
 float calculateAttenuation(float lightRange, float distance);
 float calculateFalloff(float spotAngle, float3 fromLightVector, float3 spotDirection);
 
-struct PixelShaderInput
-{
-	float4 position : SV_POSITION;
-	float4 worldPosition : WORLD_POSITION;
-	float4 clipPosition : CLIP_POSITION;
-	float4 lightClipPosition : LIGHT_CLIP_POSITION;
-	float4 lightClipPositionSpot : LIGHT_CLIP_POSITION_SPOT;
-	float3 worldNormal : WORLD_NORMAL;
-	float3 worldTangent : WORLD_TANGENT;
-	float2 textureCoordinates : TEX_COORD;
-};
-
 /**** pixel shader ****/
 [earlydepthstencil]
 float4 main(PixelShaderInput input) : SV_TARGET
@@ -115,7 +151,9 @@ float4 main(PixelShaderInput input) : SV_TARGET
 	float3 normal = (float3)0;
 	if (material.hasNormalMap)
 	{
-		float3 tangentSpaceNormal = normalMap.Sample(textureSampler, input.textureCoordinates).rgb  * 2.0 - 1.0;
+		// cooked normal maps (bc5) hold x and y only, z is rebuilt
+		float2 tangentSpaceNormalXY = normalMap.Sample(textureSampler, input.textureCoordinates).rg * 2.0 - 1.0;
+		float3 tangentSpaceNormal = float3(tangentSpaceNormalXY, sqrt(saturate(1.0 - dot(tangentSpaceNormalXY, tangentSpaceNormalXY))));
 		normal = doNormalMapping(tangentSpaceNormal, normalize(input.worldNormal), normalize(input.worldTangent));
 	}
 	else
@@ -124,53 +162,29 @@ float4 main(PixelShaderInput input) : SV_TARGET
 	/**** lighting calculations ****/
 	LightResult lightResult = (LightResult)0;
 
-	for (int i = 0; i < NUM_LIGHTS; i++)
-		if (lights[i].enabled)
-			if (lights[i].type != DIRECTIONAL_LIGHT && length(lights[i].worldPosition - input.worldPosition.xyz) > lights[i].range)
-				;
-			else if (lights[i].type == SPOT_LIGHT)
-			{
-				float2 shadowTexCoords;
-				shadowTexCoords.x = (input.lightClipPositionSpot.x / input.lightClipPositionSpot.w + 1.0) / 2.0;
-				shadowTexCoords.y = (-input.lightClipPositionSpot.y / input.lightClipPositionSpot.w + 1.0) / 2.0;
-
-				float fragmentDepth = input.lightClipPositionSpot.z / input.lightClipPositionSpot.w;
-				float closestDepth = shadowDepthMapSpot.Sample(textureSampler, shadowTexCoords).r;
-
-				if (closestDepth + 0.0001 > fragmentDepth)
-				{
-					float3 worldNormal = normal; float3 worldPosition = input.worldPosition.xyz;
-					float3 toEyeVector = normalize(cameraWorldPosition - worldPosition);
-
-					float3 toLightVector = normalize(lights[i].worldPosition - worldPosition);
-					float3 spotDirection = normalize(lights[i].worldDirection);
-
-					/* diffuse reflection */
-					float3 diffuse = diffuseLight(lights[i].color, toLightVector, worldNormal);
-
-					/* specular reflection */
-					float3 specular = specularLight(lights[i].color, -toLightVector, worldNormal, toEyeVector, material);
-
-					/* attenuation */
-					float attenuation = calculateAttenuation(lights[i].range, length(worldPosition - lights[i].worldPosition));
-
-					/* falloff */
-					float falloff = calculateFalloff(lights[i].spotLightAngle, -toLightVector, spotDirection);
-
-					LightResult result;
-					result.diffuse = diffuse * attenuation * falloff * lights[i].intensity;
-					result.specular = specular * attenuation * falloff * lights[i].intensity;
-
-					lightResult.diffuse += result.diffuse;
-					lightResult.specular += result.specular;
-				}	
-			}
-			else
-			{
-				LightResult result = calculateLighting(lights[i], material, normal, input.worldPosition.xyz, cameraWorldPosition);
-				lightResult.diffuse += result.diffuse;
-				lightResult.specular += result.specular;
-			}	
+	// directional lights
+	for (uint i = 0; i < numGlobalLights; i++)
+	{
+		LightResult result = shadeLight(lights[i], normal, input);
+		lightResult.diffuse += result.diffuse;
+		lightResult.specular += result.specular;
+	}
+
+	// point and spot lights of the fragment's cluster
+	uint2 tile = min(uint2(input.position.xy * tileScale), uint2(TILES_X - 1, TILES_Y - 1));
+	uint slice = (uint)clamp(floor(log(input.clipPosition.w) * sliceScale + sliceBias), 0.0, SLICES - 1.0);
+	uint clusterIndex = (slice * TILES_Y + tile.y) * TILES_X + tile.x;
+
+	uint cluster = clusters[clusterIndex >> 2][clusterIndex & 3];
+	uint offset = cluster & 0xFFFF;
+	uint count = cluster >> 16;
+
+	for (uint j = 0; j < count; j++)
+	{
+		LightResult result = shadeLight(lights[numGlobalLights + getClusterLightIndex(offset + j)], normal, input);
+		lightResult.diffuse += result.diffuse;
+		lightResult.specular += result.specular;
+	}
 
 	diffuse *= lightResult.diffuse;
 	specular *= lightResult.specular;
@@ -178,11 +192,18 @@ float4 main(PixelShaderInput input) : SV_TARGET
 	float3 totalColor = diffuse + specular + ambient;
 	
 	/**** directional shadow mapping ****/
+	// cascade of the fragment's view depth
+	uint cascade = (uint)dot((float4)(input.clipPosition.w > cascadeSplits), 1.0);
+	cascade = min(cascade, NUM_CASCADES - 1);
+
+	float4 lightClipPosition = mul(cascadeViewProjectionMatrices[cascade], input.worldPosition);
+
 	float2 shadowTexCoords;
-	shadowTexCoords.x = (input.lightClipPosition.x / input.lightClipPosition.w + 1.0) / 2.0;
-	shadowTexCoords.y = (-input.lightClipPosition.y / input.lightClipPosition.w + 1.0) / 2.0;
+	shadowTexCoords.x = (lightClipPosition.x / lightClipPosition.w + 1.0) / 2.0;
+	shadowTexCoords.y = (-lightClipPosition.y / lightClipPosition.w + 1.0) / 2.0;
+	shadowTexCoords = (shadowTexCoords + float2(cascade % 2, cascade / 2)) / 2.0;
 
-	float fragmentDepth = input.lightClipPosition.z / input.lightClipPosition.w;
+	float fragmentDepth = lightClipPosition.z / lightClipPosition.w;
 	float closestDepth = shadowDepthMap.Sample(textureSampler, shadowTexCoords).r;
 	
 	// shadow transition
@@ -198,6 +219,53 @@ float4 main(PixelShaderInput input) : SV_TARGET
 	return float4(totalColor, 1.0);
 }
 
+/**** light of a fragment, spot lights use the spot shadow map ****/
+LightResult shadeLight(Light light, float3 normal, PixelShaderInput input)
+{
+	LightResult lightResult = (LightResult)0;
+
+	if (!light.enabled || (light.type != DIRECTIONAL_LIGHT && length(light.worldPosition - input.worldPosition.xyz) > light.range))
+		return lightResult;
+
+	if (light.type == SPOT_LIGHT)
+	{
+		float2 shadowTexCoords;
+		shadowTexCoords.x = (input.lightClipPositionSpot.x / input.lightClipPositionSpot.w + 1.0) / 2.0;
+		shadowTexCoords.y = (-input.lightClipPositionSpot.y / input.lightClipPositionSpot.w + 1.0) / 2.0;
+
+		float fragmentDepth = input.lightClipPositionSpot.z / input.lightClipPositionSpot.w;
+		float closestDepth = shadowDepthMapSpot.Sample(textureSampler, shadowTexCoords).r;
+
+		if (closestDepth + 0.0001 > fragmentDepth)
+		{
+			float3 worldNormal = normal; float3 worldPosition = input.worldPosition.xyz;
+			float3 toEyeVector = normalize(cameraWorldPosition - worldPosition);
+
+			float3 toLightVector = normalize(light.worldPosition - worldPosition);
+			float3 spotDirection = normalize(light.worldDirection);
+
+			/* diffuse reflection */
+			float3 diffuse = diffuseLight(light.color, toLightVector, worldNormal);
+
+			/* specular reflection */
+			float3 specular = specularLight(light.color, -toLightVector, worldNormal, toEyeVector, material);
+
+			/* attenuation */
+			float attenuation = calculateAttenuation(light.range, length(worldPosition - light.worldPosition));
+
+			/* falloff */
+			float falloff = calculateFalloff(light.spotLightAngle, -toLightVector, spotDirection);
+
+			lightResult.diffuse = diffuse * attenuation * falloff * light.intensity;
+			lightResult.specular = specular * attenuation * falloff * light.intensity;
+		}
+
+		return lightResult;
+	}
+
+	return calculateLighting(light, material, normal, input.worldPosition.xyz, cameraWorldPosition);
+}
+
 /**** normal mapping calculations ****/
 float3 doNormalMapping(float3 tangentSpaceNormal, float3 worldNormal, float3 worldTangent)
 {
@@ -1,18 +1,31 @@
 cbuffer Transform : register(b0)
 {
-	float4x4 worldMatrix;                     // matrices are stored in column-major order by default (use row_major to store in row-major order)
-	float4x4 worldInverseTransposeMatrix;     // matrix data is passed in row-major order (so by default matrices are transposed)
-	float4x4 worldViewProjectionMatrix;
-	float4x4 lightViewProjectionMatrix;
-	float4x4 lightViewProjectionMatrixSpot;
+	float4x4 viewProjectionMatrix;            // matrices are stored in column-major order by default (use row_major to store in row-major order)
+	                                          // matrix data is passed in row-major order (so by default matrices are transposed)
+	float4x4 lightViewProjectionMatrixSpot;   // directional light cascades are selected per pixel
+};
+
+cbuffer Mesh : register(b1)
+{
+	float3 positionOffset;                    // quantised positions are in [0, 1] over the mesh bounds
+	float3 positionScale;
 };
 
 struct VertexShaderInput
 {
 	float3 position : POSITION;
-	float3 normal : NORMAL;
-	float3 tangent : TANGENT;
+	float2 normal : NORMAL;                   // octahedral unit vectors
+	float2 tangent : TANGENT;
 	float2 textureCoordinates : TEX_COORD;
+
+	// per instance data: matrix rows (row vector convention, vector * matrix)
+	float4 world0 : INSTANCE_WORLD0;
+	float4 world1 : INSTANCE_WORLD1;
+	float4 world2 : INSTANCE_WORLD2;
+	float4 world3 : INSTANCE_WORLD3;
+	float4 worldInverseTranspose0 : INSTANCE_WORLD_INVERSE_TRANSPOSE0;
+	float4 worldInverseTranspose1 : INSTANCE_WORLD_INVERSE_TRANSPOSE1;
+	float4 worldInverseTranspose2 : INSTANCE_WORLD_INVERSE_TRANSPOSE2;
 };
 
 struct VertexShaderOutput
@@ -20,26 +33,41 @@ struct VertexShaderOutput
 	float4 position : SV_POSITION;
 	float4 worldPosition : WORLD_POSITION;
 	float4 clipPosition : CLIP_POSITION;
-	float4 lightClipPosition : LIGHT_CLIP_POSITION;
 	float4 lightClipPositionSpot : LIGHT_CLIP_POSITION_SPOT;
 	float3 worldNormal : WORLD_NORMAL;
 	float3 worldTangent : WORLD_TANGENT;
 	float2 textureCoordinates : TEX_COORD;
 };
 
+float3 DecodeOctahedral(float2 encoded)
+{
+	// the lower half of the sphere is folded over the diagonals of the octahedron
+	float3 vector = float3(encoded.x, encoded.y, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = saturate(-vector.z);
+	vector.xy += vector.xy >= 0.0 ? -fold : fold;
+
+	return normalize(vector);
+}
+
 VertexShaderOutput main(VertexShaderInput input)
 {
 	VertexShaderOutput output;
 
-	output.position = mul(worldViewProjectionMatrix, float4(input.position, 1.0));   
-	output.worldPosition = mul(worldMatrix, float4(input.position, 1.0));
+	float3 position = positionOffset + input.position * positionScale;
+	float3 normal = DecodeOctahedral(input.normal);
+	float3 tangent = DecodeOctahedral(input.tangent);
+
+	float4x4 worldMatrix = float4x4(input.world0, input.world1, input.world2, input.world3);
+	float3x3 worldInverseTransposeMatrix = float3x3(input.worldInverseTranspose0.xyz, input.worldInverseTranspose1.xyz, input.worldInverseTranspose2.xyz);
+
+	output.worldPosition = mul(float4(position, 1.0), worldMatrix);
+	output.position = mul(viewProjectionMatrix, output.worldPosition);
 	output.clipPosition = output.position;
 
-	output.lightClipPosition = mul(lightViewProjectionMatrix, output.worldPosition);
 	output.lightClipPositionSpot = mul(lightViewProjectionMatrixSpot, output.worldPosition);
 
-	output.worldNormal = mul(worldInverseTransposeMatrix, float4(input.normal, 0.0));
-	output.worldTangent = mul(worldMatrix, float4(input.tangent, 0.0));
+	output.worldNormal = mul(normal, worldInverseTransposeMatrix);
+	output.worldTangent = mul(float4(tangent, 0.0), worldMatrix).xyz;
 	output.textureCoordinates = input.textureCoordinates;
 
 	return output;
@@ -0,0 +1,132 @@
+#include "../GraphicsSystem.h"
+#include "../NullRenderDevice.h"
+#include "../RenderingSystem.h"
+#include "../Entity.h"
+#include "../PositionComponent.h"
+#include "../StaticMeshComponent.h"
+#include "../CameraComponent.h"
+#include "../LightComponent.h"
+#include "../ShadowComponent.h"
+#include <cstdio>
+#include <cstdlib>
+
+/**** headless frames of the rendering system on the null render device - build with the engine sources except ****/
+/**** D3D11RenderDevice.cpp and main.cpp. prints the submission statistics of each frame, the number of frames is the ****/
+/**** first argument ****/
+
+namespace
+{
+	int numFailures = 0;
+
+	void Check(bool condition, const char *test)
+	{
+		printf("%s: %s\n", condition ? "passed" : "FAILED", test);
+
+		if (!condition)
+			numFailures++;
+	}
+
+	const unsigned int GRID_SIZE = 8;        // GRID_SIZE x GRID_SIZE boxes sharing a mesh and a material
+
+	// unit box with a corner at the origin, copies share its handle
+	Mesh CreateBox(std::vector<XMFLOAT3> &positions, std::vector<unsigned int> &indices)
+	{
+		positions.clear();
+		for (unsigned int i = 0; i < 8; i++)
+			positions.push_back(XMFLOAT3((float)(i & 1), (float)(i >> 1 & 1), (float)(i >> 2 & 1)));
+
+		indices = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+
+		std::vector<XMFLOAT3> normals(positions.size(), XMFLOAT3(0.0f, 1.0f, 0.0f)), tangents(positions.size(), XMFLOAT3(1.0f, 0.0f, 0.0f));
+		std::vector<XMFLOAT2> textureCoordinates(positions.size(), XMFLOAT2(0.0f, 0.0f));
+
+		VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], (unsigned int)positions.size() };
+
+		Mesh mesh;
+		mesh.LoadVertices(VertexLayout::GetStaticMeshLayout(), sources);
+		mesh.LoadIndexBuffer(indices);
+
+		return mesh;
+	}
+
+	void PrintStatistics(unsigned int frame, const NullRenderDevice::Statistics &statistics)
+	{
+		printf("frame %u: %u draws, %u instances, %u primitives, %u state changes (%u redundant), %u bytes updated\n", frame, statistics.drawCalls, statistics.instances, statistics.primitives, statistics.stateChanges, statistics.redundantStateChanges, statistics.bytesUpdated);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int numFrames = argc > 1 ? (unsigned int)atoi(argv[1]) : 10;
+	if (numFrames == 0)
+		numFrames = 1;
+
+	GraphicsSystem::GetInstance().InitializeHeadless(1280, 720);
+	NullRenderDevice &device = static_cast<NullRenderDevice&>(GraphicsSystem::GetInstance().GetRenderDevice());
+
+	// boxes on a grid in front of the camera, casting shadows
+	std::vector<XMFLOAT3> positions;
+	std::vector<unsigned int> indices;
+	Mesh box = CreateBox(positions, indices);
+	Material material;
+
+	std::vector<Entity*> entities;
+	for (unsigned int i = 0; i < GRID_SIZE * GRID_SIZE; i++)
+	{
+		Entity *entity = new Entity;
+		entity->AddComponent<PositionComponent>(XMFLOAT3(3.0f * (i % GRID_SIZE) - 12.0f, 0.0f, 3.0f * (i / GRID_SIZE) + 10.0f), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+		entity->AddComponent<StaticMeshComponent>(std::vector<Mesh>{ box }, std::vector<Material>{ material }, positions, indices);
+		entity->AddComponent<ShadowComponent>();
+
+		entities.push_back(entity);
+	}
+
+	Entity light;
+	PositionComponent &lightPosition = light.AddComponent<PositionComponent>(XMFLOAT3(), XMFLOAT3(XMConvertToRadians(45.0f), XMConvertToRadians(45.0f), 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	light.AddComponent<LightComponent>(LightComponent::Type::DIRECTIONAL, XMFLOAT3(1.0f, 1.0f, 1.0f), 0.0f, 0.7f, 45.0f, &lightPosition);
+
+	Entity camera;
+	PositionComponent &cameraPosition = camera.AddComponent<PositionComponent>(XMFLOAT3(0.0f, 8.0f, -10.0f), XMFLOAT3(XMConvertToRadians(20.0f), 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	CameraComponent &cameraComponent = camera.AddComponent<CameraComponent>(XMConvertToRadians(45.0f), 16.0f / 9.0f, 0.1f, 200.0f, &cameraPosition, XMFLOAT3(), XMFLOAT3());
+	cameraComponent.SetActive(true);
+
+	// the frames of the game loop, without the window
+	const float color[] = { 0.1f, 0.2f, 0.1f, 1.0f };
+	unsigned int firstFrameDraws = 0;
+	bool sameDraws = true;
+
+	for (unsigned int frame = 0; frame < numFrames; frame++)
+	{
+		// the commands of the last frame are recorded
+		device.SetRecording(frame + 1 == numFrames);
+
+		GraphicsSystem::GetInstance().ClearScreen(color);
+		RenderingSystem::GetInstance().Render();
+		GraphicsSystem::GetInstance().Present();
+
+		const NullRenderDevice::Statistics &statistics = device.GetLastFrameStatistics();
+		PrintStatistics(frame, statistics);
+
+		if (frame == 0)
+			firstFrameDraws = statistics.drawCalls;
+		else
+			sameDraws = sameDraws && statistics.drawCalls == firstFrameDraws;
+	}
+
+	std::vector<unsigned int> instancedDraws;
+	for (const NullRenderDevice::CommandRecord &record : device.GetCommandLog())
+		if (record.command == NullRenderDevice::Command::DRAW_INDEXED_INSTANCED)
+			instancedDraws.push_back(record.instances);
+
+	Check(device.GetFrameCount() == numFrames, "every frame is presented");
+	Check(device.GetLastFrameStatistics().drawCalls > 0, "the scene is drawn");
+	Check(instancedDraws.size() == 1 && instancedDraws[0] == GRID_SIZE * GRID_SIZE, "the boxes are drawn in one instanced draw");
+	Check(sameDraws, "a static scene submits the same draws every frame");
+
+	for (Entity *entity : entities)
+		delete entity;
+
+	printf("%d failed\n", numFailures);
+
+	return numFailures ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+#include "../LightClusterer.h"
+#include <cstdio>
+#include <algorithm>
+
+/**** tests of the light binning on the 16 x 8 x 24 cluster grid - no device, build with LightClusterer.cpp and ThreadPool.cpp ****/
+/**** the camera is at the origin looking along +z: 90 degree vertical field of view, aspect 2, depths 1 to 4096 so that ****/
+/**** slice s covers the depths 2^(s/2) to 2^((s+1)/2) ****/
+
+namespace
+{
+	int numFailures = 0;
+
+	void Check(bool condition, const char *test)
+	{
+		printf("%s: %s\n", condition ? "passed" : "FAILED", test);
+
+		if (!condition)
+			numFailures++;
+	}
+
+	// view space center of the cluster (5, 2, 10): tile x from -0.375 to -0.25, tile y from 0.5 to 0.25, depths 32 to 45.25
+	const XMFLOAT3 CLUSTER_CENTER(-23.75f, 14.25f, 38.0f);
+
+	void Bin(LightClusterer &clusterer, const std::vector<LightClusterer::Light> &lights)
+	{
+		XMFLOAT4X4 viewMatrix;
+		XMStoreFloat4x4(&viewMatrix, XMMatrixIdentity());
+
+		clusterer.SetProjection(XM_PI / 2.0f, 2.0f, 1.0f, 4096.0f);
+		clusterer.BinLights(viewMatrix, lights);
+	}
+
+	LightClusterer::Light PointLight(XMFLOAT3 position, float range)
+	{
+		return LightClusterer::Light{ position, range, XMFLOAT3(0.0f, 0.0f, 1.0f), 0.0f };
+	}
+
+	LightClusterer::Light SpotLight(XMFLOAT3 position, float range, XMFLOAT3 direction, float spotAngle)
+	{
+		return LightClusterer::Light{ position, range, direction, spotAngle };
+	}
+
+	// the index list of the cluster is exactly the given lights
+	bool ClusterLights(const LightClusterer &clusterer, unsigned int tileX, unsigned int tileY, unsigned int slice, const std::vector<uint16_t> &lights)
+	{
+		const LightClusterer::Cluster &cluster = clusterer.GetClusters()[LightClusterer::GetClusterIndex(tileX, tileY, slice)];
+
+		if (cluster.count != lights.size() || cluster.offset + cluster.count > clusterer.GetLightIndices().size())
+			return false;
+
+		return std::equal(lights.begin(), lights.end(), clusterer.GetLightIndices().begin() + cluster.offset);
+	}
+
+	unsigned int CountLists(const LightClusterer &clusterer)
+	{
+		unsigned int lists = 0;
+
+		for (const LightClusterer::Cluster &cluster : clusterer.GetClusters())
+			lists += cluster.count > 0;
+
+		return lists;
+	}
+
+	// the lists tile the index array in cluster order, and the offset | count << 16 words of the shader hold them
+	bool ListsArePacked(const LightClusterer &clusterer)
+	{
+		uint32_t offset = 0;
+
+		for (const LightClusterer::Cluster &cluster : clusterer.GetClusters())
+		{
+			uint32_t word = cluster.offset | cluster.count << 16;
+
+			if (cluster.offset != offset || (word & 0xFFFF) != cluster.offset || word >> 16 != cluster.count)
+				return false;
+
+			offset += cluster.count;
+		}
+
+		return offset == clusterer.GetLightIndices().size();
+	}
+
+	void TestSlices()
+	{
+		LightClusterer clusterer;
+		Bin(clusterer, {});
+
+		Check(clusterer.GetSlice(0.5f) == 0 && clusterer.GetSlice(38.0f) == 10 && clusterer.GetSlice(5000.0f) == LightClusterer::SLICES - 1, "view depths map to their exponential slice");
+		Check(CountLists(clusterer) == 0 && clusterer.GetLightIndices().empty(), "no lights, empty clusters");
+	}
+
+	void TestPointLight()
+	{
+		LightClusterer clusterer;
+		Bin(clusterer, { PointLight(CLUSTER_CENTER, 0.2f) });
+
+		Check(ClusterLights(clusterer, 5, 2, 10, { 0 }) && CountLists(clusterer) == 1, "a small point light is binned into the cluster around it only");
+		Check(ListsArePacked(clusterer), "offset and count words of a single light");
+
+		// the sphere reaches into the next slice, not past it (cluster bounds are boxes around the frustum segments, so the
+		// neighbouring tiles whose boxes it touches get it too)
+		Bin(clusterer, { PointLight(XMFLOAT3(CLUSTER_CENTER.x, CLUSTER_CENTER.y, 44.5f), 1.0f) });
+
+		Check(ClusterLights(clusterer, 5, 2, 10, { 0 }) && ClusterLights(clusterer, 5, 2, 11, { 0 }), "a point light across a slice boundary is binned into both slices");
+		Check(ClusterLights(clusterer, 5, 2, 9, {}) && ClusterLights(clusterer, 5, 2, 12, {}) && ClusterLights(clusterer, 3, 2, 10, {}) && ClusterLights(clusterer, 5, 1, 10, {}), "clusters out of reach of the point light are empty");
+
+		Bin(clusterer, { PointLight(XMFLOAT3(0.0f, 0.0f, -10.0f), 5.0f) });
+
+		Check(CountLists(clusterer) == 0, "a point light behind the camera is not binned");
+	}
+
+	void TestSpotLight()
+	{
+		// a point light and a spot light pointing away from the camera at the same position
+		LightClusterer clusterer;
+		Bin(clusterer, { PointLight(CLUSTER_CENTER, 20.0f), SpotLight(CLUSTER_CENTER, 20.0f, XMFLOAT3(0.0f, 0.0f, 1.0f), 30.0f) });
+
+		Check(ClusterLights(clusterer, 6, 2, 11, { 0, 1 }), "both lights are binned in front of the spot light, in light order");
+		Check(ClusterLights(clusterer, 5, 2, 8, { 0 }), "the spot light is not binned behind its cone");
+		Check(ListsArePacked(clusterer), "offset and count words of overlapping lights");
+	}
+
+	void TestIndexBudget()
+	{
+		// more lights than binned, each reaching every cluster: the lists are truncated at the index budget
+		std::vector<LightClusterer::Light> lights(LightClusterer::MAX_LIGHTS + 10, PointLight(XMFLOAT3(0.0f, 0.0f, 0.0f), 10000.0f));
+
+		LightClusterer clusterer;
+		Bin(clusterer, lights);
+
+		const LightClusterer::Cluster &first = clusterer.GetClusters()[0];
+		bool indicesValid = true;
+
+		for (uint16_t index : clusterer.GetLightIndices())
+			indicesValid = indicesValid && index < LightClusterer::MAX_LIGHTS;
+
+		Check(first.offset == 0 && first.count == LightClusterer::MAX_LIGHTS && indicesValid, "lights past the maximum are dropped");
+		Check(clusterer.GetLightIndices().size() == LightClusterer::MAX_INDICES && ListsArePacked(clusterer), "lists past the index budget are truncated");
+	}
+}
+
+int main()
+{
+	TestSlices();
+	TestPointLight();
+	TestSpotLight();
+	TestIndexBudget();
+
+	printf("%d failed\n", numFailures);
+
+	return numFailures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+#include "../OcclusionCuller.h"
+#include <cstdio>
+
+/**** headless tests of the software occlusion culler - no window or device, build with OcclusionCuller.cpp and ThreadPool.cpp ****/
+/**** the camera is at z = -10 looking along +z, the wall occluder is a quad in the z = 0 plane ****/
+
+namespace
+{
+	int numFailures = 0;
+
+	void Check(bool condition, const char *test)
+	{
+		printf("%s: %s\n", condition ? "passed" : "FAILED", test);
+
+		if (!condition)
+			numFailures++;
+	}
+
+	XMFLOAT4X4 GetViewProjectionMatrix()
+	{
+		XMMATRIX viewMatrix = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(1.0f, 2.0f, 0.1f, 100.0f);
+
+		XMFLOAT4X4 viewProjectionMatrix;
+		XMStoreFloat4x4(&viewProjectionMatrix, XMMatrixMultiply(viewMatrix, projectionMatrix));
+
+		return viewProjectionMatrix;
+	}
+
+	// rasterises a wall from (minX, minY) to (maxX, maxY) in the z = 0 plane
+	void RasteriseWall(OcclusionCuller &culler, float minX, float minY, float maxX, float maxY)
+	{
+		std::vector<XMFLOAT3> vertices = { XMFLOAT3(minX, minY, 0.0f), XMFLOAT3(maxX, minY, 0.0f), XMFLOAT3(maxX, maxY, 0.0f), XMFLOAT3(minX, maxY, 0.0f) };
+		std::vector<unsigned int> indices = { 0, 1, 2, 0, 2, 3 };
+
+		XMFLOAT4X4 worldMatrix;
+		XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
+
+		culler.BeginFrame(GetViewProjectionMatrix());
+		culler.AddOccluder(vertices, indices, worldMatrix);
+		culler.RasteriseOccluders();
+	}
+
+	void TestOccludedBox()
+	{
+		OcclusionCuller culler;
+		RasteriseWall(culler, -5.0f, -5.0f, 5.0f, 5.0f);
+
+		Check(!culler.IsVisible(XMFLOAT3(0.0f, 0.0f, 5.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), "box behind an occluder is culled");
+		Check(culler.IsVisible(XMFLOAT3(0.0f, 0.0f, -3.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), "box in front of an occluder is visible");
+		Check(culler.IsVisible(XMFLOAT3(0.0f, 0.0f, 5.0f), XMFLOAT3(20.0f, 1.0f, 1.0f)), "box behind and wider than an occluder is visible");
+	}
+
+	void TestNearPlaneBox()
+	{
+		OcclusionCuller culler;
+		RasteriseWall(culler, -50.0f, -50.0f, 50.0f, 50.0f);
+
+		// the box contains the camera: its projection is unbounded
+		Check(culler.IsVisible(XMFLOAT3(0.0f, 0.0f, -10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), "box crossing the near plane is visible");
+	}
+
+	void TestPartiallyCoveredTile()
+	{
+		// the wall edge at x = 0.3 projects inside a tile, the box behind it covers pixels on both sides of the edge in that tile
+		OcclusionCuller culler;
+		RasteriseWall(culler, -50.0f, -50.0f, 0.3f, 50.0f);
+
+		Check(culler.IsVisible(XMFLOAT3(0.5f, 0.0f, 5.0f), XMFLOAT3(0.35f, 0.2f, 0.2f)), "box behind a partially covered tile is visible");
+		Check(!culler.IsVisible(XMFLOAT3(-1.0f, 0.0f, 5.0f), XMFLOAT3(0.2f, 0.2f, 0.2f)), "box behind the covered part of the wall is culled");
+	}
+}
+
+int main()
+{
+	TestOccludedBox();
+	TestNearPlaneBox();
+	TestPartiallyCoveredTile();
+
+	printf("%d failed\n", numFailures);
+
+	return numFailures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+#include "../ResourceCache.h"
+#include <cstdio>
+
+/**** tests of the texture residency policy against a simulated budget - no device, build with ResourceCache.cpp ****/
+/**** every resource is a 64x64 texture with 7 mips and 4 bytes per texel, mip 0 alone takes 16384 bytes ****/
+
+namespace
+{
+	int numFailures = 0;
+
+	void Check(bool condition, const char *test)
+	{
+		printf("%s: %s\n", condition ? "passed" : "FAILED", test);
+
+		if (!condition)
+			numFailures++;
+	}
+
+	const unsigned int NUM_MIPS = 7;
+	const uint64_t SIZE = (4096 + 1024 + 256 + 64 + 16 + 4 + 1) * 4;      // full mip chain
+	const uint64_t MIP0_SIZE = 4096 * 4;
+	const uint64_t MIP1_SIZE = 1024 * 4;
+
+	ResourceCache::ResourceID AddTexture(ResourceCache &cache)
+	{
+		return cache.Add(64, 64, NUM_MIPS, SIZE);
+	}
+
+	bool HasChange(const std::vector<ResourceCache::Change> &changes, ResourceCache::ResourceID resource, bool evict, unsigned int firstMip = 0)
+	{
+		for (const ResourceCache::Change &change : changes)
+			if (change.resource == resource)
+				return change.evict == evict && (evict || change.firstMip == firstMip);
+
+		return false;
+	}
+
+	// a is used in frame 1, b up to frame 2, c up to frame 3
+	void UseInOrder(ResourceCache &cache, ResourceCache::ResourceID a, ResourceCache::ResourceID b, ResourceCache::ResourceID c)
+	{
+		cache.Request(a, 0);
+		cache.Request(b, 0);
+		cache.Request(c, 0);
+		cache.Update();
+
+		cache.Request(b, 0);
+		cache.Request(c, 0);
+		cache.Update();
+
+		cache.Request(c, 0);
+		cache.Update();
+	}
+
+	void TestMipDrop()
+	{
+		ResourceCache cache(16 * SIZE);
+		ResourceCache::ResourceID texture = AddTexture(cache);
+
+		cache.Request(texture, 2);
+		const std::vector<ResourceCache::Change> &changes = cache.Update();
+
+		Check(HasChange(changes, texture, false, 2) && cache.GetResidentSize() == SIZE - MIP0_SIZE - MIP1_SIZE, "mips finer than needed are dropped within budget");
+
+		cache.Request(texture, 0);
+		Check(HasChange(cache.Update(), texture, false, 0) && cache.GetResidentSize() == SIZE, "mips needed again are streamed in");
+
+		cache.Update();
+		Check(cache.GetFirstMip(texture) == 0, "a resource not requested keeps the detail it needed");
+	}
+
+	void TestEviction()
+	{
+		ResourceCache cache(16 * SIZE);
+		ResourceCache::ResourceID a = AddTexture(cache), b = AddTexture(cache), c = AddTexture(cache);
+
+		UseInOrder(cache, a, b, c);
+
+		cache.SetBudget(2 * SIZE);
+		const std::vector<ResourceCache::Change> &changes = cache.Update();
+
+		Check(changes.size() == 1 && HasChange(changes, a, true), "the least recently used resource is evicted over budget");
+		Check(cache.GetResidentSize() == 2 * SIZE, "resident size after the eviction");
+	}
+
+	void TestReferencedNotEvicted()
+	{
+		ResourceCache cache(16 * SIZE);
+		ResourceCache::ResourceID a = AddTexture(cache), b = AddTexture(cache), c = AddTexture(cache);
+
+		cache.AddReference(a);
+		UseInOrder(cache, a, b, c);
+
+		cache.SetBudget(2 * SIZE);
+		const std::vector<ResourceCache::Change> &changes = cache.Update();
+
+		Check(changes.size() == 1 && HasChange(changes, b, true), "a referenced resource is not evicted, the next least recently used is");
+
+		cache.Release(a);
+		cache.SetBudget(SIZE);
+		Check(HasChange(cache.Update(), a, true), "a released resource is evicted");
+	}
+
+	void TestCoarseningOrder()
+	{
+		ResourceCache cache(16 * SIZE);
+		ResourceCache::ResourceID a = AddTexture(cache), b = AddTexture(cache), c = AddTexture(cache);
+
+		cache.AddReference(a);
+		cache.AddReference(b);
+		cache.AddReference(c);
+		UseInOrder(cache, a, b, c);
+
+		// one mip of the least recently used resource is enough
+		cache.SetBudget(3 * SIZE - 1000);
+		cache.Update();
+
+		Check(cache.GetFirstMip(a) == 1 && cache.GetFirstMip(b) == 0 && cache.GetFirstMip(c) == 0, "the least recently used resource is coarsened first");
+
+		// the least recently used resource is coarsened further before the others lose a mip
+		cache.SetBudget(3 * SIZE - MIP0_SIZE - MIP1_SIZE);
+		cache.Update();
+
+		Check(cache.GetFirstMip(a) == 2 && cache.GetFirstMip(b) == 0 && cache.GetFirstMip(c) == 0, "coarsening goes one mip at a time in order of use");
+
+		// the resources used this frame come last
+		cache.SetBudget(3 * SIZE - SIZE);
+		cache.Request(a, 0);
+		cache.Update();
+
+		Check(cache.GetFirstMip(a) == 0 && cache.GetFirstMip(b) > 0 && cache.GetResidentSize() <= cache.GetBudget(), "a resource requested this frame keeps its detail");
+	}
+}
+
+int main()
+{
+	TestMipDrop();
+	TestEviction();
+	TestReferencedNotEvicted();
+	TestCoarseningOrder();
+
+	printf("%d failed\n", numFailures);
+
+	return numFailures ? 1 : 0;
+}
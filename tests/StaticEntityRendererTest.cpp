@@ -0,0 +1,152 @@
+#include "../GraphicsSystem.h"
+#include "../NullRenderDevice.h"
+#include "../StaticEntityRenderer.h"
+#include "../ShadowRenderer.h"
+#include "../RenderScene.h"
+#include "../Entity.h"
+#include "../PositionComponent.h"
+#include "../StaticMeshComponent.h"
+#include "../CameraComponent.h"
+#include <cstdio>
+
+/**** headless tests of the instanced submission of the static entity renderer - build with the engine sources except ****/
+/**** D3D11RenderDevice.cpp and main.cpp: the draws go to the null render device, whose command log is checked ****/
+
+namespace
+{
+	int numFailures = 0;
+
+	void Check(bool condition, const char *test)
+	{
+		printf("%s: %s\n", condition ? "passed" : "FAILED", test);
+
+		if (!condition)
+			numFailures++;
+	}
+
+	// a mesh of numTriangles triangles in the z = 0 plane, copies share its handle
+	Mesh CreateMesh(unsigned int numTriangles)
+	{
+		std::vector<XMFLOAT3> positions, normals(3 * numTriangles, XMFLOAT3(0.0f, 0.0f, -1.0f)), tangents(3 * numTriangles, XMFLOAT3(1.0f, 0.0f, 0.0f));
+		std::vector<XMFLOAT2> textureCoordinates(3 * numTriangles, XMFLOAT2(0.0f, 0.0f));
+		std::vector<unsigned int> indices;
+
+		for (unsigned int i = 0; i < numTriangles; i++)
+		{
+			positions.push_back(XMFLOAT3((float)i, 0.0f, 0.0f));
+			positions.push_back(XMFLOAT3((float)i, 1.0f, 0.0f));
+			positions.push_back(XMFLOAT3((float)i + 1.0f, 0.0f, 0.0f));
+
+			for (unsigned int j = 0; j < 3; j++)
+				indices.push_back(3 * i + j);
+		}
+
+		VertexLayout::Sources sources = { &positions[0], &normals[0], &tangents[0], &textureCoordinates[0], (unsigned int)positions.size() };
+
+		Mesh mesh;
+		mesh.LoadVertices(VertexLayout::GetStaticMeshLayout(), sources);
+		mesh.LoadIndexBuffer(indices);
+
+		return mesh;
+	}
+
+	Material CreateMaterial(const XMFLOAT3 &diffuseColor)
+	{
+		Material material;
+		material.SetDiffuseColor(diffuseColor);
+
+		return material;
+	}
+
+	Entity *CreateEntity(const Mesh &mesh, const Material &material, float x)
+	{
+		std::vector<XMFLOAT3> bounds = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 0.0f) };
+
+		Entity *entity = new Entity;
+		entity->AddComponent<PositionComponent>(XMFLOAT3(x, 0.0f, 10.0f), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+		entity->AddComponent<StaticMeshComponent>(std::vector<Mesh>{ mesh }, std::vector<Material>{ material }, bounds);
+
+		return entity;
+	}
+
+	// instance counts of the instanced draws in the command log
+	std::vector<unsigned int> GetInstancedDraws(const NullRenderDevice &device)
+	{
+		std::vector<unsigned int> instances;
+
+		for (const NullRenderDevice::CommandRecord &record : device.GetCommandLog())
+			if (record.command == NullRenderDevice::Command::DRAW_INDEXED_INSTANCED)
+				instances.push_back(record.instances);
+
+		return instances;
+	}
+
+	unsigned int CountCommands(const NullRenderDevice &device, NullRenderDevice::Command command)
+	{
+		unsigned int count = 0;
+
+		for (const NullRenderDevice::CommandRecord &record : device.GetCommandLog())
+			count += record.command == command;
+
+		return count;
+	}
+
+	void TestSharedMeshes()
+	{
+		NullRenderDevice &device = static_cast<NullRenderDevice&>(GraphicsSystem::GetInstance().GetRenderDevice());
+
+		Mesh quad = CreateMesh(2), triangle = CreateMesh(1), strip = CreateMesh(3);
+		Material red = CreateMaterial(XMFLOAT3(1.0f, 0.0f, 0.0f)), blue = CreateMaterial(XMFLOAT3(0.0f, 0.0f, 1.0f));
+
+		// the entities are added interleaved, the renderer sorts them by material then mesh:
+		// 5 red quads, 3 red triangles, 1 red strip, 2 blue quads
+		std::vector<Entity*> entities;
+		for (unsigned int i = 0; i < 5; i++)
+		{
+			entities.push_back(CreateEntity(quad, red, (float)i));
+			if (i < 3)
+				entities.push_back(CreateEntity(triangle, red, (float)i));
+			if (i < 2)
+				entities.push_back(CreateEntity(quad, blue, (float)i));
+		}
+		entities.push_back(CreateEntity(strip, red, 0.0f));
+
+		Entity camera;
+		PositionComponent &cameraPosition = camera.AddComponent<PositionComponent>(XMFLOAT3(), XMFLOAT3(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+		camera.AddComponent<CameraComponent>(XM_PI / 4.0f, 4.0f / 3.0f, 0.1f, 100.0f, &cameraPosition, XMFLOAT3(), XMFLOAT3());
+
+		RenderScene &scene = RenderScene::GetInstance();
+		scene.Update();
+
+		ShadowRenderer shadowRenderer(256, 256);
+		StaticEntityRenderer renderer;
+
+		for (unsigned int proxy = 0; proxy < scene.GetNumProxies(); proxy++)
+			renderer.AddProxy(proxy);
+
+		device.ClearCommandLog();
+		device.SetRecording(true);
+		renderer.Render(&camera, Vector<Entity*>(), shadowRenderer);
+		device.SetRecording(false);
+
+		std::vector<unsigned int> instances = GetInstancedDraws(device);
+
+		Check(instances == std::vector<unsigned int>({ 5, 3, 1, 2 }), "entities sharing a mesh and a material are drawn in one instanced draw each");
+		Check(CountCommands(device, NullRenderDevice::Command::DRAW_INDEXED) == 0, "no entity is drawn on its own");
+		Check(CountCommands(device, NullRenderDevice::Command::SET_INDEX_BUFFER) == 4, "the mesh is bound once per batch");
+
+		for (Entity *entity : entities)
+			delete entity;
+	}
+}
+
+int main()
+{
+	GraphicsSystem::GetInstance().InitializeHeadless(800, 600);
+
+	TestSharedMeshes();
+
+	printf("%d failed\n", numFailures);
+
+	return numFailures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+/**** least significant digit radix sort on 64 bit keys, 8 bits per pass ****/
+/**** stable, passes whose digit is the same for every key are skipped ****/
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using std::size_t;
+
+// sort elements by key(element), scratch is resized to the number of elements and its content is undefined after the call
+template <typename T, typename KeyFunction>
+void RadixSort(std::vector<T> &elements, std::vector<T> &scratch, KeyFunction key)
+{
+	static const unsigned int NUM_PASSES = 8;
+	static const unsigned int NUM_BUCKETS = 256;
+
+	size_t numElements = elements.size();
+	if (numElements < 2)
+		return;
+
+	scratch.resize(numElements);
+
+	// histograms of all the digits in a single read of the keys
+	size_t histograms[NUM_PASSES][NUM_BUCKETS] = {};
+
+	for (size_t i = 0; i < numElements; i++)
+	{
+		uint64_t elementKey = key(elements[i]);
+
+		for (unsigned int pass = 0; pass < NUM_PASSES; pass++)
+			histograms[pass][(elementKey >> (pass * 8)) & 0xFF]++;
+	}
+
+	std::vector<T> *source = &elements;
+	std::vector<T> *destination = &scratch;
+
+	for (unsigned int pass = 0; pass < NUM_PASSES; pass++)
+	{
+		size_t *histogram = histograms[pass];
+
+		// all keys share this digit
+		if (histogram[(key((*source)[0]) >> (pass * 8)) & 0xFF] == numElements)
+			continue;
+
+		// bucket offsets
+		size_t offset = 0;
+		for (unsigned int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+		{
+			size_t count = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < numElements; i++)
+		{
+			const T &element = (*source)[i];
+			(*destination)[histogram[(key(element) >> (pass * 8)) & 0xFF]++] = element;
+		}
+
+		std::vector<T> *temp = source;
+		source = destination;
+		destination = temp;
+	}
+
+	// odd number of passes: sorted elements are in the scratch buffer
+	if (source != &elements)
+		elements.swap(scratch);
+}
+
+#endif  // RADIX_SORT_H